@@ -36,6 +36,8 @@
 #ifndef COMMON_H_
 #define COMMON_H_
 
+#include "lwm2m-client-diagnostics-object.h"
+
 #define REGISTER_OBJECT(context, name, id, maxInstances, minInstances, handlers)                  \
 	do                                                                                            \
 	{                                                                                             \
@@ -57,6 +59,7 @@
 				Lwm2m_Error("Failed to register "name" resource with Lwm2m core\n");              \
 				return -1;                                                                        \
 			}                                                                                     \
+		DIAGNOSTICS_TRACK_RESOURCE(objId, id);                                                    \
 	}while(0)
 
 #define CREATE_OBJECT_INSTANCE(context, objectId, objectInstanceId)                               \
@@ -0,0 +1,93 @@
+/**
+ * @file
+ * Compile-time selection of optional object resources.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_CONFIG_H_
+#define LWM2M_CLIENT_CONFIG_H_
+
+/*
+ * Optional resources are built in unless set to 0 here, on the compiler command line or in a
+ * header named by LWM2M_CLIENT_CONFIG_FILE (-DLWM2M_CLIENT_CONFIG_FILE='"my-config.h"'). A resource
+ * that is left out is not registered with the core, has no storage in the instance records and no
+ * case in the handlers, so reads and writes of it fail like those of an unknown resource.
+ */
+#ifdef LWM2M_CLIENT_CONFIG_FILE
+#include LWM2M_CLIENT_CONFIG_FILE
+#endif
+
+/* Flow object (20000) */
+#ifndef LWM2M_CLIENT_FLOW_PARENT_ID
+#define LWM2M_CLIENT_FLOW_PARENT_ID							1
+#endif
+#ifndef LWM2M_CLIENT_FLOW_NAME
+#define LWM2M_CLIENT_FLOW_NAME								1
+#endif
+#ifndef LWM2M_CLIENT_FLOW_DESCRIPTION
+#define LWM2M_CLIENT_FLOW_DESCRIPTION						1
+#endif
+
+/* Digital Input object (3200) */
+#ifndef LWM2M_CLIENT_DIGITAL_INPUT_POLARITY
+#define LWM2M_CLIENT_DIGITAL_INPUT_POLARITY					1
+#endif
+#ifndef LWM2M_CLIENT_DIGITAL_INPUT_DEBOUNCE_PERIOD
+#define LWM2M_CLIENT_DIGITAL_INPUT_DEBOUNCE_PERIOD			1
+#endif
+#ifndef LWM2M_CLIENT_DIGITAL_INPUT_APPLICATION_TYPE
+#define LWM2M_CLIENT_DIGITAL_INPUT_APPLICATION_TYPE			1
+#endif
+#ifndef LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE
+#define LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE				1
+#endif
+
+/* Light Control object (3311) */
+#ifndef LWM2M_CLIENT_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER
+#define LWM2M_CLIENT_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER	1
+#endif
+#ifndef LWM2M_CLIENT_LIGHT_CONTROL_POWER_FACTOR
+#define LWM2M_CLIENT_LIGHT_CONTROL_POWER_FACTOR				1
+#endif
+
+/*
+ * With LWM2M_CLIENT_FOOTPRINT defined, FOOTPRINT_RECORD(type) emits a read-only symbol named
+ * <type>Footprint as large as the type, so tools/lwm2m-client-footprint.sh can read struct sizes
+ * from the object files with nm, even when cross compiling. Otherwise it expands to nothing.
+ */
+#ifdef LWM2M_CLIENT_FOOTPRINT
+#define FOOTPRINT_RECORD(type)	const char type##Footprint[sizeof(type)] = { 0 };
+#else
+#define FOOTPRINT_RECORD(type)
+#endif
+
+#endif /* LWM2M_CLIENT_CONFIG_H_ */
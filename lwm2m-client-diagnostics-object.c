@@ -0,0 +1,507 @@
+/**
+ * @file
+ * LightWeightM2M LWM2M Diagnostics object.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "lwm2m_core.h"
+#include "coap_abstraction.h"
+#include "lwm2m-client-diagnostics-object.h"
+#include "lwm2m-client-state.h"
+#include "common.h"
+
+#ifdef LWM2M_CLIENT_DIAGNOSTICS
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define FLOWM2M_DIAGNOSTICS_OBJECT							20002
+#define FLOWM2M_DIAGNOSTICS_OBJECT_OBJECTID					0
+#define FLOWM2M_DIAGNOSTICS_OBJECT_RESOURCEID				1
+#define FLOWM2M_DIAGNOSTICS_OBJECT_READCOUNT				2
+#define FLOWM2M_DIAGNOSTICS_OBJECT_WRITECOUNT				3
+#define FLOWM2M_DIAGNOSTICS_OBJECT_GETLENGTHCOUNT			4
+#define FLOWM2M_DIAGNOSTICS_OBJECT_EXECUTECOUNT				5
+#define FLOWM2M_DIAGNOSTICS_OBJECT_BYTESREAD				6
+#define FLOWM2M_DIAGNOSTICS_OBJECT_BYTESWRITTEN				7
+#define FLOWM2M_DIAGNOSTICS_OBJECT_READLATENCY				8
+#define FLOWM2M_DIAGNOSTICS_OBJECT_WRITELATENCY				9
+#define FLOWM2M_DIAGNOSTICS_OBJECT_GETLENGTHLATENCY			10
+#define FLOWM2M_DIAGNOSTICS_OBJECT_EXECUTELATENCY			11
+
+#ifndef DIAGNOSTICS_MAX_RESOURCES
+#define DIAGNOSTICS_MAX_RESOURCES							64
+#endif
+#define DIAGNOSTICS_TABLE_SIZE								(2 * DIAGNOSTICS_MAX_RESOURCES)
+
+/* Latency bucket 0 holds everything up to 2^DIAGNOSTICS_LATENCY_SHIFT ns (~0.5us), each
+ * following bucket doubles, and the last bucket collects everything above ~8ms. */
+#define DIAGNOSTICS_LATENCY_BUCKETS							16
+#define DIAGNOSTICS_LATENCY_SHIFT							9
+
+#define DIAGNOSTICS_KEY(objectID, resourceID) \
+	((((uint64_t)(objectID) + 1) << 32) | (uint32_t)(resourceID))
+
+#define REGISTER_DIAGNOSTICS_RESOURCE(context, name, id, type) \
+	REGISTER_RESOURCE(context, name, FLOWM2M_DIAGNOSTICS_OBJECT, id, type, \
+		MultipleInstancesEnum_Single, MandatoryEnum_Mandatory, Operations_R, \
+		&diagnosticsResourceOperationHandlers)
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef struct
+{
+	uint64_t Key;
+	int Slot;
+} DiagnosticsTableEntry;
+
+typedef struct
+{
+	int64_t Count[DiagnosticsOperation_Max];
+	int64_t Bytes[DiagnosticsOperation_Max];
+	uint32_t Latency[DiagnosticsOperation_Max][DIAGNOSTICS_LATENCY_BUCKETS];
+} DiagnosticsCounters;
+
+/* One block per thread that records operations. Only the owning thread writes to it, so
+ * recording needs neither locks nor atomic read-modify-write operations. */
+typedef struct DiagnosticsThreadCounters
+{
+	struct DiagnosticsThreadCounters * Next;
+	DiagnosticsCounters Resources[DIAGNOSTICS_MAX_RESOURCES];
+} DiagnosticsThreadCounters;
+
+/* Tracked resources are shared by all clients; each client creates its own instances of them */
+typedef struct
+{
+	int CreatedInstanceCount;
+} DiagnosticsState;
+
+/***************************************************************************************************
+ * Prototypes
+ **************************************************************************************************/
+
+static int Diagnostics_ResourceReadHandler(void * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID, uint8_t * destBuffer, int destBufferLen);
+
+static int Diagnostics_ResourceGetLengthHandler(void * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID);
+
+static int Diagnostics_ResourceCreateHandler(void * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID);
+
+static int Diagnostics_ObjectCreateInstanceHandler(void * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID);
+
+static int Diagnostics_ObjectDeleteHandler(void * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID);
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+static ObjectOperationHandlers diagnosticsObjectOperationHandlers =
+{
+	.CreateInstance = Diagnostics_ObjectCreateInstanceHandler,
+	.Delete = Diagnostics_ObjectDeleteHandler,
+};
+
+static ResourceOperationHandlers diagnosticsResourceOperationHandlers =
+{
+	.Read = Diagnostics_ResourceReadHandler,
+	.GetLength = Diagnostics_ResourceGetLengthHandler,
+	.Write = NULL,
+	.CreateOptionalResource = Diagnostics_ResourceCreateHandler,
+	.Execute = NULL,
+};
+
+static const ClientStateDefinition diagnosticsStateDefinition =
+{
+	.Slot = ClientStateSlot_Diagnostics,
+	.Size = sizeof(DiagnosticsState),
+};
+
+/*
+ * Clients may register objects from their own threads while others record operations. Adding a
+ * resource takes the lock; an entry's Key and the count are stored last, with release semantics,
+ * so lookups that see them also see the rest of the entry without locking.
+ */
+static pthread_mutex_t diagnosticsTableLock = PTHREAD_MUTEX_INITIALIZER;
+static DiagnosticsTableEntry diagnosticsTable[DIAGNOSTICS_TABLE_SIZE];
+static uint64_t trackedResources[DIAGNOSTICS_MAX_RESOURCES];
+static int trackedResourceCount;
+
+static DiagnosticsThreadCounters * threadCountersList;
+static __thread DiagnosticsThreadCounters * threadCounters;
+
+/***************************************************************************************************
+ * Implementation - Private
+ **************************************************************************************************/
+
+static int Diagnostics_FindSlot(ObjectIDType objectID, ResourceIDType resourceID)
+{
+	uint64_t key = DIAGNOSTICS_KEY(objectID, resourceID);
+	unsigned int index = (unsigned int)((key * 0x9E3779B97F4A7C15ULL) >> 32);
+	int probe;
+
+	for (probe = 0; probe < DIAGNOSTICS_TABLE_SIZE; probe++)
+	{
+		DiagnosticsTableEntry * entry = &diagnosticsTable[(index + probe) % DIAGNOSTICS_TABLE_SIZE];
+
+		uint64_t entryKey = __atomic_load_n(&entry->Key, __ATOMIC_ACQUIRE);
+
+		if (entryKey == key)
+			return entry->Slot;
+		if (entryKey == 0)
+			break;
+	}
+	return -1;
+}
+
+static DiagnosticsThreadCounters * Diagnostics_GetThreadCounters(void)
+{
+	if (threadCounters == NULL)
+	{
+		DiagnosticsThreadCounters * counters = calloc(1, sizeof(DiagnosticsThreadCounters));
+
+		if (counters == NULL)
+			return NULL;
+
+		/* Publish the block so the diagnostics object can sum it. Blocks are never unlinked,
+		 * so the counts of exited threads are kept. */
+		counters->Next = __atomic_load_n(&threadCountersList, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&threadCountersList, &counters->Next, counters, true,
+			__ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			;
+		threadCounters = counters;
+	}
+	return threadCounters;
+}
+
+static void Diagnostics_SumCounters(int slot, DiagnosticsCounters * total)
+{
+	DiagnosticsThreadCounters * counters = __atomic_load_n(&threadCountersList, __ATOMIC_ACQUIRE);
+	int operation, bucket;
+
+	memset(total, 0, sizeof(DiagnosticsCounters));
+
+	for (; counters != NULL; counters = counters->Next)
+	{
+		DiagnosticsCounters * resource = &counters->Resources[slot];
+
+		for (operation = 0; operation < DiagnosticsOperation_Max; operation++)
+		{
+			total->Count[operation] += __atomic_load_n(&resource->Count[operation],
+				__ATOMIC_RELAXED);
+			total->Bytes[operation] += __atomic_load_n(&resource->Bytes[operation],
+				__ATOMIC_RELAXED);
+			for (bucket = 0; bucket < DIAGNOSTICS_LATENCY_BUCKETS; bucket++)
+			{
+				total->Latency[operation][bucket] +=
+					__atomic_load_n(&resource->Latency[operation][bucket], __ATOMIC_RELAXED);
+			}
+		}
+	}
+}
+
+static int Diagnostics_ObjectCreateInstanceHandler(void * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID)
+{
+	int count = __atomic_load_n(&trackedResourceCount, __ATOMIC_ACQUIRE);
+
+	if (objectInstanceID >= count)
+	{
+		Lwm2m_Error("Diagnostics_ObjectCreateInstanceHandler instance number %d out of range "
+			"(max %d)", objectInstanceID, count - 1);
+		return -1;
+	}
+	return objectInstanceID;
+}
+
+static int Diagnostics_ResourceCreateHandler(void * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID)
+{
+	return 0;
+}
+
+static int Diagnostics_ObjectDeleteHandler(void * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID)
+{
+	if (objectID != FLOWM2M_DIAGNOSTICS_OBJECT)
+	{
+		Lwm2m_Error("Diagnostics_ObjectDeleteHandler Invalid OIR: %d/%d/%d\n", objectID,
+			objectInstanceID, resourceID);
+		return -1;
+	}
+	return 0;
+}
+
+static int Diagnostics_ResourceGetLengthHandler(void * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID)
+{
+	int result;
+
+	switch (resourceID)
+	{
+		case FLOWM2M_DIAGNOSTICS_OBJECT_OBJECTID:
+		case FLOWM2M_DIAGNOSTICS_OBJECT_RESOURCEID:
+		case FLOWM2M_DIAGNOSTICS_OBJECT_READCOUNT:
+		case FLOWM2M_DIAGNOSTICS_OBJECT_WRITECOUNT:
+		case FLOWM2M_DIAGNOSTICS_OBJECT_GETLENGTHCOUNT:
+		case FLOWM2M_DIAGNOSTICS_OBJECT_EXECUTECOUNT:
+		case FLOWM2M_DIAGNOSTICS_OBJECT_BYTESREAD:
+		case FLOWM2M_DIAGNOSTICS_OBJECT_BYTESWRITTEN:
+			result = sizeof(int64_t);
+			break;
+
+		case FLOWM2M_DIAGNOSTICS_OBJECT_READLATENCY:
+		case FLOWM2M_DIAGNOSTICS_OBJECT_WRITELATENCY:
+		case FLOWM2M_DIAGNOSTICS_OBJECT_GETLENGTHLATENCY:
+		case FLOWM2M_DIAGNOSTICS_OBJECT_EXECUTELATENCY:
+			result = DIAGNOSTICS_LATENCY_BUCKETS * sizeof(uint32_t);
+			break;
+
+		default:
+			result = -1;
+			break;
+	}
+
+	return result;
+}
+
+static int Diagnostics_ResourceReadHandler(void * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID, uint8_t * destBuffer, int destBufferLen)
+{
+	DiagnosticsCounters total;
+	int64_t value = 0;
+	int result = Diagnostics_ResourceGetLengthHandler(context, objectID, objectInstanceID,
+		resourceID, resourceInstanceID);
+
+	if (result < 0 || objectInstanceID >= __atomic_load_n(&trackedResourceCount, __ATOMIC_ACQUIRE))
+		return -1;
+
+	if (result > destBufferLen)
+	{
+		Lwm2m_Error("Diagnostics_ResourceReadHandler buffer too small for %d/%d/%d\n", objectID,
+			objectInstanceID, resourceID);
+		return -1;
+	}
+
+	Diagnostics_SumCounters(objectInstanceID, &total);
+
+	switch (resourceID)
+	{
+		case FLOWM2M_DIAGNOSTICS_OBJECT_OBJECTID:
+			value = (int64_t)(trackedResources[objectInstanceID] >> 32) - 1;
+			break;
+
+		case FLOWM2M_DIAGNOSTICS_OBJECT_RESOURCEID:
+			value = (int32_t)(trackedResources[objectInstanceID] & 0xFFFFFFFF);
+			break;
+
+		case FLOWM2M_DIAGNOSTICS_OBJECT_READCOUNT:
+		case FLOWM2M_DIAGNOSTICS_OBJECT_WRITECOUNT:
+		case FLOWM2M_DIAGNOSTICS_OBJECT_GETLENGTHCOUNT:
+		case FLOWM2M_DIAGNOSTICS_OBJECT_EXECUTECOUNT:
+			value = total.Count[resourceID - FLOWM2M_DIAGNOSTICS_OBJECT_READCOUNT];
+			break;
+
+		case FLOWM2M_DIAGNOSTICS_OBJECT_BYTESREAD:
+			value = total.Bytes[DiagnosticsOperation_Read];
+			break;
+
+		case FLOWM2M_DIAGNOSTICS_OBJECT_BYTESWRITTEN:
+			value = total.Bytes[DiagnosticsOperation_Write];
+			break;
+
+		default:
+			memcpy(destBuffer, total.Latency[resourceID - FLOWM2M_DIAGNOSTICS_OBJECT_READLATENCY],
+				result);
+			return result;
+	}
+
+	memcpy(destBuffer, &value, result);
+	return result;
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+uint64_t Diagnostics_GetTime(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+void Diagnostics_TrackResource(ObjectIDType objectID, ResourceIDType resourceID)
+{
+	uint64_t key = DIAGNOSTICS_KEY(objectID, resourceID);
+	unsigned int index = (unsigned int)((key * 0x9E3779B97F4A7C15ULL) >> 32);
+	int probe;
+
+	if (objectID == FLOWM2M_DIAGNOSTICS_OBJECT)
+		return;
+
+	pthread_mutex_lock(&diagnosticsTableLock);
+	if (Diagnostics_FindSlot(objectID, resourceID) != -1)
+	{
+		pthread_mutex_unlock(&diagnosticsTableLock);
+		return;
+	}
+
+	if (trackedResourceCount >= DIAGNOSTICS_MAX_RESOURCES)
+	{
+		pthread_mutex_unlock(&diagnosticsTableLock);
+		Lwm2m_Error("Diagnostics table full, %d/%d is not tracked\n", objectID, resourceID);
+		return;
+	}
+
+	for (probe = 0; probe < DIAGNOSTICS_TABLE_SIZE; probe++)
+	{
+		DiagnosticsTableEntry * entry = &diagnosticsTable[(index + probe) % DIAGNOSTICS_TABLE_SIZE];
+
+		if (entry->Key == 0)
+		{
+			entry->Slot = trackedResourceCount;
+			trackedResources[trackedResourceCount] = key;
+			__atomic_store_n(&entry->Key, key, __ATOMIC_RELEASE);
+			__atomic_store_n(&trackedResourceCount, trackedResourceCount + 1, __ATOMIC_RELEASE);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&diagnosticsTableLock);
+}
+
+void Diagnostics_Record(ObjectIDType objectID, ResourceIDType resourceID,
+	DiagnosticsOperation operation, int bytes, uint64_t startTime)
+{
+	DiagnosticsThreadCounters * counters;
+	DiagnosticsCounters * resource;
+	uint64_t elapsed = Diagnostics_GetTime() - startTime;
+	int slot = Diagnostics_FindSlot(objectID, resourceID);
+	int bucket;
+
+	if (slot == -1 || (counters = Diagnostics_GetThreadCounters()) == NULL)
+		return;
+
+	bucket = (63 - __builtin_clzll(elapsed | 1)) - DIAGNOSTICS_LATENCY_SHIFT;
+	if (bucket < 0)
+		bucket = 0;
+	else if (bucket >= DIAGNOSTICS_LATENCY_BUCKETS)
+		bucket = DIAGNOSTICS_LATENCY_BUCKETS - 1;
+
+	/* Single writer per block: relaxed stores are enough for the reader to see whole values */
+	resource = &counters->Resources[slot];
+	__atomic_store_n(&resource->Count[operation], resource->Count[operation] + 1,
+		__ATOMIC_RELAXED);
+	if (bytes > 0)
+	{
+		__atomic_store_n(&resource->Bytes[operation], resource->Bytes[operation] + bytes,
+			__ATOMIC_RELAXED);
+	}
+	__atomic_store_n(&resource->Latency[operation][bucket],
+		resource->Latency[operation][bucket] + 1, __ATOMIC_RELAXED);
+}
+
+int Diagnostics_RegisterDiagnosticsObject(Lwm2mContextType * context)
+{
+	REGISTER_OBJECT(context, "Diagnostics", FLOWM2M_DIAGNOSTICS_OBJECT, \
+		MultipleInstancesEnum_Multiple, MandatoryEnum_Optional, \
+		&diagnosticsObjectOperationHandlers);
+
+	REGISTER_DIAGNOSTICS_RESOURCE(context, "ObjectID", FLOWM2M_DIAGNOSTICS_OBJECT_OBJECTID, \
+		ResourceTypeEnum_TypeInteger);
+	REGISTER_DIAGNOSTICS_RESOURCE(context, "ResourceID", FLOWM2M_DIAGNOSTICS_OBJECT_RESOURCEID, \
+		ResourceTypeEnum_TypeInteger);
+	REGISTER_DIAGNOSTICS_RESOURCE(context, "ReadCount", FLOWM2M_DIAGNOSTICS_OBJECT_READCOUNT, \
+		ResourceTypeEnum_TypeInteger);
+	REGISTER_DIAGNOSTICS_RESOURCE(context, "WriteCount", FLOWM2M_DIAGNOSTICS_OBJECT_WRITECOUNT, \
+		ResourceTypeEnum_TypeInteger);
+	REGISTER_DIAGNOSTICS_RESOURCE(context, "GetLengthCount", \
+		FLOWM2M_DIAGNOSTICS_OBJECT_GETLENGTHCOUNT, ResourceTypeEnum_TypeInteger);
+	REGISTER_DIAGNOSTICS_RESOURCE(context, "ExecuteCount", \
+		FLOWM2M_DIAGNOSTICS_OBJECT_EXECUTECOUNT, ResourceTypeEnum_TypeInteger);
+	REGISTER_DIAGNOSTICS_RESOURCE(context, "BytesRead", FLOWM2M_DIAGNOSTICS_OBJECT_BYTESREAD, \
+		ResourceTypeEnum_TypeInteger);
+	REGISTER_DIAGNOSTICS_RESOURCE(context, "BytesWritten", \
+		FLOWM2M_DIAGNOSTICS_OBJECT_BYTESWRITTEN, ResourceTypeEnum_TypeInteger);
+	REGISTER_DIAGNOSTICS_RESOURCE(context, "ReadLatency", \
+		FLOWM2M_DIAGNOSTICS_OBJECT_READLATENCY, ResourceTypeEnum_TypeOpaque);
+	REGISTER_DIAGNOSTICS_RESOURCE(context, "WriteLatency", \
+		FLOWM2M_DIAGNOSTICS_OBJECT_WRITELATENCY, ResourceTypeEnum_TypeOpaque);
+	REGISTER_DIAGNOSTICS_RESOURCE(context, "GetLengthLatency", \
+		FLOWM2M_DIAGNOSTICS_OBJECT_GETLENGTHLATENCY, ResourceTypeEnum_TypeOpaque);
+	REGISTER_DIAGNOSTICS_RESOURCE(context, "ExecuteLatency", \
+		FLOWM2M_DIAGNOSTICS_OBJECT_EXECUTELATENCY, ResourceTypeEnum_TypeOpaque);
+
+	return 0;
+}
+
+/*
+ * Creates one diagnostics instance per tracked resource for this client. Call after all other
+ * objects have been registered; it can be called again to pick up objects registered later.
+ */
+int Diagnostics_AddDiagnostics(Lwm2mContextType * context)
+{
+	DiagnosticsState * state = ClientState_Get(context, &diagnosticsStateDefinition);
+	int count = __atomic_load_n(&trackedResourceCount, __ATOMIC_ACQUIRE);
+
+	if (state == NULL)
+		return -1;
+
+	for (; state->CreatedInstanceCount < count; state->CreatedInstanceCount++)
+	{
+		CREATE_OBJECT_INSTANCE(context, FLOWM2M_DIAGNOSTICS_OBJECT, state->CreatedInstanceCount);
+	}
+	return 0;
+}
+
+#endif /* LWM2M_CLIENT_DIAGNOSTICS */
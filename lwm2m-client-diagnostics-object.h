@@ -0,0 +1,81 @@
+/**
+ * @file
+ * LightWeightM2M LWM2M Diagnostics object.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_DIAGNOSTICS_OBJECT_H_
+#define LWM2M_CLIENT_DIAGNOSTICS_OBJECT_H_
+
+#include <stdint.h>
+#include "lwm2m_core.h"
+
+typedef enum
+{
+	DiagnosticsOperation_Read,
+	DiagnosticsOperation_Write,
+	DiagnosticsOperation_GetLength,
+	DiagnosticsOperation_Execute,
+	DiagnosticsOperation_Max
+} DiagnosticsOperation;
+
+/*
+ * Operation counters are only compiled in when LWM2M_CLIENT_DIAGNOSTICS is defined, otherwise
+ * the recording macros expand to nothing and the object handlers carry no extra cost.
+ */
+#ifdef LWM2M_CLIENT_DIAGNOSTICS
+
+int Diagnostics_RegisterDiagnosticsObject(Lwm2mContextType * context);
+int Diagnostics_AddDiagnostics(Lwm2mContextType * context);
+void Diagnostics_TrackResource(ObjectIDType objectID, ResourceIDType resourceID);
+uint64_t Diagnostics_GetTime(void);
+void Diagnostics_Record(ObjectIDType objectID, ResourceIDType resourceID,
+	DiagnosticsOperation operation, int bytes, uint64_t startTime);
+
+#define DIAGNOSTICS_TRACK_RESOURCE(objectID, resourceID) \
+	Diagnostics_TrackResource(objectID, resourceID)
+#define DIAGNOSTICS_START(startTime) \
+	uint64_t startTime = Diagnostics_GetTime()
+#define DIAGNOSTICS_RECORD(objectID, resourceID, operation, bytes, startTime) \
+	Diagnostics_Record(objectID, resourceID, operation, bytes, startTime)
+
+#else
+
+#define Diagnostics_RegisterDiagnosticsObject(context) (0)
+#define Diagnostics_AddDiagnostics(context) (0)
+#define DIAGNOSTICS_TRACK_RESOURCE(objectID, resourceID)
+#define DIAGNOSTICS_START(startTime)
+#define DIAGNOSTICS_RECORD(objectID, resourceID, operation, bytes, startTime)
+
+#endif
+
+#endif /* LWM2M_CLIENT_DIAGNOSTICS_OBJECT_H_ */
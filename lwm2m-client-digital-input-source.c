@@ -0,0 +1,366 @@
+/**
+ * @file
+ * Input sources that drive Digital Input instances from file descriptors.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <linux/gpio.h>
+#include <linux/input.h>
+#include "lwm2m_core.h"
+#include "lwm2m-client-ipso-digital-input.h"
+#include "lwm2m-client-digital-input-source.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define DIGITAL_INPUT_SOURCE_INITIAL_CAPACITY	4
+#define DIGITAL_INPUT_SOURCE_MAX_RECORD_SIZE	64
+#define DIGITAL_INPUT_SOURCE_BATCH_SIZE			4096
+#define DIGITAL_INPUT_SOURCE_EPOLL_EVENTS		16
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef enum
+{
+	DigitalInputSourceType_GpioLine,
+	DigitalInputSourceType_EvdevKey,
+	DigitalInputSourceType_Records,
+} DigitalInputSourceType;
+
+typedef struct
+{
+	int Fd;
+	DigitalInputSourceType Type;
+	ObjectInstanceIDType ObjectInstanceID;
+	int RecordSize;
+	uint16_t KeyCode;
+	DigitalInputRecordDecoder Decoder;
+	void * DecoderContext;
+	/* Start of a record a pipe delivered only part of */
+	int PartialLength;
+	uint8_t Partial[DIGITAL_INPUT_SOURCE_MAX_RECORD_SIZE];
+} DigitalInputSource;
+
+struct _DigitalInputSources
+{
+	Lwm2mContextType * Context;
+	int EpollFd;
+	DigitalInputSource * Sources;
+	int Count;
+	int Capacity;
+	/* Added to CLOCK_MONOTONIC stamps to get wall clock time; zero until first needed in a poll */
+	int64_t MonotonicOffsetNs;
+	uint8_t Batch[DIGITAL_INPUT_SOURCE_BATCH_SIZE];
+};
+
+/***************************************************************************************************
+ * Implementation - Private
+ **************************************************************************************************/
+
+static DigitalInputSource * DigitalInputSources_Find(DigitalInputSources * sources, int fd)
+{
+	int i;
+
+	for (i = 0; i < sources->Count; i++)
+	{
+		if (sources->Sources[i].Fd == fd)
+			return &sources->Sources[i];
+	}
+	return NULL;
+}
+
+static int DigitalInputSources_Add(DigitalInputSources * sources, const DigitalInputSource * source)
+{
+	struct epoll_event event = { .events = EPOLLIN };
+
+	if (sources == NULL || source->Fd < 0 || source->RecordSize <= 0 ||
+		source->RecordSize > DIGITAL_INPUT_SOURCE_MAX_RECORD_SIZE)
+	{
+		Lwm2m_Error("Invalid input source for Digital Input %d\n", source->ObjectInstanceID);
+		return -1;
+	}
+
+	if (DigitalInputSources_Find(sources, source->Fd) != NULL)
+	{
+		Lwm2m_Error("Descriptor %d is already an input source\n", source->Fd);
+		return -1;
+	}
+
+	if (sources->Count == sources->Capacity)
+	{
+		int capacity = sources->Capacity == 0 ? DIGITAL_INPUT_SOURCE_INITIAL_CAPACITY :
+			2 * sources->Capacity;
+		DigitalInputSource * grown = realloc(sources->Sources,
+			capacity * sizeof(DigitalInputSource));
+
+		if (grown == NULL)
+		{
+			Lwm2m_Error("Out of memory for input sources\n");
+			return -1;
+		}
+		sources->Sources = grown;
+		sources->Capacity = capacity;
+	}
+
+	event.data.fd = source->Fd;
+	if (epoll_ctl(sources->EpollFd, EPOLL_CTL_ADD, source->Fd, &event) == -1)
+	{
+		Lwm2m_Error("Failed to wait on descriptor %d: %s\n", source->Fd, strerror(errno));
+		return -1;
+	}
+
+	sources->Sources[sources->Count++] = *source;
+	return 0;
+}
+
+static int64_t DigitalInputSources_GetMonotonicOffset(DigitalInputSources * sources)
+{
+	if (sources->MonotonicOffsetNs == 0)
+	{
+		struct timespec realtime, monotonic;
+
+		clock_gettime(CLOCK_REALTIME, &realtime);
+		clock_gettime(CLOCK_MONOTONIC, &monotonic);
+		sources->MonotonicOffsetNs = (int64_t)(realtime.tv_sec - monotonic.tv_sec) * 1000000000 +
+			(realtime.tv_nsec - monotonic.tv_nsec);
+	}
+	return sources->MonotonicOffsetNs;
+}
+
+/* Returns 1 if the record is an event for the instance, 0 if it is not and -1 to drop the source */
+static int DigitalInputSources_Decode(DigitalInputSources * sources, DigitalInputSource * source,
+	const uint8_t * record, bool * state, int64_t * timeMs)
+{
+	switch (source->Type)
+	{
+		case DigitalInputSourceType_GpioLine:
+		{
+			struct gpio_v2_line_event event;
+
+			/* Line requests stamp events with CLOCK_MONOTONIC unless asked otherwise */
+			memcpy(&event, record, sizeof(event));
+			*state = event.id == GPIO_V2_LINE_EVENT_RISING_EDGE;
+			*timeMs = ((int64_t)event.timestamp_ns +
+				DigitalInputSources_GetMonotonicOffset(sources)) / 1000000;
+			return 1;
+		}
+
+		case DigitalInputSourceType_EvdevKey:
+		{
+			struct input_event event;
+
+			memcpy(&event, record, sizeof(event));
+			/* A value of 2 is auto-repeat, which is not an edge */
+			if (event.type != EV_KEY || event.code != source->KeyCode || event.value > 1)
+				return 0;
+			*state = event.value == 1;
+			*timeMs = (int64_t)event.input_event_sec * 1000 + event.input_event_usec / 1000;
+			return 1;
+		}
+
+		case DigitalInputSourceType_Records:
+			*timeMs = 0;
+			return source->Decoder(source->DecoderContext, record, state, timeMs);
+	}
+	return -1;
+}
+
+/* Reads one batch of records from the source and applies them. Returns -1 to drop the source. */
+static int DigitalInputSources_ReadSource(DigitalInputSources * sources,
+	DigitalInputSource * source, int * applied)
+{
+	int batchSize = DIGITAL_INPUT_SOURCE_BATCH_SIZE / source->RecordSize * source->RecordSize;
+	int length, offset;
+
+	memcpy(sources->Batch, source->Partial, source->PartialLength);
+	length = read(source->Fd, sources->Batch + source->PartialLength,
+		batchSize - source->PartialLength);
+	if (length == 0)
+		return -1;
+	if (length == -1)
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+	length += source->PartialLength;
+
+	for (offset = 0; offset + source->RecordSize <= length; offset += source->RecordSize)
+	{
+		bool state = false;
+		int64_t timeMs;
+		int result = DigitalInputSources_Decode(sources, source, sources->Batch + offset, &state,
+			&timeMs);
+
+		if (result == -1)
+			return -1;
+		if (result == 0)
+			continue;
+
+		if (timeMs == 0)
+			timeMs = ResourceHistory_GetTime();
+		/* The instance may be deleted and added again, so a missing one does not drop the source */
+		if (DigitalInput_SetInputAt(sources->Context, source->ObjectInstanceID, state, timeMs) == 0)
+			(*applied)++;
+	}
+
+	source->PartialLength = length - offset;
+	memcpy(source->Partial, sources->Batch + offset, source->PartialLength);
+	return 0;
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+DigitalInputSources * DigitalInputSources_Create(Lwm2mContextType * context)
+{
+	DigitalInputSources * sources = calloc(1, sizeof(DigitalInputSources));
+
+	if (sources == NULL)
+	{
+		Lwm2m_Error("Out of memory for input sources\n");
+		return NULL;
+	}
+
+	sources->Context = context;
+	if ((sources->EpollFd = epoll_create1(EPOLL_CLOEXEC)) == -1)
+	{
+		Lwm2m_Error("Failed to create input source epoll: %s\n", strerror(errno));
+		free(sources);
+		return NULL;
+	}
+	return sources;
+}
+
+void DigitalInputSources_Destroy(DigitalInputSources * sources)
+{
+	if (sources == NULL)
+		return;
+
+	close(sources->EpollFd);
+	free(sources->Sources);
+	free(sources);
+}
+
+int DigitalInputSources_AddGpioLine(DigitalInputSources * sources, int fd,
+	ObjectInstanceIDType objectInstanceID)
+{
+	DigitalInputSource source = { .Fd = fd, .Type = DigitalInputSourceType_GpioLine,
+		.ObjectInstanceID = objectInstanceID, .RecordSize = sizeof(struct gpio_v2_line_event) };
+
+	return DigitalInputSources_Add(sources, &source);
+}
+
+int DigitalInputSources_AddEvdevKey(DigitalInputSources * sources, int fd, uint16_t keyCode,
+	ObjectInstanceIDType objectInstanceID)
+{
+	DigitalInputSource source = { .Fd = fd, .Type = DigitalInputSourceType_EvdevKey,
+		.ObjectInstanceID = objectInstanceID, .RecordSize = sizeof(struct input_event),
+		.KeyCode = keyCode };
+
+	return DigitalInputSources_Add(sources, &source);
+}
+
+int DigitalInputSources_AddRecords(DigitalInputSources * sources, int fd, int recordSize,
+	DigitalInputRecordDecoder decoder, void * decoderContext,
+	ObjectInstanceIDType objectInstanceID)
+{
+	DigitalInputSource source = { .Fd = fd, .Type = DigitalInputSourceType_Records,
+		.ObjectInstanceID = objectInstanceID, .RecordSize = recordSize, .Decoder = decoder,
+		.DecoderContext = decoderContext };
+
+	if (decoder == NULL)
+	{
+		Lwm2m_Error("Input source %d has no decoder\n", fd);
+		return -1;
+	}
+	return DigitalInputSources_Add(sources, &source);
+}
+
+int DigitalInputSources_Remove(DigitalInputSources * sources, int fd)
+{
+	DigitalInputSource * source = sources == NULL ? NULL : DigitalInputSources_Find(sources, fd);
+
+	if (source == NULL)
+		return -1;
+
+	/* A descriptor the caller has already closed has left the epoll set by itself */
+	epoll_ctl(sources->EpollFd, EPOLL_CTL_DEL, fd, NULL);
+	*source = sources->Sources[--sources->Count];
+	return 0;
+}
+
+int DigitalInputSources_Poll(DigitalInputSources * sources, int timeoutMs)
+{
+	struct epoll_event events[DIGITAL_INPUT_SOURCE_EPOLL_EVENTS];
+	int applied = 0;
+	int ready, i;
+
+	if (sources == NULL)
+		return -1;
+
+	ready = epoll_wait(sources->EpollFd, events, DIGITAL_INPUT_SOURCE_EPOLL_EVENTS, timeoutMs);
+	if (ready == -1)
+		return errno == EINTR ? 0 : -1;
+
+	sources->MonotonicOffsetNs = 0;
+	for (i = 0; i < ready; i++)
+	{
+		DigitalInputSource * source = DigitalInputSources_Find(sources, events[i].data.fd);
+
+		if (source == NULL)
+			continue;
+
+		/* Drain what is buffered before acting on a hang up, so the last edges are not lost */
+		if (((events[i].events & EPOLLIN) &&
+			DigitalInputSources_ReadSource(sources, source, &applied) == -1) ||
+			(!(events[i].events & EPOLLIN) && (events[i].events & (EPOLLHUP | EPOLLERR))))
+		{
+			Lwm2m_Debug("Dropping input source %d of Digital Input %d\n", source->Fd,
+				source->ObjectInstanceID);
+			DigitalInputSources_Remove(sources, source->Fd);
+		}
+	}
+	return applied;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file
+ * Input sources that drive Digital Input instances from file descriptors.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_DIGITAL_INPUT_SOURCE_H_
+#define LWM2M_CLIENT_DIGITAL_INPUT_SOURCE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwm2m_core.h"
+
+/*
+ * Binds Digital Input instances to file descriptors that yield fixed-size event records, waits on
+ * them with epoll and applies each event to its instance with the time the kernel stamped on it.
+ * A set is changed and polled from one thread, which need not be the LWM2M core thread. The
+ * descriptors stay owned by the caller and must be non-blocking.
+ */
+typedef struct _DigitalInputSources DigitalInputSources;
+
+/*
+ * Turns one record read from a generic source into an input state and a time in milliseconds
+ * since the epoch, or 0 for now. Returns 1 to apply the event, 0 to skip it or -1 to drop the
+ * source.
+ */
+typedef int (*DigitalInputRecordDecoder)(void * decoderContext, const uint8_t * record,
+	bool * state, int64_t * timeMs);
+
+DigitalInputSources * DigitalInputSources_Create(Lwm2mContextType * context);
+void DigitalInputSources_Destroy(DigitalInputSources * sources);
+
+/* Line events from a GPIO character device line request; rising edges set the input */
+int DigitalInputSources_AddGpioLine(DigitalInputSources * sources, int fd,
+	ObjectInstanceIDType objectInstanceID);
+
+/* Presses and releases of one key from an evdev device; auto-repeat is ignored */
+int DigitalInputSources_AddEvdevKey(DigitalInputSources * sources, int fd, uint16_t keyCode,
+	ObjectInstanceIDType objectInstanceID);
+
+/* Any descriptor yielding recordSize byte records, such as a pipe or an eventfd in tests */
+int DigitalInputSources_AddRecords(DigitalInputSources * sources, int fd, int recordSize,
+	DigitalInputRecordDecoder decoder, void * decoderContext,
+	ObjectInstanceIDType objectInstanceID);
+
+int DigitalInputSources_Remove(DigitalInputSources * sources, int fd);
+
+/*
+ * Waits up to timeoutMs (-1 for ever) for events, then reads and applies them in batches. A
+ * source that hangs up, fails or is rejected by its decoder is removed. Returns the number of
+ * events applied, or -1 on error.
+ */
+int DigitalInputSources_Poll(DigitalInputSources * sources, int timeoutMs);
+
+#endif /* LWM2M_CLIENT_DIGITAL_INPUT_SOURCE_H_ */
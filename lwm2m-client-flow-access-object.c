@@ -43,6 +43,11 @@
 #include <string.h>
 #include "lwm2m_core.h"
 #include "coap_abstraction.h"
+#include "lwm2m-client-tlv.h"
+#include "lwm2m-client-flow-access-object.h"
+#include "lwm2m-client-resource-version.h"
+#include "lwm2m-client-state.h"
+#include "lwm2m-client-config.h"
 #include "common.h"
 
 /***************************************************************************************************
@@ -75,6 +80,9 @@ typedef struct
 	char * CustomerSecret;
 	char * RememberMeToken;
 	int64_t RememberMeTokenExpiry;
+	char * Provisioned;							/* Block shared by the provisioned values */
+	int ProvisionedSize;
+	bool Exists;
 } FlowAccessObject;
 
 /***************************************************************************************************
@@ -103,11 +111,18 @@ static int FlowAccessObject_ObjectCreateInstanceHandler(void * context, ObjectID
 static int FlowAccessObject_ObjectDeleteHandler(void * context, ObjectIDType objectID,
 	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID);
 
+static void FlowAccessObject_ClearObject(void * state);
+
 /***************************************************************************************************
  * Globals
  **************************************************************************************************/
 
-FlowAccessObject flowAccessObject;
+static const ClientStateDefinition flowAccessObjectStateDefinition =
+{
+	.Slot = ClientStateSlot_FlowAccess,
+	.Size = sizeof(FlowAccessObject),
+	.Cleanup = FlowAccessObject_ClearObject,
+};
 
 static ObjectOperationHandlers flowAccessObjectOperationHandlers =
 {
@@ -124,13 +139,35 @@ static ResourceOperationHandlers flowAccessObjectResourceOperationHandlers =
 	.Execute = NULL,
 };
 
+/* Readable resources, in the order a whole-instance read serializes them */
+static const TlvResourceType flowAccessObjectResourceTypes[] =
+{
+	{ FLOWM2M_FLOW_ACCESS_OBJECT_URL, ResourceTypeEnum_TypeString },
+	{ FLOWM2M_FLOW_ACCESS_OBJECT_CUSTOMERKEY, ResourceTypeEnum_TypeString },
+	{ FLOWM2M_FLOW_ACCESS_OBJECT_CUSTOMERSECRET, ResourceTypeEnum_TypeString },
+	{ FLOWM2M_FLOW_ACCESS_OBJECT_REMEMBERMETOKEN, ResourceTypeEnum_TypeString },
+	{ FLOWM2M_FLOW_ACCESS_OBJECT_REMEMBERMETOKENEXPIRY, ResourceTypeEnum_TypeOpaque },
+};
+
+FOOTPRINT_RECORD(FlowAccessObject)
+
 /***************************************************************************************************
  * Implementation - Private
  **************************************************************************************************/
 
+static FlowAccessObject * FlowAccessObject_GetState(void * context)
+{
+	return ClientState_Get(context, &flowAccessObjectStateDefinition);
+}
+
 static int FlowAccessObject_ObjectCreateInstanceHandler(void * context, ObjectIDType objectID,
 	ObjectInstanceIDType objectInstanceID)
 {
+	FlowAccessObject * flowAccessObject = FlowAccessObject_GetState(context);
+
+	if (flowAccessObject != NULL)
+		flowAccessObject->Exists = true;
+	ResourceVersion_StampInstance(context, objectID, objectInstanceID, false);
 	return 0;
 }
 
@@ -140,9 +177,31 @@ static int FlowAccessObject_ResourceCreateHandler(void * context, ObjectIDType o
 	return 0;
 }
 
+/* Provisioned values share one block, freed with the instance rather than one at a time */
+static void FlowAccessObject_FreeValue(const FlowAccessObject * flowAccessObject, void * value)
+{
+	if (!Provisioning_OwnsValue(flowAccessObject->Provisioned, flowAccessObject->ProvisionedSize,
+		value))
+		free(value);
+}
+
+static void FlowAccessObject_ClearObject(void * state)
+{
+	FlowAccessObject * flowAccessObject = state;
+
+	FlowAccessObject_FreeValue(flowAccessObject, flowAccessObject->URL);
+	FlowAccessObject_FreeValue(flowAccessObject, flowAccessObject->CustomerKey);
+	FlowAccessObject_FreeValue(flowAccessObject, flowAccessObject->CustomerSecret);
+	FlowAccessObject_FreeValue(flowAccessObject, flowAccessObject->RememberMeToken);
+	free(flowAccessObject->Provisioned);
+
+	memset(flowAccessObject, 0, sizeof(FlowAccessObject));
+}
+
 static int FlowAccessObject_ObjectDeleteHandler(void * context, ObjectIDType objectID,
 	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID)
 {
+	FlowAccessObject * flowAccessObject;
 
 	if (objectID != FLOWM2M_FLOW_ACCESS_OBJECT)
 	{
@@ -153,16 +212,11 @@ static int FlowAccessObject_ObjectDeleteHandler(void * context, ObjectIDType obj
 
 	if (objectInstanceID == 0)
 	{
-		memset(&flowAccessObject, 0, sizeof(FlowAccessObject));
-
-		if (flowAccessObject.URL)
-			free(flowAccessObject.URL);
-		if (flowAccessObject.CustomerKey)
-			free(flowAccessObject.CustomerKey);
-		if (flowAccessObject.CustomerSecret)
-			free(flowAccessObject.CustomerSecret);
-		if (flowAccessObject.RememberMeToken)
-			free(flowAccessObject.RememberMeToken);
+		if ((flowAccessObject = FlowAccessObject_GetState(context)) == NULL)
+			return -1;
+
+		FlowAccessObject_ClearObject(flowAccessObject);
+		ResourceVersion_StampInstance(context, objectID, objectInstanceID, true);
 	}
 	else
 	{
@@ -174,83 +228,83 @@ static int FlowAccessObject_ObjectDeleteHandler(void * context, ObjectIDType obj
 	return 0;
 }
 
-static int FlowAccessObject_ResourceReadHandler(void * context, ObjectIDType objectID,
-	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
-	ResourceInstanceIDType resourceInstanceID, uint8_t * destBuffer, int destBufferLen)
+/*
+ * Returns the length of the current value of a resource and points value at it. The pointer stays
+ * valid until the resource is next written or the instance is deleted.
+ */
+static int FlowAccessObject_GetResourceValue(const FlowAccessObject * flowAccessObject,
+	ResourceIDType resourceID, const void ** value)
 {
-	int result = 0;
-
 	switch (resourceID)
 	{
 		case FLOWM2M_FLOW_ACCESS_OBJECT_URL:
-			memcpy(destBuffer, flowAccessObject.URL, strlen(flowAccessObject.URL) + 1);
-			result = strlen(flowAccessObject.URL) + 1;
+			*value = flowAccessObject->URL;
 			break;
+
 		case FLOWM2M_FLOW_ACCESS_OBJECT_CUSTOMERKEY:
-			memcpy(destBuffer, flowAccessObject.CustomerKey,
-				strlen(flowAccessObject.CustomerKey) + 1);
-			result = strlen(flowAccessObject.CustomerKey) + 1;
+			*value = flowAccessObject->CustomerKey;
 			break;
+
 		case FLOWM2M_FLOW_ACCESS_OBJECT_CUSTOMERSECRET:
-			memcpy(destBuffer, flowAccessObject.CustomerSecret,
-				strlen(flowAccessObject.CustomerSecret) + 1);
-			result = strlen(flowAccessObject.CustomerSecret) + 1;
+			*value = flowAccessObject->CustomerSecret;
 			break;
+
 		case FLOWM2M_FLOW_ACCESS_OBJECT_REMEMBERMETOKEN:
-			memcpy(destBuffer, flowAccessObject.RememberMeToken,
-				strlen(flowAccessObject.RememberMeToken) + 1);
-			result = strlen(flowAccessObject.RememberMeToken) + 1;
+			*value = flowAccessObject->RememberMeToken;
 			break;
+
 		case FLOWM2M_FLOW_ACCESS_OBJECT_REMEMBERMETOKENEXPIRY:
-			memcpy(destBuffer, &flowAccessObject.RememberMeTokenExpiry,
-				sizeof(flowAccessObject.RememberMeTokenExpiry));
-			result = sizeof(flowAccessObject.RememberMeTokenExpiry);
-			break;
+			*value = &flowAccessObject->RememberMeTokenExpiry;
+			return sizeof(flowAccessObject->RememberMeTokenExpiry);
+
 		default:
-			result = -1;
-			break;
+			*value = NULL;
+			return -1;
 	}
 
-	return result;
+	return *value != NULL ? strlen(*value) + 1 : 0;
 }
 
-static int FlowAccessObject_ResourceGetLengthHandler(void * context, ObjectIDType objectID,
+static int FlowAccessObject_ResourceReadHandler(void * context, ObjectIDType objectID,
 	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
-	ResourceInstanceIDType resourceInstanceID)
+	ResourceInstanceIDType resourceInstanceID, uint8_t * destBuffer, int destBufferLen)
 {
-	int result = 0;
-
-	switch (resourceID)
-	{
-		case FLOWM2M_FLOW_ACCESS_OBJECT_URL:
-			if(flowAccessObject.URL != NULL)
-				result = strlen(flowAccessObject.URL) + 1;
-			break;
+	FlowAccessObject * flowAccessObject = FlowAccessObject_GetState(context);
+	const void * value;
+	int result = -1;
+	DIAGNOSTICS_START(startTime);
 
-		case FLOWM2M_FLOW_ACCESS_OBJECT_CUSTOMERKEY:
-			if(flowAccessObject.CustomerKey != NULL)
-				result = strlen(flowAccessObject.CustomerKey) + 1;
-			break;
+	if (flowAccessObject != NULL)
+		result = FlowAccessObject_GetResourceValue(flowAccessObject, resourceID, &value);
 
-		case FLOWM2M_FLOW_ACCESS_OBJECT_CUSTOMERSECRET:
-			if(flowAccessObject.CustomerSecret != NULL)
-				result = strlen(flowAccessObject.CustomerSecret) + 1;
-			break;
+	if (result > destBufferLen)
+	{
+		Lwm2m_Error("FlowAccessObject_ResourceReadHandler resource %d needs %d bytes, buffer has "
+			"%d\n", resourceID, result, destBufferLen);
+		result = -1;
+	}
+	else if (result > 0)
+	{
+		memcpy(destBuffer, value, result);
+	}
 
-		case FLOWM2M_FLOW_ACCESS_OBJECT_REMEMBERMETOKEN:
-			if(flowAccessObject.RememberMeToken != NULL)
-				result = strlen(flowAccessObject.RememberMeToken) + 1;
-			break;
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Read, result, startTime);
+	return result;
+}
 
-		case FLOWM2M_FLOW_ACCESS_OBJECT_REMEMBERMETOKENEXPIRY:
-			result = sizeof(flowAccessObject.RememberMeTokenExpiry);
-			break;
+static int FlowAccessObject_ResourceGetLengthHandler(void * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID)
+{
+	FlowAccessObject * flowAccessObject = FlowAccessObject_GetState(context);
+	const void * value;
+	int result = -1;
+	DIAGNOSTICS_START(startTime);
 
-		default:
-			result = -1;
-			break;
-	}
+	if (flowAccessObject != NULL)
+		result = FlowAccessObject_GetResourceValue(flowAccessObject, resourceID, &value);
 
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_GetLength, result, startTime);
 	return result;
 }
 
@@ -259,48 +313,59 @@ static int FlowAccessObject_ResourceWriteHandler(void * context, ObjectIDType ob
 	ResourceInstanceIDType resourceInstanceID, uint8_t * srcBuffer, int srcBufferLen,
 	bool * changed)
 {
+	FlowAccessObject * flowAccessObject = FlowAccessObject_GetState(context);
 	int result = 0;
+	DIAGNOSTICS_START(startTime);
+
+	if (flowAccessObject == NULL)
+	{
+		DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Write, -1, startTime);
+		return -1;
+	}
 
 	switch(resourceID)
 	{
 		case FLOWM2M_FLOW_ACCESS_OBJECT_URL:
-			if (flowAccessObject.URL)
-				free(flowAccessObject.URL);
-			flowAccessObject.URL = (char *)malloc(srcBufferLen + 1);
-			memset(flowAccessObject.URL, 0, srcBufferLen + 1);
-			memcpy(flowAccessObject.URL, srcBuffer, srcBufferLen);
+			FlowAccessObject_FreeValue(flowAccessObject, flowAccessObject->URL);
+			flowAccessObject->URL = (char *)malloc(srcBufferLen + 1);
+			memset(flowAccessObject->URL, 0, srcBufferLen + 1);
+			memcpy(flowAccessObject->URL, srcBuffer, srcBufferLen);
 			result = srcBufferLen;
 			break;
 
 		case FLOWM2M_FLOW_ACCESS_OBJECT_CUSTOMERKEY:
-			if (flowAccessObject.CustomerKey)
-				free(flowAccessObject.CustomerKey);
-			flowAccessObject.CustomerKey = (char *)malloc(srcBufferLen + 1);
-			memset(flowAccessObject.CustomerKey, 0, srcBufferLen + 1);
-			memcpy(flowAccessObject.CustomerKey, srcBuffer, srcBufferLen);
+			FlowAccessObject_FreeValue(flowAccessObject, flowAccessObject->CustomerKey);
+			flowAccessObject->CustomerKey = (char *)malloc(srcBufferLen + 1);
+			memset(flowAccessObject->CustomerKey, 0, srcBufferLen + 1);
+			memcpy(flowAccessObject->CustomerKey, srcBuffer, srcBufferLen);
 			result = srcBufferLen;
 			break;
 
 		case FLOWM2M_FLOW_ACCESS_OBJECT_CUSTOMERSECRET:
-			if (flowAccessObject.CustomerSecret)
-				free(flowAccessObject.CustomerSecret);
-			flowAccessObject.CustomerSecret = (char *)malloc(srcBufferLen + 1);
-			memset(flowAccessObject.CustomerSecret, 0, srcBufferLen + 1);
-			memcpy(flowAccessObject.CustomerSecret, srcBuffer, srcBufferLen);
+			FlowAccessObject_FreeValue(flowAccessObject, flowAccessObject->CustomerSecret);
+			flowAccessObject->CustomerSecret = (char *)malloc(srcBufferLen + 1);
+			memset(flowAccessObject->CustomerSecret, 0, srcBufferLen + 1);
+			memcpy(flowAccessObject->CustomerSecret, srcBuffer, srcBufferLen);
 			result = srcBufferLen;
 			break;
 
 		case FLOWM2M_FLOW_ACCESS_OBJECT_REMEMBERMETOKEN:
-			if (flowAccessObject.RememberMeToken)
-				free(flowAccessObject.RememberMeToken);
-			flowAccessObject.RememberMeToken = (char *)malloc(srcBufferLen + 1);
-			memset(flowAccessObject.RememberMeToken, 0, srcBufferLen + 1);
-			memcpy(flowAccessObject.RememberMeToken, srcBuffer, srcBufferLen);
+			FlowAccessObject_FreeValue(flowAccessObject, flowAccessObject->RememberMeToken);
+			flowAccessObject->RememberMeToken = (char *)malloc(srcBufferLen + 1);
+			memset(flowAccessObject->RememberMeToken, 0, srcBufferLen + 1);
+			memcpy(flowAccessObject->RememberMeToken, srcBuffer, srcBufferLen);
 			result = srcBufferLen;
 			break;
 
 		case FLOWM2M_FLOW_ACCESS_OBJECT_REMEMBERMETOKENEXPIRY:
-			memcpy(&flowAccessObject.RememberMeTokenExpiry, srcBuffer, srcBufferLen);
+			/* Opaque, so the server picks the length: anything longer would overrun the field */
+			if (srcBufferLen > (int)sizeof(flowAccessObject->RememberMeTokenExpiry))
+			{
+				result = -1;
+				break;
+			}
+			flowAccessObject->RememberMeTokenExpiry = 0;
+			memcpy(&flowAccessObject->RememberMeTokenExpiry, srcBuffer, srcBufferLen);
 			result = srcBufferLen;
 			break;
 
@@ -309,6 +374,10 @@ static int FlowAccessObject_ResourceWriteHandler(void * context, ObjectIDType ob
 			break;
 	}
 
+	if (result >= 0)
+		ResourceVersion_Stamp(context, objectID, objectInstanceID, resourceID);
+
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Write, result, startTime);
 	return result;
 }
 
@@ -334,3 +403,143 @@ int Lwm2m_RegisterFlowAccessObject(Lwm2mContextType * context)
 
 	return 0;
 }
+
+int Lwm2m_GetFlowAccessObjectResource(Lwm2mContextType * context, ResourceIDType resourceID,
+	const void ** value)
+{
+	FlowAccessObject * flowAccessObject = FlowAccessObject_GetState(context);
+
+	return flowAccessObject != NULL ?
+		FlowAccessObject_GetResourceValue(flowAccessObject, resourceID, value) : -1;
+}
+
+int Lwm2m_ReadFlowAccessObjectResource(Lwm2mContextType * context, ResourceIDType resourceID,
+	int offset, uint8_t * destBuffer, int destBufferLen)
+{
+	FlowAccessObject * flowAccessObject = FlowAccessObject_GetState(context);
+	const void * value;
+	int length;
+
+	if (flowAccessObject == NULL)
+		return -1;
+
+	length = FlowAccessObject_GetResourceValue(flowAccessObject, resourceID, &value);
+	if (length < 0 || offset < 0)
+		return -1;
+
+	length = offset < length ? length - offset : 0;
+	if (length > destBufferLen)
+		length = destBufferLen;
+	if (length > 0)
+		memcpy(destBuffer, (const uint8_t *)value + offset, length);
+
+	return length;
+}
+
+int Lwm2m_ReadFlowAccessObjectInstance(Lwm2mContextType * context, uint8_t * destBuffer,
+	int destBufferLen)
+{
+	const int resourceCount = sizeof(flowAccessObjectResourceTypes) /
+		sizeof(flowAccessObjectResourceTypes[0]);
+	FlowAccessObject * flowAccessObject = FlowAccessObject_GetState(context);
+	int i, length = 0;
+
+	if (flowAccessObject == NULL)
+		return -1;
+
+	for (i = 0; i < resourceCount; i++)
+	{
+		const TlvResourceType * resource = &flowAccessObjectResourceTypes[i];
+		const void * value;
+		int valueLength = FlowAccessObject_GetResourceValue(flowAccessObject,
+			resource->ResourceID, &value);
+		int result;
+
+		if (valueLength <= 0)
+			continue;
+
+		result = Tlv_EncodeResource(destBuffer + length, destBufferLen - length,
+			resource->ResourceID, resource->Type, value, valueLength);
+		if (result == -1)
+			return -1;
+		length += result;
+	}
+	return length;
+}
+
+int Lwm2m_PrepareFlowAccessProvisioning(Lwm2mContextType * context,
+	const FlowProvisioningInfo * info, ProvisioningBatch * batch)
+{
+	FlowAccessObject * flowAccessObject = FlowAccessObject_GetState(context);
+
+	memset(batch, 0, sizeof(*batch));
+	if (flowAccessObject == NULL)
+		return -1;
+
+	Provisioning_AddString(batch, FLOWM2M_FLOW_ACCESS_OBJECT_URL, info->URL,
+		flowAccessObject->URL);
+	Provisioning_AddString(batch, FLOWM2M_FLOW_ACCESS_OBJECT_CUSTOMERKEY, info->CustomerKey,
+		flowAccessObject->CustomerKey);
+	Provisioning_AddString(batch, FLOWM2M_FLOW_ACCESS_OBJECT_CUSTOMERSECRET,
+		info->CustomerSecret, flowAccessObject->CustomerSecret);
+	Provisioning_AddString(batch, FLOWM2M_FLOW_ACCESS_OBJECT_REMEMBERMETOKEN,
+		info->RememberMeToken, flowAccessObject->RememberMeToken);
+	Provisioning_AddInteger(batch, FLOWM2M_FLOW_ACCESS_OBJECT_REMEMBERMETOKENEXPIRY,
+		info->HasRememberMeTokenExpiry ? &info->RememberMeTokenExpiry : NULL,
+		flowAccessObject->RememberMeTokenExpiry);
+
+	/* Nothing to provision, so leave the object (and whether it has an instance) alone */
+	if (batch->Given == 0)
+	{
+		batch->Count = 0;
+		return 0;
+	}
+	return Provisioning_Allocate(batch);
+}
+
+int Lwm2m_CreateFlowAccessInstance(Lwm2mContextType * context, const ProvisioningBatch * batch)
+{
+	FlowAccessObject * flowAccessObject = FlowAccessObject_GetState(context);
+
+	if (batch->Given == 0)
+		return 0;
+	if (flowAccessObject == NULL)
+		return -1;
+
+	if (!flowAccessObject->Exists)
+	{
+		CREATE_OBJECT_INSTANCE(context, FLOWM2M_FLOW_ACCESS_OBJECT, 0);
+		flowAccessObject->Exists = true;
+	}
+	return 0;
+}
+
+void Lwm2m_CommitFlowAccessProvisioning(Lwm2mContextType * context, ProvisioningBatch * batch)
+{
+	FlowAccessObject * flowAccessObject = FlowAccessObject_GetState(context);
+	int64_t * expiry;
+
+	if (batch->Given == 0 || flowAccessObject == NULL)
+		return;
+
+	FlowAccessObject_FreeValue(flowAccessObject, flowAccessObject->URL);
+	flowAccessObject->URL = Provisioning_GetValue(batch, FLOWM2M_FLOW_ACCESS_OBJECT_URL);
+	FlowAccessObject_FreeValue(flowAccessObject, flowAccessObject->CustomerKey);
+	flowAccessObject->CustomerKey = Provisioning_GetValue(batch,
+		FLOWM2M_FLOW_ACCESS_OBJECT_CUSTOMERKEY);
+	FlowAccessObject_FreeValue(flowAccessObject, flowAccessObject->CustomerSecret);
+	flowAccessObject->CustomerSecret = Provisioning_GetValue(batch,
+		FLOWM2M_FLOW_ACCESS_OBJECT_CUSTOMERSECRET);
+	FlowAccessObject_FreeValue(flowAccessObject, flowAccessObject->RememberMeToken);
+	flowAccessObject->RememberMeToken = Provisioning_GetValue(batch,
+		FLOWM2M_FLOW_ACCESS_OBJECT_REMEMBERMETOKEN);
+	expiry = Provisioning_GetValue(batch, FLOWM2M_FLOW_ACCESS_OBJECT_REMEMBERMETOKENEXPIRY);
+	flowAccessObject->RememberMeTokenExpiry = *expiry;
+
+	free(flowAccessObject->Provisioned);
+	flowAccessObject->Provisioned = batch->Block;
+	flowAccessObject->ProvisionedSize = batch->BlockSize;
+	batch->Block = NULL;
+
+	Provisioning_MarkObservers(context, FLOWM2M_FLOW_ACCESS_OBJECT, 0, batch);
+}
@@ -36,6 +36,27 @@
 #ifndef LWM2M_CLIENT_FLOW_ACCESS_OBJECT_H_
 #define LWM2M_CLIENT_FLOW_ACCESS_OBJECT_H_
 
+#include "lwm2m-client-provisioning.h"
+
 int Lwm2m_RegisterFlowAccessObject(Lwm2mContextType * context);
 
+/* Zero-copy and offset reads, see Lwm2m_GetFlowObjectResource() */
+int Lwm2m_GetFlowAccessObjectResource(Lwm2mContextType * context, ResourceIDType resourceID,
+	const void ** value);
+int Lwm2m_ReadFlowAccessObjectResource(Lwm2mContextType * context, ResourceIDType resourceID,
+	int offset, uint8_t * destBuffer, int destBufferLen);
+int Lwm2m_ReadFlowAccessObjectInstance(Lwm2mContextType * context, uint8_t * destBuffer,
+	int destBufferLen);
+
+/*
+ * The Flow Access half of Lwm2m_ProvisionFlowObjects(). Prepare copies the values given into one
+ * allocation and changes nothing. CreateInstance creates the instance in the core if values were
+ * given and it does not exist yet, the one step that can fail. Commit then swaps the values in.
+ * The caller discards the batch if provisioning fails.
+ */
+int Lwm2m_PrepareFlowAccessProvisioning(Lwm2mContextType * context,
+	const FlowProvisioningInfo * info, ProvisioningBatch * batch);
+int Lwm2m_CreateFlowAccessInstance(Lwm2mContextType * context, const ProvisioningBatch * batch);
+void Lwm2m_CommitFlowAccessProvisioning(Lwm2mContextType * context, ProvisioningBatch * batch);
+
 #endif /* LWM2M_CLIENT_FLOW_ACCESS_OBJECT_H_ */
@@ -43,35 +43,30 @@
 #include <string.h>
 #include <inttypes.h>
 #include "lwm2m_core.h"
+#include "lwm2m_observers.h"
 #include "coap_abstraction.h"
 #include "hmac.h"
 #include "b64.h"
+#include "lwm2m-client-hmac-sha256.h"
+#include "lwm2m-client-licensee-hash.h"
+#include "lwm2m-client-flow-object.h"
+#include "lwm2m-client-flow-access-object.h"
+#include "lwm2m-client-tlv.h"
+#include "lwm2m-client-registration.h"
+#include "lwm2m-client-resource-version.h"
+#include "lwm2m-client-state.h"
+#include "lwm2m-client-config.h"
 #include "common.h"
 
 /***************************************************************************************************
  * Definitions
  **************************************************************************************************/
 
-#define FLOWM2M_FLOW_OBJECT							20000
-#define FLOWM2M_FLOW_OBJECT_DEVICEID				0
-#define FLOWM2M_FLOW_OBJECT_PARENTID				1
-#define FLOWM2M_FLOW_OBJECT_DEVICETYPE				2
-#define FLOWM2M_FLOW_OBJECT_NAME					3
-#define FLOWM2M_FLOW_OBJECT_DESCRIPTION				4
-#define FLOWM2M_FLOW_OBJECT_FCAP					5
-#define FLOWM2M_FLOW_OBJECT_LICENSEEID				6
-#define FLOWM2M_FLOW_OBJECT_LICENSEECHALLENGE		7
-#define FLOWM2M_FLOW_OBJECT_HASHITERATIONS			8
-#define FLOWM2M_FLOW_OBJECT_LICENSEEHASH			9
-#define FLOWM2M_FLOW_OBJECT_STATUS					10
-
 #define MAX_STRING_SIZE								64
 #define MAX_KEY_SIZE								64
 
-#define REGISTER_FLOW_OBJECT_RESOURCE(context, name, id, type, minInstances) \
-	REGISTER_RESOURCE(context, name, FLOWM2M_FLOW_OBJECT, id, type, \
-		MultipleInstancesEnum_Single, minInstances, Operations_RW, \
-		&flowObjectResourceOperationHandlers)
+#define FLOW_OBJECT_RESOURCE(name, id, type, minInstances) \
+	{ name, id, type, MultipleInstancesEnum_Single, minInstances, Operations_RW }
 
 #define CREATE_FLOW_OBJECT_OPTIONAL_RESOURCE(context, objectInstanceId, resourcId) \
 	CREATE_OPTIONAL_RESOURCE(context, FLOWM2M_FLOW_OBJECT, objectInstanceId, resourcId)
@@ -84,11 +79,17 @@ typedef struct
 {
 	void * DeviceID;
 	int DeviceIDSize;
+#if LWM2M_CLIENT_FLOW_PARENT_ID
 	void * ParentID;
 	int64_t ParentIDSize;
+#endif
 	char * DeviceType;
+#if LWM2M_CLIENT_FLOW_NAME
 	char * Name;
+#endif
+#if LWM2M_CLIENT_FLOW_DESCRIPTION
 	char * Description;
+#endif
 	char * FCAP;
 	int64_t LicenseeID;
 	void * LicenseeChallenge;
@@ -97,8 +98,33 @@ typedef struct
 	void * LicenseeHash;
 	int64_t LicenseeHashSize;
 	int64_t Status;
+	TlvCachedResource DeviceTypeTlv;			/* Freed on write, as values have no limit */
+	TlvCachedResource FCAPTlv;
+	char * Provisioned;							/* Block shared by the provisioned values */
+	int ProvisionedSize;
+	bool Exists;
 } FlowObject;
 
+/* A block-wise (CoAP Block1) write of an opaque resource in progress */
+typedef struct
+{
+	ResourceIDType ResourceID;
+	uint8_t * Buffer;
+	int TotalLength;
+	int Received;
+	bool Hashing;
+	HmacSha256StreamContext Hmac;
+	uint8_t Key[MAX_KEY_SIZE];
+	int KeyLength;
+} FlowObjectBlockWrite;
+
+/* Everything the Flow object keeps for one client */
+typedef struct
+{
+	FlowObject Object;
+	FlowObjectBlockWrite BlockWrite;
+} FlowObjectState;
+
 /***************************************************************************************************
  * Prototypes
  **************************************************************************************************/
@@ -125,12 +151,23 @@ static int FlowObject_ObjectCreateInstanceHandler(void * context, ObjectIDType o
 static int FlowObject_ObjectDeleteHandler(void * context, ObjectIDType objectID,
 	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID);
 
+static void FlowObject_AbortBlockWrite(FlowObjectBlockWrite * blockWrite);
+static void FlowObject_InitialiseState(void * state);
+static void FlowObject_CleanupState(void * state);
+
 /***************************************************************************************************
  * Globals
  **************************************************************************************************/
 
 static char licenseeSecret[MAX_STRING_SIZE] = "getATTtDsNBpBRnMsN7GoQ==";
-FlowObject flowObject;
+
+static const ClientStateDefinition flowObjectStateDefinition =
+{
+	.Slot = ClientStateSlot_Flow,
+	.Size = sizeof(FlowObjectState),
+	.Initialise = FlowObject_InitialiseState,
+	.Cleanup = FlowObject_CleanupState,
+};
 
 static ObjectOperationHandlers flowObjectOperationHandlers =
 {
@@ -147,13 +184,80 @@ static ResourceOperationHandlers flowObjectResourceOperationHandlers =
 	.Execute = NULL,
 };
 
+/* Every resource, in the order they are registered */
+static const ResourceDescriptor flowObjectResources[] =
+{
+	FLOW_OBJECT_RESOURCE("DeviceID", FLOWM2M_FLOW_OBJECT_DEVICEID, ResourceTypeEnum_TypeOpaque,
+		MandatoryEnum_Mandatory),
+#if LWM2M_CLIENT_FLOW_PARENT_ID
+	FLOW_OBJECT_RESOURCE("ParentID", FLOWM2M_FLOW_OBJECT_PARENTID, ResourceTypeEnum_TypeOpaque,
+		MandatoryEnum_Optional),
+#endif
+	FLOW_OBJECT_RESOURCE("DeviceType", FLOWM2M_FLOW_OBJECT_DEVICETYPE, ResourceTypeEnum_TypeString,
+		MandatoryEnum_Mandatory),
+#if LWM2M_CLIENT_FLOW_NAME
+	FLOW_OBJECT_RESOURCE("Name", FLOWM2M_FLOW_OBJECT_NAME, ResourceTypeEnum_TypeString,
+		MandatoryEnum_Optional),
+#endif
+#if LWM2M_CLIENT_FLOW_DESCRIPTION
+	FLOW_OBJECT_RESOURCE("Description", FLOWM2M_FLOW_OBJECT_DESCRIPTION,
+		ResourceTypeEnum_TypeString, MandatoryEnum_Optional),
+#endif
+	FLOW_OBJECT_RESOURCE("FCAP", FLOWM2M_FLOW_OBJECT_FCAP, ResourceTypeEnum_TypeString,
+		MandatoryEnum_Mandatory),
+	FLOW_OBJECT_RESOURCE("LicenseeID", FLOWM2M_FLOW_OBJECT_LICENSEEID,
+		ResourceTypeEnum_TypeInteger, MandatoryEnum_Mandatory),
+	FLOW_OBJECT_RESOURCE("LicenseeChallenge", FLOWM2M_FLOW_OBJECT_LICENSEECHALLENGE,
+		ResourceTypeEnum_TypeOpaque, MandatoryEnum_Optional),
+	FLOW_OBJECT_RESOURCE("HashIterations", FLOWM2M_FLOW_OBJECT_HASHITERATIONS,
+		ResourceTypeEnum_TypeInteger, MandatoryEnum_Optional),
+	FLOW_OBJECT_RESOURCE("LicenseeHash", FLOWM2M_FLOW_OBJECT_LICENSEEHASH,
+		ResourceTypeEnum_TypeOpaque, MandatoryEnum_Optional),
+	FLOW_OBJECT_RESOURCE("Status", FLOWM2M_FLOW_OBJECT_STATUS, ResourceTypeEnum_TypeInteger,
+		MandatoryEnum_Optional),
+};
+
+/* Readable resources, in the order a whole-instance read serializes them */
+static const TlvResourceType flowObjectResourceTypes[] =
+{
+	{ FLOWM2M_FLOW_OBJECT_DEVICEID, ResourceTypeEnum_TypeOpaque },
+#if LWM2M_CLIENT_FLOW_PARENT_ID
+	{ FLOWM2M_FLOW_OBJECT_PARENTID, ResourceTypeEnum_TypeOpaque },
+#endif
+	{ FLOWM2M_FLOW_OBJECT_DEVICETYPE, ResourceTypeEnum_TypeString },
+#if LWM2M_CLIENT_FLOW_NAME
+	{ FLOWM2M_FLOW_OBJECT_NAME, ResourceTypeEnum_TypeString },
+#endif
+#if LWM2M_CLIENT_FLOW_DESCRIPTION
+	{ FLOWM2M_FLOW_OBJECT_DESCRIPTION, ResourceTypeEnum_TypeString },
+#endif
+	{ FLOWM2M_FLOW_OBJECT_FCAP, ResourceTypeEnum_TypeString },
+	{ FLOWM2M_FLOW_OBJECT_LICENSEEID, ResourceTypeEnum_TypeInteger },
+	{ FLOWM2M_FLOW_OBJECT_LICENSEECHALLENGE, ResourceTypeEnum_TypeOpaque },
+	{ FLOWM2M_FLOW_OBJECT_HASHITERATIONS, ResourceTypeEnum_TypeInteger },
+	{ FLOWM2M_FLOW_OBJECT_LICENSEEHASH, ResourceTypeEnum_TypeOpaque },
+	{ FLOWM2M_FLOW_OBJECT_STATUS, ResourceTypeEnum_TypeInteger },
+};
+
+FOOTPRINT_RECORD(FlowObjectState)
+
 /***************************************************************************************************
  * Implementation - Private
  **************************************************************************************************/
 
+static FlowObjectState * FlowObject_GetState(void * context)
+{
+	return ClientState_Get(context, &flowObjectStateDefinition);
+}
+
 static int FlowObject_ObjectCreateInstanceHandler(void * context, ObjectIDType objectID,
 	ObjectInstanceIDType objectInstanceID)
 {
+	FlowObjectState * state = FlowObject_GetState(context);
+
+	if (state != NULL)
+		state->Object.Exists = true;
+	ResourceVersion_StampInstance(context, objectID, objectInstanceID, false);
 	return 0;
 }
 
@@ -163,9 +267,51 @@ static int FlowObject_ResourceCreateHandler(void * context, ObjectIDType objectI
 	return 0;
 }
 
+/* Provisioned values share one block, freed with the instance rather than one at a time */
+static void FlowObject_FreeValue(const FlowObject * flowObject, void * value)
+{
+	if (!Provisioning_OwnsValue(flowObject->Provisioned, flowObject->ProvisionedSize, value))
+		free(value);
+}
+
+static void FlowObject_ClearObject(FlowObject * flowObject)
+{
+	FlowObject_FreeValue(flowObject, flowObject->DeviceID);
+#if LWM2M_CLIENT_FLOW_PARENT_ID
+	FlowObject_FreeValue(flowObject, flowObject->ParentID);
+#endif
+	FlowObject_FreeValue(flowObject, flowObject->DeviceType);
+#if LWM2M_CLIENT_FLOW_NAME
+	FlowObject_FreeValue(flowObject, flowObject->Name);
+#endif
+#if LWM2M_CLIENT_FLOW_DESCRIPTION
+	FlowObject_FreeValue(flowObject, flowObject->Description);
+#endif
+	FlowObject_FreeValue(flowObject, flowObject->FCAP);
+	FlowObject_FreeValue(flowObject, flowObject->LicenseeChallenge);
+	FlowObject_FreeValue(flowObject, flowObject->LicenseeHash);
+	free(flowObject->Provisioned);
+	Tlv_FreeCachedResource(&flowObject->DeviceTypeTlv);
+	Tlv_FreeCachedResource(&flowObject->FCAPTlv);
+
+	memset(flowObject, 0, sizeof(FlowObject));
+}
+
+static void FlowObject_InitialiseState(void * state)
+{
+	((FlowObjectState *)state)->BlockWrite.ResourceID = -1;
+}
+
+static void FlowObject_CleanupState(void * state)
+{
+	FlowObject_ClearObject(&((FlowObjectState *)state)->Object);
+	FlowObject_AbortBlockWrite(&((FlowObjectState *)state)->BlockWrite);
+}
+
 static int FlowObject_ObjectDeleteHandler(void * context, ObjectIDType objectID,
 	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID)
 {
+	FlowObjectState * state;
 
 	if (objectID != FLOWM2M_FLOW_OBJECT)
 	{
@@ -176,24 +322,12 @@ static int FlowObject_ObjectDeleteHandler(void * context, ObjectIDType objectID,
 
 	if (objectInstanceID == 0)
 	{
-		memset(&flowObject, 0, sizeof(FlowObject));
-
-		if(flowObject.DeviceID)
-			free(flowObject.DeviceID);
-		if(flowObject.ParentID)
-			free(flowObject.ParentID);
-		if(flowObject.DeviceType)
-			free(flowObject.DeviceType);
-		if(flowObject.Name)
-			free(flowObject.Name);
-		if(flowObject.Description)
-			free(flowObject.Description);
-		if(flowObject.FCAP)
-			free(flowObject.FCAP);
-		if(flowObject.LicenseeChallenge)
-			free(flowObject.LicenseeChallenge);
-		if(flowObject.LicenseeHash)
-			free(flowObject.LicenseeHash);
+		if ((state = FlowObject_GetState(context)) == NULL)
+			return -1;
+
+		FlowObject_ClearObject(&state->Object);
+		FlowObject_AbortBlockWrite(&state->BlockWrite);
+		ResourceVersion_StampInstance(context, objectID, objectInstanceID, true);
 	}
 	else
 	{
@@ -204,277 +338,367 @@ static int FlowObject_ObjectDeleteHandler(void * context, ObjectIDType objectID,
 	return 0;
 }
 
-static int FlowObject_ResourceReadHandler(void * context, ObjectIDType objectID,
-	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
-	ResourceInstanceIDType resourceInstanceID, uint8_t * destBuffer, int destBufferLen)
+/*
+ * Returns the length of the current value of a resource and points value at it. The pointer stays
+ * valid until the resource is next written or the instance is deleted.
+ */
+static int FlowObject_GetResourceValue(const FlowObject * flowObject, ResourceIDType resourceID,
+	const void ** value)
 {
 	int result = 0;
 
+	*value = NULL;
+
 	switch (resourceID)
 	{
 		case FLOWM2M_FLOW_OBJECT_DEVICEID:
-			if(flowObject.DeviceID != NULL)
-			{
-				memcpy(destBuffer, flowObject.DeviceID, flowObject.DeviceIDSize);
-				result = flowObject.DeviceIDSize;
-			}
+			*value = flowObject->DeviceID;
+			result = flowObject->DeviceIDSize;
 			break;
 
+#if LWM2M_CLIENT_FLOW_PARENT_ID
 		case FLOWM2M_FLOW_OBJECT_PARENTID:
-			if(flowObject.ParentID != NULL)
-			{
-				memcpy(destBuffer, flowObject.ParentID, flowObject.ParentIDSize);
-				result = flowObject.ParentIDSize;
-			}
+			*value = flowObject->ParentID;
+			result = flowObject->ParentIDSize;
 			break;
+#endif
 
 		case FLOWM2M_FLOW_OBJECT_DEVICETYPE:
-			if(flowObject.DeviceType != NULL)
-			{
-				memcpy(destBuffer, flowObject.DeviceType, strlen(flowObject.DeviceType) + 1);
-				result = strlen(flowObject.DeviceType);
-			}
+			*value = flowObject->DeviceType;
 			break;
 
+#if LWM2M_CLIENT_FLOW_NAME
 		case FLOWM2M_FLOW_OBJECT_NAME:
-			if(flowObject.Name != NULL)
-			{
-				memcpy(destBuffer, flowObject.Name, strlen(flowObject.Name) + 1);
-				result = strlen(flowObject.Name) + 1;
-			}
+			*value = flowObject->Name;
 			break;
+#endif
 
+#if LWM2M_CLIENT_FLOW_DESCRIPTION
 		case FLOWM2M_FLOW_OBJECT_DESCRIPTION:
-			if(flowObject.Description != NULL)
-			{
-				memcpy(destBuffer, flowObject.Description, strlen(flowObject.Description) + 1);
-				result = strlen(flowObject.Description) + 1;
-			}
+			*value = flowObject->Description;
 			break;
+#endif
 
 		case FLOWM2M_FLOW_OBJECT_FCAP:
-			if(flowObject.FCAP != NULL)
-			{
-				memcpy(destBuffer, flowObject.FCAP, strlen(flowObject.FCAP) + 1);
-				result = strlen(flowObject.FCAP) + 1;
-			}
+			*value = flowObject->FCAP;
 			break;
 
 		case FLOWM2M_FLOW_OBJECT_LICENSEEID:
-			memcpy(destBuffer, &flowObject.LicenseeID, sizeof(flowObject.LicenseeID));
-			result = sizeof(flowObject.LicenseeID);
+			*value = &flowObject->LicenseeID;
+			result = sizeof(flowObject->LicenseeID);
 			break;
 
 		case FLOWM2M_FLOW_OBJECT_LICENSEECHALLENGE:
-			if(flowObject.LicenseeChallenge != NULL)
-			{
-				memcpy(destBuffer, flowObject.LicenseeChallenge, flowObject.LicenseeChallengeSize);
-				result = flowObject.LicenseeChallengeSize;
-			}
+			*value = flowObject->LicenseeChallenge;
+			result = flowObject->LicenseeChallengeSize;
 			break;
 
 		case FLOWM2M_FLOW_OBJECT_HASHITERATIONS:
-			memcpy(destBuffer, &flowObject.HashIterations, sizeof(flowObject.HashIterations));
-			result = sizeof(flowObject.HashIterations);
+			*value = &flowObject->HashIterations;
+			result = sizeof(flowObject->HashIterations);
 			break;
 
 		case FLOWM2M_FLOW_OBJECT_LICENSEEHASH:
-			if(flowObject.LicenseeHash != NULL)
-			{
-				memcpy(destBuffer, flowObject.LicenseeHash, flowObject.LicenseeHashSize);
-				result = flowObject.LicenseeHashSize;
-			}
+			*value = flowObject->LicenseeHash;
+			result = flowObject->LicenseeHashSize;
 			break;
 
 		case FLOWM2M_FLOW_OBJECT_STATUS:
-			memcpy(destBuffer, &flowObject.Status, sizeof(flowObject.Status));
-			result = sizeof(flowObject.Status);
+			*value = &flowObject->Status;
+			result = sizeof(flowObject->Status);
 			break;
 
 		default:
-			result = -1;
-			break;
+			return -1;
 	}
 
-	return result;
-}
-
-static int FlowObject_ResourceGetLengthHandler(void * context, ObjectIDType objectID,
-	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
-	ResourceInstanceIDType resourceInstanceID)
-{
-	int result = 0;
+	if (*value == NULL)
+		return 0;
 
 	switch (resourceID)
 	{
-		case FLOWM2M_FLOW_OBJECT_DEVICEID:
-			result = flowObject.DeviceIDSize;
-			break;
-
-		case FLOWM2M_FLOW_OBJECT_PARENTID:
-			result = flowObject.ParentIDSize;
-			break;
-
 		case FLOWM2M_FLOW_OBJECT_DEVICETYPE:
-			if(flowObject.DeviceType != NULL)
-				result = strlen(flowObject.DeviceType) + 1;
-			break;
-
 		case FLOWM2M_FLOW_OBJECT_NAME:
-			if(flowObject.Name != NULL)
-				result = strlen(flowObject.Name) + 1;
-			break;
-
 		case FLOWM2M_FLOW_OBJECT_DESCRIPTION:
-			if(flowObject.Description != NULL)
-				result = strlen(flowObject.Description) + 1;
-			break;
-
 		case FLOWM2M_FLOW_OBJECT_FCAP:
-			if(flowObject.FCAP != NULL)
-				result = strlen(flowObject.FCAP) + 1;
-			break;
-
-		case FLOWM2M_FLOW_OBJECT_LICENSEEID:
-			result = sizeof(flowObject.LicenseeID);
+			result = strlen(*value) + 1;
 			break;
 
-		case FLOWM2M_FLOW_OBJECT_LICENSEECHALLENGE:
-			result = flowObject.LicenseeChallengeSize;
+		default:
 			break;
+	}
 
-		case FLOWM2M_FLOW_OBJECT_HASHITERATIONS:
-			result = sizeof(flowObject.HashIterations);
-			break;
+	return result;
+}
 
-		case FLOWM2M_FLOW_OBJECT_LICENSEEHASH:
-			result = flowObject.LicenseeHashSize;
-			break;
+/* Resources that almost never change keep their encoded TLV record between reads */
+static TlvCachedResource * FlowObject_GetResourceCache(FlowObject * flowObject,
+	ResourceIDType resourceID)
+{
+	switch (resourceID)
+	{
+		case FLOWM2M_FLOW_OBJECT_DEVICETYPE:
+			return &flowObject->DeviceTypeTlv;
 
-		case FLOWM2M_FLOW_OBJECT_STATUS:
-			result = sizeof(flowObject.Status);
-			break;
+		case FLOWM2M_FLOW_OBJECT_FCAP:
+			return &flowObject->FCAPTlv;
 
 		default:
-			result = -1;
-			break;
+			return NULL;
 	}
+}
 
+static int FlowObject_ResourceReadHandler(void * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID, uint8_t * destBuffer, int destBufferLen)
+{
+	FlowObjectState * state = FlowObject_GetState(context);
+	const void * value;
+	int result = -1;
+	DIAGNOSTICS_START(startTime);
+
+	if (state != NULL)
+		result = FlowObject_GetResourceValue(&state->Object, resourceID, &value);
+
+	if (result > destBufferLen)
+	{
+		Lwm2m_Error("FlowObject_ResourceReadHandler resource %d needs %d bytes, buffer has %d\n",
+			resourceID, result, destBufferLen);
+		result = -1;
+	}
+	else if (result > 0)
+	{
+		memcpy(destBuffer, value, result);
+	}
+
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Read, result, startTime);
+	return result;
+}
+
+static int FlowObject_ResourceGetLengthHandler(void * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID)
+{
+	FlowObjectState * state = FlowObject_GetState(context);
+	const void * value;
+	int result = -1;
+	DIAGNOSTICS_START(startTime);
+
+	if (state != NULL)
+		result = FlowObject_GetResourceValue(&state->Object, resourceID, &value);
+
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_GetLength, result, startTime);
 	return result;
 }
 
+static int DecodeLicenseeSecret(const char * licenseeSecret, uint8_t key[MAX_KEY_SIZE])
+{
+	return b64Decode(key, MAX_KEY_SIZE, licenseeSecret, strlen(licenseeSecret));
+}
+
 static bool CalculateLicenseeHash(char * licenseeSecret, uint8_t hash[SHA256_HASH_LENGTH],
 	const char * challenge, int challengeLength, int iterations)
 {
-	int i;
 	uint8_t key[MAX_KEY_SIZE];
-	int keyLen = b64Decode(key, sizeof(key), licenseeSecret, strlen(licenseeSecret));
+	int keyLen = DecodeLicenseeSecret(licenseeSecret, key);
 
 	if (keyLen == -1)
 	{
 		return false;
 	}
 
-	HmacSha256_ComputeHash(hash, challenge, challengeLength, key, keyLen);
-	for (i = 1; i < iterations; i++)
+	LicenseeHash_Compute(key, keyLen, challenge, challengeLength, iterations, hash);
+	return true;
+}
+
+static int FlowObject_PublishLicenseeHash(void * context, uint8_t hash[SHA256_HASH_LENGTH])
+{
+	Lwm2m_Debug("Calculated hash, writing Licensee Hash resource...\n");
+	if (Lwm2mCore_SetResourceInstanceValue(context, FLOWM2M_FLOW_OBJECT, 0,
+		FLOWM2M_FLOW_OBJECT_LICENSEEHASH, 0, hash, SHA256_HASH_LENGTH) == -1)
 	{
-		HmacSha256_ComputeHash(hash, hash, SHA256_HASH_LENGTH, key, keyLen);
+		Lwm2m_Error("Failed to set Licensee Hash\n");
+		return -1;
 	}
-	return true;
+	return 0;
+}
+
+static void FlowObject_AbortBlockWrite(FlowObjectBlockWrite * blockWrite)
+{
+	if (blockWrite->Buffer)
+		free(blockWrite->Buffer);
+	memset(blockWrite, 0, sizeof(FlowObjectBlockWrite));
+	blockWrite->ResourceID = -1;
+}
+
+/* Moves a completed block-wise transfer into the object, taking ownership of its buffer */
+static int FlowObject_CompleteBlockWrite(void * context, FlowObjectState * state)
+{
+	FlowObject * flowObject = &state->Object;
+	FlowObjectBlockWrite * blockWrite = &state->BlockWrite;
+	void ** value;
+	int result = 0;
+
+	switch (blockWrite->ResourceID)
+	{
+		case FLOWM2M_FLOW_OBJECT_DEVICEID:
+			value = &flowObject->DeviceID;
+			flowObject->DeviceIDSize = blockWrite->TotalLength;
+			break;
+
+#if LWM2M_CLIENT_FLOW_PARENT_ID
+		case FLOWM2M_FLOW_OBJECT_PARENTID:
+			value = &flowObject->ParentID;
+			flowObject->ParentIDSize = blockWrite->TotalLength;
+			break;
+#endif
+
+		case FLOWM2M_FLOW_OBJECT_LICENSEECHALLENGE:
+			value = &flowObject->LicenseeChallenge;
+			flowObject->LicenseeChallengeSize = blockWrite->TotalLength;
+			break;
+
+		default:
+			value = &flowObject->LicenseeHash;
+			flowObject->LicenseeHashSize = blockWrite->TotalLength;
+			break;
+	}
+
+	FlowObject_FreeValue(flowObject, *value);
+	*value = blockWrite->Buffer;
+	blockWrite->Buffer = NULL;
+	Lwm2m_MarkObserversChanged(context, FLOWM2M_FLOW_OBJECT, 0, blockWrite->ResourceID, *value,
+		blockWrite->TotalLength);
+	ResourceVersion_Stamp(context, FLOWM2M_FLOW_OBJECT, 0, blockWrite->ResourceID);
+
+	if (blockWrite->ResourceID == FLOWM2M_FLOW_OBJECT_LICENSEECHALLENGE &&
+		flowObject->HashIterations > 0)
+	{
+		uint8_t licenseeHash[SHA256_HASH_LENGTH];
+
+		if (blockWrite->Hashing)
+		{
+			/* The first round was hashed while the challenge arrived */
+			Lwm2m_Debug("Completing licensee hash with %d iterations...\n",
+				(int)flowObject->HashIterations);
+			HmacSha256Stream_Final(&blockWrite->Hmac, licenseeHash);
+			LicenseeHash_Iterate(licenseeHash, blockWrite->Key, blockWrite->KeyLength,
+				flowObject->HashIterations);
+			result = FlowObject_PublishLicenseeHash(context, licenseeHash);
+		}
+		else
+		{
+			Lwm2m_Error("Licensee secret is invalid\n");
+			result = -1;
+		}
+	}
+
+	FlowObject_AbortBlockWrite(blockWrite);
+	return result;
 }
 
 static int FlowObject_ResourceWriteHandler(void * context, ObjectIDType objectID,
 	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
 	ResourceInstanceIDType resourceInstanceID, uint8_t * srcBuffer, int srcBufferLen, bool * changed)
 {
+	FlowObjectState * state = FlowObject_GetState(context);
+	FlowObject * flowObject;
 	int result;
+	DIAGNOSTICS_START(startTime);
+
+	if (state == NULL)
+	{
+		DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Write, -1, startTime);
+		return -1;
+	}
+	flowObject = &state->Object;
 
 	switch(resourceID)
 	{
 		case FLOWM2M_FLOW_OBJECT_DEVICEID:
-			if(flowObject.DeviceID)
-				free(flowObject.DeviceID);
-			flowObject.DeviceID = malloc(srcBufferLen);
-			memcpy(flowObject.DeviceID, srcBuffer, srcBufferLen);
-			result = flowObject.DeviceIDSize = srcBufferLen;
+			FlowObject_FreeValue(flowObject, flowObject->DeviceID);
+			flowObject->DeviceID = malloc(srcBufferLen);
+			memcpy(flowObject->DeviceID, srcBuffer, srcBufferLen);
+			result = flowObject->DeviceIDSize = srcBufferLen;
 			break;
 
+#if LWM2M_CLIENT_FLOW_PARENT_ID
 		case FLOWM2M_FLOW_OBJECT_PARENTID:
-			if(flowObject.ParentID)
-				free(flowObject.ParentID);
-			flowObject.ParentID = malloc(srcBufferLen);
-			memcpy(flowObject.ParentID, srcBuffer, srcBufferLen);
-			result = flowObject.ParentIDSize = srcBufferLen;
+			FlowObject_FreeValue(flowObject, flowObject->ParentID);
+			flowObject->ParentID = malloc(srcBufferLen);
+			memcpy(flowObject->ParentID, srcBuffer, srcBufferLen);
+			result = flowObject->ParentIDSize = srcBufferLen;
 			break;
+#endif
 
 		case FLOWM2M_FLOW_OBJECT_DEVICETYPE:
-			if(flowObject.DeviceType)
-				free(flowObject.DeviceType);
-			flowObject.DeviceType = malloc(srcBufferLen + 1);
-			memset(flowObject.DeviceType, 0, srcBufferLen + 1);
-			memcpy(flowObject.DeviceType, srcBuffer, srcBufferLen);
-			Lwm2m_Debug("Device type: %s\n", flowObject.DeviceType);
+			FlowObject_FreeValue(flowObject, flowObject->DeviceType);
+			flowObject->DeviceType = malloc(srcBufferLen + 1);
+			memset(flowObject->DeviceType, 0, srcBufferLen + 1);
+			memcpy(flowObject->DeviceType, srcBuffer, srcBufferLen);
+			Lwm2m_Debug("Device type: %s\n", flowObject->DeviceType);
+			Tlv_FreeCachedResource(&flowObject->DeviceTypeTlv);
 			result = srcBufferLen;
 			break;
 
+#if LWM2M_CLIENT_FLOW_NAME
 		case FLOWM2M_FLOW_OBJECT_NAME:
-			if(flowObject.Name)
-				free(flowObject.Name);
-			flowObject.Name = malloc(srcBufferLen + 1);
-			memset(flowObject.Name, 0, srcBufferLen + 1);
-			memcpy(flowObject.Name, srcBuffer, srcBufferLen);
+			FlowObject_FreeValue(flowObject, flowObject->Name);
+			flowObject->Name = malloc(srcBufferLen + 1);
+			memset(flowObject->Name, 0, srcBufferLen + 1);
+			memcpy(flowObject->Name, srcBuffer, srcBufferLen);
 			result = srcBufferLen;
 			break;
+#endif
 
+#if LWM2M_CLIENT_FLOW_DESCRIPTION
 		case FLOWM2M_FLOW_OBJECT_DESCRIPTION:
-			if(flowObject.Description)
-				free(flowObject.Description);
-			flowObject.Description = malloc(srcBufferLen + 1);
-			memset(flowObject.Description, 0, srcBufferLen + 1);
-			memcpy(flowObject.Description, srcBuffer, srcBufferLen);
+			FlowObject_FreeValue(flowObject, flowObject->Description);
+			flowObject->Description = malloc(srcBufferLen + 1);
+			memset(flowObject->Description, 0, srcBufferLen + 1);
+			memcpy(flowObject->Description, srcBuffer, srcBufferLen);
 			result = srcBufferLen;
 			break;
+#endif
 
 		case FLOWM2M_FLOW_OBJECT_FCAP:
-			if(flowObject.FCAP)
-				free(flowObject.FCAP);
-			flowObject.FCAP = malloc(srcBufferLen + 1);
-			memset(flowObject.FCAP, 0, srcBufferLen + 1);
-			memcpy(flowObject.FCAP, srcBuffer, srcBufferLen);
-			Lwm2m_Error("FCAP: %s\n", flowObject.FCAP);
+			FlowObject_FreeValue(flowObject, flowObject->FCAP);
+			flowObject->FCAP = malloc(srcBufferLen + 1);
+			memset(flowObject->FCAP, 0, srcBufferLen + 1);
+			memcpy(flowObject->FCAP, srcBuffer, srcBufferLen);
+			Lwm2m_Debug("FCAP: %s\n", flowObject->FCAP);
+			Tlv_FreeCachedResource(&flowObject->FCAPTlv);
 			result = srcBufferLen;
 			break;
 
 		case FLOWM2M_FLOW_OBJECT_LICENSEEID:
-			memcpy(&flowObject.LicenseeID, srcBuffer, srcBufferLen);
+			memcpy(&flowObject->LicenseeID, srcBuffer, srcBufferLen);
 			result = srcBufferLen;
 			break;
 
 		case FLOWM2M_FLOW_OBJECT_LICENSEECHALLENGE:
-			if(flowObject.LicenseeChallenge)
-				free(flowObject.LicenseeChallenge);
-			flowObject.LicenseeChallenge = malloc(srcBufferLen);
-			memcpy(flowObject.LicenseeChallenge, srcBuffer, srcBufferLen);
-			result = flowObject.LicenseeChallengeSize = srcBufferLen;
+			FlowObject_FreeValue(flowObject, flowObject->LicenseeChallenge);
+			flowObject->LicenseeChallenge = malloc(srcBufferLen);
+			memcpy(flowObject->LicenseeChallenge, srcBuffer, srcBufferLen);
+			result = flowObject->LicenseeChallengeSize = srcBufferLen;
 			break;
 
 		case FLOWM2M_FLOW_OBJECT_HASHITERATIONS:
-			memcpy(&flowObject.HashIterations, srcBuffer, srcBufferLen);
+			memcpy(&flowObject->HashIterations, srcBuffer, srcBufferLen);
 			result = srcBufferLen;
 			break;
 
 		case FLOWM2M_FLOW_OBJECT_LICENSEEHASH:
-			if(flowObject.LicenseeHash)
-				free(flowObject.LicenseeHash);
-			flowObject.LicenseeHash = malloc(srcBufferLen);
-			memcpy(flowObject.LicenseeHash, srcBuffer, srcBufferLen);
-			result = flowObject.LicenseeHashSize = srcBufferLen;
+			FlowObject_FreeValue(flowObject, flowObject->LicenseeHash);
+			flowObject->LicenseeHash = malloc(srcBufferLen);
+			memcpy(flowObject->LicenseeHash, srcBuffer, srcBufferLen);
+			result = flowObject->LicenseeHashSize = srcBufferLen;
 			*changed = true;
 			break;
 
 		case FLOWM2M_FLOW_OBJECT_STATUS:
-			memcpy(&flowObject.Status, srcBuffer, srcBufferLen);
-			Lwm2m_Debug("Status: %d\n", (int)flowObject.Status);
+			memcpy(&flowObject->Status, srcBuffer, srcBufferLen);
+			Lwm2m_Debug("Status: %d\n", (int)flowObject->Status);
 			result = srcBufferLen;
 			break;
 
@@ -483,38 +707,131 @@ static int FlowObject_ResourceWriteHandler(void * context, ObjectIDType objectID
 			break;
 	}
 
-	if(flowObject.HashIterations > 0 &&
-		flowObject.LicenseeChallengeSize > 0 &&
-		flowObject.LicenseeChallenge != NULL &&
+	if (result >= 0)
+		ResourceVersion_Stamp(context, objectID, objectInstanceID, resourceID);
+
+	if(flowObject->HashIterations > 0 &&
+		flowObject->LicenseeChallengeSize > 0 &&
+		flowObject->LicenseeChallenge != NULL &&
 		(resourceID == FLOWM2M_FLOW_OBJECT_HASHITERATIONS ||
 		(resourceID == FLOWM2M_FLOW_OBJECT_LICENSEECHALLENGE)))
 	{
 		uint8_t licenseeHash[SHA256_HASH_LENGTH];
 
 		Lwm2m_Debug("Calculating licensee hash with %d iterations...\n",
-			(int)flowObject.HashIterations);
+			(int)flowObject->HashIterations);
 
-		if (CalculateLicenseeHash(licenseeSecret, licenseeHash, flowObject.LicenseeChallenge,
-			flowObject.LicenseeChallengeSize, flowObject.HashIterations))
+		if (CalculateLicenseeHash(licenseeSecret, licenseeHash, flowObject->LicenseeChallenge,
+			flowObject->LicenseeChallengeSize, flowObject->HashIterations))
 		{
-			Lwm2m_Debug("Calculated hash, writing Licensee Hash resource...\n");
-			if (Lwm2mCore_SetResourceInstanceValue(context, FLOWM2M_FLOW_OBJECT, 0,
-				FLOWM2M_FLOW_OBJECT_LICENSEEHASH, 0, licenseeHash, sizeof(licenseeHash)) == -1)
-			{
-				Lwm2m_Error("Failed to set Licensee Hash\n");
-				return -1;
-			}
+			if (FlowObject_PublishLicenseeHash(context, licenseeHash) == -1)
+				result = -1;
 		}
 		else
 		{
 			Lwm2m_Error("Licensee secret is invalid\n");
-			return -1;
+			result = -1;
 		}
 	}
 
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Write, result, startTime);
 	return result;
 }
 
+/* Stages the provisioned Flow values, keeping the current value of any not given */
+static int FlowObject_PrepareProvisioning(const FlowObject * flowObject,
+	const FlowProvisioningInfo * info, ProvisioningBatch * batch)
+{
+	memset(batch, 0, sizeof(*batch));
+#if LWM2M_CLIENT_FLOW_PARENT_ID
+	Provisioning_AddOpaque(batch, FLOWM2M_FLOW_OBJECT_PARENTID, info->ParentID,
+		info->ParentIDLength, flowObject->ParentID, flowObject->ParentIDSize);
+#endif
+	Provisioning_AddString(batch, FLOWM2M_FLOW_OBJECT_DEVICETYPE, info->DeviceType,
+		flowObject->DeviceType);
+#if LWM2M_CLIENT_FLOW_NAME
+	Provisioning_AddString(batch, FLOWM2M_FLOW_OBJECT_NAME, info->Name, flowObject->Name);
+#endif
+#if LWM2M_CLIENT_FLOW_DESCRIPTION
+	Provisioning_AddString(batch, FLOWM2M_FLOW_OBJECT_DESCRIPTION, info->Description,
+		flowObject->Description);
+#endif
+	Provisioning_AddString(batch, FLOWM2M_FLOW_OBJECT_FCAP, info->FCAP, flowObject->FCAP);
+	Provisioning_AddInteger(batch, FLOWM2M_FLOW_OBJECT_LICENSEEID,
+		info->HasLicenseeID ? &info->LicenseeID : NULL, flowObject->LicenseeID);
+
+	return Provisioning_Allocate(batch);
+}
+
+static int FlowObject_CreateInstance(Lwm2mContextType * context, FlowObject * flowObject)
+{
+	if (!flowObject->Exists)
+	{
+		CREATE_OBJECT_INSTANCE(context, FLOWM2M_FLOW_OBJECT, 0);
+		flowObject->Exists = true;
+	}
+	return 0;
+}
+
+/* Creates each optional resource getting its first value in the core */
+static int FlowObject_CreateProvisionedResources(Lwm2mContextType * context,
+	FlowObject * flowObject, const ProvisioningBatch * batch)
+{
+#if LWM2M_CLIENT_FLOW_PARENT_ID || LWM2M_CLIENT_FLOW_NAME || LWM2M_CLIENT_FLOW_DESCRIPTION
+	ObjectInstanceIDType objectInstanceID = 0;
+#endif
+
+#if LWM2M_CLIENT_FLOW_PARENT_ID
+	if (flowObject->ParentID == NULL &&
+		Provisioning_GetValue(batch, FLOWM2M_FLOW_OBJECT_PARENTID) != NULL)
+		CREATE_FLOW_OBJECT_OPTIONAL_RESOURCE(context, objectInstanceID,
+			FLOWM2M_FLOW_OBJECT_PARENTID);
+#endif
+#if LWM2M_CLIENT_FLOW_NAME
+	if (flowObject->Name == NULL && Provisioning_GetValue(batch, FLOWM2M_FLOW_OBJECT_NAME) != NULL)
+		CREATE_FLOW_OBJECT_OPTIONAL_RESOURCE(context, objectInstanceID, FLOWM2M_FLOW_OBJECT_NAME);
+#endif
+#if LWM2M_CLIENT_FLOW_DESCRIPTION
+	if (flowObject->Description == NULL &&
+		Provisioning_GetValue(batch, FLOWM2M_FLOW_OBJECT_DESCRIPTION) != NULL)
+		CREATE_FLOW_OBJECT_OPTIONAL_RESOURCE(context, objectInstanceID,
+			FLOWM2M_FLOW_OBJECT_DESCRIPTION);
+#endif
+	return 0;
+}
+
+/* Swaps the staged values in. The object takes ownership of the batch's block */
+static void FlowObject_CommitProvisioning(FlowObject * flowObject, ProvisioningBatch * batch)
+{
+#if LWM2M_CLIENT_FLOW_PARENT_ID
+	FlowObject_FreeValue(flowObject, flowObject->ParentID);
+	flowObject->ParentID = Provisioning_GetValue(batch, FLOWM2M_FLOW_OBJECT_PARENTID);
+	flowObject->ParentIDSize = Provisioning_GetLength(batch, FLOWM2M_FLOW_OBJECT_PARENTID);
+#endif
+	FlowObject_FreeValue(flowObject, flowObject->DeviceType);
+	flowObject->DeviceType = Provisioning_GetValue(batch, FLOWM2M_FLOW_OBJECT_DEVICETYPE);
+#if LWM2M_CLIENT_FLOW_NAME
+	FlowObject_FreeValue(flowObject, flowObject->Name);
+	flowObject->Name = Provisioning_GetValue(batch, FLOWM2M_FLOW_OBJECT_NAME);
+#endif
+#if LWM2M_CLIENT_FLOW_DESCRIPTION
+	FlowObject_FreeValue(flowObject, flowObject->Description);
+	flowObject->Description = Provisioning_GetValue(batch, FLOWM2M_FLOW_OBJECT_DESCRIPTION);
+#endif
+	FlowObject_FreeValue(flowObject, flowObject->FCAP);
+	flowObject->FCAP = Provisioning_GetValue(batch, FLOWM2M_FLOW_OBJECT_FCAP);
+	memcpy(&flowObject->LicenseeID, Provisioning_GetValue(batch, FLOWM2M_FLOW_OBJECT_LICENSEEID),
+		sizeof(flowObject->LicenseeID));
+
+	free(flowObject->Provisioned);
+	flowObject->Provisioned = batch->Block;
+	flowObject->ProvisionedSize = batch->BlockSize;
+	batch->Block = NULL;
+
+	Tlv_FreeCachedResource(&flowObject->DeviceTypeTlv);
+	Tlv_FreeCachedResource(&flowObject->FCAPTlv);
+}
+
 /***************************************************************************************************
  * Implementation - Public
  **************************************************************************************************/
@@ -523,56 +840,240 @@ int Lwm2m_RegisterFlowObject(Lwm2mContextType * context)
 {
 	REGISTER_OBJECT(context, "FlowObject", FLOWM2M_FLOW_OBJECT, MultipleInstancesEnum_Single, \
 		MandatoryEnum_Optional, &flowObjectOperationHandlers);
-	REGISTER_FLOW_OBJECT_RESOURCE(context, "DeviceID", FLOWM2M_FLOW_OBJECT_DEVICEID, \
-		ResourceTypeEnum_TypeOpaque, MandatoryEnum_Mandatory);
-	REGISTER_FLOW_OBJECT_RESOURCE(context, "ParentID", FLOWM2M_FLOW_OBJECT_PARENTID, \
-		ResourceTypeEnum_TypeOpaque, MandatoryEnum_Optional);
-	REGISTER_FLOW_OBJECT_RESOURCE(context, "DeviceType", FLOWM2M_FLOW_OBJECT_DEVICETYPE, \
-		ResourceTypeEnum_TypeString, MandatoryEnum_Mandatory);
-	REGISTER_FLOW_OBJECT_RESOURCE(context, "Name", FLOWM2M_FLOW_OBJECT_NAME, \
-		ResourceTypeEnum_TypeString, MandatoryEnum_Optional);
-	REGISTER_FLOW_OBJECT_RESOURCE(context, "Description", FLOWM2M_FLOW_OBJECT_DESCRIPTION, \
-		ResourceTypeEnum_TypeString, MandatoryEnum_Optional);
-	REGISTER_FLOW_OBJECT_RESOURCE(context, "FCAP", FLOWM2M_FLOW_OBJECT_FCAP, \
-		ResourceTypeEnum_TypeString, MandatoryEnum_Mandatory);
-	REGISTER_FLOW_OBJECT_RESOURCE(context, "LicenseeID", FLOWM2M_FLOW_OBJECT_LICENSEEID, \
-		ResourceTypeEnum_TypeInteger, MandatoryEnum_Mandatory);
-	REGISTER_FLOW_OBJECT_RESOURCE(context, "LicenseeChallenge", FLOWM2M_FLOW_OBJECT_LICENSEECHALLENGE, \
-		ResourceTypeEnum_TypeOpaque, MandatoryEnum_Optional);
-	REGISTER_FLOW_OBJECT_RESOURCE(context, "HashIterations", FLOWM2M_FLOW_OBJECT_HASHITERATIONS, \
-		ResourceTypeEnum_TypeInteger, MandatoryEnum_Optional);
-	REGISTER_FLOW_OBJECT_RESOURCE(context, "LicenseeHash", FLOWM2M_FLOW_OBJECT_LICENSEEHASH, \
-		ResourceTypeEnum_TypeOpaque, MandatoryEnum_Optional);
-	REGISTER_FLOW_OBJECT_RESOURCE(context, "Status", FLOWM2M_FLOW_OBJECT_STATUS, \
-		ResourceTypeEnum_TypeInteger, MandatoryEnum_Optional);
 
-	return 0;
+	return Registration_RegisterResources(context, FLOWM2M_FLOW_OBJECT, flowObjectResources,
+		RESOURCE_DESCRIPTOR_COUNT(flowObjectResources), &flowObjectResourceOperationHandlers);
 }
 
 int Lwm2m_SetProvisioningInfo(Lwm2mContextType * context, const char * DeviceType,
 	const char * FCAP, int64_t LicenseeID)
 {
-	CREATE_OBJECT_INSTANCE(context, FLOWM2M_FLOW_OBJECT, 0);
+	FlowProvisioningInfo info = { 0 };
 
-	if (Lwm2mCore_SetResourceInstanceValue(context, FLOWM2M_FLOW_OBJECT, 0,
-		FLOWM2M_FLOW_OBJECT_FCAP, 0, FCAP, strlen(FCAP)) == -1)
+	info.DeviceType = DeviceType;
+	info.FCAP = FCAP;
+	info.LicenseeID = LicenseeID;
+	info.HasLicenseeID = true;
+	return Lwm2m_ProvisionFlowObjects(context, &info);
+}
+
+/*
+ * Every value is copied before anything changes, so running out of memory leaves both objects as
+ * they were. Then both instances are created in the core, before any optional resource, as those
+ * are the steps that can fail. The core cannot take an instance back, so one created before a
+ * later step fails is kept, still without values, and the next call reuses it.
+ */
+int Lwm2m_ProvisionFlowObjects(Lwm2mContextType * context, const FlowProvisioningInfo * info)
+{
+	FlowObjectState * state = FlowObject_GetState(context);
+	ProvisioningBatch flowBatch;
+	ProvisioningBatch flowAccessBatch;
+
+	/* The mandatory strings must be given the first time; after that they may be left out */
+	if (state == NULL || info == NULL ||
+		(info->DeviceType == NULL && state->Object.DeviceType == NULL) ||
+		(info->FCAP == NULL && state->Object.FCAP == NULL))
 	{
-		Lwm2m_Error("Failed to set FCAP to %s\n", FCAP);
+		Lwm2m_Error("Invalid provisioning info\n");
 		return -1;
 	}
 
-	if (Lwm2mCore_SetResourceInstanceValue(context, FLOWM2M_FLOW_OBJECT, 0,
-		FLOWM2M_FLOW_OBJECT_DEVICETYPE, 0, DeviceType, strlen(DeviceType)) == -1)
+	if (FlowObject_PrepareProvisioning(&state->Object, info, &flowBatch) == -1)
 	{
-		Lwm2m_Error("Failed to set Device Type to %s\n", DeviceType);
+		Lwm2m_Error("Failed to allocate provisioning info\n");
+		return -1;
+	}
+	if (Lwm2m_PrepareFlowAccessProvisioning(context, info, &flowAccessBatch) == -1)
+	{
+		Lwm2m_Error("Failed to allocate provisioning info\n");
+		Provisioning_Discard(&flowBatch);
 		return -1;
 	}
 
-	if (Lwm2mCore_SetResourceInstanceValue(context, FLOWM2M_FLOW_OBJECT, 0,
-		FLOWM2M_FLOW_OBJECT_LICENSEEID, 0, &LicenseeID, sizeof(int64_t)) == -1)
+	if (FlowObject_CreateInstance(context, &state->Object) == -1 ||
+		Lwm2m_CreateFlowAccessInstance(context, &flowAccessBatch) == -1 ||
+		FlowObject_CreateProvisionedResources(context, &state->Object, &flowBatch) == -1)
 	{
-		Lwm2m_Error("Failed to set Licensee Id to %" PRId64 "\n", LicenseeID);
+		Provisioning_Discard(&flowAccessBatch);
+		Provisioning_Discard(&flowBatch);
 		return -1;
 	}
+	Lwm2m_CommitFlowAccessProvisioning(context, &flowAccessBatch);
+	FlowObject_CommitProvisioning(&state->Object, &flowBatch);
+	Lwm2m_Debug("Provisioned %s (FCAP %s, licensee %" PRId64 ")\n", state->Object.DeviceType,
+		state->Object.FCAP, state->Object.LicenseeID);
+
+	Provisioning_MarkObservers(context, FLOWM2M_FLOW_OBJECT, 0, &flowBatch);
 	return 0;
 }
+
+int Lwm2m_GetFlowObjectResource(Lwm2mContextType * context, ResourceIDType resourceID,
+	const void ** value)
+{
+	FlowObjectState * state = FlowObject_GetState(context);
+
+	return state != NULL ? FlowObject_GetResourceValue(&state->Object, resourceID, value) : -1;
+}
+
+int Lwm2m_ReadFlowObjectResource(Lwm2mContextType * context, ResourceIDType resourceID,
+	int offset, uint8_t * destBuffer, int destBufferLen)
+{
+	FlowObjectState * state = FlowObject_GetState(context);
+	const void * value;
+	int length;
+
+	if (state == NULL)
+		return -1;
+
+	length = FlowObject_GetResourceValue(&state->Object, resourceID, &value);
+	if (length < 0 || offset < 0)
+		return -1;
+
+	length = offset < length ? length - offset : 0;
+	if (length > destBufferLen)
+		length = destBufferLen;
+	if (length > 0)
+		memcpy(destBuffer, (const uint8_t *)value + offset, length);
+
+	return length;
+}
+
+int Lwm2m_BeginFlowObjectResourceWrite(Lwm2mContextType * context, ResourceIDType resourceID,
+	int totalLength)
+{
+	FlowObjectState * state = FlowObject_GetState(context);
+	FlowObjectBlockWrite * blockWrite;
+
+	if (state == NULL)
+		return -1;
+	blockWrite = &state->BlockWrite;
+	FlowObject_AbortBlockWrite(blockWrite);
+
+	switch (resourceID)
+	{
+		case FLOWM2M_FLOW_OBJECT_DEVICEID:
+#if LWM2M_CLIENT_FLOW_PARENT_ID
+		case FLOWM2M_FLOW_OBJECT_PARENTID:
+#endif
+		case FLOWM2M_FLOW_OBJECT_LICENSEECHALLENGE:
+		case FLOWM2M_FLOW_OBJECT_LICENSEEHASH:
+			break;
+
+		default:
+			Lwm2m_Error("Block-wise write not supported for Flow resource %d\n", resourceID);
+			return -1;
+	}
+
+	if (totalLength <= 0 || (blockWrite->Buffer = malloc(totalLength)) == NULL)
+	{
+		Lwm2m_Error("Failed to allocate %d bytes for Flow resource %d\n", totalLength, resourceID);
+		return -1;
+	}
+
+	blockWrite->ResourceID = resourceID;
+	blockWrite->TotalLength = totalLength;
+
+	if (resourceID == FLOWM2M_FLOW_OBJECT_LICENSEECHALLENGE)
+	{
+		blockWrite->KeyLength = DecodeLicenseeSecret(licenseeSecret, blockWrite->Key);
+		if (blockWrite->KeyLength != -1)
+		{
+			HmacSha256Stream_Init(&blockWrite->Hmac, blockWrite->Key, blockWrite->KeyLength);
+			blockWrite->Hashing = true;
+		}
+	}
+	return 0;
+}
+
+int Lwm2m_WriteFlowObjectResourceBlock(Lwm2mContextType * context, ResourceIDType resourceID,
+	int offset, const uint8_t * block, int blockLength)
+{
+	FlowObjectState * state = FlowObject_GetState(context);
+	FlowObjectBlockWrite * blockWrite;
+	int result = blockLength;
+	DIAGNOSTICS_START(startTime);
+
+	if (state == NULL)
+	{
+		DIAGNOSTICS_RECORD(FLOWM2M_FLOW_OBJECT, resourceID, DiagnosticsOperation_Write, -1,
+			startTime);
+		return -1;
+	}
+	blockWrite = &state->BlockWrite;
+
+	if (resourceID != blockWrite->ResourceID || offset != blockWrite->Received || blockLength < 0 ||
+		blockLength > blockWrite->TotalLength - offset)
+	{
+		Lwm2m_Error("Unexpected block for Flow resource %d at offset %d (length %d)\n", resourceID,
+			offset, blockLength);
+		FlowObject_AbortBlockWrite(blockWrite);
+		result = -1;
+	}
+	else
+	{
+		memcpy(blockWrite->Buffer + offset, block, blockLength);
+		blockWrite->Received += blockLength;
+
+		if (blockWrite->Hashing)
+			HmacSha256Stream_Update(&blockWrite->Hmac, block, blockLength);
+
+		if (blockWrite->Received == blockWrite->TotalLength &&
+			FlowObject_CompleteBlockWrite(context, state) == -1)
+		{
+			result = -1;
+		}
+	}
+
+	DIAGNOSTICS_RECORD(FLOWM2M_FLOW_OBJECT, resourceID, DiagnosticsOperation_Write, result,
+		startTime);
+	return result;
+}
+
+int Lwm2m_ReadFlowObjectInstance(Lwm2mContextType * context, uint8_t * destBuffer,
+	int destBufferLen)
+{
+	FlowObjectState * state = FlowObject_GetState(context);
+	int i, length = 0;
+
+	if (state == NULL)
+		return -1;
+
+	for (i = 0; i < sizeof(flowObjectResourceTypes) / sizeof(flowObjectResourceTypes[0]); i++)
+	{
+		const TlvResourceType * resource = &flowObjectResourceTypes[i];
+		TlvCachedResource * cache = FlowObject_GetResourceCache(&state->Object,
+			resource->ResourceID);
+		const void * value;
+		int valueLength;
+		int result;
+
+		if (cache != NULL && cache->Length > 0)
+		{
+			result = Tlv_CopyCachedResource(cache, destBuffer + length, destBufferLen - length);
+		}
+		else
+		{
+			valueLength = FlowObject_GetResourceValue(&state->Object, resource->ResourceID,
+				&value);
+			if (valueLength <= 0)
+				continue;
+
+			if (cache != NULL)
+			{
+				result = Tlv_EncodeCachedResource(cache, destBuffer + length,
+					destBufferLen - length, resource->ResourceID, resource->Type, value,
+					valueLength, valueLength);
+			}
+			else
+			{
+				result = Tlv_EncodeResource(destBuffer + length, destBufferLen - length,
+					resource->ResourceID, resource->Type, value, valueLength);
+			}
+		}
+
+		if (result == -1)
+			return -1;
+		length += result;
+	}
+	return length;
+}
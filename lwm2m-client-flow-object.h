@@ -36,8 +36,68 @@
 #ifndef LWM2M_CLIENT_FLOW_OBJECT_H_
 #define LWM2M_CLIENT_FLOW_OBJECT_H_
 
+#include "lwm2m-client-provisioning.h"
+
+/* Flow object and resource IDs, for the functions below that take a resourceID */
+#define FLOWM2M_FLOW_OBJECT							20000
+#define FLOWM2M_FLOW_OBJECT_DEVICEID				0
+#define FLOWM2M_FLOW_OBJECT_PARENTID				1
+#define FLOWM2M_FLOW_OBJECT_DEVICETYPE				2
+#define FLOWM2M_FLOW_OBJECT_NAME					3
+#define FLOWM2M_FLOW_OBJECT_DESCRIPTION				4
+#define FLOWM2M_FLOW_OBJECT_FCAP					5
+#define FLOWM2M_FLOW_OBJECT_LICENSEEID				6
+#define FLOWM2M_FLOW_OBJECT_LICENSEECHALLENGE		7
+#define FLOWM2M_FLOW_OBJECT_HASHITERATIONS			8
+#define FLOWM2M_FLOW_OBJECT_LICENSEEHASH			9
+#define FLOWM2M_FLOW_OBJECT_STATUS					10
+
 int Lwm2m_RegisterFlowObject(Lwm2mContextType * context);
 int Lwm2m_SetProvisioningInfo(Lwm2mContextType * context, const char * DeviceType,
 	const char * FCAP, int64_t LicenseeID);
 
+/*
+ * Sets every provisioned Flow and Flow Access value in one pass. Values not given keep their
+ * current value; DeviceType and FCAP are required until the Flow object has them. The instances
+ * are created if they do not exist yet. Each object copies its values into one allocation, and
+ * observers get one notification for all the resources that changed. Returns -1 and changes no
+ * values on failure; an instance already created in the core by then is kept, with no values, and
+ * reused by the next call.
+ */
+int Lwm2m_ProvisionFlowObjects(Lwm2mContextType * context, const FlowProvisioningInfo * info);
+
+/*
+ * Points value at the stored resource value and returns its length, without copying. The pointer
+ * is valid until the resource is next written or the object is deleted.
+ */
+int Lwm2m_GetFlowObjectResource(Lwm2mContextType * context, ResourceIDType resourceID,
+	const void ** value);
+
+/*
+ * Copies at most destBufferLen bytes of the resource value starting at offset, for block-wise
+ * transfers. Returns the number of bytes copied, 0 for an offset at or past the end, or -1 on
+ * error.
+ */
+int Lwm2m_ReadFlowObjectResource(Lwm2mContextType * context, ResourceIDType resourceID,
+	int offset, uint8_t * destBuffer, int destBufferLen);
+
+/*
+ * Block-wise write of an opaque resource (DeviceID, ParentID, LicenseeChallenge, LicenseeHash).
+ * Begin allocates the whole value up front, blocks must then arrive in order and are appended in
+ * place. The value replaces the old one once the last block arrives, and its observers are marked
+ * then. LicenseeChallenge blocks are hashed as they arrive, so only the remaining iterations run on
+ * completion.
+ */
+int Lwm2m_BeginFlowObjectResourceWrite(Lwm2mContextType * context, ResourceIDType resourceID,
+	int totalLength);
+int Lwm2m_WriteFlowObjectResourceBlock(Lwm2mContextType * context, ResourceIDType resourceID,
+	int offset, const uint8_t * block, int blockLength);
+
+/*
+ * Serializes every resource that has a value into destBuffer as OMA-TLV records in one pass.
+ * Returns the number of bytes written, or -1 if destBuffer is too small.
+ */
+int Lwm2m_ReadFlowObjectInstance(Lwm2mContextType * context, uint8_t * destBuffer,
+	int destBufferLen);
+
 #endif /* LWM2M_CLIENT_FLOW_OBJECT_H_ */
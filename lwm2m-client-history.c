@@ -0,0 +1,303 @@
+/**
+ * @file
+ * Compressed resource value history for libobjects.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "lwm2m-client-history.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define HISTORY_BLOCK_SIZE				64
+#define HISTORY_MAX_VARINT_LENGTH		10
+#define HISTORY_MAX_SAMPLE_LENGTH		(2 * HISTORY_MAX_VARINT_LENGTH)
+
+#define ZIGZAG_ENCODE(value)			(((uint64_t)(value) << 1) ^ (uint64_t)((value) >> 63))
+#define ZIGZAG_DECODE(value)			((int64_t)((value) >> 1) ^ -(int64_t)((value) & 1))
+
+/***************************************************************************************************
+ * Implementation - Private
+ **************************************************************************************************/
+
+static int History_PutVarint(uint8_t * destBuffer, uint64_t value)
+{
+	int length = 0;
+
+	while (value >= 0x80)
+	{
+		destBuffer[length++] = (uint8_t)value | 0x80;
+		value >>= 7;
+	}
+	destBuffer[length++] = (uint8_t)value;
+	return length;
+}
+
+static int History_GetVarint(const uint8_t * srcBuffer, int srcBufferLen, uint64_t * value)
+{
+	int length = 0, shift = 0;
+
+	*value = 0;
+	while (length < srcBufferLen && shift < 64)
+	{
+		uint8_t byte = srcBuffer[length++];
+
+		*value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return length;
+		shift += 7;
+	}
+	return -1;
+}
+
+static bool History_SequenceReached(uint32_t sequence, uint32_t mark)
+{
+	return (int32_t)(sequence - mark) <= 0;
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+ResourceHistory * ResourceHistory_Create(int blockCount, ResourceHistoryEncoding encoding)
+{
+	ResourceHistory * history;
+
+	if (blockCount <= 0)
+		return NULL;
+
+	history = calloc(1, sizeof(ResourceHistory) + blockCount * sizeof(ResourceHistoryBlock) +
+		blockCount * HISTORY_BLOCK_SIZE);
+	if (history == NULL)
+		return NULL;
+
+	history->Encoding = encoding;
+	history->BlockCount = blockCount;
+	history->Blocks = (ResourceHistoryBlock *)(history + 1);
+	history->Data = (uint8_t *)(history->Blocks + blockCount);
+	pthread_mutex_init(&history->Lock, NULL);
+	return history;
+}
+
+void ResourceHistory_Destroy(ResourceHistory * history)
+{
+	if (history == NULL)
+		return;
+
+	pthread_mutex_destroy(&history->Lock);
+	free(history);
+}
+
+int64_t ResourceHistory_GetTime(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+void ResourceHistory_Append(ResourceHistory * history, int64_t timeMs, int64_t value)
+{
+	ResourceHistoryBlock * block = NULL;
+	uint8_t * data;
+	int index;
+
+	pthread_mutex_lock(&history->Lock);
+	if (history->Used > 0 && !history->Sealed)
+	{
+		index = (history->Oldest + history->Used - 1) % history->BlockCount;
+		block = &history->Blocks[index];
+		if (block->Length + HISTORY_MAX_SAMPLE_LENGTH > HISTORY_BLOCK_SIZE)
+			block = NULL;
+	}
+
+	if (block == NULL)
+	{
+		if (history->Used == history->BlockCount)
+		{
+			history->Dropped += history->Blocks[history->Oldest].Count;
+			history->Oldest = (history->Oldest + 1) % history->BlockCount;
+			history->Used--;
+		}
+
+		index = (history->Oldest + history->Used) % history->BlockCount;
+		block = &history->Blocks[index];
+		block->Sequence = history->NextSequence++;
+		block->Count = 0;
+		history->Used++;
+		history->Sealed = false;
+
+		data = &history->Data[index * HISTORY_BLOCK_SIZE];
+		block->Length = History_PutVarint(data, (uint64_t)timeMs);
+		block->Length += History_PutVarint(data + block->Length, ZIGZAG_ENCODE(value));
+		history->LastTimeDelta = 0;
+	}
+	else
+	{
+		int64_t timeDelta = timeMs - history->LastTime;
+		uint64_t encodedValue = history->Encoding == ResourceHistoryEncoding_Xor ?
+			(uint64_t)(value ^ history->LastValue) : ZIGZAG_ENCODE(value - history->LastValue);
+
+		data = &history->Data[index * HISTORY_BLOCK_SIZE];
+		block->Length += History_PutVarint(data + block->Length,
+			ZIGZAG_ENCODE(timeDelta - history->LastTimeDelta));
+		block->Length += History_PutVarint(data + block->Length, encodedValue);
+		history->LastTimeDelta = timeDelta;
+	}
+
+	block->Count++;
+	history->LastTime = timeMs;
+	history->LastValue = value;
+	pthread_mutex_unlock(&history->Lock);
+}
+
+int ResourceHistory_Read(ResourceHistory * history, uint8_t * destBuffer, int destBufferLen,
+	uint32_t * mark)
+{
+	uint8_t header[2 * HISTORY_MAX_VARINT_LENGTH];
+	int length = 0, i;
+
+	pthread_mutex_lock(&history->Lock);
+	for (i = 0; i < history->Used; i++)
+	{
+		int index = (history->Oldest + i) % history->BlockCount;
+		ResourceHistoryBlock * block = &history->Blocks[index];
+		int headerLength = History_PutVarint(header, block->Count);
+
+		headerLength += History_PutVarint(header + headerLength, block->Length);
+		if (length + headerLength + block->Length > destBufferLen)
+			break;
+
+		memcpy(destBuffer + length, header, headerLength);
+		memcpy(destBuffer + length + headerLength, &history->Data[index * HISTORY_BLOCK_SIZE],
+			block->Length);
+		length += headerLength + block->Length;
+		*mark = block->Sequence;
+
+		/* Samples appended after the read must not go into a block that may be acknowledged */
+		if (i == history->Used - 1)
+			history->Sealed = true;
+	}
+	pthread_mutex_unlock(&history->Lock);
+	return length;
+}
+
+void ResourceHistory_Acknowledge(ResourceHistory * history, uint32_t mark)
+{
+	pthread_mutex_lock(&history->Lock);
+	while (history->Used > 0 &&
+		History_SequenceReached(history->Blocks[history->Oldest].Sequence, mark))
+	{
+		if (history->Used == 1 && !history->Sealed)
+			break;
+		history->Oldest = (history->Oldest + 1) % history->BlockCount;
+		history->Used--;
+	}
+	pthread_mutex_unlock(&history->Lock);
+}
+
+uint32_t ResourceHistory_GetDropped(ResourceHistory * history)
+{
+	uint32_t dropped;
+
+	pthread_mutex_lock(&history->Lock);
+	dropped = history->Dropped;
+	pthread_mutex_unlock(&history->Lock);
+	return dropped;
+}
+
+int ResourceHistory_Decode(const uint8_t * batch, int batchLength,
+	ResourceHistoryEncoding encoding, ResourceHistorySampleCallback callback, void * context)
+{
+	int offset = 0, samples = 0;
+
+	while (offset < batchLength)
+	{
+		uint64_t count, blockLength, timeMs, value, field;
+		int64_t timeDelta = 0;
+		int end, length, i;
+
+		if ((length = History_GetVarint(batch + offset, batchLength - offset, &count)) == -1)
+			return -1;
+		offset += length;
+		if ((length = History_GetVarint(batch + offset, batchLength - offset, &blockLength)) == -1)
+			return -1;
+		offset += length;
+		if (blockLength > (uint64_t)(batchLength - offset))
+			return -1;
+		end = offset + blockLength;
+
+		for (i = 0; (uint64_t)i < count; i++)
+		{
+			if ((length = History_GetVarint(batch + offset, end - offset, &field)) == -1)
+				return -1;
+			offset += length;
+
+			if (i == 0)
+			{
+				timeMs = field;
+			}
+			else
+			{
+				timeDelta += ZIGZAG_DECODE(field);
+				timeMs += timeDelta;
+			}
+
+			if ((length = History_GetVarint(batch + offset, end - offset, &field)) == -1)
+				return -1;
+			offset += length;
+
+			if (i == 0)
+				value = ZIGZAG_DECODE(field);
+			else if (encoding == ResourceHistoryEncoding_Xor)
+				value ^= field;
+			else
+				value += ZIGZAG_DECODE(field);
+
+			callback(context, (int64_t)timeMs, (int64_t)value);
+			samples++;
+		}
+		offset = end;
+	}
+	return samples;
+}
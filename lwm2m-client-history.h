@@ -0,0 +1,103 @@
+/**
+ * @file
+ * Compressed resource value history for libobjects.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_HISTORY_H_
+#define LWM2M_CLIENT_HISTORY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+typedef enum
+{
+	ResourceHistoryEncoding_Delta,		/* counters and levels: zigzag delta to previous value */
+	ResourceHistoryEncoding_Xor,		/* states: XOR with the previous value */
+} ResourceHistoryEncoding;
+
+typedef struct
+{
+	uint32_t Sequence;
+	uint16_t Length;
+	uint16_t Count;
+} ResourceHistoryBlock;
+
+/*
+ * Fixed-size ring of timestamped samples. Samples are packed into fixed-size blocks, each block
+ * starting with an absolute sample followed by delta-of-delta varint timestamps and delta or XOR
+ * varint values. When the ring is full the oldest block is dropped. Appending, reading and
+ * acknowledging take the history's own lock, so a history may be read and acknowledged while an
+ * object records into it. It must be detached from the object before it is destroyed.
+ */
+typedef struct
+{
+	pthread_mutex_t Lock;
+	ResourceHistoryEncoding Encoding;
+	int BlockCount;
+	ResourceHistoryBlock * Blocks;
+	uint8_t * Data;
+	int Oldest;
+	int Used;
+	bool Sealed;
+	uint32_t NextSequence;
+	int64_t LastTime;
+	int64_t LastTimeDelta;
+	int64_t LastValue;
+	uint32_t Dropped;
+} ResourceHistory;
+
+typedef void (*ResourceHistorySampleCallback)(void * context, int64_t timeMs, int64_t value);
+
+ResourceHistory * ResourceHistory_Create(int blockCount, ResourceHistoryEncoding encoding);
+void ResourceHistory_Destroy(ResourceHistory * history);
+int64_t ResourceHistory_GetTime(void);
+void ResourceHistory_Append(ResourceHistory * history, int64_t timeMs, int64_t value);
+
+/*
+ * Copies as many whole blocks as fit, oldest first, and sets mark to the last one copied. The
+ * blocks stay in the ring until ResourceHistory_Acknowledge() is called with that mark. Returns
+ * the number of bytes copied.
+ */
+int ResourceHistory_Read(ResourceHistory * history, uint8_t * destBuffer, int destBufferLen,
+	uint32_t * mark);
+void ResourceHistory_Acknowledge(ResourceHistory * history, uint32_t mark);
+
+/* Number of samples dropped so far because the ring was full */
+uint32_t ResourceHistory_GetDropped(ResourceHistory * history);
+
+/* Calls callback for every sample in a batch produced by ResourceHistory_Read() */
+int ResourceHistory_Decode(const uint8_t * batch, int batchLength,
+	ResourceHistoryEncoding encoding, ResourceHistorySampleCallback callback, void * context);
+
+#endif /* LWM2M_CLIENT_HISTORY_H_ */
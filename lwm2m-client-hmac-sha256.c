@@ -0,0 +1,236 @@
+/**
+ * @file
+ * Incremental SHA-256 and HMAC-SHA256 for libobjects.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "lwm2m-client-hmac-sha256.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define ROTR(x, n)			(((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z)			(((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z)		(((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define SIGMA0(x)			(ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define SIGMA1(x)			(ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define GAMMA0(x)			(ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define GAMMA1(x)			(ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+#define HMAC_IPAD			0x36
+#define HMAC_OPAD			0x5c
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+static const uint32_t sha256InitialState[8] =
+{
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+const uint32_t sha256RoundConstants[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+void Sha256Stream_Compress(uint32_t state[8], const uint8_t block[SHA256_STREAM_BLOCK_LENGTH])
+{
+	uint32_t w[64];
+	uint32_t a, b, c, d, e, f, g, h, t1, t2;
+	int i;
+
+	for (i = 0; i < 16; i++)
+	{
+		w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+			((uint32_t)block[i * 4 + 2] << 8) | block[i * 4 + 3];
+	}
+	for (; i < 64; i++)
+	{
+		w[i] = GAMMA1(w[i - 2]) + w[i - 7] + GAMMA0(w[i - 15]) + w[i - 16];
+	}
+
+	a = state[0]; b = state[1]; c = state[2]; d = state[3];
+	e = state[4]; f = state[5]; g = state[6]; h = state[7];
+
+	for (i = 0; i < 64; i++)
+	{
+		t1 = h + SIGMA1(e) + CH(e, f, g) + sha256RoundConstants[i] + w[i];
+		t2 = SIGMA0(a) + MAJ(a, b, c);
+		h = g; g = f; f = e; e = d + t1;
+		d = c; c = b; b = a; a = t1 + t2;
+	}
+
+	state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+	state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void Sha256Stream_Init(Sha256StreamContext * context)
+{
+	memcpy(context->State, sha256InitialState, sizeof(context->State));
+	context->Length = 0;
+	context->BlockLength = 0;
+}
+
+void Sha256Stream_Update(Sha256StreamContext * context, const void * data, int dataLength)
+{
+	const uint8_t * bytes = data;
+
+	context->Length += dataLength;
+
+	if (context->BlockLength > 0)
+	{
+		int count = SHA256_STREAM_BLOCK_LENGTH - context->BlockLength;
+
+		if (count > dataLength)
+			count = dataLength;
+		memcpy(&context->Block[context->BlockLength], bytes, count);
+		context->BlockLength += count;
+		bytes += count;
+		dataLength -= count;
+
+		if (context->BlockLength < SHA256_STREAM_BLOCK_LENGTH)
+			return;
+		Sha256Stream_Compress(context->State, context->Block);
+		context->BlockLength = 0;
+	}
+
+	/* Whole blocks are hashed straight from the caller's buffer */
+	for (; dataLength >= SHA256_STREAM_BLOCK_LENGTH; dataLength -= SHA256_STREAM_BLOCK_LENGTH)
+	{
+		Sha256Stream_Compress(context->State, bytes);
+		bytes += SHA256_STREAM_BLOCK_LENGTH;
+	}
+
+	memcpy(context->Block, bytes, dataLength);
+	context->BlockLength = dataLength;
+}
+
+void Sha256Stream_Final(Sha256StreamContext * context, uint8_t hash[SHA256_STREAM_HASH_LENGTH])
+{
+	uint64_t bits = context->Length * 8;
+	int i;
+
+	context->Block[context->BlockLength++] = 0x80;
+	if (context->BlockLength > SHA256_STREAM_BLOCK_LENGTH - 8)
+	{
+		memset(&context->Block[context->BlockLength], 0,
+			SHA256_STREAM_BLOCK_LENGTH - context->BlockLength);
+		Sha256Stream_Compress(context->State, context->Block);
+		context->BlockLength = 0;
+	}
+	memset(&context->Block[context->BlockLength], 0,
+		SHA256_STREAM_BLOCK_LENGTH - 8 - context->BlockLength);
+	for (i = 0; i < 8; i++)
+	{
+		context->Block[SHA256_STREAM_BLOCK_LENGTH - 1 - i] = (uint8_t)(bits >> (i * 8));
+	}
+	Sha256Stream_Compress(context->State, context->Block);
+
+	for (i = 0; i < 8; i++)
+	{
+		hash[i * 4] = (uint8_t)(context->State[i] >> 24);
+		hash[i * 4 + 1] = (uint8_t)(context->State[i] >> 16);
+		hash[i * 4 + 2] = (uint8_t)(context->State[i] >> 8);
+		hash[i * 4 + 3] = (uint8_t)context->State[i];
+	}
+}
+
+void HmacSha256Stream_Init(HmacSha256StreamContext * context, const void * key, int keyLength)
+{
+	uint8_t pad[SHA256_STREAM_BLOCK_LENGTH];
+	uint8_t keyHash[SHA256_STREAM_HASH_LENGTH];
+	int i;
+
+	if (keyLength > SHA256_STREAM_BLOCK_LENGTH)
+	{
+		Sha256Stream_Init(&context->Inner);
+		Sha256Stream_Update(&context->Inner, key, keyLength);
+		Sha256Stream_Final(&context->Inner, keyHash);
+		key = keyHash;
+		keyLength = sizeof(keyHash);
+	}
+
+	memset(pad, 0, sizeof(pad));
+	memcpy(pad, key, keyLength);
+	for (i = 0; i < SHA256_STREAM_BLOCK_LENGTH; i++)
+	{
+		pad[i] ^= HMAC_OPAD;
+	}
+	memcpy(context->OuterState, sha256InitialState, sizeof(context->OuterState));
+	Sha256Stream_Compress(context->OuterState, pad);
+
+	for (i = 0; i < SHA256_STREAM_BLOCK_LENGTH; i++)
+	{
+		pad[i] ^= HMAC_OPAD ^ HMAC_IPAD;
+	}
+	Sha256Stream_Init(&context->Inner);
+	Sha256Stream_Update(&context->Inner, pad, sizeof(pad));
+}
+
+void HmacSha256Stream_Update(HmacSha256StreamContext * context, const void * data,
+	int dataLength)
+{
+	Sha256Stream_Update(&context->Inner, data, dataLength);
+}
+
+void HmacSha256Stream_Final(HmacSha256StreamContext * context,
+	uint8_t hash[SHA256_STREAM_HASH_LENGTH])
+{
+	Sha256StreamContext outer;
+
+	Sha256Stream_Final(&context->Inner, hash);
+
+	memcpy(outer.State, context->OuterState, sizeof(outer.State));
+	outer.Length = SHA256_STREAM_BLOCK_LENGTH;
+	outer.BlockLength = 0;
+	Sha256Stream_Update(&outer, hash, SHA256_STREAM_HASH_LENGTH);
+	Sha256Stream_Final(&outer, hash);
+}
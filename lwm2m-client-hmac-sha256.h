@@ -0,0 +1,76 @@
+/**
+ * @file
+ * Incremental SHA-256 and HMAC-SHA256 for libobjects.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_HMAC_SHA256_H_
+#define LWM2M_CLIENT_HMAC_SHA256_H_
+
+#include <stdint.h>
+
+#define SHA256_STREAM_BLOCK_LENGTH		64
+#define SHA256_STREAM_HASH_LENGTH		32
+
+typedef struct
+{
+	uint32_t State[8];
+	uint64_t Length;
+	uint8_t Block[SHA256_STREAM_BLOCK_LENGTH];
+	int BlockLength;
+} Sha256StreamContext;
+
+/*
+ * HMAC computed as data arrives, so a value can be hashed while it is still being transferred.
+ * Produces the same result as HmacSha256_ComputeHash() over the whole value.
+ */
+typedef struct
+{
+	Sha256StreamContext Inner;
+	uint32_t OuterState[8];
+} HmacSha256StreamContext;
+
+/* The 64 SHA-256 round constants, shared with the multi-buffer licensee verifier */
+extern const uint32_t sha256RoundConstants[64];
+
+void Sha256Stream_Compress(uint32_t state[8], const uint8_t block[SHA256_STREAM_BLOCK_LENGTH]);
+void Sha256Stream_Init(Sha256StreamContext * context);
+void Sha256Stream_Update(Sha256StreamContext * context, const void * data, int dataLength);
+void Sha256Stream_Final(Sha256StreamContext * context, uint8_t hash[SHA256_STREAM_HASH_LENGTH]);
+
+void HmacSha256Stream_Init(HmacSha256StreamContext * context, const void * key, int keyLength);
+void HmacSha256Stream_Update(HmacSha256StreamContext * context, const void * data,
+	int dataLength);
+void HmacSha256Stream_Final(HmacSha256StreamContext * context,
+	uint8_t hash[SHA256_STREAM_HASH_LENGTH]);
+
+#endif /* LWM2M_CLIENT_HMAC_SHA256_H_ */
@@ -43,6 +43,16 @@
 #include <string.h>
 #include "lwm2m_core.h"
 #include "coap_abstraction.h"
+#include "lwm2m-client-tlv.h"
+#include "lwm2m-client-registration.h"
+#include "lwm2m-client-resource-version.h"
+#include "lwm2m-client-offline-queue.h"
+#include "lwm2m-client-senml-cbor.h"
+#include "lwm2m-client-history.h"
+#include "lwm2m-client-seqlock.h"
+#include "lwm2m-client-state.h"
+#include "lwm2m-client-string-table.h"
+#include "lwm2m-client-config.h"
 #include "common.h"
 
 /***************************************************************************************************
@@ -64,28 +74,58 @@
 
 #define MAX_STR_SIZE							128
 
-#define REGISTER_DIGITAL_INPUT_RESOURCE(context, name, id, type, operations) \
-	REGISTER_RESOURCE(context, name, IPSO_DIGITAL_INPUT_OBJECT, id, type,    \
-		MultipleInstancesEnum_Single, MandatoryEnum_Optional, operations,    \
-		&DigitalInputResourceOperationHandlers)
+#define DIGITAL_INPUT_STRINGS \
+	(LWM2M_CLIENT_DIGITAL_INPUT_APPLICATION_TYPE || LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE)
 
-#define CREATE_DIGITAL_INPUT_OPTIONAL_RESOURCE(context, objectInstanceId, resourcId) \
-	CREATE_OPTIONAL_RESOURCE(context, IPSO_DIGITAL_INPUT_OBJECT, objectInstanceId, resourcId)
+#define DIGITAL_INPUT_RESOURCE(name, id, type, operations) \
+	{ name, id, type, MultipleInstancesEnum_Single, MandatoryEnum_Optional, operations }
 
 /***************************************************************************************************
  * Typedefs
  **************************************************************************************************/
 
-typedef struct
+/* One cache line aligned record per instance, guarded by its own sequence lock */
+typedef struct SEQLOCK_ALIGNED
 {
+	SeqLock Lock;
 	bool State;
 	int64_t Counter;
+#if LWM2M_CLIENT_DIGITAL_INPUT_POLARITY
 	bool Polarity;
+#endif
+#if LWM2M_CLIENT_DIGITAL_INPUT_DEBOUNCE_PERIOD
 	int64_t DebouncePeriod;
+#endif
 	int64_t EdgeSelection;
+#if LWM2M_CLIENT_DIGITAL_INPUT_APPLICATION_TYPE
+	StringHandle ApplicationType;
+	TlvCachedResource ApplicationTypeTlv;
+#endif
+#if LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE
+	StringHandle SensoryType;
+	TlvCachedResource SensoryTypeTlv;
+#endif
+	ResourceHistory * StateHistory;
+	ResourceHistory * CounterHistory;
+} IPSODigitalInput;
+
+/* Consistent copy of one instance, with its strings copied out of the string table */
+typedef struct
+{
+	IPSODigitalInput Input;
+#if LWM2M_CLIENT_DIGITAL_INPUT_APPLICATION_TYPE
 	char ApplicationType[MAX_STR_SIZE];
+#endif
+#if LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE
 	char SensoryType[MAX_STR_SIZE];
-} IPSODigitalInput;
+#endif
+} DigitalInputSnapshot;
+
+/* Every instance one client can have */
+typedef struct
+{
+	IPSODigitalInput Inputs[DIGITAL_INPUTS];
+} DigitalInputState;
 
 /***************************************************************************************************
  * Prototypes
@@ -116,6 +156,10 @@ static int DigitalInput_ObjectCreateInstanceHandler(void *context, ObjectIDType
 static int DigitalInput_ObjectDeleteHandler(void *context, ObjectIDType objectID,
 	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID);
 
+#if DIGITAL_INPUT_STRINGS
+static void DigitalInput_CleanupState(void *state);
+#endif
+
 /***************************************************************************************************
  * Globals
  **************************************************************************************************/
@@ -135,12 +179,163 @@ static ResourceOperationHandlers DigitalInputResourceOperationHandlers =
 	.Execute = DigitalInput_ResourceExecuteHandler,
 };
 
-static IPSODigitalInput digitalInputs[DIGITAL_INPUTS];
+static const ClientStateDefinition digitalInputStateDefinition =
+{
+	.Slot = ClientStateSlot_DigitalInput,
+	.Size = sizeof(DigitalInputState),
+#if DIGITAL_INPUT_STRINGS
+	.Cleanup = DigitalInput_CleanupState,
+#endif
+};
+
+/* Every resource, in the order they are registered */
+static const ResourceDescriptor digitalInputResources[] =
+{
+	DIGITAL_INPUT_RESOURCE("State", IPSO_DIGITAL_INPUT_STATE, ResourceTypeEnum_TypeBoolean,
+		Operations_R),
+	DIGITAL_INPUT_RESOURCE("Counter", IPSO_DIGITAL_INPUT_COUNTER, ResourceTypeEnum_TypeInteger,
+		Operations_R),
+#if LWM2M_CLIENT_DIGITAL_INPUT_POLARITY
+	DIGITAL_INPUT_RESOURCE("Polarity", IPSO_DIGITAL_INPUT_POLARITY, ResourceTypeEnum_TypeBoolean,
+		Operations_RW),
+#endif
+#if LWM2M_CLIENT_DIGITAL_INPUT_DEBOUNCE_PERIOD
+	DIGITAL_INPUT_RESOURCE("DebouncePeriod", IPSO_DIGITAL_INPUT_DEBOUNCE_PERIOD,
+		ResourceTypeEnum_TypeInteger, Operations_RW),
+#endif
+	DIGITAL_INPUT_RESOURCE("EdgeSelection", IPSO_DIGITAL_INPUT_EDGE_SELECTION,
+		ResourceTypeEnum_TypeInteger, Operations_RW),
+	DIGITAL_INPUT_RESOURCE("CounterReset", IPSO_DIGITAL_INPUT_COUNTER_RESET,
+		ResourceTypeEnum_TypeNone, Operations_E),
+#if LWM2M_CLIENT_DIGITAL_INPUT_APPLICATION_TYPE
+	DIGITAL_INPUT_RESOURCE("ApplicationType", IPSO_APPICATION_TYPE, ResourceTypeEnum_TypeString,
+		Operations_R),
+#endif
+#if LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE
+	DIGITAL_INPUT_RESOURCE("SensorType", IPSO_SENSOR_TYPE, ResourceTypeEnum_TypeString,
+		Operations_R),
+#endif
+};
+
+/* Optional resources created with every instance */
+static const ResourceIDType digitalInputInstanceResources[] =
+{
+	IPSO_DIGITAL_INPUT_COUNTER,
+	IPSO_DIGITAL_INPUT_COUNTER_RESET,
+#if LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE
+	IPSO_SENSOR_TYPE,
+#endif
+};
+
+/* Readable resources, in the order a whole-instance read serializes them */
+static const TlvResourceType digitalInputResourceTypes[] =
+{
+	{ IPSO_DIGITAL_INPUT_STATE, ResourceTypeEnum_TypeBoolean },
+	{ IPSO_DIGITAL_INPUT_COUNTER, ResourceTypeEnum_TypeInteger },
+#if LWM2M_CLIENT_DIGITAL_INPUT_POLARITY
+	{ IPSO_DIGITAL_INPUT_POLARITY, ResourceTypeEnum_TypeBoolean },
+#endif
+#if LWM2M_CLIENT_DIGITAL_INPUT_DEBOUNCE_PERIOD
+	{ IPSO_DIGITAL_INPUT_DEBOUNCE_PERIOD, ResourceTypeEnum_TypeInteger },
+#endif
+	{ IPSO_DIGITAL_INPUT_EDGE_SELECTION, ResourceTypeEnum_TypeInteger },
+#if LWM2M_CLIENT_DIGITAL_INPUT_APPLICATION_TYPE
+	{ IPSO_APPICATION_TYPE, ResourceTypeEnum_TypeString },
+#endif
+#if LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE
+	{ IPSO_SENSOR_TYPE, ResourceTypeEnum_TypeString },
+#endif
+};
+
+FOOTPRINT_RECORD(IPSODigitalInput)
+FOOTPRINT_RECORD(DigitalInputState)
 
 /***************************************************************************************************
  * Implementation
  **************************************************************************************************/
 
+/* Returns the client's record for an instance, or NULL if out of range or out of memory */
+static IPSODigitalInput *DigitalInput_GetInput(void *context, ObjectInstanceIDType objectInstanceID)
+{
+	DigitalInputState *state;
+
+	if (objectInstanceID < 0 || objectInstanceID >= DIGITAL_INPUTS ||
+		(state = ClientState_Get(context, &digitalInputStateDefinition)) == NULL)
+	{
+		return NULL;
+	}
+	return &state->Inputs[objectInstanceID];
+}
+
+#if DIGITAL_INPUT_STRINGS
+static void DigitalInput_CleanupState(void *state)
+{
+	int i;
+
+	for (i = 0; i < DIGITAL_INPUTS; i++)
+	{
+		IPSODigitalInput *input = &((DigitalInputState *)state)->Inputs[i];
+
+#if LWM2M_CLIENT_DIGITAL_INPUT_APPLICATION_TYPE
+		StringTable_Release(input->ApplicationType);
+		Tlv_FreeCachedResource(&input->ApplicationTypeTlv);
+#endif
+#if LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE
+		StringTable_Release(input->SensoryType);
+		Tlv_FreeCachedResource(&input->SensoryTypeTlv);
+#endif
+	}
+}
+#endif
+
+/*
+ * Resets an instance. The cached record buffers are kept, empty, as a reader may be copying them;
+ * they are freed with the client state.
+ */
+static void DigitalInput_ClearInstance(IPSODigitalInput *input)
+{
+	IPSODigitalInput cleared = { 0 };
+
+	SeqLock_WriteBegin(&input->Lock);
+	cleared.Lock = input->Lock;
+#if LWM2M_CLIENT_DIGITAL_INPUT_APPLICATION_TYPE
+	StringTable_Release(input->ApplicationType);
+	cleared.ApplicationTypeTlv = input->ApplicationTypeTlv;
+	Tlv_InvalidateCachedResource(&cleared.ApplicationTypeTlv);
+#endif
+#if LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE
+	StringTable_Release(input->SensoryType);
+	cleared.SensoryTypeTlv = input->SensoryTypeTlv;
+	Tlv_InvalidateCachedResource(&cleared.SensoryTypeTlv);
+#endif
+	memcpy(input, &cleared, sizeof(IPSODigitalInput));
+	SeqLock_WriteEnd(&input->Lock);
+}
+
+/*
+ * Takes a consistent copy of an instance and its strings without shutting writers out. Returns the
+ * sequence the copy was taken at, so a caller reading more of the instance, like its cached
+ * records, can check with SeqLock_ReadRetry() that nothing was written since.
+ */
+static uint32_t DigitalInput_GetSnapshot(IPSODigitalInput *input, DigitalInputSnapshot *snapshot)
+{
+	uint32_t sequence;
+
+	do
+	{
+		sequence = SeqLock_ReadBegin(&input->Lock);
+		memcpy(&snapshot->Input, input, sizeof(IPSODigitalInput));
+#if LWM2M_CLIENT_DIGITAL_INPUT_APPLICATION_TYPE
+		StringTable_Copy(snapshot->Input.ApplicationType, snapshot->ApplicationType,
+			MAX_STR_SIZE);
+#endif
+#if LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE
+		StringTable_Copy(snapshot->Input.SensoryType, snapshot->SensoryType, MAX_STR_SIZE);
+#endif
+	} while (SeqLock_ReadRetry(&input->Lock, sequence));
+	return sequence;
+}
+
 static int DigitalInput_ObjectCreateInstanceHandler(void *context, ObjectIDType objectID,
 	ObjectInstanceIDType objectInstanceID)
 {
@@ -150,6 +345,7 @@ static int DigitalInput_ObjectCreateInstanceHandler(void *context, ObjectIDType
 			objectInstanceID, DIGITAL_INPUTS - 1);
 		return -1;
 	}
+	ResourceVersion_StampInstance(context, objectID, objectInstanceID, false);
 	return objectInstanceID;
 }
 
@@ -162,6 +358,8 @@ static int DigitalInput_ResourceCreateHandler(void *context, ObjectIDType object
 static int DigitalInput_ObjectDeleteHandler(void *context, ObjectIDType objectID,
 	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID)
 {
+	IPSODigitalInput *input;
+
 	if (objectID != IPSO_DIGITAL_INPUT_OBJECT)
 	{
 		Lwm2m_Error("DigitalInput_ObjectDeleteHandler Invalid OIR: %d/%d/%d\n", objectID,
@@ -169,7 +367,7 @@ static int DigitalInput_ObjectDeleteHandler(void *context, ObjectIDType objectID
 		return -1;
 	}
 
-	if(objectInstanceID >= DIGITAL_INPUTS)
+	if ((input = DigitalInput_GetInput(context, objectInstanceID)) == NULL)
 	{
 		Lwm2m_Error("DigitalInput_ObjectDeleteHandler instance number %d out of range (max %d)",
 			objectInstanceID, DIGITAL_INPUTS - 1);
@@ -178,7 +376,8 @@ static int DigitalInput_ObjectDeleteHandler(void *context, ObjectIDType objectID
 
 	if (resourceID == -1)
 	{
-		memset(&digitalInputs[objectInstanceID], 0, sizeof(IPSODigitalInput));
+		DigitalInput_ClearInstance(input);
+		ResourceVersion_StampInstance(context, objectID, objectInstanceID, true);
 	}
 	else
 	{
@@ -188,98 +387,128 @@ static int DigitalInput_ObjectDeleteHandler(void *context, ObjectIDType objectID
 	return 0;
 }
 
-static int DigitalInput_ResourceReadHandler(void *context, ObjectIDType objectID,
-	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
-	ResourceInstanceIDType resourceInstanceID, uint8_t *destBuffer, int destBufferLen)
+/*
+ * Returns the length of the value of a resource in a snapshot and points value at it, or -1 for an
+ * unknown resource.
+ */
+static int DigitalInput_GetResourceValue(const DigitalInputSnapshot *snapshot,
+	ResourceIDType resourceID, const void **value)
 {
-	int result = 0;
+	const IPSODigitalInput *input = &snapshot->Input;
 
 	switch (resourceID)
 	{
 		case IPSO_DIGITAL_INPUT_STATE:
-			result = sizeof(digitalInputs[objectInstanceID].State);
-			memcpy(destBuffer, &digitalInputs[objectInstanceID].State, result);
-			break;
+			*value = &input->State;
+			return sizeof(input->State);
 
 		case IPSO_DIGITAL_INPUT_COUNTER:
-			result = sizeof(digitalInputs[objectInstanceID].Counter);
-			memcpy(destBuffer, &digitalInputs[objectInstanceID].Counter, result);
-			break;
+			*value = &input->Counter;
+			return sizeof(input->Counter);
 
+#if LWM2M_CLIENT_DIGITAL_INPUT_POLARITY
 		case IPSO_DIGITAL_INPUT_POLARITY:
-			result = sizeof(digitalInputs[objectInstanceID].State);
-			memcpy(destBuffer, &digitalInputs[objectInstanceID].State, result);
-			break;
+			*value = &input->Polarity;
+			return sizeof(input->Polarity);
+#endif
 
+#if LWM2M_CLIENT_DIGITAL_INPUT_DEBOUNCE_PERIOD
 		case IPSO_DIGITAL_INPUT_DEBOUNCE_PERIOD:
-			result = sizeof(digitalInputs[objectInstanceID].Counter);
-			memcpy(destBuffer, &digitalInputs[objectInstanceID].Counter, result);
-			break;
+			*value = &input->DebouncePeriod;
+			return sizeof(input->DebouncePeriod);
+#endif
 
 		case IPSO_DIGITAL_INPUT_EDGE_SELECTION:
-			result = sizeof(digitalInputs[objectInstanceID].State);
-			memcpy(destBuffer, &digitalInputs[objectInstanceID].State, result);
-			break;
+			*value = &input->EdgeSelection;
+			return sizeof(input->EdgeSelection);
 
+#if LWM2M_CLIENT_DIGITAL_INPUT_APPLICATION_TYPE
 		case IPSO_APPICATION_TYPE:
-			result = strlen(digitalInputs[objectInstanceID].ApplicationType) + 1;
-			memcpy(destBuffer, digitalInputs[objectInstanceID].ApplicationType, result);
-			break;
+			*value = snapshot->ApplicationType;
+			return strlen(snapshot->ApplicationType) + 1;
+#endif
 
+#if LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE
 		case IPSO_SENSOR_TYPE:
-			result = strlen(digitalInputs[objectInstanceID].SensoryType) + 1;
-			memcpy(destBuffer, digitalInputs[objectInstanceID].SensoryType, result);
-			break;
+			*value = snapshot->SensoryType;
+			return strlen(snapshot->SensoryType) + 1;
+#endif
 
 		default:
-			result = -1;
-			break;
+			*value = NULL;
+			return -1;
 	}
-
-	return result;
 }
 
-static int DigitalInput_ResourceGetLengthHandler(void *context, ObjectIDType objectID,
-	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
-	ResourceInstanceIDType resourceInstanceID)
+/* Resources that almost never change keep their encoded TLV record between reads */
+static TlvCachedResource *DigitalInput_GetResourceCache(IPSODigitalInput *input,
+	ResourceIDType resourceID)
 {
-	int result = 0;
-
 	switch (resourceID)
 	{
-		case IPSO_DIGITAL_INPUT_STATE:
-			result = sizeof(digitalInputs[objectInstanceID].State);
-			break;
+#if LWM2M_CLIENT_DIGITAL_INPUT_APPLICATION_TYPE
+		case IPSO_APPICATION_TYPE:
+			return &input->ApplicationTypeTlv;
+#endif
 
-		case IPSO_DIGITAL_INPUT_COUNTER:
-			result = sizeof(digitalInputs[objectInstanceID].Counter);
-			break;
+#if LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE
+		case IPSO_SENSOR_TYPE:
+			return &input->SensoryTypeTlv;
+#endif
 
-		case IPSO_DIGITAL_INPUT_POLARITY:
-			result = sizeof(digitalInputs[objectInstanceID].State);
-			break;
+		default:
+			return NULL;
+	}
+}
 
-		case IPSO_DIGITAL_INPUT_DEBOUNCE_PERIOD:
-			result = sizeof(digitalInputs[objectInstanceID].Counter);
-			break;
+static int DigitalInput_ResourceReadHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID, uint8_t *destBuffer, int destBufferLen)
+{
+	IPSODigitalInput *input = DigitalInput_GetInput(context, objectInstanceID);
+	DigitalInputSnapshot snapshot;
+	const void *value;
+	int result = -1;
+	DIAGNOSTICS_START(startTime);
 
-		case IPSO_DIGITAL_INPUT_EDGE_SELECTION:
-			result = sizeof(digitalInputs[objectInstanceID].State);
-			break;
+	if (input != NULL)
+	{
+		DigitalInput_GetSnapshot(input, &snapshot);
+		result = DigitalInput_GetResourceValue(&snapshot, resourceID, &value);
+	}
 
-		case IPSO_APPICATION_TYPE:
-			result = strlen(digitalInputs[objectInstanceID].ApplicationType) + 1;
-			break;
+	if (result > destBufferLen)
+	{
+		Lwm2m_Error("DigitalInput_ResourceReadHandler resource %d needs %d bytes, buffer has %d\n",
+			resourceID, result, destBufferLen);
+		result = -1;
+	}
+	else if (result > 0)
+	{
+		memcpy(destBuffer, value, result);
+	}
 
-		case IPSO_SENSOR_TYPE:
-			result = strlen(digitalInputs[objectInstanceID].SensoryType) + 1;
-			break;
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Read, result, startTime);
+	return result;
+}
 
-		default:
-			result = -1;
-			break;
+static int DigitalInput_ResourceGetLengthHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID)
+{
+	IPSODigitalInput *input = DigitalInput_GetInput(context, objectInstanceID);
+	DigitalInputSnapshot snapshot;
+	const void *value;
+	int result = -1;
+	DIAGNOSTICS_START(startTime);
+
+	if (input != NULL)
+	{
+		DigitalInput_GetSnapshot(input, &snapshot);
+		result = DigitalInput_GetResourceValue(&snapshot, resourceID, &value);
 	}
 
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_GetLength, result, startTime);
 	return result;
 }
 
@@ -287,73 +516,121 @@ static int DigitalInput_ResourceWriteHandler(void *context, ObjectIDType objectI
 	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
 	ResourceInstanceIDType resourceInstanceID, uint8_t *srcBuffer, int srcBufferLen, bool *changed)
 {
+	IPSODigitalInput *input = DigitalInput_GetInput(context, objectInstanceID);
+	int64_t offlineValue = 0;
 	int result;
+	DIAGNOSTICS_START(startTime);
+
+	if (input == NULL)
+	{
+		DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Write, -1, startTime);
+		return -1;
+	}
 
+	SeqLock_WriteBegin(&input->Lock);
 	switch(resourceID)
 	{
 		case IPSO_DIGITAL_INPUT_STATE:
 			result = srcBufferLen;
-			memcpy(&digitalInputs[objectInstanceID].State, srcBuffer, result);
+			memcpy(&input->State, srcBuffer, result);
+			offlineValue = input->State;
+			if (input->StateHistory != NULL)
+				ResourceHistory_Append(input->StateHistory,
+					ResourceHistory_GetTime(), input->State);
 			break;
 
 		case IPSO_DIGITAL_INPUT_COUNTER:
 			result = srcBufferLen;
-			memcpy(&digitalInputs[objectInstanceID].Counter, srcBuffer, result);
+			offlineValue = -input->Counter;
+			memcpy(&input->Counter, srcBuffer, result);
+			offlineValue += input->Counter;
 			Lwm2m_Debug("Button %d counter incremented to %d.\n", objectInstanceID + 1,
-				(int)digitalInputs[objectInstanceID].Counter);
+				(int)input->Counter);
+			if (input->CounterHistory != NULL)
+				ResourceHistory_Append(input->CounterHistory,
+					ResourceHistory_GetTime(), input->Counter);
 			break;
 
+#if LWM2M_CLIENT_DIGITAL_INPUT_POLARITY
 		case IPSO_DIGITAL_INPUT_POLARITY:
 			result = srcBufferLen;
-			memcpy(&digitalInputs[objectInstanceID].State, srcBuffer, result);
+			memcpy(&input->Polarity, srcBuffer, result);
 			break;
+#endif
 
+#if LWM2M_CLIENT_DIGITAL_INPUT_DEBOUNCE_PERIOD
 		case IPSO_DIGITAL_INPUT_DEBOUNCE_PERIOD:
 			result = srcBufferLen;
-			memcpy(&digitalInputs[objectInstanceID].Counter, srcBuffer, result);
+			memcpy(&input->DebouncePeriod, srcBuffer, result);
 			break;
+#endif
 
 		case IPSO_DIGITAL_INPUT_EDGE_SELECTION:
 			result = srcBufferLen;
-			memcpy(&digitalInputs[objectInstanceID].State, srcBuffer, result);
+			memcpy(&input->EdgeSelection, srcBuffer, result);
 			break;
 
+#if LWM2M_CLIENT_DIGITAL_INPUT_APPLICATION_TYPE
 		case IPSO_APPICATION_TYPE:
 			result = srcBufferLen;
-			if(result < sizeof(digitalInputs[objectInstanceID].ApplicationType))
-			{
-				memcpy(digitalInputs[objectInstanceID].ApplicationType, srcBuffer, result);
-			}
-			else
+			if(result >= MAX_STR_SIZE)
 			{
 				Lwm2m_Error("DigitalInput_ResourceWriteHandler Application Type string too long: "
 					"%d", result);
 				result = -1;
 			}
+			else if (StringTable_Replace(&input->ApplicationType, (const char *)srcBuffer,
+				result) == -1)
+			{
+				Lwm2m_Error("DigitalInput_ResourceWriteHandler no room for Application Type\n");
+				result = -1;
+			}
+			else
+				Tlv_InvalidateCachedResource(&input->ApplicationTypeTlv);
 			break;
+#endif
 
+#if LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE
 		case IPSO_SENSOR_TYPE:
 			result = srcBufferLen;
-			if(result < sizeof(digitalInputs[objectInstanceID].SensoryType))
-			{
-				memcpy(digitalInputs[objectInstanceID].SensoryType, srcBuffer, result);
-			}
-			else
+			if(result >= MAX_STR_SIZE)
 			{
 				Lwm2m_Error("DigitalInput_ResourceWriteHandler Sensor Type string too long: %d",
 					result);
 				result = -1;
 			}
+			else if (StringTable_Replace(&input->SensoryType, (const char *)srcBuffer,
+				result) == -1)
+			{
+				Lwm2m_Error("DigitalInput_ResourceWriteHandler no room for Sensor Type\n");
+				result = -1;
+			}
+			else
+				Tlv_InvalidateCachedResource(&input->SensoryTypeTlv);
 			break;
+#endif
 
 		default:
 			result = -1;
 			break;
 	}
+	SeqLock_WriteEnd(&input->Lock);
 
 	if(result > 0)
+	{
 		*changed = true;
+		ResourceVersion_Stamp(context, objectID, objectInstanceID, resourceID);
 
+		/* Counter is queued as the increment, so offline increments fold into one sum */
+		if (resourceID == IPSO_DIGITAL_INPUT_STATE || resourceID == IPSO_DIGITAL_INPUT_COUNTER)
+		{
+			OfflineQueue_Record(context, objectID, objectInstanceID, resourceID,
+				resourceID == IPSO_DIGITAL_INPUT_STATE ? OfflineChangeKind_Transition :
+				OfflineChangeKind_Counter, offlineValue, ResourceHistory_GetTime());
+		}
+	}
+
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Write, result, startTime);
 	return result;
 }
 
@@ -361,6 +638,9 @@ static int DigitalInput_ResourceExecuteHandler(void *context, ObjectIDType objec
 	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID, uint8_t *srcBuffer,
 	int srcBufferLen)
 {
+	int result = 0;
+	DIAGNOSTICS_START(startTime);
+
 	if(resourceID == IPSO_DIGITAL_INPUT_COUNTER_RESET)
 	{
 		int64_t zero = 0;
@@ -368,13 +648,15 @@ static int DigitalInput_ResourceExecuteHandler(void *context, ObjectIDType objec
 			IPSO_DIGITAL_INPUT_COUNTER, 0, &zero, sizeof(zero)) == -1)
 		{
 			Lwm2m_Error("Failed to set Counter to %" PRId64 "\n", zero);
-			return -1;
+			result = -1;
 		}
 	}
 	else
-		return -1;
+		result = -1;
 
-	return 0;
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Execute, srcBufferLen,
+		startTime);
+	return result;
 }
 
 /***************************************************************************************************
@@ -388,53 +670,69 @@ int DigitalInput_RegisterDigitalInputObject(Lwm2mContextType * context)
 		MultipleInstancesEnum_Multiple, MandatoryEnum_Optional, \
 		&DigitalInputObjectOperationHandlers);
 
-	REGISTER_DIGITAL_INPUT_RESOURCE(context, "State", IPSO_DIGITAL_INPUT_STATE, \
-		ResourceTypeEnum_TypeBoolean, Operations_R);
-	REGISTER_DIGITAL_INPUT_RESOURCE(context, "Counter", IPSO_DIGITAL_INPUT_COUNTER, \
-		ResourceTypeEnum_TypeInteger, Operations_R);
-	REGISTER_DIGITAL_INPUT_RESOURCE(context, "Polarity", IPSO_DIGITAL_INPUT_POLARITY, \
-		ResourceTypeEnum_TypeBoolean, Operations_RW);
-	REGISTER_DIGITAL_INPUT_RESOURCE(context, "DebouncePeriod", IPSO_DIGITAL_INPUT_DEBOUNCE_PERIOD, \
-		ResourceTypeEnum_TypeInteger, Operations_RW);
-	REGISTER_DIGITAL_INPUT_RESOURCE(context, "EdgeSelection", IPSO_DIGITAL_INPUT_EDGE_SELECTION, \
-		ResourceTypeEnum_TypeInteger, Operations_RW);
-	REGISTER_DIGITAL_INPUT_RESOURCE(context, "CounterReset", IPSO_DIGITAL_INPUT_COUNTER_RESET, \
-		ResourceTypeEnum_TypeNone, Operations_E);
-	REGISTER_DIGITAL_INPUT_RESOURCE(context, "ApplicationType", IPSO_APPICATION_TYPE, \
-		ResourceTypeEnum_TypeString, Operations_R);
-	REGISTER_DIGITAL_INPUT_RESOURCE(context, "SensorType", IPSO_SENSOR_TYPE, \
-		ResourceTypeEnum_TypeString, Operations_R);
-
-	return 0;
+	return Registration_RegisterResources(context, IPSO_DIGITAL_INPUT_OBJECT, digitalInputResources,
+		RESOURCE_DESCRIPTOR_COUNT(digitalInputResources), &DigitalInputResourceOperationHandlers);
 }
 
-int DigitalInput_AddDigitialInput(Lwm2mContextType *context, ObjectInstanceIDType objectInstanceID)
+/* The whole range is checked before any instance is created */
+int DigitalInput_AddDigitalInputs(Lwm2mContextType *context, ObjectInstanceIDType firstInstanceID,
+	int count)
 {
-	if(objectInstanceID < DIGITAL_INPUTS)
+	IPSODigitalInput *inputs = DigitalInput_GetInput(context, firstInstanceID);
+#if LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE
+	char sensoryType[MAX_STR_SIZE];
+	int result;
+#endif
+	int i;
+
+	if (inputs == NULL || count < 1 || count > DIGITAL_INPUTS - firstInstanceID)
 	{
-		CREATE_OBJECT_INSTANCE(context, IPSO_DIGITAL_INPUT_OBJECT, objectInstanceID);
-		CREATE_DIGITAL_INPUT_OPTIONAL_RESOURCE(context, objectInstanceID, \
-			IPSO_DIGITAL_INPUT_COUNTER);
-		CREATE_DIGITAL_INPUT_OPTIONAL_RESOURCE(context, objectInstanceID, \
-			IPSO_DIGITAL_INPUT_COUNTER_RESET);
-		CREATE_DIGITAL_INPUT_OPTIONAL_RESOURCE(context, objectInstanceID, IPSO_SENSOR_TYPE);
-
-		memset(&digitalInputs[objectInstanceID], 0, sizeof(IPSODigitalInput));
-		snprintf(digitalInputs[objectInstanceID].SensoryType, MAX_STR_SIZE, "Button%d",
-			objectInstanceID + 1);
+		Lwm2m_Error("Digital Input instances %d to %d exceed max instances %d\n", firstInstanceID,
+			firstInstanceID + count - 1, DIGITAL_INPUTS);
+		return -1;
 	}
-	else
+
+	if (Registration_CreateInstances(context, IPSO_DIGITAL_INPUT_OBJECT, firstInstanceID, count,
+		digitalInputInstanceResources, RESOURCE_DESCRIPTOR_COUNT(digitalInputInstanceResources))
+		== -1)
 	{
-		Lwm2m_Error("%d instance of Digital Input exceeds max instances %d\n", objectInstanceID,
-			DIGITAL_INPUTS);
 		return -1;
 	}
+
+	for (i = 0; i < count; i++)
+	{
+		DigitalInput_ClearInstance(&inputs[i]);
+#if LWM2M_CLIENT_DIGITAL_INPUT_SENSOR_TYPE
+		snprintf(sensoryType, sizeof(sensoryType), "Button%d", firstInstanceID + i + 1);
+		SeqLock_WriteBegin(&inputs[i].Lock);
+		result = StringTable_Replace(&inputs[i].SensoryType, sensoryType, sizeof(sensoryType));
+		SeqLock_WriteEnd(&inputs[i].Lock);
+		if (result == -1)
+		{
+			Lwm2m_Error("No room for the Sensor Type of Digital Input %d\n", firstInstanceID + i);
+			return -1;
+		}
+#endif
+	}
 	return 0;
 }
 
+int DigitalInput_AddDigitialInput(Lwm2mContextType *context, ObjectInstanceIDType objectInstanceID)
+{
+	return DigitalInput_AddDigitalInputs(context, objectInstanceID, 1);
+}
+
 int DigitalInput_IncrementCounter(Lwm2mContextType *context, ObjectInstanceIDType objectInstanceID)
 {
-	int64_t counter = digitalInputs[objectInstanceID].Counter + 1;
+	IPSODigitalInput *input = DigitalInput_GetInput(context, objectInstanceID);
+	DigitalInputSnapshot snapshot;
+	int64_t counter;
+
+	if (input == NULL)
+		return -1;
+
+	DigitalInput_GetSnapshot(input, &snapshot);
+	counter = snapshot.Input.Counter + 1;
 	if (Lwm2mCore_SetResourceInstanceValue(context, IPSO_DIGITAL_INPUT_OBJECT, objectInstanceID,
 		IPSO_DIGITAL_INPUT_COUNTER, 0, &counter, sizeof(counter)) == -1)
 	{
@@ -443,3 +741,222 @@ int DigitalInput_IncrementCounter(Lwm2mContextType *context, ObjectInstanceIDTyp
 	}
 	return 0;
 }
+
+/*
+ * Sets State, and bumps Counter on an edge picked by Edge Selection, as one atomic update of the
+ * instance, recording the change in history at timeMs. Unlike the LWM2M core this may be called
+ * from any thread, such as one polling GPIOs. Observers are not notified; the core thread picks
+ * the values up on its next read.
+ */
+int DigitalInput_SetInputAt(Lwm2mContextType *context, ObjectInstanceIDType objectInstanceID,
+	bool state, int64_t timeMs)
+{
+	IPSODigitalInput *input = DigitalInput_GetInput(context, objectInstanceID);
+	bool changed, counted = false;
+
+	if (input == NULL)
+		return -1;
+
+	SeqLock_WriteBegin(&input->Lock);
+	if ((changed = state != input->State))
+	{
+		/* Edge Selection is 1 for falling, 2 for rising and 3 for both edges */
+		if ((counted = input->EdgeSelection & (state ? 2 : 1)))
+		{
+			input->Counter++;
+			if (input->CounterHistory != NULL)
+				ResourceHistory_Append(input->CounterHistory, timeMs, input->Counter);
+		}
+		input->State = state;
+		if (input->StateHistory != NULL)
+			ResourceHistory_Append(input->StateHistory, timeMs, state);
+	}
+	SeqLock_WriteEnd(&input->Lock);
+
+	if (changed)
+	{
+		ResourceVersion_Stamp(context, IPSO_DIGITAL_INPUT_OBJECT, objectInstanceID,
+			IPSO_DIGITAL_INPUT_STATE);
+		OfflineQueue_Record(context, IPSO_DIGITAL_INPUT_OBJECT, objectInstanceID,
+			IPSO_DIGITAL_INPUT_STATE, OfflineChangeKind_Transition, state, timeMs);
+		if (counted)
+		{
+			ResourceVersion_Stamp(context, IPSO_DIGITAL_INPUT_OBJECT, objectInstanceID,
+				IPSO_DIGITAL_INPUT_COUNTER);
+			OfflineQueue_Record(context, IPSO_DIGITAL_INPUT_OBJECT, objectInstanceID,
+				IPSO_DIGITAL_INPUT_COUNTER, OfflineChangeKind_Counter, 1, timeMs);
+		}
+	}
+	return 0;
+}
+
+/* As DigitalInput_SetInputAt(), with the change recorded at the current time */
+int DigitalInput_SetInput(Lwm2mContextType *context, ObjectInstanceIDType objectInstanceID,
+	bool state)
+{
+	return DigitalInput_SetInputAt(context, objectInstanceID, state, ResourceHistory_GetTime());
+}
+
+/*
+ * Records every write of State or Counter into history, which stays owned by the caller. Pass
+ * NULL to stop recording. Deleting the instance also stops recording.
+ */
+int DigitalInput_EnableHistory(Lwm2mContextType *context, ObjectInstanceIDType objectInstanceID,
+	ResourceIDType resourceID, ResourceHistory *history)
+{
+	IPSODigitalInput *input = DigitalInput_GetInput(context, objectInstanceID);
+
+	if (input == NULL)
+	{
+		Lwm2m_Error("%d instance of Digital Input exceeds max instances %d\n", objectInstanceID,
+			DIGITAL_INPUTS);
+		return -1;
+	}
+
+	if (resourceID != IPSO_DIGITAL_INPUT_STATE && resourceID != IPSO_DIGITAL_INPUT_COUNTER)
+	{
+		Lwm2m_Error("Digital Input resource %d does not support history\n", resourceID);
+		return -1;
+	}
+
+	SeqLock_WriteBegin(&input->Lock);
+	if (resourceID == IPSO_DIGITAL_INPUT_STATE)
+		input->StateHistory = history;
+	else
+		input->CounterHistory = history;
+	SeqLock_WriteEnd(&input->Lock);
+	return 0;
+}
+
+/*
+ * Serializes the instance from a snapshot, copying cached records under the same sequence and
+ * retrying if a writer got in. Missing cached records are filled afterwards, only if nothing was
+ * written in the meantime, so a read never waits for a writer.
+ */
+int DigitalInput_ReadInstance(Lwm2mContextType *context, ObjectInstanceIDType objectInstanceID,
+	uint8_t *destBuffer, int destBufferLen)
+{
+	const int typeCount = sizeof(digitalInputResourceTypes) / sizeof(digitalInputResourceTypes[0]);
+	int uncachedOffsets[sizeof(digitalInputResourceTypes) / sizeof(digitalInputResourceTypes[0])];
+	IPSODigitalInput *input = DigitalInput_GetInput(context, objectInstanceID);
+	DigitalInputSnapshot snapshot;
+	uint32_t sequence;
+	bool fillCaches;
+	int i, length;
+
+	if (input == NULL)
+		return -1;
+
+	do
+	{
+		sequence = DigitalInput_GetSnapshot(input, &snapshot);
+		fillCaches = false;
+		length = 0;
+
+		for (i = 0; i < typeCount && length != -1; i++)
+		{
+			const TlvResourceType *resource = &digitalInputResourceTypes[i];
+			TlvCachedResource *cache = DigitalInput_GetResourceCache(&snapshot.Input,
+				resource->ResourceID);
+			const void *value;
+			int valueLength;
+			int result;
+
+			uncachedOffsets[i] = -1;
+			if (cache != NULL && cache->Length > 0)
+			{
+				result = Tlv_CopyCachedResource(cache, destBuffer + length,
+					destBufferLen - length);
+			}
+			else
+			{
+				valueLength = DigitalInput_GetResourceValue(&snapshot, resource->ResourceID,
+					&value);
+				if (valueLength <= 0)
+					continue;
+
+				result = Tlv_EncodeResource(destBuffer + length, destBufferLen - length,
+					resource->ResourceID, resource->Type, value, valueLength);
+				if (cache != NULL)
+				{
+					uncachedOffsets[i] = length;
+					fillCaches = true;
+				}
+			}
+			length = result == -1 ? -1 : length + result;
+		}
+	} while (SeqLock_ReadRetry(&input->Lock, sequence));
+
+	/* The snapshot still matches the instance if no writer got in, so its values can be cached */
+	if (length != -1 && fillCaches && SeqLock_TryWriteBegin(&input->Lock, sequence))
+	{
+		for (i = 0; i < typeCount; i++)
+		{
+			const TlvResourceType *resource = &digitalInputResourceTypes[i];
+			const void *value;
+			int valueLength;
+
+			if (uncachedOffsets[i] == -1)
+				continue;
+
+			valueLength = DigitalInput_GetResourceValue(&snapshot, resource->ResourceID, &value);
+			Tlv_EncodeCachedResource(DigitalInput_GetResourceCache(input, resource->ResourceID),
+				destBuffer + uncachedOffsets[i], destBufferLen - uncachedOffsets[i],
+				resource->ResourceID, resource->Type, value, valueLength, MAX_STR_SIZE);
+		}
+		SeqLock_WriteEnd(&input->Lock);
+	}
+	return length;
+}
+
+/*
+ * Adds the given resources (all readable ones when resources is NULL) of the given instances to a
+ * SenML-CBOR payload, all stamped with timeMs.
+ */
+int DigitalInput_EncodeSenML(Lwm2mContextType *context, SenMLCborEncoder *encoder,
+	const ObjectInstanceIDType *instances, int instanceCount, const ResourceIDType *resources,
+	int resourceCount, int64_t timeMs)
+{
+	const int typeCount = sizeof(digitalInputResourceTypes) / sizeof(digitalInputResourceTypes[0]);
+	int i, j, k;
+
+	if (resources == NULL)
+		resourceCount = typeCount;
+
+	for (i = 0; i < instanceCount; i++)
+	{
+		IPSODigitalInput *input = DigitalInput_GetInput(context, instances[i]);
+		DigitalInputSnapshot snapshot;
+
+		if (input == NULL)
+			return -1;
+		DigitalInput_GetSnapshot(input, &snapshot);
+
+		for (j = 0; j < resourceCount; j++)
+		{
+			const TlvResourceType *resource = NULL;
+			const void *value;
+			int valueLength;
+
+			for (k = 0; k < typeCount; k++)
+			{
+				if (resources == NULL ? k == j :
+					digitalInputResourceTypes[k].ResourceID == resources[j])
+				{
+					resource = &digitalInputResourceTypes[k];
+					break;
+				}
+			}
+			if (resource == NULL)
+				return -1;
+
+			valueLength = DigitalInput_GetResourceValue(&snapshot, resource->ResourceID, &value);
+			if (SenMLCbor_AddResource(encoder, IPSO_DIGITAL_INPUT_OBJECT, instances[i],
+				resource->ResourceID, resource->Type, value, valueLength, timeMs) == -1)
+			{
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
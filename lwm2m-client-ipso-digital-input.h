@@ -37,9 +37,24 @@
 #define LWM2M_CLIENT_IPSO_DIGITAL_INPUT_H_
 
 #include "lwm2m_core.h"
+#include "lwm2m-client-senml-cbor.h"
+#include "lwm2m-client-history.h"
 
 int DigitalInput_RegisterDigitalInputObject(Lwm2mContextType * context);
 int DigitalInput_AddDigitialInput(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID);
+int DigitalInput_AddDigitalInputs(Lwm2mContextType * context, ObjectInstanceIDType firstInstanceID,
+	int count);
 int DigitalInput_IncrementCounter(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID);
+int DigitalInput_SetInput(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
+	bool state);
+int DigitalInput_SetInputAt(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
+	bool state, int64_t timeMs);
+int DigitalInput_EnableHistory(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
+	ResourceIDType resourceID, ResourceHistory * history);
+int DigitalInput_ReadInstance(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
+	uint8_t * destBuffer, int destBufferLen);
+int DigitalInput_EncodeSenML(Lwm2mContextType * context, SenMLCborEncoder * encoder,
+	const ObjectInstanceIDType * instances, int instanceCount, const ResourceIDType * resources,
+	int resourceCount, int64_t timeMs);
 
 #endif /* LWM2M_CLIENT_IPSO_DIGITAL_INPUT_H_ */
@@ -40,10 +40,25 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "lwm2m_core.h"
 #include "coap_abstraction.h"
 #include "lwm2m-client-ipso-light-control.h"
+#include "lwm2m-client-tlv.h"
+#include "lwm2m-client-registration.h"
+#include "lwm2m-client-resource-version.h"
+#include "lwm2m-client-offline-queue.h"
+#include "lwm2m-client-senml-cbor.h"
+#include "lwm2m-client-history.h"
+#include "lwm2m-client-seqlock.h"
+#include "lwm2m-client-state.h"
+#include "lwm2m-client-string-table.h"
+#include "lwm2m-client-light-dispatch.h"
+#include "lwm2m-client-light-colour.h"
+#include "lwm2m-client-light-dimming.h"
+#include "lwm2m-client-config.h"
 #include "common.h"
 
 /***************************************************************************************************
@@ -59,34 +74,82 @@
 #define IPSO_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER		5805
 #define IPSO_LIGHT_CONTROL_POWER_FACTOR					5820
 
-#define LIGHT_CONTROLS									2
+#define LIGHT_CONTROL_INITIAL_CAPACITY					4
+#define LIGHT_CONTROL_EMPTY_BUCKET						-1
 
 #define MAX_STR_SIZE									64
 
-#define REGISTER_LIGHT_CONTROL_RESOURCE(context, name, id, type, minInstances, operations) \
-	REGISTER_RESOURCE(context, name, IPSO_LIGHT_CONTROL_OBJECT, id, type, \
-		MultipleInstancesEnum_Single, minInstances, operations, \
-		&LightControlResourceOperationHandlers)
-
-#define CREATE_LIGHT_CONTROL_OPTIONAL_RESOURCE(context, objectInstanceId, resourcId) \
-	CREATE_OPTIONAL_RESOURCE(context, IPSO_LIGHT_CONTROL_OBJECT, objectInstanceId, resourcId)
+#define LIGHT_CONTROL_RESOURCE(name, id, type, minInstances, operations) \
+	{ name, id, type, MultipleInstancesEnum_Single, minInstances, operations }
 
 /***************************************************************************************************
  * Typedefs
  **************************************************************************************************/
 
+/*
+ * Per-instance fields that are not touched on every On/Off or Dimmer change, in one cache line
+ * aligned record. Its sequence lock also guards the slot's entries in the hot arrays.
+ */
+typedef struct SEQLOCK_ALIGNED
+{
+	SeqLock Lock;
+	StringHandle Colour;
+	LightColour ColourValue;			/* Colour parsed when it is written */
+	LightDimmingCurve DimmingCurve;
+	LightDimmingResolution DimmingResolution;
+	StringHandle Units;
+	int64_t OnTime;
+#if LWM2M_CLIENT_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER
+	float CumulativeActivePower;
+	double EnergyWh;
+	int64_t PowerChangeTime;
+#endif
+#if LWM2M_CLIENT_LIGHT_CONTROL_POWER_FACTOR
+	float PowerFactor;
+#endif
+	float RatedPower;
+	float ActivePower;
+	bool DimmerWritten;					/* until then power is worked out at full brightness */
+	LightControlPowerCallBack PowerCallback;
+	void * PowerContext;
+	TlvCachedResource ColourTlv;
+	TlvCachedResource UnitsTlv;
+	ResourceHistory * OnOffHistory;
+	ResourceHistory * DimmerHistory;
+} IPSOLightControl;
+
+/* Consistent copy of one instance, hot fields included, with its strings copied out of the table */
 typedef struct
 {
 	bool OnOff;
 	int64_t Dimmer;
+	IPSOLightControl Light;
 	char Colour[MAX_STR_SIZE];
 	char Units[MAX_STR_SIZE];
-	int64_t OnTime;
-	float CumulativeActivePower;
-	float PowerFactor;
-	LightControlCallBack callback;
-	void * context;
-} IPSOLightControl;
+} LightControlSnapshot;
+
+/*
+ * Instances live in dense slots, so iterating over all of them walks contiguous arrays. Sparse
+ * instance IDs map to slots through an open-addressing hash table with linear probing. Deleting an
+ * instance moves the last slot into the hole. Adding and deleting instances may move slots, so it
+ * must not race with other threads using the object; values are read and written concurrently
+ * through each slot's sequence lock.
+ */
+typedef struct
+{
+	int Count;
+	int Capacity;
+	ObjectInstanceIDType * InstanceIDs;
+	bool * OnOff;
+	int64_t * Dimmer;
+	LightControlCallBack * Callbacks;
+	LightControlOutputCallBack * OutputCallbacks;
+	void ** CallbackContexts;
+	IPSOLightControl * Cold;
+	int * Buckets;
+	int BucketCount;
+	LightDispatcher * Dispatcher;
+} LightControlStore;
 
 /***************************************************************************************************
  * Prototypes
@@ -115,6 +178,8 @@ static int LightControl_ObjectCreateInstanceHandler(void * context, ObjectIDType
 static int LightControl_ObjectDeleteHandler(void * context, ObjectIDType objectID,
 	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID);
 
+static void LightControl_CleanupState(void * state);
+
 /***************************************************************************************************
  * Globals
  **************************************************************************************************/
@@ -134,22 +199,466 @@ static ResourceOperationHandlers LightControlResourceOperationHandlers =
 	.Execute = NULL,
 };
 
-static IPSOLightControl LightControls[LIGHT_CONTROLS];
+static const ClientStateDefinition lightControlStateDefinition =
+{
+	.Slot = ClientStateSlot_LightControl,
+	.Size = sizeof(LightControlStore),
+	.Cleanup = LightControl_CleanupState,
+};
+
+/* Every resource, in the order they are registered */
+static const ResourceDescriptor lightControlResources[] =
+{
+	LIGHT_CONTROL_RESOURCE("On/Off", IPSO_LIGHT_CONTROL_ON_OFF, ResourceTypeEnum_TypeBoolean,
+		MandatoryEnum_Mandatory, Operations_RW),
+	LIGHT_CONTROL_RESOURCE("Dimmer", IPSO_LIGHT_CONTROL_DIMMER, ResourceTypeEnum_TypeInteger,
+		MandatoryEnum_Optional, Operations_RW),
+	LIGHT_CONTROL_RESOURCE("Colour", IPSO_LIGHT_CONTROL_COLOUR, ResourceTypeEnum_TypeString,
+		MandatoryEnum_Optional, Operations_RW),
+	LIGHT_CONTROL_RESOURCE("Units", IPSO_LIGHT_CONTROL_UNITS, ResourceTypeEnum_TypeString,
+		MandatoryEnum_Mandatory, Operations_R),
+	LIGHT_CONTROL_RESOURCE("OnTime", IPSO_LIGHT_CONTROL_ON_TIME, ResourceTypeEnum_TypeInteger,
+		MandatoryEnum_Optional, Operations_RW),
+#if LWM2M_CLIENT_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER
+	LIGHT_CONTROL_RESOURCE("CumulativeActivePower", IPSO_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER,
+		ResourceTypeEnum_TypeFloat, MandatoryEnum_Optional, Operations_R),
+#endif
+#if LWM2M_CLIENT_LIGHT_CONTROL_POWER_FACTOR
+	LIGHT_CONTROL_RESOURCE("PowerFactor", IPSO_LIGHT_CONTROL_POWER_FACTOR,
+		ResourceTypeEnum_TypeFloat, MandatoryEnum_Optional, Operations_R),
+#endif
+};
+
+/* Optional resources created with every instance */
+static const ResourceIDType lightControlInstanceResources[] =
+{
+	IPSO_LIGHT_CONTROL_ON_OFF,
+	IPSO_LIGHT_CONTROL_COLOUR,
+	IPSO_LIGHT_CONTROL_ON_TIME,
+};
+
+/* Readable resources, in the order a whole-instance read serializes them */
+static const TlvResourceType lightControlResourceTypes[] =
+{
+	{ IPSO_LIGHT_CONTROL_ON_OFF, ResourceTypeEnum_TypeBoolean },
+	{ IPSO_LIGHT_CONTROL_DIMMER, ResourceTypeEnum_TypeInteger },
+	{ IPSO_LIGHT_CONTROL_COLOUR, ResourceTypeEnum_TypeString },
+	{ IPSO_LIGHT_CONTROL_UNITS, ResourceTypeEnum_TypeString },
+	{ IPSO_LIGHT_CONTROL_ON_TIME, ResourceTypeEnum_TypeInteger },
+#if LWM2M_CLIENT_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER
+	{ IPSO_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER, ResourceTypeEnum_TypeFloat },
+#endif
+#if LWM2M_CLIENT_LIGHT_CONTROL_POWER_FACTOR
+	{ IPSO_LIGHT_CONTROL_POWER_FACTOR, ResourceTypeEnum_TypeFloat },
+#endif
+};
+
+FOOTPRINT_RECORD(IPSOLightControl)
+FOOTPRINT_RECORD(LightControlStore)
 
 /***************************************************************************************************
  * Implementation
  **************************************************************************************************/
 
+static LightControlStore * LightControl_GetStore(void * context)
+{
+	return ClientState_Get(context, &lightControlStateDefinition);
+}
+
+/*
+ * Copies what the driver callbacks need, with Dimmer clamped to 0 to 100 rather than truncated.
+ * Called with the slot's sequence lock held for writing.
+ */
+static void LightControl_GetOutput(LightControlStore * store, int slot, LightControlOutput * output)
+{
+	const IPSOLightControl * light = &store->Cold[slot];
+	int64_t dimmer = store->Dimmer[slot];
+
+	output->OnOff = store->OnOff[slot];
+	output->Dimmer = dimmer < 0 ? 0 : dimmer > 100 ? 100 : dimmer;
+	output->Colour = light->ColourValue;
+	output->Curve = light->DimmingCurve;
+	output->Resolution = light->DimmingResolution;
+}
+
+/* Takes Dimmer through the dimming curve, so the driver only has to write the results out */
+static void LightControl_SetLevels(LightControlOutput * output)
+{
+	if (!output->OnOff)
+	{
+		output->Level = 0;
+		memset(output->Duty, 0, sizeof(output->Duty));
+		return;
+	}
+
+	output->Level = LightDimming_ToPwm(output->Curve, output->Resolution, output->Dimmer);
+	LightDimming_ScaleChannels(output->Curve, output->Resolution, output->Dimmer,
+		output->Colour.Duty, output->Duty, LIGHT_COLOUR_CHANNELS);
+}
+
+/* Runs the driver callback, or queues it when a dispatcher takes callbacks off this thread */
+static void LightControl_Notify(void * context, LightControlStore * store, int slot,
+	ObjectInstanceIDType objectInstanceID, LightControlOutput * output, const char * colour)
+{
+	if (store->OutputCallbacks[slot] != NULL)
+	{
+		LightControl_SetLevels(output);
+		if (store->Dispatcher == NULL)
+			store->OutputCallbacks[slot](store->CallbackContexts[slot], output);
+		else if (LightDispatcher_SubmitOutput(store->Dispatcher, context, objectInstanceID,
+			store->OutputCallbacks[slot], store->CallbackContexts[slot], output, colour) == -1)
+		{
+			Lwm2m_Debug("Dropped update of Light Control %d\n", objectInstanceID);
+		}
+		return;
+	}
+
+	if (store->Callbacks[slot] == NULL)
+		return;
+
+	if (store->Dispatcher != NULL)
+	{
+		if (LightDispatcher_Submit(store->Dispatcher, context, objectInstanceID,
+			store->Callbacks[slot], store->CallbackContexts[slot], output->OnOff, output->Dimmer,
+			colour) == -1)
+		{
+			Lwm2m_Debug("Dropped update of Light Control %d\n", objectInstanceID);
+		}
+	}
+	else
+	{
+		store->Callbacks[slot](store->CallbackContexts[slot], output->OnOff, output->Dimmer,
+			colour);
+	}
+}
+
+/* Frees the slot arrays; the store itself goes with the client's arena */
+static void LightControl_CleanupState(void * state)
+{
+	LightControlStore * store = state;
+	int slot;
+
+	for (slot = 0; slot < store->Count; slot++)
+	{
+		StringTable_Release(store->Cold[slot].Colour);
+		StringTable_Release(store->Cold[slot].Units);
+		Tlv_FreeCachedResource(&store->Cold[slot].ColourTlv);
+		Tlv_FreeCachedResource(&store->Cold[slot].UnitsTlv);
+	}
+	free(store->InstanceIDs);
+	free(store->OnOff);
+	free(store->Dimmer);
+	free(store->Callbacks);
+	free(store->OutputCallbacks);
+	free(store->CallbackContexts);
+	free(store->Cold);
+	free(store->Buckets);
+}
+
+static uint32_t LightControl_Hash(ObjectInstanceIDType objectInstanceID)
+{
+	return (uint32_t)objectInstanceID * 2654435761u;
+}
+
+static int LightControl_FindBucket(LightControlStore * store,
+	ObjectInstanceIDType objectInstanceID)
+{
+	int mask;
+	int bucket;
+
+	if (store == NULL || store->BucketCount == 0)
+		return -1;
+	mask = store->BucketCount - 1;
+
+	for (bucket = LightControl_Hash(objectInstanceID) & mask;
+		store->Buckets[bucket] != LIGHT_CONTROL_EMPTY_BUCKET;
+		bucket = (bucket + 1) & mask)
+	{
+		if (store->InstanceIDs[store->Buckets[bucket]] == objectInstanceID)
+			return bucket;
+	}
+	return -1;
+}
+
+/* Returns the slot holding an instance, or -1 if it does not exist */
+static int LightControl_FindSlot(LightControlStore * store,
+	ObjectInstanceIDType objectInstanceID)
+{
+	int bucket = LightControl_FindBucket(store, objectInstanceID);
+
+	return bucket == -1 ? -1 : store->Buckets[bucket];
+}
+
+static void LightControl_PlaceSlot(LightControlStore * store, int slot)
+{
+	int mask = store->BucketCount - 1;
+	int bucket = LightControl_Hash(store->InstanceIDs[slot]) & mask;
+
+	while (store->Buckets[bucket] != LIGHT_CONTROL_EMPTY_BUCKET)
+		bucket = (bucket + 1) & mask;
+	store->Buckets[bucket] = slot;
+}
+
+/* Empties a bucket, shifting later entries of the same probe run back so no tombstone is needed */
+static void LightControl_RemoveBucket(LightControlStore * store, int bucket)
+{
+	int mask = store->BucketCount - 1;
+	int next = bucket;
+
+	for (;;)
+	{
+		int home;
+
+		next = (next + 1) & mask;
+		if (store->Buckets[next] == LIGHT_CONTROL_EMPTY_BUCKET)
+			break;
+
+		home = LightControl_Hash(store->InstanceIDs[store->Buckets[next]]) & mask;
+		if (((next - home) & mask) >= ((next - bucket) & mask))
+		{
+			store->Buckets[bucket] = store->Buckets[next];
+			bucket = next;
+		}
+	}
+	store->Buckets[bucket] = LIGHT_CONTROL_EMPTY_BUCKET;
+}
+
+/* Rehashes into enough buckets to keep the table at most half full with count instances */
+static int LightControl_GrowBuckets(LightControlStore * store, int count)
+{
+	int bucketCount = store->BucketCount == 0 ? 2 * LIGHT_CONTROL_INITIAL_CAPACITY :
+		2 * store->BucketCount;
+	int * buckets;
+	int i;
+
+	while (bucketCount < 2 * count)
+		bucketCount *= 2;
+	buckets = malloc(bucketCount * sizeof(int));
+
+	if (buckets == NULL)
+		return -1;
+
+	free(store->Buckets);
+	store->Buckets = buckets;
+	store->BucketCount = bucketCount;
+
+	for (i = 0; i < bucketCount; i++)
+		buckets[i] = LIGHT_CONTROL_EMPTY_BUCKET;
+	for (i = 0; i < store->Count; i++)
+		LightControl_PlaceSlot(store, i);
+	return 0;
+}
+
+#define GROW_SLOT_ARRAY(array, capacity)                                                           \
+	do                                                                                             \
+	{                                                                                              \
+		void * grown = realloc(array, (capacity) * sizeof(*(array)));                              \
+		if (grown == NULL)                                                                         \
+			return -1;                                                                             \
+		array = grown;                                                                             \
+	}while(0)
+
+/* Grows the slot arrays to hold at least count instances */
+static int LightControl_GrowSlots(LightControlStore * store, int count)
+{
+	int capacity = store->Capacity == 0 ? LIGHT_CONTROL_INITIAL_CAPACITY : 2 * store->Capacity;
+	void * cold;
+
+	if (capacity < count)
+		capacity = count;
+
+	GROW_SLOT_ARRAY(store->InstanceIDs, capacity);
+	GROW_SLOT_ARRAY(store->OnOff, capacity);
+	GROW_SLOT_ARRAY(store->Dimmer, capacity);
+	GROW_SLOT_ARRAY(store->Callbacks, capacity);
+	GROW_SLOT_ARRAY(store->OutputCallbacks, capacity);
+	GROW_SLOT_ARRAY(store->CallbackContexts, capacity);
+
+	/* realloc() does not keep the cache line alignment of the records */
+	if (posix_memalign(&cold, SEQLOCK_CACHE_LINE_SIZE, capacity * sizeof(IPSOLightControl)) != 0)
+		return -1;
+	if (store->Count > 0)
+		memcpy(cold, store->Cold, store->Count * sizeof(IPSOLightControl));
+	free(store->Cold);
+	store->Cold = cold;
+
+	store->Capacity = capacity;
+	return 0;
+}
+
+#if LWM2M_CLIENT_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER
+static int64_t LightControl_GetTime(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+#endif
+
+/*
+ * Adds the energy used at the previous power level to Cumulative Active Power, then works out the
+ * power for the current On/Off and Dimmer and reports any change to the attached meter.
+ */
+static void LightControl_UpdatePower(LightControlStore * store, int slot)
+{
+	IPSOLightControl * light = &store->Cold[slot];
+#if LWM2M_CLIENT_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER
+	int64_t now = LightControl_GetTime();
+#endif
+	float power = 0;
+
+	if (store->OnOff[slot])
+	{
+		int64_t dimmer = light->DimmerWritten ? store->Dimmer[slot] : 100;
+
+		dimmer = dimmer < 0 ? 0 : dimmer > 100 ? 100 : dimmer;
+		power = light->RatedPower * dimmer / 100;
+	}
+
+#if LWM2M_CLIENT_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER
+	if (light->PowerChangeTime != 0)
+	{
+		light->EnergyWh += light->ActivePower * (now - light->PowerChangeTime) / 3600000.0;
+		light->CumulativeActivePower = light->EnergyWh;
+	}
+	light->PowerChangeTime = now;
+#endif
+
+	if (power != light->ActivePower)
+	{
+		float oldPower = light->ActivePower;
+
+		light->ActivePower = power;
+		if (light->PowerCallback != NULL)
+			light->PowerCallback(light->PowerContext, oldPower, power);
+	}
+}
+
+static void LightControl_ClearInstance(LightControlStore * store, int slot)
+{
+	IPSOLightControl * light = &store->Cold[slot];
+	SeqLock lock;
+
+	SeqLock_WriteBegin(&light->Lock);
+	if (light->PowerCallback != NULL && light->ActivePower != 0)
+		light->PowerCallback(light->PowerContext, light->ActivePower, 0);
+
+	StringTable_Release(light->Colour);
+	StringTable_Release(light->Units);
+	Tlv_FreeCachedResource(&light->ColourTlv);
+	Tlv_FreeCachedResource(&light->UnitsTlv);
+	lock = light->Lock;
+	memset(light, 0, sizeof(IPSOLightControl));
+	light->Lock = lock;
+	LightColour_Parse("", &light->ColourValue);
+	store->OnOff[slot] = false;
+	store->Dimmer[slot] = 0;
+	store->Callbacks[slot] = NULL;
+	store->OutputCallbacks[slot] = NULL;
+	store->CallbackContexts[slot] = NULL;
+	SeqLock_WriteEnd(&light->Lock);
+}
+
+/*
+ * Takes a consistent copy of a slot and its strings without shutting writers out. Returns the
+ * sequence the copy was taken at, so a caller reading more of the slot, like its cached records,
+ * can check with SeqLock_ReadRetry() that nothing was written since.
+ */
+static uint32_t LightControl_GetSnapshot(LightControlStore * store, int slot,
+	LightControlSnapshot * snapshot)
+{
+	IPSOLightControl * light = &store->Cold[slot];
+	uint32_t sequence;
+
+	do
+	{
+		sequence = SeqLock_ReadBegin(&light->Lock);
+		snapshot->OnOff = store->OnOff[slot];
+		snapshot->Dimmer = store->Dimmer[slot];
+		memcpy(&snapshot->Light, light, sizeof(IPSOLightControl));
+		StringTable_Copy(snapshot->Light.Colour, snapshot->Colour, MAX_STR_SIZE);
+		StringTable_Copy(snapshot->Light.Units, snapshot->Units, MAX_STR_SIZE);
+	} while (SeqLock_ReadRetry(&light->Lock, sequence));
+
+	return sequence;
+}
+
+/* Makes room for count more instances at once, so adding many does not grow the store repeatedly */
+static int LightControl_ReserveInstances(LightControlStore * store, int count)
+{
+	int total = store->Count + count;
+
+	if ((total > store->Capacity && LightControl_GrowSlots(store, total) == -1) ||
+		(2 * total > store->BucketCount && LightControl_GrowBuckets(store, total) == -1))
+		return -1;
+	return 0;
+}
+
+/* Returns the slot of the instance, adding an empty one if it does not exist yet */
+static int LightControl_InsertInstance(LightControlStore * store,
+	ObjectInstanceIDType objectInstanceID)
+{
+	int slot = LightControl_FindSlot(store, objectInstanceID);
+
+	if (slot != -1 || store == NULL)
+		return slot;
+
+	if (LightControl_ReserveInstances(store, 1) == -1)
+	{
+		Lwm2m_Error("LightControl_InsertInstance out of memory for instance %d\n",
+			objectInstanceID);
+		return -1;
+	}
+
+	slot = store->Count++;
+	store->InstanceIDs[slot] = objectInstanceID;
+	memset(&store->Cold[slot], 0, sizeof(IPSOLightControl));
+	LightControl_ClearInstance(store, slot);
+	LightControl_PlaceSlot(store, slot);
+	return slot;
+}
+
+static int LightControl_RemoveInstance(LightControlStore * store,
+	ObjectInstanceIDType objectInstanceID)
+{
+	int bucket = LightControl_FindBucket(store, objectInstanceID);
+	int slot, last;
+
+	if (bucket == -1)
+		return -1;
+
+	slot = store->Buckets[bucket];
+	LightControl_ClearInstance(store, slot);
+	LightControl_RemoveBucket(store, bucket);
+
+	last = --store->Count;
+	if (slot != last)
+	{
+		bucket = LightControl_FindBucket(store, store->InstanceIDs[last]);
+		store->Buckets[bucket] = slot;
+		store->InstanceIDs[slot] = store->InstanceIDs[last];
+		store->OnOff[slot] = store->OnOff[last];
+		store->Dimmer[slot] = store->Dimmer[last];
+		store->Callbacks[slot] = store->Callbacks[last];
+		store->OutputCallbacks[slot] = store->OutputCallbacks[last];
+		store->CallbackContexts[slot] = store->CallbackContexts[last];
+		store->Cold[slot] = store->Cold[last];
+	}
+	return 0;
+}
+
 static int LightControl_ObjectCreateInstanceHandler(void * context, ObjectIDType objectID,
 	ObjectInstanceIDType objectInstanceID)
 {
-	if(objectInstanceID >= LIGHT_CONTROLS)
+	if (LightControl_InsertInstance(LightControl_GetStore(context), objectInstanceID) == -1)
 	{
-		Lwm2m_Error("LightControl_ResourceCreateHandler instance number %d out of range (max %d)",
-			objectInstanceID, LIGHT_CONTROLS - 1);
+		Lwm2m_Error("LightControl_ObjectCreateInstanceHandler failed to add instance %d\n",
+			objectInstanceID);
 		return -1;
 	}
 
+	ResourceVersion_StampInstance(context, objectID, objectInstanceID, false);
 	return objectInstanceID;
 }
 
@@ -162,6 +671,8 @@ static int LightControl_ResourceCreateHandler(void * context, ObjectIDType objec
 static int LightControl_ObjectDeleteHandler(void * context, ObjectIDType objectID,
 	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID)
 {
+	LightControlStore * store = LightControl_GetStore(context);
+
 	if (objectID != IPSO_LIGHT_CONTROL_OBJECT)
 	{
 		Lwm2m_Error("LightControl_ObjectDeleteHandler Invalid OIR: %d/%d/%d\n", objectID,
@@ -169,16 +680,17 @@ static int LightControl_ObjectDeleteHandler(void * context, ObjectIDType objectI
 		return -1;
 	}
 
-	if(objectInstanceID >= LIGHT_CONTROLS)
+	if (LightControl_FindSlot(store, objectInstanceID) == -1)
 	{
-		Lwm2m_Error("LightControl_ObjectDeleteHandler instance number %d out of range (max %d)",
-			objectInstanceID, LIGHT_CONTROLS - 1);
+		Lwm2m_Error("LightControl_ObjectDeleteHandler instance %d does not exist\n",
+			objectInstanceID);
 		return -1;
 	}
 
 	if (resourceID == -1)
 	{
-		memset(&LightControls[objectInstanceID], 0, sizeof(IPSOLightControl));
+		LightControl_RemoveInstance(store, objectInstanceID);
+		ResourceVersion_StampInstance(context, objectID, objectInstanceID, true);
 	}
 	else
 	{
@@ -188,182 +700,304 @@ static int LightControl_ObjectDeleteHandler(void * context, ObjectIDType objectI
 	return 0;
 }
 
-static int LightControl_ResourceReadHandler(void * context, ObjectIDType objectID,
-	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
-	ResourceInstanceIDType resourceInstanceID, uint8_t * destBuffer, int destBufferLen)
+/*
+ * Returns the length of the current value of a resource and points value at it, or -1 for an
+ * unknown resource.
+ */
+static int LightControl_GetResourceValue(const LightControlSnapshot * snapshot,
+	ResourceIDType resourceID, const void ** value)
 {
-	int result = 0;
+	const IPSOLightControl * light = &snapshot->Light;
 
 	switch (resourceID)
 	{
 		case IPSO_LIGHT_CONTROL_ON_OFF:
-			result = sizeof(LightControls[objectInstanceID].OnOff);
-			memcpy(destBuffer, &LightControls[objectInstanceID].OnOff, result);
-			break;
+			*value = &snapshot->OnOff;
+			return sizeof(snapshot->OnOff);
 
 		case IPSO_LIGHT_CONTROL_DIMMER:
-			result = sizeof(LightControls[objectInstanceID].Dimmer);
-			memcpy(destBuffer, &LightControls[objectInstanceID].Dimmer, result);
-			break;
+			*value = &snapshot->Dimmer;
+			return sizeof(snapshot->Dimmer);
 
 		case IPSO_LIGHT_CONTROL_COLOUR:
-			result = strlen(LightControls[objectInstanceID].Colour) + 1;
-			memcpy(destBuffer, LightControls[objectInstanceID].Colour, result);
-			break;
+			*value = snapshot->Colour;
+			return strlen(snapshot->Colour) + 1;
 
 		case IPSO_LIGHT_CONTROL_UNITS:
-			result = strlen(LightControls[objectInstanceID].Units) + 1;
-			memcpy(destBuffer, LightControls[objectInstanceID].Units, result);
-			break;
+			*value = snapshot->Units;
+			return strlen(snapshot->Units) + 1;
 
 		case IPSO_LIGHT_CONTROL_ON_TIME:
-			result = sizeof(LightControls[objectInstanceID].OnTime);
-			memcpy(destBuffer, &LightControls[objectInstanceID].OnTime, result);
-			break;
+			*value = &light->OnTime;
+			return sizeof(light->OnTime);
 
+#if LWM2M_CLIENT_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER
 		case IPSO_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER:
-			result = sizeof(LightControls[objectInstanceID].CumulativeActivePower);
-			memcpy(destBuffer, &LightControls[objectInstanceID].CumulativeActivePower, result);
-			break;
+			*value = &light->CumulativeActivePower;
+			return sizeof(light->CumulativeActivePower);
+#endif
 
+#if LWM2M_CLIENT_LIGHT_CONTROL_POWER_FACTOR
 		case IPSO_LIGHT_CONTROL_POWER_FACTOR:
-			result = sizeof(LightControls[objectInstanceID].PowerFactor);
-			memcpy(destBuffer, &LightControls[objectInstanceID].PowerFactor, result);
-			break;
+			*value = &light->PowerFactor;
+			return sizeof(light->PowerFactor);
+#endif
 
 		default:
-			result = -1;
-			break;
+			*value = NULL;
+			return -1;
 	}
-
-	return result;
 }
 
-static int LightControl_ResourceGetLengthHandler(void * context, ObjectIDType objectID,
-	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
-	ResourceInstanceIDType resourceInstanceID)
+/* Resources that almost never change keep their encoded TLV record between reads */
+static TlvCachedResource * LightControl_GetResourceCache(IPSOLightControl * light,
+	ResourceIDType resourceID)
 {
-	int result = 0;
-
 	switch (resourceID)
 	{
-		case IPSO_LIGHT_CONTROL_ON_OFF:
-			result = sizeof(LightControls[objectInstanceID].OnOff);
-			break;
-
-		case IPSO_LIGHT_CONTROL_DIMMER:
-			result = sizeof(LightControls[objectInstanceID].Dimmer);
-			break;
-
 		case IPSO_LIGHT_CONTROL_COLOUR:
-			result = strlen(LightControls[objectInstanceID].Colour) + 1;
-			break;
+			return &light->ColourTlv;
 
 		case IPSO_LIGHT_CONTROL_UNITS:
-			result = strlen(LightControls[objectInstanceID].Units) + 1;
-			break;
+			return &light->UnitsTlv;
 
-		case IPSO_LIGHT_CONTROL_ON_TIME:
-			result = sizeof(LightControls[objectInstanceID].OnTime);
-			break;
+		default:
+			return NULL;
+	}
+}
 
-		case IPSO_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER:
-			result = sizeof(LightControls[objectInstanceID].CumulativeActivePower);
-			break;
+static int LightControl_ResourceReadHandler(void * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID, uint8_t * destBuffer, int destBufferLen)
+{
+	LightControlSnapshot snapshot;
+	const void * value;
+	LightControlStore * store = LightControl_GetStore(context);
+	int slot = LightControl_FindSlot(store, objectInstanceID);
+	int result = -1;
+	DIAGNOSTICS_START(startTime);
+
+	if (slot == -1)
+		Lwm2m_Error("LightControl_ResourceReadHandler instance %d does not exist\n",
+			objectInstanceID);
+	else
+	{
+		LightControl_GetSnapshot(store, slot, &snapshot);
+		result = LightControl_GetResourceValue(&snapshot, resourceID, &value);
+	}
 
-		case IPSO_LIGHT_CONTROL_POWER_FACTOR:
-			result = sizeof(LightControls[objectInstanceID].PowerFactor);
-			break;
+	if (result > destBufferLen)
+	{
+		Lwm2m_Error("LightControl_ResourceReadHandler resource %d needs %d bytes, buffer has %d\n",
+			resourceID, result, destBufferLen);
+		result = -1;
+	}
+	else if (result > 0)
+	{
+		memcpy(destBuffer, value, result);
+	}
 
-		default:
-			result = -1;
-			break;
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Read, result, startTime);
+	return result;
+}
+
+static int LightControl_ResourceGetLengthHandler(void * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID)
+{
+	LightControlSnapshot snapshot;
+	const void * value;
+	LightControlStore * store = LightControl_GetStore(context);
+	int slot = LightControl_FindSlot(store, objectInstanceID);
+	int result = -1;
+	DIAGNOSTICS_START(startTime);
+
+	if (slot != -1)
+	{
+		LightControl_GetSnapshot(store, slot, &snapshot);
+		result = LightControl_GetResourceValue(&snapshot, resourceID, &value);
 	}
 
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_GetLength, result, startTime);
 	return result;
 }
 
+/*
+ * Copies a fixed size value from a write. The hot fields of neighbouring instances sit next to each
+ * other, so a value of any other length is rejected rather than copied over them.
+ */
+static int LightControl_WriteValue(void * value, int valueLen, const uint8_t * srcBuffer,
+	int srcBufferLen)
+{
+	if (srcBufferLen != valueLen)
+	{
+		Lwm2m_Error("LightControl_ResourceWriteHandler expected %d bytes, got %d\n", valueLen,
+			srcBufferLen);
+		return -1;
+	}
+	memcpy(value, srcBuffer, srcBufferLen);
+	return srcBufferLen;
+}
+
 static int LightControl_ResourceWriteHandler(void * context, ObjectIDType objectID,
 	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
 	ResourceInstanceIDType resourceInstanceID, uint8_t * srcBuffer, int srcBufferLen, bool * changed)
 {
 	int result;
 	bool CallCallback = false;
+	bool powerChanged = false;
+	LightControlStore * store = LightControl_GetStore(context);
+	int slot = LightControl_FindSlot(store, objectInstanceID);
+	IPSOLightControl * light;
+	bool onOff;
+	int64_t dimmer, onTime;
+	char colour[MAX_STR_SIZE];
+	LightControlOutput output;
+	DIAGNOSTICS_START(startTime);
+
+	if (slot == -1)
+	{
+		Lwm2m_Error("LightControl_ResourceWriteHandler instance %d does not exist\n",
+			objectInstanceID);
+		DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Write, -1, startTime);
+		return -1;
+	}
+	light = &store->Cold[slot];
 
+	SeqLock_WriteBegin(&light->Lock);
 	switch(resourceID)
 	{
 		case IPSO_LIGHT_CONTROL_ON_OFF:
-			result = srcBufferLen;
-			memcpy(&LightControls[objectInstanceID].OnOff, srcBuffer, result);
+			result = LightControl_WriteValue(&store->OnOff[slot], sizeof(store->OnOff[slot]),
+				srcBuffer, srcBufferLen);
+			if (result == -1)
+				break;
+			if (light->OnOffHistory != NULL)
+				ResourceHistory_Append(light->OnOffHistory, ResourceHistory_GetTime(),
+					store->OnOff[slot]);
 			CallCallback = true;
+			powerChanged = true;
 			break;
 
 		case IPSO_LIGHT_CONTROL_DIMMER:
-			result = srcBufferLen;
-			memcpy(&LightControls[objectInstanceID].Dimmer, srcBuffer, result);
+			result = LightControl_WriteValue(&store->Dimmer[slot], sizeof(store->Dimmer[slot]),
+				srcBuffer, srcBufferLen);
+			if (result == -1)
+				break;
+			light->DimmerWritten = true;
+			if (light->DimmerHistory != NULL)
+				ResourceHistory_Append(light->DimmerHistory, ResourceHistory_GetTime(),
+					store->Dimmer[slot]);
 			CallCallback = true;
+			powerChanged = true;
 			break;
 
 		case IPSO_LIGHT_CONTROL_COLOUR:
 			result = srcBufferLen;
-			if(result < sizeof(LightControls[objectInstanceID].Colour))
-			{
-				memcpy(LightControls[objectInstanceID].Colour, srcBuffer, result);
-			}
-			else
+			if(result >= MAX_STR_SIZE)
 			{
 				Lwm2m_Error("LightControl_ResourceWriteHandler Colour Type string too long: %d",
 					result);
 				result = -1;
 			}
+			else if (StringTable_Replace(&light->Colour, (const char *)srcBuffer, result) == -1)
+			{
+				Lwm2m_Error("LightControl_ResourceWriteHandler no room for Colour\n");
+				result = -1;
+			}
+			else
+			{
+				Tlv_InvalidateCachedResource(&light->ColourTlv);
+				if (LightColour_Parse(StringTable_Resolve(light->Colour),
+					&light->ColourValue) == -1)
+				{
+					Lwm2m_Debug("Colour of Light Control %d is not a known format, using white\n",
+						objectInstanceID);
+				}
+			}
 			CallCallback = true;
 			break;
 
 		case IPSO_LIGHT_CONTROL_UNITS:
 			result = srcBufferLen;
-			if(result < sizeof(LightControls[objectInstanceID].Units))
-			{
-				memcpy(LightControls[objectInstanceID].Units, srcBuffer, result);
-			}
-			else
+			if(result >= MAX_STR_SIZE)
 			{
 				Lwm2m_Error("LightControl_ResourceWriteHandler Units Type string too long: %d",
 					result);
 				result = -1;
 			}
+			else if (StringTable_Replace(&light->Units, (const char *)srcBuffer, result) == -1)
+			{
+				Lwm2m_Error("LightControl_ResourceWriteHandler no room for Units\n");
+				result = -1;
+			}
+			else
+				Tlv_InvalidateCachedResource(&light->UnitsTlv);
 			break;
 
 		case IPSO_LIGHT_CONTROL_ON_TIME:
-			result = srcBufferLen;
-			memcpy(&LightControls[objectInstanceID].OnTime, srcBuffer, result);
+			result = LightControl_WriteValue(&light->OnTime, sizeof(light->OnTime), srcBuffer,
+				srcBufferLen);
 			break;
 
+#if LWM2M_CLIENT_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER
 		case IPSO_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER:
-			result = srcBufferLen;
-			memcpy(&LightControls[objectInstanceID].CumulativeActivePower, srcBuffer, result);
+			result = LightControl_WriteValue(&light->CumulativeActivePower,
+				sizeof(light->CumulativeActivePower), srcBuffer, srcBufferLen);
+			if (result != -1)
+				light->EnergyWh = light->CumulativeActivePower;
 			break;
+#endif
 
+#if LWM2M_CLIENT_LIGHT_CONTROL_POWER_FACTOR
 		case IPSO_LIGHT_CONTROL_POWER_FACTOR:
-			result = srcBufferLen;
-			memcpy(&LightControls[objectInstanceID].PowerFactor, srcBuffer, result);
+			result = LightControl_WriteValue(&light->PowerFactor, sizeof(light->PowerFactor),
+				srcBuffer, srcBufferLen);
 			break;
+#endif
 		default:
 
 			result = -1;
 			break;
 	}
 
-	if (LightControls[objectInstanceID].callback != NULL && CallCallback)
-	{
-		LightControls[objectInstanceID].callback(LightControls[objectInstanceID].context,
-			LightControls[objectInstanceID].OnOff, LightControls[objectInstanceID].Dimmer,
-			LightControls[objectInstanceID].Colour);
-	}
+	if (powerChanged)
+		LightControl_UpdatePower(store, slot);
+
+	onOff = store->OnOff[slot];
+	dimmer = store->Dimmer[slot];
+	onTime = light->OnTime;
+	/* Copied now, as the next writer may replace Colour before the callback runs */
+	StringTable_Copy(light->Colour, colour, MAX_STR_SIZE);
+	if (CallCallback)
+		LightControl_GetOutput(store, slot, &output);
+	SeqLock_WriteEnd(&light->Lock);
+
+	if (CallCallback)
+		LightControl_Notify(context, store, slot, objectInstanceID, &output, colour);
 
 
 	if(result > 0)
+	{
 		*changed = true;
+		ResourceVersion_Stamp(context, objectID, objectInstanceID, resourceID);
 
+		/* Switching is queued as transitions; only the latest Dimmer and On Time matter */
+		if (resourceID == IPSO_LIGHT_CONTROL_ON_OFF)
+		{
+			OfflineQueue_Record(context, objectID, objectInstanceID, resourceID,
+				OfflineChangeKind_Transition, onOff, ResourceHistory_GetTime());
+		}
+		else if (resourceID == IPSO_LIGHT_CONTROL_DIMMER ||
+			resourceID == IPSO_LIGHT_CONTROL_ON_TIME)
+		{
+			OfflineQueue_Record(context, objectID, objectInstanceID, resourceID,
+				OfflineChangeKind_State, resourceID == IPSO_LIGHT_CONTROL_DIMMER ? dimmer : onTime,
+				ResourceHistory_GetTime());
+		}
+	}
+
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Write, result, startTime);
 	return result;
 }
 
@@ -377,55 +1011,236 @@ int LightControl_RegisterLightControlObject(Lwm2mContextType * context)
 		MultipleInstancesEnum_Multiple, MandatoryEnum_Optional,                              \
 		&LightControlObjectOperationHandlers);
 
-	REGISTER_LIGHT_CONTROL_RESOURCE(context, "On/Off", IPSO_LIGHT_CONTROL_ON_OFF,            \
-		ResourceTypeEnum_TypeBoolean, MandatoryEnum_Mandatory, Operations_RW);
-	REGISTER_LIGHT_CONTROL_RESOURCE(context, "Dimmer", IPSO_LIGHT_CONTROL_DIMMER,            \
-		ResourceTypeEnum_TypeInteger, MandatoryEnum_Optional, Operations_RW);
-	REGISTER_LIGHT_CONTROL_RESOURCE(context, "Colour", IPSO_LIGHT_CONTROL_COLOUR,            \
-		ResourceTypeEnum_TypeString, MandatoryEnum_Optional, Operations_RW);
-	REGISTER_LIGHT_CONTROL_RESOURCE(context, "Units", IPSO_LIGHT_CONTROL_UNITS,              \
-		ResourceTypeEnum_TypeString, MandatoryEnum_Mandatory, Operations_R);
-	REGISTER_LIGHT_CONTROL_RESOURCE(context, "OnTime", IPSO_LIGHT_CONTROL_ON_TIME,           \
-		ResourceTypeEnum_TypeInteger, MandatoryEnum_Optional, Operations_RW);
-	REGISTER_LIGHT_CONTROL_RESOURCE(context, "CumulativeActivePower",                        \
-		IPSO_LIGHT_CONTROL_CUMULATIVE_ACTIVE_POWER, ResourceTypeEnum_TypeFloat,              \
-		MandatoryEnum_Optional, Operations_R);
-	REGISTER_LIGHT_CONTROL_RESOURCE(context, "PowerFactor", IPSO_LIGHT_CONTROL_POWER_FACTOR, \
-		ResourceTypeEnum_TypeFloat, MandatoryEnum_Optional, Operations_R);
+	return Registration_RegisterResources(context, IPSO_LIGHT_CONTROL_OBJECT, lightControlResources,
+		RESOURCE_DESCRIPTOR_COUNT(lightControlResources), &LightControlResourceOperationHandlers);
+}
+
+/*
+ * Instances firstInstanceID to firstInstanceID + count - 1 are created in the core and then set up
+ * in place: the store grows once, and each starts switched off without a write through the core.
+ */
+int LightControl_AddLightControls(Lwm2mContextType * context, ObjectInstanceIDType firstInstanceID,
+	int count, LightControlCallBack callback, void * callbackContext)
+{
+	LightControlStore * store = LightControl_GetStore(context);
+	ObjectInstanceIDType objectInstanceID;
+	char colour[MAX_STR_SIZE];
+
+	if (store == NULL || count < 1 || LightControl_ReserveInstances(store, count) == -1)
+	{
+		Lwm2m_Error("No room for Light Control instances %d to %d\n", firstInstanceID,
+			firstInstanceID + count - 1);
+		return -1;
+	}
+
+	if (Registration_CreateInstances(context, IPSO_LIGHT_CONTROL_OBJECT, firstInstanceID, count,
+		lightControlInstanceResources, RESOURCE_DESCRIPTOR_COUNT(lightControlInstanceResources))
+		== -1)
+	{
+		return -1;
+	}
+
+	for (objectInstanceID = firstInstanceID; objectInstanceID < firstInstanceID + count;
+		objectInstanceID++)
+	{
+		int slot = LightControl_InsertInstance(store, objectInstanceID);
+		IPSOLightControl * light;
+		LightControlOutput output;
+
+		if (slot == -1)
+			return -1;
+		light = &store->Cold[slot];
 
+		LightControl_ClearInstance(store, slot);
+		snprintf(colour, sizeof(colour), "Red%d", objectInstanceID + 1);
+		if (StringTable_Replace(&light->Colour, colour, sizeof(colour)) == -1)
+		{
+			Lwm2m_Error("No room for the Colour of Light Control %d\n", objectInstanceID);
+			return -1;
+		}
+		LightColour_Parse(colour, &light->ColourValue);
+
+		SeqLock_WriteBegin(&light->Lock);
+		store->Callbacks[slot] = callback;
+		store->CallbackContexts[slot] = callbackContext;
+		store->Dimmer[slot] = 0;
+		store->OnOff[slot] = false;
+		LightControl_UpdatePower(store, slot);
+		LightControl_GetOutput(store, slot, &output);
+		SeqLock_WriteEnd(&light->Lock);
+
+		LightControl_Notify(context, store, slot, objectInstanceID, &output, colour);
+	}
 	return 0;
 }
 
 int LightControl_AddLightControl(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
 	LightControlCallBack callback, void * callbackContext)
 {
-	if(objectInstanceID <= LIGHT_CONTROLS)
+	return LightControl_AddLightControls(context, objectInstanceID, 1, callback, callbackContext);
+}
+
+/*
+ * Replaces the instance's callback with one that gets numbers instead of the Colour string, so the
+ * driver does no parsing. It is called straight away with the current state.
+ */
+int LightControl_SetOutputCallBack(Lwm2mContextType * context,
+	ObjectInstanceIDType objectInstanceID, LightControlOutputCallBack callback,
+	void * callbackContext)
+{
+	LightControlStore * store = LightControl_GetStore(context);
+	int slot = LightControl_FindSlot(store, objectInstanceID);
+	IPSOLightControl * light;
+	char colour[MAX_STR_SIZE];
+	LightControlOutput output;
+
+	if (slot == -1)
+	{
+		Lwm2m_Error("LightControl_SetOutputCallBack: instance %d does not exist\n",
+			objectInstanceID);
+		return -1;
+	}
+	light = &store->Cold[slot];
+
+	SeqLock_WriteBegin(&light->Lock);
+	store->Callbacks[slot] = NULL;
+	store->OutputCallbacks[slot] = callback;
+	store->CallbackContexts[slot] = callbackContext;
+	LightControl_GetOutput(store, slot, &output);
+	StringTable_Copy(light->Colour, colour, MAX_STR_SIZE);
+	SeqLock_WriteEnd(&light->Lock);
+
+	LightControl_Notify(context, store, slot, objectInstanceID, &output, colour);
+	return 0;
+}
+
+/*
+ * Selects how the instance's Dimmer maps to the PWM values in LightControlOutput: linear, gamma
+ * 2.2 or CIE 1931 lightness, at 12 or 16 bits. Instances start linear at 16 bits. The callback is
+ * called straight away with the new values.
+ */
+int LightControl_SetDimmingCurve(Lwm2mContextType * context,
+	ObjectInstanceIDType objectInstanceID, LightDimmingCurve curve,
+	LightDimmingResolution resolution)
+{
+	LightControlStore * store = LightControl_GetStore(context);
+	int slot = LightControl_FindSlot(store, objectInstanceID);
+	IPSOLightControl * light;
+	char colour[MAX_STR_SIZE];
+	LightControlOutput output;
+
+	if (slot == -1 || (unsigned)curve >= LightDimmingCurve_Count ||
+		(resolution != LightDimmingResolution_16Bit && resolution != LightDimmingResolution_12Bit))
 	{
-		CREATE_OBJECT_INSTANCE(context, IPSO_LIGHT_CONTROL_OBJECT, objectInstanceID);
-		CREATE_LIGHT_CONTROL_OPTIONAL_RESOURCE(context, objectInstanceID, IPSO_LIGHT_CONTROL_ON_OFF);
-		CREATE_LIGHT_CONTROL_OPTIONAL_RESOURCE(context, objectInstanceID, IPSO_LIGHT_CONTROL_COLOUR);
-		CREATE_LIGHT_CONTROL_OPTIONAL_RESOURCE(context, objectInstanceID, IPSO_LIGHT_CONTROL_ON_TIME);
+		Lwm2m_Error("LightControl_SetDimmingCurve: invalid curve for instance %d\n",
+			objectInstanceID);
+		return -1;
+	}
+	light = &store->Cold[slot];
 
-		memset(&LightControls[objectInstanceID], 0, sizeof(IPSOLightControl));
-		snprintf(LightControls[objectInstanceID].Colour, MAX_STR_SIZE, "Red%d", objectInstanceID+1);
+	SeqLock_WriteBegin(&light->Lock);
+	light->DimmingCurve = curve;
+	light->DimmingResolution = resolution;
+	LightControl_GetOutput(store, slot, &output);
+	StringTable_Copy(light->Colour, colour, MAX_STR_SIZE);
+	SeqLock_WriteEnd(&light->Lock);
 
-		LightControls[objectInstanceID].callback = callback;
-		LightControls[objectInstanceID].context = callbackContext;
+	LightControl_Notify(context, store, slot, objectInstanceID, &output, colour);
+	return 0;
+}
 
-		bool state = false;
+/*
+ * Hands this client's driver callbacks to dispatcher's worker thread from now on, or runs them
+ * inline again when dispatcher is NULL. The dispatcher may be shared between clients, and must be
+ * flushed before a client it serves is destroyed.
+ */
+int LightControl_SetDispatcher(Lwm2mContextType * context, LightDispatcher * dispatcher)
+{
+	LightControlStore * store = LightControl_GetStore(context);
 
-		if (Lwm2mCore_SetResourceInstanceValue(context, IPSO_LIGHT_CONTROL_OBJECT, objectInstanceID,
-			IPSO_LIGHT_CONTROL_ON_OFF, 0, &state, sizeof(state)) == -1)
+	if (store == NULL)
+		return -1;
+
+	store->Dispatcher = dispatcher;
+	return 0;
+}
+
+/*
+ * Feeds back the state the light actually shows, for a driver that reads its hardware back or
+ * could not apply all it was given, typically from a LightDispatchCompletion. Changes are recorded
+ * as a write would record them, but the driver is not called again. A NULL colour leaves Colour as
+ * it is. Like DigitalInput_SetInputAt() this may be called from any thread; observers are not
+ * notified, and the core thread picks the values up on its next read.
+ */
+int LightControl_ReportState(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
+	bool onOff, unsigned char dimmer, const char * colour)
+{
+	LightControlStore * store = LightControl_GetStore(context);
+	int slot = LightControl_FindSlot(store, objectInstanceID);
+	IPSOLightControl * light;
+	bool onOffChanged, dimmerChanged, colourChanged = false;
+	int64_t timeMs = ResourceHistory_GetTime();
+	int length = colour != NULL ? strlen(colour) : 0;
+
+	if (slot == -1 || length >= MAX_STR_SIZE)
+	{
+		Lwm2m_Error("LightControl_ReportState: invalid state for instance %d\n", objectInstanceID);
+		return -1;
+	}
+	light = &store->Cold[slot];
+
+	SeqLock_WriteBegin(&light->Lock);
+	if ((onOffChanged = store->OnOff[slot] != onOff))
+	{
+		store->OnOff[slot] = onOff;
+		if (light->OnOffHistory != NULL)
+			ResourceHistory_Append(light->OnOffHistory, timeMs, onOff);
+	}
+	if ((dimmerChanged = store->Dimmer[slot] != dimmer))
+	{
+		store->Dimmer[slot] = dimmer;
+		light->DimmerWritten = true;
+		if (light->DimmerHistory != NULL)
+			ResourceHistory_Append(light->DimmerHistory, timeMs, dimmer);
+	}
+	if (colour != NULL && (StringTable_GetLength(light->Colour) != length ||
+		memcmp(StringTable_Resolve(light->Colour), colour, length) != 0))
+	{
+		if (StringTable_Replace(&light->Colour, colour, length) == -1)
+			Lwm2m_Error("LightControl_ReportState no room for Colour\n");
+		else
 		{
-			Lwm2m_Error("Failed to set On/Off resource to %s", state ? "true" : "false");
-			return -1;
+			Tlv_InvalidateCachedResource(&light->ColourTlv);
+			LightColour_Parse(StringTable_Resolve(light->Colour), &light->ColourValue);
+			colourChanged = true;
 		}
 	}
+
+	if (onOffChanged || dimmerChanged)
+		LightControl_UpdatePower(store, slot);
+	if (onOffChanged || dimmerChanged || colourChanged)
+		SeqLock_WriteEnd(&light->Lock);
 	else
+		SeqLock_WriteCancel(&light->Lock);
+
+	if (onOffChanged)
 	{
-		Lwm2m_Error("%d instance of Light Control exceeds max instances %d\n", objectInstanceID,
-			LIGHT_CONTROLS);
-		return -1;
+		ResourceVersion_Stamp(context, IPSO_LIGHT_CONTROL_OBJECT, objectInstanceID,
+			IPSO_LIGHT_CONTROL_ON_OFF);
+		OfflineQueue_Record(context, IPSO_LIGHT_CONTROL_OBJECT, objectInstanceID,
+			IPSO_LIGHT_CONTROL_ON_OFF, OfflineChangeKind_Transition, onOff, timeMs);
+	}
+	if (dimmerChanged)
+	{
+		ResourceVersion_Stamp(context, IPSO_LIGHT_CONTROL_OBJECT, objectInstanceID,
+			IPSO_LIGHT_CONTROL_DIMMER);
+		OfflineQueue_Record(context, IPSO_LIGHT_CONTROL_OBJECT, objectInstanceID,
+			IPSO_LIGHT_CONTROL_DIMMER, OfflineChangeKind_State, dimmer, timeMs);
+	}
+	if (colourChanged)
+	{
+		ResourceVersion_Stamp(context, IPSO_LIGHT_CONTROL_OBJECT, objectInstanceID,
+			IPSO_LIGHT_CONTROL_COLOUR);
 	}
 	return 0;
 }
@@ -433,10 +1248,17 @@ int LightControl_AddLightControl(Lwm2mContextType * context, ObjectInstanceIDTyp
 int LightControl_IncrementOnTime(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
 	int seconds)
 {
+	LightControlStore * store = LightControl_GetStore(context);
+	int slot = LightControl_FindSlot(store, objectInstanceID);
+	LightControlSnapshot snapshot;
+
+	if (slot != -1)
+		LightControl_GetSnapshot(store, slot, &snapshot);
+
 	//only increment on time if it is on.
-	if(LightControls[objectInstanceID].OnOff == true)
+	if(slot != -1 && snapshot.OnOff == true)
 	{
-		int64_t OnTime = LightControls[objectInstanceID].OnTime + seconds;
+		int64_t OnTime = snapshot.Light.OnTime + seconds;
 		if (Lwm2mCore_SetResourceInstanceValue(context, IPSO_LIGHT_CONTROL_OBJECT, objectInstanceID,
 			IPSO_LIGHT_CONTROL_ON_TIME, 0, &OnTime, sizeof(OnTime)) == -1)
 		{
@@ -449,3 +1271,235 @@ int LightControl_IncrementOnTime(Lwm2mContextType * context, ObjectInstanceIDTyp
 
 	return 0;
 }
+
+/*
+ * Attaches a power meter to a light drawing ratedPower watts at full brightness. The callback gets
+ * the old and new power of the light on every change, starting with a change from 0 to the current
+ * power, and a change back to 0 when the meter is replaced or the instance is deleted.
+ */
+int LightControl_SetPowerMeter(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
+	float ratedPower, LightControlPowerCallBack callback, void * callbackContext)
+{
+	LightControlStore * store = LightControl_GetStore(context);
+	int slot = LightControl_FindSlot(store, objectInstanceID);
+	IPSOLightControl * light;
+
+	if (slot == -1)
+	{
+		Lwm2m_Error("LightControl_SetPowerMeter: instance %d does not exist\n", objectInstanceID);
+		return -1;
+	}
+	light = &store->Cold[slot];
+
+	SeqLock_WriteBegin(&light->Lock);
+	LightControl_UpdatePower(store, slot);
+	if (light->PowerCallback != NULL && light->ActivePower != 0)
+		light->PowerCallback(light->PowerContext, light->ActivePower, 0);
+
+	light->RatedPower = ratedPower;
+	light->ActivePower = 0;
+	light->PowerCallback = callback;
+	light->PowerContext = callbackContext;
+	LightControl_UpdatePower(store, slot);
+	SeqLock_WriteEnd(&light->Lock);
+	return 0;
+}
+
+/*
+ * Detaches every light reporting to callbackContext, each hearing a last change back to 0, so the
+ * meter can go away.
+ */
+void LightControl_RemovePowerMeter(Lwm2mContextType * context, void * callbackContext)
+{
+	LightControlStore * store = LightControl_GetStore(context);
+	int slot;
+
+	for (slot = 0; store != NULL && slot < store->Count; slot++)
+	{
+		IPSOLightControl * light = &store->Cold[slot];
+
+		SeqLock_WriteBegin(&light->Lock);
+		if (light->PowerContext != callbackContext)
+		{
+			SeqLock_WriteCancel(&light->Lock);
+			continue;
+		}
+
+		LightControl_UpdatePower(store, slot);
+		if (light->PowerCallback != NULL && light->ActivePower != 0)
+			light->PowerCallback(light->PowerContext, light->ActivePower, 0);
+		light->RatedPower = 0;
+		light->ActivePower = 0;
+		light->PowerCallback = NULL;
+		light->PowerContext = NULL;
+		SeqLock_WriteEnd(&light->Lock);
+	}
+}
+
+/*
+ * Records every write of On/Off or Dimmer into history, which stays owned by the caller. Pass NULL
+ * to stop recording. Deleting the instance also stops recording.
+ */
+int LightControl_EnableHistory(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
+	ResourceIDType resourceID, ResourceHistory * history)
+{
+	LightControlStore * store = LightControl_GetStore(context);
+	int slot = LightControl_FindSlot(store, objectInstanceID);
+
+	if (slot == -1)
+	{
+		Lwm2m_Error("LightControl_EnableHistory: instance %d does not exist\n", objectInstanceID);
+		return -1;
+	}
+
+	if (resourceID != IPSO_LIGHT_CONTROL_ON_OFF && resourceID != IPSO_LIGHT_CONTROL_DIMMER)
+	{
+		Lwm2m_Error("Light Control resource %d does not support history\n", resourceID);
+		return -1;
+	}
+
+	SeqLock_WriteBegin(&store->Cold[slot].Lock);
+	if (resourceID == IPSO_LIGHT_CONTROL_ON_OFF)
+		store->Cold[slot].OnOffHistory = history;
+	else
+		store->Cold[slot].DimmerHistory = history;
+	SeqLock_WriteEnd(&store->Cold[slot].Lock);
+	return 0;
+}
+
+/*
+ * Serializes the instance from a snapshot, copying cached records under the same sequence and
+ * retrying if a writer got in. Missing cached records are filled afterwards, only if nothing was
+ * written in the meantime, so a read never waits for a writer.
+ */
+int LightControl_ReadInstance(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
+	uint8_t * destBuffer, int destBufferLen)
+{
+	const int typeCount = sizeof(lightControlResourceTypes) / sizeof(lightControlResourceTypes[0]);
+	int uncachedOffsets[sizeof(lightControlResourceTypes) / sizeof(lightControlResourceTypes[0])];
+	LightControlStore * store = LightControl_GetStore(context);
+	int slot = LightControl_FindSlot(store, objectInstanceID);
+	LightControlSnapshot snapshot;
+	IPSOLightControl * light;
+	uint32_t sequence;
+	bool fillCaches;
+	int i, length;
+
+	if (slot == -1)
+		return -1;
+	light = &store->Cold[slot];
+
+	do
+	{
+		sequence = LightControl_GetSnapshot(store, slot, &snapshot);
+		fillCaches = false;
+		length = 0;
+
+		for (i = 0; i < typeCount && length != -1; i++)
+		{
+			const TlvResourceType * resource = &lightControlResourceTypes[i];
+			TlvCachedResource * cache = LightControl_GetResourceCache(&snapshot.Light,
+				resource->ResourceID);
+			const void * value;
+			int valueLength;
+			int result;
+
+			uncachedOffsets[i] = -1;
+			if (cache != NULL && cache->Length > 0)
+			{
+				result = Tlv_CopyCachedResource(cache, destBuffer + length,
+					destBufferLen - length);
+			}
+			else
+			{
+				valueLength = LightControl_GetResourceValue(&snapshot, resource->ResourceID,
+					&value);
+				if (valueLength <= 0)
+					continue;
+
+				result = Tlv_EncodeResource(destBuffer + length, destBufferLen - length,
+					resource->ResourceID, resource->Type, value, valueLength);
+				if (cache != NULL)
+				{
+					uncachedOffsets[i] = length;
+					fillCaches = true;
+				}
+			}
+			length = result == -1 ? -1 : length + result;
+		}
+	} while (SeqLock_ReadRetry(&light->Lock, sequence));
+
+	/* The snapshot still matches the slot if no writer got in, so its values can be cached */
+	if (length != -1 && fillCaches && SeqLock_TryWriteBegin(&light->Lock, sequence))
+	{
+		for (i = 0; i < typeCount; i++)
+		{
+			const TlvResourceType * resource = &lightControlResourceTypes[i];
+			const void * value;
+			int valueLength;
+
+			if (uncachedOffsets[i] == -1)
+				continue;
+
+			valueLength = LightControl_GetResourceValue(&snapshot, resource->ResourceID, &value);
+			Tlv_EncodeCachedResource(LightControl_GetResourceCache(light, resource->ResourceID),
+				destBuffer + uncachedOffsets[i], destBufferLen - uncachedOffsets[i],
+				resource->ResourceID, resource->Type, value, valueLength, MAX_STR_SIZE);
+		}
+		SeqLock_WriteEnd(&light->Lock);
+	}
+	return length;
+}
+
+/*
+ * Adds the given resources (all readable ones when resources is NULL) of the given instances to a
+ * SenML-CBOR payload, all stamped with timeMs.
+ */
+int LightControl_EncodeSenML(Lwm2mContextType * context, SenMLCborEncoder * encoder,
+	const ObjectInstanceIDType * instances, int instanceCount, const ResourceIDType * resources,
+	int resourceCount, int64_t timeMs)
+{
+	LightControlStore * store = LightControl_GetStore(context);
+	const int typeCount = sizeof(lightControlResourceTypes) / sizeof(lightControlResourceTypes[0]);
+	int i, j, k;
+
+	if (resources == NULL)
+		resourceCount = typeCount;
+
+	for (i = 0; i < instanceCount; i++)
+	{
+		int slot = LightControl_FindSlot(store, instances[i]);
+		LightControlSnapshot snapshot;
+
+		if (slot == -1)
+			return -1;
+		LightControl_GetSnapshot(store, slot, &snapshot);
+
+		for (j = 0; j < resourceCount; j++)
+		{
+			const TlvResourceType * resource = NULL;
+			const void * value;
+			int valueLength;
+
+			for (k = 0; k < typeCount; k++)
+			{
+				if (resources == NULL ? k == j :
+					lightControlResourceTypes[k].ResourceID == resources[j])
+				{
+					resource = &lightControlResourceTypes[k];
+					break;
+				}
+			}
+			if (resource == NULL)
+				return -1;
+
+			valueLength = LightControl_GetResourceValue(&snapshot, resource->ResourceID, &value);
+			if (SenMLCbor_AddResource(encoder, IPSO_LIGHT_CONTROL_OBJECT, instances[i],
+				resource->ResourceID, resource->Type, value, valueLength, timeMs) == -1)
+			{
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
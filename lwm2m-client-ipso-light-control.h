@@ -37,14 +37,56 @@
 #define LWM2M_CLIENT_IPSO_LIGHT_CONTROL_H_
 
 #include "lwm2m_core.h"
+#include "lwm2m-client-senml-cbor.h"
+#include "lwm2m-client-history.h"
+#include "lwm2m-client-light-colour.h"
+#include "lwm2m-client-light-dimming.h"
 
+/*
+ * What a light should show, with Colour already parsed and Dimmer already taken through the
+ * instance's dimming curve. Level and Duty are PWM values at Resolution, all 0 when off.
+ */
+typedef struct
+{
+	bool OnOff;
+	unsigned char Dimmer;					/* 0 to 100 */
+	LightColour Colour;
+	LightDimmingCurve Curve;
+	LightDimmingResolution Resolution;
+	uint16_t Level;							/* Dimmer along Curve, for a single channel light */
+	uint16_t Duty[LIGHT_COLOUR_CHANNELS];	/* each channel of Colour dimmed along Curve */
+} LightControlOutput;
 
 typedef void (*LightControlCallBack)(void * context, bool OnOff, unsigned char Dimmer,
 	const char * Colour);
+typedef void (*LightControlOutputCallBack)(void * context, const LightControlOutput * Output);
+typedef void (*LightControlPowerCallBack)(void * context, float oldPower, float newPower);
+typedef struct _LightDispatcher LightDispatcher;
 int LightControl_RegisterLightControlObject(Lwm2mContextType * context);
 int LightControl_AddLightControl(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
 	LightControlCallBack callback, void * callbackContext);
+int LightControl_AddLightControls(Lwm2mContextType * context, ObjectInstanceIDType firstInstanceID,
+	int count, LightControlCallBack callback, void * callbackContext);
+int LightControl_SetOutputCallBack(Lwm2mContextType * context,
+	ObjectInstanceIDType objectInstanceID, LightControlOutputCallBack callback,
+	void * callbackContext);
+int LightControl_SetDimmingCurve(Lwm2mContextType * context,
+	ObjectInstanceIDType objectInstanceID, LightDimmingCurve curve,
+	LightDimmingResolution resolution);
+int LightControl_SetDispatcher(Lwm2mContextType * context, LightDispatcher * dispatcher);
+int LightControl_ReportState(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
+	bool onOff, unsigned char dimmer, const char * colour);
 int LightControl_IncrementOnTime(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
 	int seconds);
+int LightControl_SetPowerMeter(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
+	float ratedPower, LightControlPowerCallBack callback, void * callbackContext);
+void LightControl_RemovePowerMeter(Lwm2mContextType * context, void * callbackContext);
+int LightControl_EnableHistory(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
+	ResourceIDType resourceID, ResourceHistory * history);
+int LightControl_ReadInstance(Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID,
+	uint8_t * destBuffer, int destBufferLen);
+int LightControl_EncodeSenML(Lwm2mContextType * context, SenMLCborEncoder * encoder,
+	const ObjectInstanceIDType * instances, int instanceCount, const ResourceIDType * resources,
+	int resourceCount, int64_t timeMs);
 
 #endif /* LWM2M_CLIENT_IPSO_LIGHT_CONTROL_H_ */
@@ -0,0 +1,498 @@
+/**
+ * @file
+ * IPSO Power Measurement object for libobjects.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "lwm2m_core.h"
+#include "coap_abstraction.h"
+#include "lwm2m-client-ipso-light-control.h"
+#include "lwm2m-client-ipso-power-measurement.h"
+#include "lwm2m-client-resource-version.h"
+#include "lwm2m-client-seqlock.h"
+#include "lwm2m-client-state.h"
+#include "lwm2m-client-config.h"
+#include "common.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define IPSO_POWER_MEASUREMENT_OBJECT					3305
+#define IPSO_POWER_MEASUREMENT_INSTANTANEOUS_ACTIVE		5800
+#define IPSO_POWER_MEASUREMENT_MIN_ACTIVE				5801
+#define IPSO_POWER_MEASUREMENT_MAX_ACTIVE				5802
+#define IPSO_POWER_MEASUREMENT_CUMULATIVE_ACTIVE		5805
+#define IPSO_POWER_MEASUREMENT_RESET_CUMULATIVE_ENERGY	5822
+#define IPSO_RESET_MIN_MAX								5605
+
+#define POWER_MEASUREMENTS								4
+
+#define MS_PER_HOUR										3600000.0
+
+#define REGISTER_POWER_MEASUREMENT_RESOURCE(context, name, id, type, minInstances, operations) \
+	REGISTER_RESOURCE(context, name, IPSO_POWER_MEASUREMENT_OBJECT, id, type,                \
+		MultipleInstancesEnum_Single, minInstances, operations,                              \
+		&PowerMeasurementResourceOperationHandlers)
+
+#define CREATE_POWER_MEASUREMENT_OPTIONAL_RESOURCE(context, objectInstanceId, resourcId) \
+	CREATE_OPTIONAL_RESOURCE(context, IPSO_POWER_MEASUREMENT_OBJECT, objectInstanceId, resourcId)
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+/*
+ * A circuit of lights. Instantaneous power is the sum of the power of its lights, adjusted by the
+ * difference on every light transition. Energy is integrated up to EnergyTime, and reads add the
+ * energy used since then, so no read or transition has to visit every light. Lights report from
+ * their own write sections on any thread, so updates take the sequence lock for writing and reads
+ * work from a consistent copy.
+ */
+typedef struct SEQLOCK_ALIGNED
+{
+	SeqLock Lock;
+	bool Active;
+	double InstantaneousActivePower;
+	double MinActivePower;
+	double MaxActivePower;
+	double EnergyWh;
+	int64_t EnergyTime;
+	double CumulativeActivePower;
+} IPSOPowerMeasurement;
+
+/* Every instance one client can have; lights keep pointers into it as their meter context */
+typedef struct
+{
+	IPSOPowerMeasurement Measurements[POWER_MEASUREMENTS];
+} PowerMeasurementState;
+
+/***************************************************************************************************
+ * Prototypes
+ **************************************************************************************************/
+
+static int PowerMeasurement_ResourceReadHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID, uint8_t *destBuffer, int destBufferLen);
+
+static int PowerMeasurement_ResourceGetLengthHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID);
+
+static int PowerMeasurement_ResourceExecuteHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID, uint8_t *srcBuffer,
+	int srcBufferLen);
+
+static int PowerMeasurement_ResourceCreateHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID);
+
+static int PowerMeasurement_ObjectCreateInstanceHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID);
+
+static int PowerMeasurement_ObjectDeleteHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID);
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+static ObjectOperationHandlers PowerMeasurementObjectOperationHandlers =
+{
+	.CreateInstance = PowerMeasurement_ObjectCreateInstanceHandler,
+	.Delete = PowerMeasurement_ObjectDeleteHandler,
+};
+
+static ResourceOperationHandlers PowerMeasurementResourceOperationHandlers =
+{
+	.Read = PowerMeasurement_ResourceReadHandler,
+	.GetLength = PowerMeasurement_ResourceGetLengthHandler,
+	.Write = NULL,
+	.CreateOptionalResource = PowerMeasurement_ResourceCreateHandler,
+	.Execute = PowerMeasurement_ResourceExecuteHandler,
+};
+
+static const ClientStateDefinition powerMeasurementStateDefinition =
+{
+	.Slot = ClientStateSlot_PowerMeasurement,
+	.Size = sizeof(PowerMeasurementState),
+};
+
+FOOTPRINT_RECORD(IPSOPowerMeasurement)
+FOOTPRINT_RECORD(PowerMeasurementState)
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/* Returns the client's record for an instance, or NULL if out of range or out of memory */
+static IPSOPowerMeasurement *PowerMeasurement_GetInstance(void *context,
+	ObjectInstanceIDType objectInstanceID)
+{
+	PowerMeasurementState *state;
+
+	if (objectInstanceID < 0 || objectInstanceID >= POWER_MEASUREMENTS ||
+		(state = ClientState_Get(context, &powerMeasurementStateDefinition)) == NULL)
+	{
+		return NULL;
+	}
+	return &state->Measurements[objectInstanceID];
+}
+
+static int64_t PowerMeasurement_GetTime(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/* Energy used up to now, without moving EnergyTime */
+static double PowerMeasurement_GetEnergy(const IPSOPowerMeasurement *power, int64_t now)
+{
+	return power->EnergyWh + power->InstantaneousActivePower * (now - power->EnergyTime) /
+		MS_PER_HOUR;
+}
+
+static void PowerMeasurement_GetSnapshot(IPSOPowerMeasurement *power,
+	IPSOPowerMeasurement *snapshot)
+{
+	uint32_t sequence;
+
+	do
+	{
+		sequence = SeqLock_ReadBegin(&power->Lock);
+		memcpy(snapshot, power, sizeof(IPSOPowerMeasurement));
+	} while (SeqLock_ReadRetry(&power->Lock, sequence));
+}
+
+/* Called from the light's write section, so the light's lock is always taken before this one */
+static void PowerMeasurement_LightPowerChanged(void *context, float oldPower, float newPower)
+{
+	IPSOPowerMeasurement *power = context;
+	int64_t now = PowerMeasurement_GetTime();
+
+	SeqLock_WriteBegin(&power->Lock);
+	power->EnergyWh = PowerMeasurement_GetEnergy(power, now);
+	power->EnergyTime = now;
+
+	power->InstantaneousActivePower += (double)newPower - oldPower;
+	/* Keep rounding from leaving a tiny negative total once every light is off */
+	if (power->InstantaneousActivePower < 0)
+		power->InstantaneousActivePower = 0;
+
+	if (power->InstantaneousActivePower < power->MinActivePower)
+		power->MinActivePower = power->InstantaneousActivePower;
+	if (power->InstantaneousActivePower > power->MaxActivePower)
+		power->MaxActivePower = power->InstantaneousActivePower;
+	SeqLock_WriteEnd(&power->Lock);
+}
+
+static int PowerMeasurement_ObjectCreateInstanceHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID)
+{
+	if(objectInstanceID >= POWER_MEASUREMENTS)
+	{
+		Lwm2m_Error("PowerMeasurement_ObjectCreateInstanceHandler instance number %d out of range "
+			"(max %d)", objectInstanceID, POWER_MEASUREMENTS - 1);
+		return -1;
+	}
+	ResourceVersion_StampInstance(context, objectID, objectInstanceID, false);
+	return objectInstanceID;
+}
+
+static int PowerMeasurement_ResourceCreateHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID)
+{
+	return 0;
+}
+
+static int PowerMeasurement_ObjectDeleteHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID)
+{
+	IPSOPowerMeasurement *power;
+
+	if (objectID != IPSO_POWER_MEASUREMENT_OBJECT)
+	{
+		Lwm2m_Error("PowerMeasurement_ObjectDeleteHandler Invalid OIR: %d/%d/%d\n", objectID,
+			objectInstanceID, resourceID);
+		return -1;
+	}
+
+	if ((power = PowerMeasurement_GetInstance(context, objectInstanceID)) == NULL)
+	{
+		Lwm2m_Error("PowerMeasurement_ObjectDeleteHandler instance number %d out of range (max %d)",
+			objectInstanceID, POWER_MEASUREMENTS - 1);
+		return -1;
+	}
+
+	if (resourceID == -1)
+	{
+		/* Detach the circuit's lights, so none keeps reporting into a later instance */
+		LightControl_RemovePowerMeter(context, power);
+		SeqLock_WriteBegin(&power->Lock);
+		power->Active = false;
+		SeqLock_WriteEnd(&power->Lock);
+		ResourceVersion_StampInstance(context, objectID, objectInstanceID, true);
+	}
+	else
+	{
+		//TODO
+	}
+
+	return 0;
+}
+
+/*
+ * Returns the length of the current value of a resource and points value at it in the snapshot,
+ * or -1 for an unknown resource.
+ */
+static int PowerMeasurement_GetResourceValue(IPSOPowerMeasurement *snapshot,
+	ResourceIDType resourceID, const void **value)
+{
+	switch (resourceID)
+	{
+		case IPSO_POWER_MEASUREMENT_INSTANTANEOUS_ACTIVE:
+			*value = &snapshot->InstantaneousActivePower;
+			return sizeof(snapshot->InstantaneousActivePower);
+
+		case IPSO_POWER_MEASUREMENT_MIN_ACTIVE:
+			*value = &snapshot->MinActivePower;
+			return sizeof(snapshot->MinActivePower);
+
+		case IPSO_POWER_MEASUREMENT_MAX_ACTIVE:
+			*value = &snapshot->MaxActivePower;
+			return sizeof(snapshot->MaxActivePower);
+
+		case IPSO_POWER_MEASUREMENT_CUMULATIVE_ACTIVE:
+			snapshot->CumulativeActivePower = PowerMeasurement_GetEnergy(snapshot,
+				PowerMeasurement_GetTime());
+			*value = &snapshot->CumulativeActivePower;
+			return sizeof(snapshot->CumulativeActivePower);
+
+		default:
+			*value = NULL;
+			return -1;
+	}
+}
+
+static int PowerMeasurement_ResourceReadHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID, uint8_t *destBuffer, int destBufferLen)
+{
+	IPSOPowerMeasurement *power = PowerMeasurement_GetInstance(context, objectInstanceID);
+	IPSOPowerMeasurement snapshot;
+	const void *value;
+	int result = -1;
+	DIAGNOSTICS_START(startTime);
+
+	if (power != NULL)
+	{
+		PowerMeasurement_GetSnapshot(power, &snapshot);
+		result = PowerMeasurement_GetResourceValue(&snapshot, resourceID, &value);
+	}
+
+	if (result > destBufferLen)
+	{
+		Lwm2m_Error("PowerMeasurement_ResourceReadHandler resource %d needs %d bytes, buffer has "
+			"%d\n", resourceID, result, destBufferLen);
+		result = -1;
+	}
+	else if (result > 0)
+	{
+		memcpy(destBuffer, value, result);
+	}
+
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Read, result, startTime);
+	return result;
+}
+
+static int PowerMeasurement_ResourceGetLengthHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID)
+{
+	IPSOPowerMeasurement *power = PowerMeasurement_GetInstance(context, objectInstanceID);
+	IPSOPowerMeasurement snapshot;
+	const void *value;
+	int result = -1;
+	DIAGNOSTICS_START(startTime);
+
+	if (power != NULL)
+	{
+		PowerMeasurement_GetSnapshot(power, &snapshot);
+		result = PowerMeasurement_GetResourceValue(&snapshot, resourceID, &value);
+	}
+
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_GetLength, result, startTime);
+	return result;
+}
+
+static int PowerMeasurement_ResourceExecuteHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID, uint8_t *srcBuffer,
+	int srcBufferLen)
+{
+	IPSOPowerMeasurement *power = PowerMeasurement_GetInstance(context, objectInstanceID);
+	int result = 0;
+	DIAGNOSTICS_START(startTime);
+
+	if (power == NULL)
+	{
+		DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Execute, srcBufferLen,
+			startTime);
+		return -1;
+	}
+
+	SeqLock_WriteBegin(&power->Lock);
+	if (resourceID == IPSO_RESET_MIN_MAX)
+	{
+		power->MinActivePower = power->InstantaneousActivePower;
+		power->MaxActivePower = power->InstantaneousActivePower;
+	}
+	else if (resourceID == IPSO_POWER_MEASUREMENT_RESET_CUMULATIVE_ENERGY)
+	{
+		power->EnergyWh = 0;
+		power->EnergyTime = PowerMeasurement_GetTime();
+	}
+	else
+		result = -1;
+	SeqLock_WriteEnd(&power->Lock);
+
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Execute, srcBufferLen,
+		startTime);
+	return result;
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+int PowerMeasurement_RegisterPowerMeasurementObject(Lwm2mContextType *context)
+{
+	REGISTER_OBJECT(context, "PowerMeasurement", IPSO_POWER_MEASUREMENT_OBJECT,             \
+		MultipleInstancesEnum_Multiple, MandatoryEnum_Optional,                             \
+		&PowerMeasurementObjectOperationHandlers);
+
+	REGISTER_POWER_MEASUREMENT_RESOURCE(context, "InstantaneousActivePower",                \
+		IPSO_POWER_MEASUREMENT_INSTANTANEOUS_ACTIVE, ResourceTypeEnum_TypeFloat,            \
+		MandatoryEnum_Mandatory, Operations_R);
+	REGISTER_POWER_MEASUREMENT_RESOURCE(context, "MinMeasuredActivePower",                  \
+		IPSO_POWER_MEASUREMENT_MIN_ACTIVE, ResourceTypeEnum_TypeFloat,                      \
+		MandatoryEnum_Optional, Operations_R);
+	REGISTER_POWER_MEASUREMENT_RESOURCE(context, "MaxMeasuredActivePower",                  \
+		IPSO_POWER_MEASUREMENT_MAX_ACTIVE, ResourceTypeEnum_TypeFloat,                      \
+		MandatoryEnum_Optional, Operations_R);
+	REGISTER_POWER_MEASUREMENT_RESOURCE(context, "CumulativeActivePower",                   \
+		IPSO_POWER_MEASUREMENT_CUMULATIVE_ACTIVE, ResourceTypeEnum_TypeFloat,               \
+		MandatoryEnum_Optional, Operations_R);
+	REGISTER_POWER_MEASUREMENT_RESOURCE(context, "ResetMinMaxMeasuredValues",               \
+		IPSO_RESET_MIN_MAX, ResourceTypeEnum_TypeNone, MandatoryEnum_Optional, Operations_E);
+	REGISTER_POWER_MEASUREMENT_RESOURCE(context, "ResetCumulativeEnergy",                   \
+		IPSO_POWER_MEASUREMENT_RESET_CUMULATIVE_ENERGY, ResourceTypeEnum_TypeNone,          \
+		MandatoryEnum_Optional, Operations_E);
+
+	return 0;
+}
+
+int PowerMeasurement_AddPowerMeasurement(Lwm2mContextType *context,
+	ObjectInstanceIDType objectInstanceID)
+{
+	IPSOPowerMeasurement *power = PowerMeasurement_GetInstance(context, objectInstanceID);
+	SeqLock lock;
+
+	if (power != NULL && power->Active)
+	{
+		Lwm2m_Error("Power Measurement instance %d already exists\n", objectInstanceID);
+		return -1;
+	}
+	else if(power != NULL)
+	{
+		CREATE_OBJECT_INSTANCE(context, IPSO_POWER_MEASUREMENT_OBJECT, objectInstanceID);
+		CREATE_POWER_MEASUREMENT_OPTIONAL_RESOURCE(context, objectInstanceID, \
+			IPSO_POWER_MEASUREMENT_MIN_ACTIVE);
+		CREATE_POWER_MEASUREMENT_OPTIONAL_RESOURCE(context, objectInstanceID, \
+			IPSO_POWER_MEASUREMENT_MAX_ACTIVE);
+		CREATE_POWER_MEASUREMENT_OPTIONAL_RESOURCE(context, objectInstanceID, \
+			IPSO_POWER_MEASUREMENT_CUMULATIVE_ACTIVE);
+		CREATE_POWER_MEASUREMENT_OPTIONAL_RESOURCE(context, objectInstanceID, \
+			IPSO_RESET_MIN_MAX);
+		CREATE_POWER_MEASUREMENT_OPTIONAL_RESOURCE(context, objectInstanceID, \
+			IPSO_POWER_MEASUREMENT_RESET_CUMULATIVE_ENERGY);
+
+		/* Deleting the instance detached its lights, so none adds to the cleared total */
+		SeqLock_WriteBegin(&power->Lock);
+		lock = power->Lock;
+		memset(power, 0, sizeof(IPSOPowerMeasurement));
+		power->Lock = lock;
+		power->Active = true;
+		power->EnergyTime = PowerMeasurement_GetTime();
+		SeqLock_WriteEnd(&power->Lock);
+	}
+	else
+	{
+		Lwm2m_Error("%d instance of Power Measurement exceeds max instances %d\n",
+			objectInstanceID, POWER_MEASUREMENTS);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Adds a light drawing ratedPower watts at full brightness to a circuit. A light is in at most one
+ * circuit, so adding it here moves it out of any other.
+ */
+int PowerMeasurement_AddLight(Lwm2mContextType *context, ObjectInstanceIDType objectInstanceID,
+	ObjectInstanceIDType lightInstanceID, float ratedPower)
+{
+	IPSOPowerMeasurement *power = PowerMeasurement_GetInstance(context, objectInstanceID);
+
+	if (power == NULL || !power->Active)
+	{
+		Lwm2m_Error("Power Measurement instance %d does not exist\n", objectInstanceID);
+		return -1;
+	}
+
+	return LightControl_SetPowerMeter(context, lightInstanceID, ratedPower,
+		PowerMeasurement_LightPowerChanged, power);
+}
+
+int PowerMeasurement_RemoveLight(Lwm2mContextType *context, ObjectInstanceIDType lightInstanceID)
+{
+	return LightControl_SetPowerMeter(context, lightInstanceID, 0, NULL, NULL);
+}
@@ -0,0 +1,657 @@
+/**
+ * @file
+ * IPSO Temperature, Humidity and Barometer objects for libobjects.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lwm2m_core.h"
+#include "coap_abstraction.h"
+#include "lwm2m-client-ipso-sensor.h"
+#include "lwm2m-client-resource-version.h"
+#include "lwm2m-client-state.h"
+#include "lwm2m-client-config.h"
+#include "common.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define IPSO_MIN_MEASURED_VALUE					5601
+#define IPSO_MAX_MEASURED_VALUE					5602
+#define IPSO_MIN_RANGE_VALUE					5603
+#define IPSO_MAX_RANGE_VALUE					5604
+#define IPSO_RESET_MIN_MAX						5605
+#define IPSO_SENSOR_VALUE						5700
+#define IPSO_SENSOR_UNITS						5701
+
+#define SENSORS									4
+#define SENSOR_OBJECTS							3
+
+#define MAX_STR_SIZE							16
+
+#define REGISTER_SENSOR_RESOURCE(context, name, objectID, id, type, mandatory, operations) \
+	REGISTER_RESOURCE(context, name, objectID, id, type, MultipleInstancesEnum_Single,    \
+		mandatory, operations, &SensorResourceOperationHandlers)
+
+#define CREATE_SENSOR_OPTIONAL_RESOURCE(context, objectID, objectInstanceId, resourcId) \
+	CREATE_OPTIONAL_RESOURCE(context, objectID, objectInstanceId, resourcId)
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef struct
+{
+	double SensorValue;
+	double MinMeasuredValue;
+	double MaxMeasuredValue;
+	double MinRangeValue;
+	double MaxRangeValue;
+	char SensorUnits[MAX_STR_SIZE];
+	double Sum;
+	int64_t SampleCount;
+} IPSOSensor;
+
+typedef struct
+{
+	ObjectIDType ObjectID;
+	const char *Units;
+} IPSOSensorObject;
+
+/* Every instance of every sensor object one client can have, indexed like sensorObjects */
+typedef struct
+{
+	IPSOSensor Instances[SENSOR_OBJECTS][SENSORS];
+} SensorState;
+
+/***************************************************************************************************
+ * Prototypes
+ **************************************************************************************************/
+
+static int Sensor_ResourceReadHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID, uint8_t *destBuffer, int destBufferLen);
+
+static int Sensor_ResourceGetLengthHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID);
+
+static int Sensor_ResourceWriteHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID, uint8_t *srcBuffer, int srcBufferLen, bool *changed);
+
+static int Sensor_ResourceExecuteHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID, uint8_t *srcBuffer,
+	int srcBufferLen);
+
+static int Sensor_ResourceCreateHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID);
+
+static int Sensor_ObjectCreateInstanceHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID);
+
+static int Sensor_ObjectDeleteHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID);
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+static ObjectOperationHandlers SensorObjectOperationHandlers =
+{
+	.CreateInstance = Sensor_ObjectCreateInstanceHandler,
+	.Delete = Sensor_ObjectDeleteHandler,
+};
+
+static ResourceOperationHandlers SensorResourceOperationHandlers =
+{
+	.Read = Sensor_ResourceReadHandler,
+	.GetLength = Sensor_ResourceGetLengthHandler,
+	.Write = Sensor_ResourceWriteHandler,
+	.CreateOptionalResource = Sensor_ResourceCreateHandler,
+	.Execute = Sensor_ResourceExecuteHandler,
+};
+
+static const IPSOSensorObject sensorObjects[SENSOR_OBJECTS] =
+{
+	{ .ObjectID = IPSO_TEMPERATURE_OBJECT, .Units = "Cel" },
+	{ .ObjectID = IPSO_HUMIDITY_OBJECT, .Units = "%RH" },
+	{ .ObjectID = IPSO_BAROMETER_OBJECT, .Units = "hPa" },
+};
+
+static const ClientStateDefinition sensorStateDefinition =
+{
+	.Slot = ClientStateSlot_Sensor,
+	.Size = sizeof(SensorState),
+};
+
+FOOTPRINT_RECORD(IPSOSensor)
+FOOTPRINT_RECORD(SensorState)
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/* Returns the client's instance of a sensor object, or NULL if out of range or out of memory */
+static IPSOSensor *Sensor_GetInstance(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID)
+{
+	SensorState *state;
+	int i;
+
+	if (objectInstanceID < 0 || objectInstanceID >= SENSORS)
+		return NULL;
+
+	for (i = 0; i < SENSOR_OBJECTS; i++)
+	{
+		if (sensorObjects[i].ObjectID == objectID)
+		{
+			state = ClientState_Get(context, &sensorStateDefinition);
+			return state != NULL ? &state->Instances[i][objectInstanceID] : NULL;
+		}
+	}
+	return NULL;
+}
+
+static int Sensor_ObjectCreateInstanceHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID)
+{
+	if (Sensor_GetInstance(context, objectID, objectInstanceID) == NULL)
+	{
+		Lwm2m_Error("Sensor_ObjectCreateInstanceHandler instance number %d out of range (max %d)",
+			objectInstanceID, SENSORS - 1);
+		return -1;
+	}
+	ResourceVersion_StampInstance(context, objectID, objectInstanceID, false);
+	return objectInstanceID;
+}
+
+static int Sensor_ResourceCreateHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID)
+{
+	return 0;
+}
+
+static int Sensor_ObjectDeleteHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID)
+{
+	IPSOSensor *sensor = Sensor_GetInstance(context, objectID, objectInstanceID);
+
+	if (sensor == NULL)
+	{
+		Lwm2m_Error("Sensor_ObjectDeleteHandler Invalid OIR: %d/%d/%d\n", objectID,
+			objectInstanceID, resourceID);
+		return -1;
+	}
+
+	if (resourceID == -1)
+	{
+		memset(sensor, 0, sizeof(IPSOSensor));
+		ResourceVersion_StampInstance(context, objectID, objectInstanceID, true);
+	}
+	else
+	{
+		//TODO
+	}
+
+	return 0;
+}
+
+/*
+ * Returns the length of the current value of a resource and points value at it, or -1 for an
+ * unknown resource.
+ */
+static int Sensor_GetResourceValue(IPSOSensor *sensor, ResourceIDType resourceID,
+	const void **value)
+{
+	switch (resourceID)
+	{
+		case IPSO_SENSOR_VALUE:
+			*value = &sensor->SensorValue;
+			return sizeof(sensor->SensorValue);
+
+		case IPSO_MIN_MEASURED_VALUE:
+			*value = &sensor->MinMeasuredValue;
+			return sizeof(sensor->MinMeasuredValue);
+
+		case IPSO_MAX_MEASURED_VALUE:
+			*value = &sensor->MaxMeasuredValue;
+			return sizeof(sensor->MaxMeasuredValue);
+
+		case IPSO_MIN_RANGE_VALUE:
+			*value = &sensor->MinRangeValue;
+			return sizeof(sensor->MinRangeValue);
+
+		case IPSO_MAX_RANGE_VALUE:
+			*value = &sensor->MaxRangeValue;
+			return sizeof(sensor->MaxRangeValue);
+
+		case IPSO_SENSOR_UNITS:
+			*value = sensor->SensorUnits;
+			return strlen(sensor->SensorUnits) + 1;
+
+		default:
+			*value = NULL;
+			return -1;
+	}
+}
+
+static int Sensor_ResourceReadHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID, uint8_t *destBuffer, int destBufferLen)
+{
+	IPSOSensor *sensor = Sensor_GetInstance(context, objectID, objectInstanceID);
+	const void *value;
+	int result = -1;
+	DIAGNOSTICS_START(startTime);
+
+	if (sensor != NULL)
+		result = Sensor_GetResourceValue(sensor, resourceID, &value);
+
+	if (result > destBufferLen)
+	{
+		Lwm2m_Error("Sensor_ResourceReadHandler resource %d needs %d bytes, buffer has %d\n",
+			resourceID, result, destBufferLen);
+		result = -1;
+	}
+	else if (result > 0)
+	{
+		memcpy(destBuffer, value, result);
+	}
+
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Read, result, startTime);
+	return result;
+}
+
+static int Sensor_ResourceGetLengthHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID)
+{
+	IPSOSensor *sensor = Sensor_GetInstance(context, objectID, objectInstanceID);
+	const void *value;
+	int result = -1;
+	DIAGNOSTICS_START(startTime);
+
+	if (sensor != NULL)
+		result = Sensor_GetResourceValue(sensor, resourceID, &value);
+
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_GetLength, result, startTime);
+	return result;
+}
+
+/* Floats arrive as either single or double precision */
+static int Sensor_ReadFloat(const uint8_t *srcBuffer, int srcBufferLen, double *value)
+{
+	if (srcBufferLen == sizeof(double))
+	{
+		memcpy(value, srcBuffer, sizeof(double));
+	}
+	else if (srcBufferLen == sizeof(float))
+	{
+		float single;
+		memcpy(&single, srcBuffer, sizeof(float));
+		*value = single;
+	}
+	else
+	{
+		return -1;
+	}
+	return srcBufferLen;
+}
+
+static int Sensor_ResourceWriteHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID,
+	ResourceInstanceIDType resourceInstanceID, uint8_t *srcBuffer, int srcBufferLen, bool *changed)
+{
+	IPSOSensor *sensor = Sensor_GetInstance(context, objectID, objectInstanceID);
+	int result;
+	DIAGNOSTICS_START(startTime);
+
+	if (sensor == NULL)
+	{
+		Lwm2m_Error("Sensor_ResourceWriteHandler Invalid OIR: %d/%d/%d\n", objectID,
+			objectInstanceID, resourceID);
+		DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Write, -1, startTime);
+		return -1;
+	}
+
+	switch(resourceID)
+	{
+		case IPSO_SENSOR_VALUE:
+			result = Sensor_ReadFloat(srcBuffer, srcBufferLen, &sensor->SensorValue);
+			break;
+
+		case IPSO_MIN_MEASURED_VALUE:
+			result = Sensor_ReadFloat(srcBuffer, srcBufferLen, &sensor->MinMeasuredValue);
+			break;
+
+		case IPSO_MAX_MEASURED_VALUE:
+			result = Sensor_ReadFloat(srcBuffer, srcBufferLen, &sensor->MaxMeasuredValue);
+			break;
+
+		case IPSO_MIN_RANGE_VALUE:
+			result = Sensor_ReadFloat(srcBuffer, srcBufferLen, &sensor->MinRangeValue);
+			break;
+
+		case IPSO_MAX_RANGE_VALUE:
+			result = Sensor_ReadFloat(srcBuffer, srcBufferLen, &sensor->MaxRangeValue);
+			break;
+
+		case IPSO_SENSOR_UNITS:
+			result = srcBufferLen;
+			if(result < sizeof(sensor->SensorUnits))
+			{
+				memcpy(sensor->SensorUnits, srcBuffer, result);
+				sensor->SensorUnits[result] = '\0';
+			}
+			else
+			{
+				Lwm2m_Error("Sensor_ResourceWriteHandler Sensor Units string too long: %d",
+					result);
+				result = -1;
+			}
+			break;
+
+		default:
+			result = -1;
+			break;
+	}
+
+	if(result > 0)
+	{
+		*changed = true;
+		ResourceVersion_Stamp(context, objectID, objectInstanceID, resourceID);
+	}
+
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Write, result, startTime);
+	return result;
+}
+
+/* Publishes Min/Max Measured Value through the core so observers are notified */
+static int Sensor_PublishMinMax(Lwm2mContextType *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, double min, double max)
+{
+	if (Lwm2mCore_SetResourceInstanceValue(context, objectID, objectInstanceID,
+		IPSO_MIN_MEASURED_VALUE, 0, &min, sizeof(min)) == -1 ||
+		Lwm2mCore_SetResourceInstanceValue(context, objectID, objectInstanceID,
+		IPSO_MAX_MEASURED_VALUE, 0, &max, sizeof(max)) == -1)
+	{
+		Lwm2m_Error("Failed to set Min/Max Measured Value of %d/%d\n", objectID, objectInstanceID);
+		return -1;
+	}
+	return 0;
+}
+
+/* Min/Max and the running mean restart from the current value */
+static int Sensor_ResourceExecuteHandler(void *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID, uint8_t *srcBuffer,
+	int srcBufferLen)
+{
+	IPSOSensor *sensor = Sensor_GetInstance(context, objectID, objectInstanceID);
+	int result = -1;
+	DIAGNOSTICS_START(startTime);
+
+	if (sensor != NULL && resourceID == IPSO_RESET_MIN_MAX)
+	{
+		sensor->Sum = sensor->SensorValue;
+		sensor->SampleCount = sensor->SampleCount > 0 ? 1 : 0;
+		result = Sensor_PublishMinMax(context, objectID, objectInstanceID, sensor->SensorValue,
+			sensor->SensorValue);
+	}
+
+	DIAGNOSTICS_RECORD(objectID, resourceID, DiagnosticsOperation_Execute, srcBufferLen,
+		startTime);
+	return result;
+}
+
+/* Min, max and sum of samples in one pass, two lanes at a time where SIMD is available */
+static void Sensor_Reduce(const double *samples, int sampleCount, double *min, double *max,
+	double *sum)
+{
+	double lanes[2];
+	int i = 0;
+
+	*min = *max = samples[0];
+	*sum = 0;
+
+#if defined(__SSE2__)
+	if (sampleCount >= 2)
+	{
+		__m128d vmin = _mm_set1_pd(samples[0]);
+		__m128d vmax = vmin;
+		__m128d vsum = _mm_setzero_pd();
+
+		for (; i + 2 <= sampleCount; i += 2)
+		{
+			__m128d v = _mm_loadu_pd(&samples[i]);
+			vmin = _mm_min_pd(vmin, v);
+			vmax = _mm_max_pd(vmax, v);
+			vsum = _mm_add_pd(vsum, v);
+		}
+
+		_mm_storeu_pd(lanes, vmin);
+		*min = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+		_mm_storeu_pd(lanes, vmax);
+		*max = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+		_mm_storeu_pd(lanes, vsum);
+		*sum = lanes[0] + lanes[1];
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	if (sampleCount >= 2)
+	{
+		float64x2_t vmin = vdupq_n_f64(samples[0]);
+		float64x2_t vmax = vmin;
+		float64x2_t vsum = vdupq_n_f64(0);
+
+		for (; i + 2 <= sampleCount; i += 2)
+		{
+			float64x2_t v = vld1q_f64(&samples[i]);
+			vmin = vminq_f64(vmin, v);
+			vmax = vmaxq_f64(vmax, v);
+			vsum = vaddq_f64(vsum, v);
+		}
+
+		vst1q_f64(lanes, vmin);
+		*min = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+		vst1q_f64(lanes, vmax);
+		*max = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+		vst1q_f64(lanes, vsum);
+		*sum = lanes[0] + lanes[1];
+	}
+#else
+	(void)lanes;
+#endif
+
+	for (; i < sampleCount; i++)
+	{
+		if (samples[i] < *min)
+			*min = samples[i];
+		if (samples[i] > *max)
+			*max = samples[i];
+		*sum += samples[i];
+	}
+}
+
+static int Sensor_RegisterSensorResources(Lwm2mContextType *context, ObjectIDType objectID)
+{
+	REGISTER_SENSOR_RESOURCE(context, "SensorValue", objectID, IPSO_SENSOR_VALUE, \
+		ResourceTypeEnum_TypeFloat, MandatoryEnum_Mandatory, Operations_R);
+	REGISTER_SENSOR_RESOURCE(context, "Units", objectID, IPSO_SENSOR_UNITS, \
+		ResourceTypeEnum_TypeString, MandatoryEnum_Optional, Operations_R);
+	REGISTER_SENSOR_RESOURCE(context, "MinMeasuredValue", objectID, IPSO_MIN_MEASURED_VALUE, \
+		ResourceTypeEnum_TypeFloat, MandatoryEnum_Optional, Operations_R);
+	REGISTER_SENSOR_RESOURCE(context, "MaxMeasuredValue", objectID, IPSO_MAX_MEASURED_VALUE, \
+		ResourceTypeEnum_TypeFloat, MandatoryEnum_Optional, Operations_R);
+	REGISTER_SENSOR_RESOURCE(context, "MinRangeValue", objectID, IPSO_MIN_RANGE_VALUE, \
+		ResourceTypeEnum_TypeFloat, MandatoryEnum_Optional, Operations_R);
+	REGISTER_SENSOR_RESOURCE(context, "MaxRangeValue", objectID, IPSO_MAX_RANGE_VALUE, \
+		ResourceTypeEnum_TypeFloat, MandatoryEnum_Optional, Operations_R);
+	REGISTER_SENSOR_RESOURCE(context, "ResetMinMaxMeasuredValues", objectID, IPSO_RESET_MIN_MAX, \
+		ResourceTypeEnum_TypeNone, MandatoryEnum_Optional, Operations_E);
+
+	return 0;
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+int Sensor_RegisterTemperatureObject(Lwm2mContextType *context)
+{
+	REGISTER_OBJECT(context, "Temperature", IPSO_TEMPERATURE_OBJECT, \
+		MultipleInstancesEnum_Multiple, MandatoryEnum_Optional, &SensorObjectOperationHandlers);
+	return Sensor_RegisterSensorResources(context, IPSO_TEMPERATURE_OBJECT);
+}
+
+int Sensor_RegisterHumidityObject(Lwm2mContextType *context)
+{
+	REGISTER_OBJECT(context, "Humidity", IPSO_HUMIDITY_OBJECT, \
+		MultipleInstancesEnum_Multiple, MandatoryEnum_Optional, &SensorObjectOperationHandlers);
+	return Sensor_RegisterSensorResources(context, IPSO_HUMIDITY_OBJECT);
+}
+
+int Sensor_RegisterBarometerObject(Lwm2mContextType *context)
+{
+	REGISTER_OBJECT(context, "Barometer", IPSO_BAROMETER_OBJECT, \
+		MultipleInstancesEnum_Multiple, MandatoryEnum_Optional, &SensorObjectOperationHandlers);
+	return Sensor_RegisterSensorResources(context, IPSO_BAROMETER_OBJECT);
+}
+
+int Sensor_AddSensor(Lwm2mContextType *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, double minRange, double maxRange)
+{
+	IPSOSensor *sensor = Sensor_GetInstance(context, objectID, objectInstanceID);
+	const char *units;
+	int i;
+
+	if (sensor == NULL)
+	{
+		Lwm2m_Error("%d instance of sensor object %d exceeds max instances %d\n", objectInstanceID,
+			objectID, SENSORS);
+		return -1;
+	}
+
+	CREATE_OBJECT_INSTANCE(context, objectID, objectInstanceID);
+	CREATE_SENSOR_OPTIONAL_RESOURCE(context, objectID, objectInstanceID, IPSO_SENSOR_UNITS);
+	CREATE_SENSOR_OPTIONAL_RESOURCE(context, objectID, objectInstanceID, IPSO_MIN_MEASURED_VALUE);
+	CREATE_SENSOR_OPTIONAL_RESOURCE(context, objectID, objectInstanceID, IPSO_MAX_MEASURED_VALUE);
+	CREATE_SENSOR_OPTIONAL_RESOURCE(context, objectID, objectInstanceID, IPSO_MIN_RANGE_VALUE);
+	CREATE_SENSOR_OPTIONAL_RESOURCE(context, objectID, objectInstanceID, IPSO_MAX_RANGE_VALUE);
+	CREATE_SENSOR_OPTIONAL_RESOURCE(context, objectID, objectInstanceID, IPSO_RESET_MIN_MAX);
+
+	for (i = 0, units = ""; i < SENSOR_OBJECTS; i++)
+	{
+		if (sensorObjects[i].ObjectID == objectID)
+			units = sensorObjects[i].Units;
+	}
+
+	memset(sensor, 0, sizeof(IPSOSensor));
+	snprintf(sensor->SensorUnits, MAX_STR_SIZE, "%s", units);
+	sensor->MinRangeValue = minRange;
+	sensor->MaxRangeValue = maxRange;
+	return 0;
+}
+
+/* Sets Sensor Value and folds it into Min/Max Measured Value and the running mean */
+int Sensor_SetValue(Lwm2mContextType *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, double value)
+{
+	return Sensor_IngestSamples(context, objectID, objectInstanceID, &value, 1);
+}
+
+/*
+ * Folds a batch of samples, oldest first, into Min/Max Measured Value and the running mean, and
+ * sets Sensor Value to the last one. Min/Max are only published when the batch moves them.
+ */
+int Sensor_IngestSamples(Lwm2mContextType *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, const double *samples, int sampleCount)
+{
+	IPSOSensor *sensor = Sensor_GetInstance(context, objectID, objectInstanceID);
+	double min, max, sum;
+
+	if (sensor == NULL || sampleCount <= 0)
+		return -1;
+
+	Sensor_Reduce(samples, sampleCount, &min, &max, &sum);
+
+	if (sensor->SampleCount > 0)
+	{
+		if (sensor->MinMeasuredValue < min)
+			min = sensor->MinMeasuredValue;
+		if (sensor->MaxMeasuredValue > max)
+			max = sensor->MaxMeasuredValue;
+	}
+	sensor->Sum += sum;
+	sensor->SampleCount += sampleCount;
+
+	if ((min != sensor->MinMeasuredValue || max != sensor->MaxMeasuredValue ||
+		sensor->SampleCount == sampleCount) &&
+		Sensor_PublishMinMax(context, objectID, objectInstanceID, min, max) == -1)
+	{
+		return -1;
+	}
+
+	if (Lwm2mCore_SetResourceInstanceValue(context, objectID, objectInstanceID, IPSO_SENSOR_VALUE,
+		0, &samples[sampleCount - 1], sizeof(double)) == -1)
+	{
+		Lwm2m_Error("Failed to set Sensor Value of %d/%d\n", objectID, objectInstanceID);
+		return -1;
+	}
+	return 0;
+}
+
+/* Mean of the samples since the instance was added or Min/Max were last reset */
+int Sensor_GetMean(Lwm2mContextType *context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, double *mean)
+{
+	IPSOSensor *sensor = Sensor_GetInstance(context, objectID, objectInstanceID);
+
+	if (sensor == NULL || sensor->SampleCount == 0)
+		return -1;
+
+	*mean = sensor->Sum / sensor->SampleCount;
+	return 0;
+}
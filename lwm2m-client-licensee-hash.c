@@ -0,0 +1,133 @@
+/**
+ * @file
+ * Flow licensee hash chain.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lwm2m-client-licensee-hash.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+/* Bits hashed by the inner and outer digests of a later round: one key pad block and a hash */
+#define LICENSEE_HASH_ROUND_BITS		((SHA256_STREAM_BLOCK_LENGTH + LICENSEE_HASH_LENGTH) * 8)
+
+/***************************************************************************************************
+ * Implementation - Private
+ **************************************************************************************************/
+
+static void LicenseeHash_PutState(uint8_t * bytes, const uint32_t state[8])
+{
+	int i;
+
+	for (i = 0; i < 8; i++)
+	{
+		bytes[i * 4] = (uint8_t)(state[i] >> 24);
+		bytes[i * 4 + 1] = (uint8_t)(state[i] >> 16);
+		bytes[i * 4 + 2] = (uint8_t)(state[i] >> 8);
+		bytes[i * 4 + 3] = (uint8_t)state[i];
+	}
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+void LicenseeHash_InitRoundBlock(uint8_t block[SHA256_STREAM_BLOCK_LENGTH])
+{
+	memset(block, 0, SHA256_STREAM_BLOCK_LENGTH);
+	block[LICENSEE_HASH_LENGTH] = 0x80;
+	block[SHA256_STREAM_BLOCK_LENGTH - 2] = (uint8_t)(LICENSEE_HASH_ROUND_BITS >> 8);
+	block[SHA256_STREAM_BLOCK_LENGTH - 1] = (uint8_t)LICENSEE_HASH_ROUND_BITS;
+}
+
+/*
+ * The key pads are hashed once up front, so each round costs two compressions (inner and outer)
+ * instead of the four a full HMAC computation takes.
+ */
+void LicenseeHash_Iterate(uint8_t hash[LICENSEE_HASH_LENGTH], const uint8_t * key, int keyLength,
+	int iterations)
+{
+	HmacSha256StreamContext hmac;
+	uint8_t block[SHA256_STREAM_BLOCK_LENGTH];
+	uint32_t state[8];
+	int i;
+
+	if (iterations <= 1)
+		return;
+
+	HmacSha256Stream_Init(&hmac, key, keyLength);
+	LicenseeHash_InitRoundBlock(block);
+	memcpy(block, hash, LICENSEE_HASH_LENGTH);
+
+	for (i = 1; i < iterations; i++)
+	{
+		memcpy(state, hmac.Inner.State, sizeof(state));
+		Sha256Stream_Compress(state, block);
+		LicenseeHash_PutState(block, state);
+
+		memcpy(state, hmac.OuterState, sizeof(state));
+		Sha256Stream_Compress(state, block);
+		LicenseeHash_PutState(block, state);
+	}
+	memcpy(hash, block, LICENSEE_HASH_LENGTH);
+}
+
+void LicenseeHash_Compute(const uint8_t * key, int keyLength, const void * challenge,
+	int challengeLength, int iterations, uint8_t hash[LICENSEE_HASH_LENGTH])
+{
+	HmacSha256StreamContext hmac;
+
+	HmacSha256Stream_Init(&hmac, key, keyLength);
+	HmacSha256Stream_Update(&hmac, challenge, challengeLength);
+	HmacSha256Stream_Final(&hmac, hash);
+	LicenseeHash_Iterate(hash, key, keyLength, iterations);
+}
+
+bool LicenseeHash_Equal(const uint8_t a[LICENSEE_HASH_LENGTH],
+	const uint8_t b[LICENSEE_HASH_LENGTH])
+{
+	volatile uint8_t difference = 0;
+	int i;
+
+	for (i = 0; i < LICENSEE_HASH_LENGTH; i++)
+		difference |= a[i] ^ b[i];
+	return difference == 0;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file
+ * Flow licensee hash chain.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_LICENSEE_HASH_H_
+#define LWM2M_CLIENT_LICENSEE_HASH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwm2m-client-hmac-sha256.h"
+
+#define LICENSEE_HASH_LENGTH			SHA256_STREAM_HASH_LENGTH
+
+/*
+ * The licensee hash proves a device knows its licensee secret. The first round is the HMAC-SHA256
+ * of the challenge keyed with the decoded secret; each further round is the HMAC of the previous
+ * round's hash under the same key, for Hash Iterations rounds in all.
+ */
+
+/* Runs the whole chain; iterations below 1 count as 1 */
+void LicenseeHash_Compute(const uint8_t * key, int keyLength, const void * challenge,
+	int challengeLength, int iterations, uint8_t hash[LICENSEE_HASH_LENGTH]);
+
+/* Applies rounds 2..iterations to a hash holding the first round */
+void LicenseeHash_Iterate(uint8_t hash[LICENSEE_HASH_LENGTH], const uint8_t * key, int keyLength,
+	int iterations);
+
+/*
+ * The SHA-256 message block of a later round: the previous 32-byte hash, then the padding and
+ * length for a 96-byte message (the 64-byte key pad plus the hash). Only the first 8 words vary.
+ */
+void LicenseeHash_InitRoundBlock(uint8_t block[SHA256_STREAM_BLOCK_LENGTH]);
+
+/* Compares two hashes in time independent of where they differ */
+bool LicenseeHash_Equal(const uint8_t a[LICENSEE_HASH_LENGTH],
+	const uint8_t b[LICENSEE_HASH_LENGTH]);
+
+#endif /* LWM2M_CLIENT_LICENSEE_HASH_H_ */
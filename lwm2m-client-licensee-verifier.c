@@ -0,0 +1,568 @@
+/**
+ * @file
+ * Batch licensee hash verifier.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "lwm2m-client-hmac-sha256.h"
+#include "lwm2m-client-licensee-hash.h"
+#include "lwm2m-client-licensee-verifier.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define LICENSEE_VERIFIER_LANES			8
+#define LICENSEE_VERIFIER_MAX_CHUNK		64		/* Items claimed by a thread at a time */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LICENSEE_VERIFIER_AVX2
+#endif
+
+/* SHA-256 functions, written so they apply to every lane of a vector at once */
+#define ROTR(x, n)			(((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z)			(((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z)		(((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define SIGMA0(x)			(ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define SIGMA1(x)			(ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define GAMMA0(x)			(ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define GAMMA1(x)			(ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+/* Padding and length words of a later round's message block (see LicenseeHash_InitRoundBlock) */
+#define LICENSEE_VERIFIER_PAD_WORD		0x80000000
+#define LICENSEE_VERIFIER_ROUND_BITS	((SHA256_STREAM_BLOCK_LENGTH + LICENSEE_HASH_LENGTH) * 8)
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+/* One 32-bit word from each chain; lane n of every vector belongs to chain n */
+typedef uint32_t LicenseeVerifierWords __attribute__((vector_size(LICENSEE_VERIFIER_LANES * 4)));
+
+/*
+ * The chains a thread runs side by side. Words are kept one vector per SHA-256 state word, so the
+ * hash a round produces is already laid out as the next round's message and needs no transposing.
+ */
+typedef struct
+{
+	LicenseeVerifierWords Inner[8];
+	LicenseeVerifierWords Outer[8];
+	LicenseeVerifierWords Hash[8];
+	int Item[LICENSEE_VERIFIER_LANES];			/* -1 when the lane is idle */
+	int Remaining[LICENSEE_VERIFIER_LANES];
+} LicenseeVerifierLanes;
+
+typedef void (*LicenseeVerifierRunLanes)(LicenseeVerifierLanes * lanes, int rounds);
+
+struct _LicenseeVerifier
+{
+	pthread_t * Threads;
+	int ThreadCount;							/* Workers; the calling thread also takes part */
+	LicenseeVerifierRunLanes RunLanes;
+	const char * Engine;
+
+	pthread_mutex_t BatchLock;					/* One batch at a time */
+	pthread_mutex_t Lock;
+	pthread_cond_t Started;
+	pthread_cond_t Finished;
+	unsigned int Generation;
+	int Busy;
+	bool Stopping;
+
+	LicenseeVerification * Items;
+	int Count;
+	int ChunkSize;
+	int Next;
+	int Matched;
+};
+
+/***************************************************************************************************
+ * Implementation - Private
+ **************************************************************************************************/
+
+/*
+ * Compresses one message block per lane. The message is a 32-byte hash followed by the fixed
+ * padding of a later round, so only its first 8 words differ between chains.
+ */
+static inline __attribute__((always_inline)) void LicenseeVerifier_Compress(
+	LicenseeVerifierWords state[8], const LicenseeVerifierWords initial[8],
+	const LicenseeVerifierWords message[8])
+{
+	const LicenseeVerifierWords zero = { 0 };
+	LicenseeVerifierWords w[64];
+	LicenseeVerifierWords a, b, c, d, e, f, g, h, t1, t2;
+	int i;
+
+	for (i = 0; i < 8; i++)
+	{
+		w[i] = message[i];
+	}
+	w[8] = zero + LICENSEE_VERIFIER_PAD_WORD;
+	for (i = 9; i < 15; i++)
+	{
+		w[i] = zero;
+	}
+	w[15] = zero + LICENSEE_VERIFIER_ROUND_BITS;
+	for (i = 16; i < 64; i++)
+	{
+		w[i] = GAMMA1(w[i - 2]) + w[i - 7] + GAMMA0(w[i - 15]) + w[i - 16];
+	}
+
+	a = initial[0]; b = initial[1]; c = initial[2]; d = initial[3];
+	e = initial[4]; f = initial[5]; g = initial[6]; h = initial[7];
+
+	for (i = 0; i < 64; i++)
+	{
+		t1 = h + SIGMA1(e) + CH(e, f, g) + sha256RoundConstants[i] + w[i];
+		t2 = SIGMA0(a) + MAJ(a, b, c);
+		h = g; g = f; f = e; e = d + t1;
+		d = c; c = b; b = a; a = t1 + t2;
+	}
+
+	state[0] = initial[0] + a; state[1] = initial[1] + b;
+	state[2] = initial[2] + c; state[3] = initial[3] + d;
+	state[4] = initial[4] + e; state[5] = initial[5] + f;
+	state[6] = initial[6] + g; state[7] = initial[7] + h;
+}
+
+/* Each round is the inner compression of the previous hash, then the outer one of the result */
+static inline __attribute__((always_inline)) void LicenseeVerifier_Rounds(
+	LicenseeVerifierLanes * lanes, int rounds)
+{
+	LicenseeVerifierWords inner[8];
+
+	while (rounds-- > 0)
+	{
+		LicenseeVerifier_Compress(inner, lanes->Inner, lanes->Hash);
+		LicenseeVerifier_Compress(lanes->Hash, lanes->Outer, inner);
+	}
+}
+
+/* Built for the baseline instruction set, which the compiler lowers to whatever vectors it has */
+static void LicenseeVerifier_RunLanesGeneric(LicenseeVerifierLanes * lanes, int rounds)
+{
+	LicenseeVerifier_Rounds(lanes, rounds);
+}
+
+#ifdef LICENSEE_VERIFIER_AVX2
+/* The same rounds with one AVX2 register per vector of 8 lanes */
+__attribute__((target("avx2")))
+static void LicenseeVerifier_RunLanesAvx2(LicenseeVerifierLanes * lanes, int rounds)
+{
+	LicenseeVerifier_Rounds(lanes, rounds);
+}
+#endif
+
+static void LicenseeVerifier_SetLane(LicenseeVerifierWords words[8], int lane,
+	const uint32_t state[8])
+{
+	int i;
+
+	for (i = 0; i < 8; i++)
+	{
+		words[i][lane] = state[i];
+	}
+}
+
+static void LicenseeVerifier_GetLaneHash(const LicenseeVerifierWords words[8], int lane,
+	uint8_t hash[LICENSEE_HASH_LENGTH])
+{
+	int i;
+
+	for (i = 0; i < 8; i++)
+	{
+		uint32_t word = words[i][lane];
+
+		hash[i * 4] = (uint8_t)(word >> 24);
+		hash[i * 4 + 1] = (uint8_t)(word >> 16);
+		hash[i * 4 + 2] = (uint8_t)(word >> 8);
+		hash[i * 4 + 3] = (uint8_t)word;
+	}
+}
+
+static bool LicenseeVerifier_IsValid(const LicenseeVerification * item)
+{
+	return item->KeyLength >= 0 && (item->Key != NULL || item->KeyLength == 0) &&
+		item->ChallengeLength >= 0 && (item->Challenge != NULL || item->ChallengeLength == 0);
+}
+
+/*
+ * Hashes an item's first round, which covers the whole challenge, and starts its chain in a lane.
+ * Returns false when the item is already finished.
+ */
+static bool LicenseeVerifier_StartLane(LicenseeVerifierLanes * lanes, int lane,
+	LicenseeVerification * item)
+{
+	HmacSha256StreamContext hmac;
+	uint8_t hash[LICENSEE_HASH_LENGTH];
+	uint32_t words[8];
+	int i;
+
+	item->Verified = false;
+	if (!LicenseeVerifier_IsValid(item))
+	{
+		return false;
+	}
+
+	HmacSha256Stream_Init(&hmac, item->Key, item->KeyLength);
+	LicenseeVerifier_SetLane(lanes->Inner, lane, hmac.Inner.State);
+	LicenseeVerifier_SetLane(lanes->Outer, lane, hmac.OuterState);
+	HmacSha256Stream_Update(&hmac, item->Challenge, item->ChallengeLength);
+	HmacSha256Stream_Final(&hmac, hash);
+
+	if (item->Iterations <= 1)
+	{
+		item->Verified = LicenseeHash_Equal(hash, item->ExpectedHash);
+		return false;
+	}
+
+	for (i = 0; i < 8; i++)
+	{
+		words[i] = ((uint32_t)hash[i * 4] << 24) | ((uint32_t)hash[i * 4 + 1] << 16) |
+			((uint32_t)hash[i * 4 + 2] << 8) | hash[i * 4 + 3];
+	}
+	LicenseeVerifier_SetLane(lanes->Hash, lane, words);
+	lanes->Remaining[lane] = item->Iterations - 1;
+	return true;
+}
+
+/*
+ * Runs every item of a chunk through the lanes. Lanes are refilled as their chains finish, and all
+ * lanes advance by the fewest rounds any active chain has left, so chains of different lengths can
+ * share the lanes. Idle lanes compute values nobody reads.
+ */
+static int LicenseeVerifier_VerifyChunk(LicenseeVerifier * verifier, LicenseeVerification * items,
+	int start, int end)
+{
+	LicenseeVerifierLanes lanes;
+	uint8_t hash[LICENSEE_HASH_LENGTH];
+	int matched = 0;
+	int next = start;
+	int lane;
+
+	memset(&lanes, 0, sizeof(lanes));
+	for (lane = 0; lane < LICENSEE_VERIFIER_LANES; lane++)
+	{
+		lanes.Item[lane] = -1;
+	}
+
+	for (;;)
+	{
+		int rounds = 0;
+
+		for (lane = 0; lane < LICENSEE_VERIFIER_LANES; lane++)
+		{
+			while (lanes.Item[lane] == -1 && next < end)
+			{
+				if (LicenseeVerifier_StartLane(&lanes, lane, &items[next]))
+				{
+					lanes.Item[lane] = next;
+				}
+				else if (items[next].Verified)
+				{
+					matched++;
+				}
+				next++;
+			}
+			if (lanes.Item[lane] != -1 && (rounds == 0 || lanes.Remaining[lane] < rounds))
+			{
+				rounds = lanes.Remaining[lane];
+			}
+		}
+		if (rounds == 0)
+		{
+			break;
+		}
+
+		verifier->RunLanes(&lanes, rounds);
+
+		for (lane = 0; lane < LICENSEE_VERIFIER_LANES; lane++)
+		{
+			LicenseeVerification * item;
+
+			if (lanes.Item[lane] == -1)
+			{
+				continue;
+			}
+			lanes.Remaining[lane] -= rounds;
+			if (lanes.Remaining[lane] > 0)
+			{
+				continue;
+			}
+
+			item = &items[lanes.Item[lane]];
+			LicenseeVerifier_GetLaneHash(lanes.Hash, lane, hash);
+			item->Verified = LicenseeHash_Equal(hash, item->ExpectedHash);
+			if (item->Verified)
+			{
+				matched++;
+			}
+			lanes.Item[lane] = -1;
+		}
+	}
+	return matched;
+}
+
+/* Claims chunks of the current batch until none are left */
+static void LicenseeVerifier_Work(LicenseeVerifier * verifier)
+{
+	int matched = 0;
+
+	for (;;)
+	{
+		int start = __atomic_fetch_add(&verifier->Next, verifier->ChunkSize, __ATOMIC_RELAXED);
+		int end = start + verifier->ChunkSize;
+
+		if (start >= verifier->Count)
+		{
+			break;
+		}
+		if (end > verifier->Count)
+		{
+			end = verifier->Count;
+		}
+		matched += LicenseeVerifier_VerifyChunk(verifier, verifier->Items, start, end);
+	}
+	__atomic_fetch_add(&verifier->Matched, matched, __ATOMIC_RELAXED);
+}
+
+static void * LicenseeVerifier_Thread(void * argument)
+{
+	LicenseeVerifier * verifier = argument;
+	unsigned int generation = 0;				/* Threads start before the first batch */
+
+	pthread_mutex_lock(&verifier->Lock);
+	for (;;)
+	{
+		while (verifier->Generation == generation && !verifier->Stopping)
+		{
+			pthread_cond_wait(&verifier->Started, &verifier->Lock);
+		}
+		if (verifier->Stopping)
+		{
+			break;
+		}
+		generation = verifier->Generation;
+		pthread_mutex_unlock(&verifier->Lock);
+
+		LicenseeVerifier_Work(verifier);
+
+		pthread_mutex_lock(&verifier->Lock);
+		if (--verifier->Busy == 0)
+		{
+			pthread_cond_signal(&verifier->Finished);
+		}
+	}
+	pthread_mutex_unlock(&verifier->Lock);
+	return NULL;
+}
+
+static void LicenseeVerifier_StopThreads(LicenseeVerifier * verifier, int started)
+{
+	int i;
+
+	pthread_mutex_lock(&verifier->Lock);
+	verifier->Stopping = true;
+	pthread_cond_broadcast(&verifier->Started);
+	pthread_mutex_unlock(&verifier->Lock);
+
+	for (i = 0; i < started; i++)
+	{
+		pthread_join(verifier->Threads[i], NULL);
+	}
+}
+
+static double LicenseeVerifier_GetTime(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+LicenseeVerifier * LicenseeVerifier_Create(int threads)
+{
+	LicenseeVerifier * verifier;
+	int i;
+
+	if (threads <= 0)
+	{
+		long online = sysconf(_SC_NPROCESSORS_ONLN);
+
+		threads = online > 0 ? (int)online : 1;
+	}
+
+	verifier = calloc(1, sizeof(*verifier));
+	if (verifier == NULL)
+	{
+		return NULL;
+	}
+
+	verifier->RunLanes = LicenseeVerifier_RunLanesGeneric;
+	verifier->Engine = "generic";
+#ifdef LICENSEE_VERIFIER_AVX2
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+	{
+		verifier->RunLanes = LicenseeVerifier_RunLanesAvx2;
+		verifier->Engine = "avx2";
+	}
+#endif
+
+	verifier->ThreadCount = threads - 1;
+	if (verifier->ThreadCount > 0 &&
+		(verifier->Threads = calloc(verifier->ThreadCount, sizeof(pthread_t))) == NULL)
+	{
+		free(verifier);
+		return NULL;
+	}
+
+	pthread_mutex_init(&verifier->BatchLock, NULL);
+	pthread_mutex_init(&verifier->Lock, NULL);
+	pthread_cond_init(&verifier->Started, NULL);
+	pthread_cond_init(&verifier->Finished, NULL);
+
+	for (i = 0; i < verifier->ThreadCount; i++)
+	{
+		if (pthread_create(&verifier->Threads[i], NULL, LicenseeVerifier_Thread, verifier) != 0)
+		{
+			/* Carry on with the threads already running */
+			verifier->ThreadCount = i;
+			break;
+		}
+	}
+	return verifier;
+}
+
+void LicenseeVerifier_Destroy(LicenseeVerifier * verifier)
+{
+	if (verifier == NULL)
+	{
+		return;
+	}
+
+	LicenseeVerifier_StopThreads(verifier, verifier->ThreadCount);
+	pthread_cond_destroy(&verifier->Finished);
+	pthread_cond_destroy(&verifier->Started);
+	pthread_mutex_destroy(&verifier->Lock);
+	pthread_mutex_destroy(&verifier->BatchLock);
+	free(verifier->Threads);
+	free(verifier);
+}
+
+int LicenseeVerifier_VerifyBatch(LicenseeVerifier * verifier, LicenseeVerification * items,
+	int count, LicenseeVerifierStats * stats)
+{
+	double startTime;
+	int threads;
+	int chunk;
+	int matched;
+
+	if (verifier == NULL || count < 0 || (items == NULL && count > 0))
+	{
+		return -1;
+	}
+
+	pthread_mutex_lock(&verifier->BatchLock);
+	startTime = LicenseeVerifier_GetTime();
+
+	/* Small batches get small chunks, so every thread has some of the work */
+	threads = verifier->ThreadCount + 1;
+	chunk = count / (threads * 4);
+	chunk -= chunk % LICENSEE_VERIFIER_LANES;
+	if (chunk < LICENSEE_VERIFIER_LANES)
+	{
+		chunk = LICENSEE_VERIFIER_LANES;
+	}
+	else if (chunk > LICENSEE_VERIFIER_MAX_CHUNK)
+	{
+		chunk = LICENSEE_VERIFIER_MAX_CHUNK;
+	}
+
+	verifier->Items = items;
+	verifier->Count = count;
+	verifier->ChunkSize = chunk;
+	verifier->Next = 0;
+	verifier->Matched = 0;
+
+	if (verifier->ThreadCount > 0 && count > chunk)
+	{
+		pthread_mutex_lock(&verifier->Lock);
+		verifier->Busy = verifier->ThreadCount;
+		verifier->Generation++;
+		pthread_cond_broadcast(&verifier->Started);
+		pthread_mutex_unlock(&verifier->Lock);
+
+		LicenseeVerifier_Work(verifier);
+
+		pthread_mutex_lock(&verifier->Lock);
+		while (verifier->Busy > 0)
+		{
+			pthread_cond_wait(&verifier->Finished, &verifier->Lock);
+		}
+		pthread_mutex_unlock(&verifier->Lock);
+	}
+	else
+	{
+		LicenseeVerifier_Work(verifier);
+		threads = 1;
+	}
+
+	matched = verifier->Matched;
+	if (stats != NULL)
+	{
+		stats->Verified = matched;
+		stats->Failed = count - matched;
+		stats->Seconds = LicenseeVerifier_GetTime() - startTime;
+		stats->VerificationsPerSecond = stats->Seconds > 0 ? count / stats->Seconds : 0;
+		stats->Threads = threads;
+		stats->Lanes = LICENSEE_VERIFIER_LANES;
+		stats->Engine = verifier->Engine;
+	}
+	pthread_mutex_unlock(&verifier->BatchLock);
+	return matched;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file
+ * Batch licensee hash verifier.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_LICENSEE_VERIFIER_H_
+#define LWM2M_CLIENT_LICENSEE_VERIFIER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwm2m-client-licensee-hash.h"
+
+/*
+ * Checks the licensee hashes reported by many devices at once, for the provisioning server side.
+ * Each thread runs several independent hash chains side by side, one per SIMD lane (AVX2 where the
+ * CPU has it), and batches are split between a pool of threads. Hashes are compared in constant
+ * time.
+ */
+
+typedef struct
+{
+	const uint8_t * Key;						/* Decoded licensee secret */
+	int KeyLength;
+	const void * Challenge;
+	int ChallengeLength;
+	int Iterations;
+	uint8_t ExpectedHash[LICENSEE_HASH_LENGTH];
+	bool Verified;								/* Set by LicenseeVerifier_VerifyBatch */
+} LicenseeVerification;
+
+typedef struct
+{
+	int Verified;
+	int Failed;
+	double Seconds;
+	double VerificationsPerSecond;
+	int Threads;
+	int Lanes;									/* Chains run side by side on each thread */
+	const char * Engine;						/* "avx2" or "generic" */
+} LicenseeVerifierStats;
+
+typedef struct _LicenseeVerifier LicenseeVerifier;
+
+/* threads of 0 or less uses one per online CPU */
+LicenseeVerifier * LicenseeVerifier_Create(int threads);
+void LicenseeVerifier_Destroy(LicenseeVerifier * verifier);
+
+/* Returns the number of items verified, or -1 on error. stats may be NULL */
+int LicenseeVerifier_VerifyBatch(LicenseeVerifier * verifier, LicenseeVerification * items,
+	int count, LicenseeVerifierStats * stats);
+
+#endif /* LWM2M_CLIENT_LICENSEE_VERIFIER_H_ */
@@ -0,0 +1,393 @@
+/**
+ * @file
+ * Parses Light Control Colour strings into numeric colours.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "lwm2m-client-light-colour.h"
+#include "lwm2m-client-light-tables.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define LIGHT_COLOUR_MAX_VALUES			3
+
+/* Chromaticity of the D65 white point, used for white and for black, which has none */
+#define LIGHT_COLOUR_WHITE_X			0.3127f
+#define LIGHT_COLOUR_WHITE_Y			0.3290f
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef struct
+{
+	const char * Name;
+	uint8_t Red;
+	uint8_t Green;
+	uint8_t Blue;
+} LightColourName;
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+/* Names are matched ignoring case and spaces */
+static const LightColourName lightColourNames[] =
+{
+	{ "black", 0, 0, 0 },
+	{ "white", 255, 255, 255 },
+	{ "warmwhite", 255, 180, 107 },
+	{ "red", 255, 0, 0 },
+	{ "green", 0, 255, 0 },
+	{ "blue", 0, 0, 255 },
+	{ "yellow", 255, 255, 0 },
+	{ "cyan", 0, 255, 255 },
+	{ "magenta", 255, 0, 255 },
+	{ "orange", 255, 165, 0 },
+	{ "purple", 128, 0, 128 },
+};
+
+/***************************************************************************************************
+ * Implementation - Private
+ **************************************************************************************************/
+
+static uint8_t LightColour_ToByte(float value)
+{
+	return value <= 0 ? 0 : value >= 1 ? 255 : (uint8_t)(value * 255 + 0.5f);
+}
+
+/* Returns the 8-bit sRGB value whose linear light is nearest to duty */
+static uint8_t LightColour_FromLinear(uint16_t duty)
+{
+	int low = 0;
+	int high = 255;
+
+	while (low < high)
+	{
+		int middle = (low + high) / 2;
+
+		if (lightSrgbToLinear[middle] < duty)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	if (low > 0 && duty - lightSrgbToLinear[low - 1] < lightSrgbToLinear[low] - duty)
+		low--;
+	return low;
+}
+
+static void LightColour_SetHSVFromRGB(LightColour * colour)
+{
+	int red = colour->Red, green = colour->Green, blue = colour->Blue;
+	int max = red > green ? (red > blue ? red : blue) : (green > blue ? green : blue);
+	int min = red < green ? (red < blue ? red : blue) : (green < blue ? green : blue);
+	float hue = 0;
+
+	if (max != min)
+	{
+		if (max == red)
+			hue = 60.0f * (green - blue) / (max - min);
+		else if (max == green)
+			hue = 60.0f * (blue - red) / (max - min) + 120;
+		else
+			hue = 60.0f * (red - green) / (max - min) + 240;
+		if (hue < 0)
+			hue += 360;
+	}
+	colour->Hue = hue;
+	colour->Saturation = max == 0 ? 0 : (float)(max - min) / max;
+	colour->Value = max / 255.0f;
+}
+
+/* Chromaticity of the linear channel outputs, through the sRGB (D65) to CIE XYZ matrix */
+static void LightColour_SetXYFromDuty(LightColour * colour)
+{
+	float red = colour->Duty[LightColourChannel_Red];
+	float green = colour->Duty[LightColourChannel_Green];
+	float blue = colour->Duty[LightColourChannel_Blue];
+	float x = 0.4124f * red + 0.3576f * green + 0.1805f * blue;
+	float y = 0.2126f * red + 0.7152f * green + 0.0722f * blue;
+	float z = 0.0193f * red + 0.1192f * green + 0.9505f * blue;
+
+	if (x + y + z == 0)
+	{
+		colour->X = LIGHT_COLOUR_WHITE_X;
+		colour->Y = LIGHT_COLOUR_WHITE_Y;
+	}
+	else
+	{
+		colour->X = x / (x + y + z);
+		colour->Y = y / (x + y + z);
+	}
+}
+
+static void LightColour_SetRGB(LightColour * colour, uint8_t red, uint8_t green, uint8_t blue)
+{
+	colour->Model = LightColourModel_RGB;
+	colour->Red = red;
+	colour->Green = green;
+	colour->Blue = blue;
+	colour->Duty[LightColourChannel_Red] = lightSrgbToLinear[red];
+	colour->Duty[LightColourChannel_Green] = lightSrgbToLinear[green];
+	colour->Duty[LightColourChannel_Blue] = lightSrgbToLinear[blue];
+	LightColour_SetHSVFromRGB(colour);
+	LightColour_SetXYFromDuty(colour);
+}
+
+static void LightColour_SetHSV(LightColour * colour, float hue, float saturation, float value)
+{
+	float sector = (hue >= 360 ? 0 : hue) / 60;
+	int index = (int)sector;
+	float fraction = sector - index;
+	float p = value * (1 - saturation);
+	float q = value * (1 - saturation * fraction);
+	float t = value * (1 - saturation * (1 - fraction));
+	float red, green, blue;
+
+	switch (index)
+	{
+		case 0: red = value; green = t; blue = p; break;
+		case 1: red = q; green = value; blue = p; break;
+		case 2: red = p; green = value; blue = t; break;
+		case 3: red = p; green = q; blue = value; break;
+		case 4: red = t; green = p; blue = value; break;
+		default: red = value; green = p; blue = q; break;
+	}
+
+	LightColour_SetRGB(colour, LightColour_ToByte(red), LightColour_ToByte(green),
+		LightColour_ToByte(blue));
+	colour->Model = LightColourModel_HSV;
+	colour->Hue = hue >= 360 ? 0 : hue;
+	colour->Saturation = saturation;
+	colour->Value = value;
+}
+
+/*
+ * The brightest colour of the given chromaticity the channels can make: CIE XYZ back to linear
+ * sRGB, with channels outside the gamut clipped.
+ */
+static void LightColour_SetXY(LightColour * colour, float x, float y)
+{
+	float bigX = x / y;
+	float bigZ = (1 - x - y) / y;
+	float linear[LIGHT_COLOUR_CHANNELS];
+	float max = 0;
+	int i;
+
+	linear[LightColourChannel_Red] = 3.2406f * bigX - 1.5372f - 0.4986f * bigZ;
+	linear[LightColourChannel_Green] = -0.9689f * bigX + 1.8758f + 0.0415f * bigZ;
+	linear[LightColourChannel_Blue] = 0.0557f * bigX - 0.2040f + 1.0570f * bigZ;
+
+	for (i = 0; i < LIGHT_COLOUR_CHANNELS; i++)
+	{
+		if (linear[i] < 0)
+			linear[i] = 0;
+		if (linear[i] > max)
+			max = linear[i];
+	}
+	for (i = 0; i < LIGHT_COLOUR_CHANNELS; i++)
+		colour->Duty[i] = max == 0 ? 0 : (uint16_t)(linear[i] / max * 65535 + 0.5f);
+
+	colour->Model = LightColourModel_XY;
+	colour->Red = LightColour_FromLinear(colour->Duty[LightColourChannel_Red]);
+	colour->Green = LightColour_FromLinear(colour->Duty[LightColourChannel_Green]);
+	colour->Blue = LightColour_FromLinear(colour->Duty[LightColourChannel_Blue]);
+	LightColour_SetHSVFromRGB(colour);
+	colour->X = x;
+	colour->Y = y;
+}
+
+static int LightColour_HexDigit(char c)
+{
+	return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+		c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+}
+
+static const char * LightColour_SkipSpace(const char * string)
+{
+	while (isspace((unsigned char)*string))
+		string++;
+	return string;
+}
+
+/* Parses "#RRGGBB" or "#RGB" from just after the '#' */
+static int LightColour_ParseHex(const char * string, LightColour * colour)
+{
+	int digits[6];
+	int count = 0;
+
+	while (count < 6 && (digits[count] = LightColour_HexDigit(string[count])) != -1)
+		count++;
+	if (*LightColour_SkipSpace(string + count) != '\0')
+		return -1;
+
+	if (count == 6)
+	{
+		LightColour_SetRGB(colour, digits[0] * 16 + digits[1], digits[2] * 16 + digits[3],
+			digits[4] * 16 + digits[5]);
+	}
+	else if (count == 3)
+		LightColour_SetRGB(colour, digits[0] * 17, digits[1] * 17, digits[2] * 17);
+	else
+		return -1;
+	return 0;
+}
+
+/*
+ * Parses count comma separated numbers and the closing bracket, from just after the opening one.
+ * Each number may be followed by '%'.
+ */
+static int LightColour_ParseValues(const char * string, float * values, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		char * end;
+
+		values[i] = strtof(string, &end);
+		if (end == string)
+			return -1;
+		string = LightColour_SkipSpace(end);
+		if (*string == '%')
+			string = LightColour_SkipSpace(string + 1);
+		if (*string != (i == count - 1 ? ')' : ','))
+			return -1;
+		string++;
+	}
+	return *LightColour_SkipSpace(string) == '\0' ? 0 : -1;
+}
+
+/* Returns the text after prefix if string starts with it, ignoring case, or NULL */
+static const char * LightColour_MatchPrefix(const char * string, const char * prefix)
+{
+	int length = strlen(prefix);
+
+	return strncasecmp(string, prefix, length) == 0 ? string + length : NULL;
+}
+
+static int LightColour_ParseName(const char * string, LightColour * colour)
+{
+	const int nameCount = sizeof(lightColourNames) / sizeof(lightColourNames[0]);
+	int i;
+
+	for (i = 0; i < nameCount; i++)
+	{
+		const char * name = lightColourNames[i].Name;
+		const char * c = string;
+
+		for (; *c != '\0' && *name != '\0'; c++)
+		{
+			if (*c == ' ')
+				continue;
+			if (tolower((unsigned char)*c) != *name)
+				break;
+			name++;
+		}
+		if (*name != '\0')
+			continue;
+
+		while (isdigit((unsigned char)*c) || isspace((unsigned char)*c))
+			c++;
+		if (*c == '\0')
+		{
+			LightColour_SetRGB(colour, lightColourNames[i].Red, lightColourNames[i].Green,
+				lightColourNames[i].Blue);
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+int LightColour_Parse(const char * string, LightColour * colour)
+{
+	float values[LIGHT_COLOUR_MAX_VALUES];
+	const char * rest;
+	int result = -1;
+
+	string = LightColour_SkipSpace(string);
+
+	if (*string == '#')
+		result = LightColour_ParseHex(string + 1, colour);
+	else if ((rest = LightColour_MatchPrefix(string, "rgb(")) != NULL)
+	{
+		if (LightColour_ParseValues(rest, values, 3) == 0 && values[0] >= 0 && values[0] <= 255 &&
+			values[1] >= 0 && values[1] <= 255 && values[2] >= 0 && values[2] <= 255)
+		{
+			LightColour_SetRGB(colour, (uint8_t)(values[0] + 0.5f), (uint8_t)(values[1] + 0.5f),
+				(uint8_t)(values[2] + 0.5f));
+			result = 0;
+		}
+	}
+	else if ((rest = LightColour_MatchPrefix(string, "hsv(")) != NULL)
+	{
+		if (LightColour_ParseValues(rest, values, 3) == 0 && values[0] >= 0 && values[0] <= 360 &&
+			values[1] >= 0 && values[1] <= 100 && values[2] >= 0 && values[2] <= 100)
+		{
+			LightColour_SetHSV(colour, values[0], values[1] / 100, values[2] / 100);
+			result = 0;
+		}
+	}
+	else if ((rest = LightColour_MatchPrefix(string, "xy(")) != NULL)
+	{
+		if (LightColour_ParseValues(rest, values, 2) == 0 && values[0] >= 0 && values[1] > 0 &&
+			values[0] + values[1] <= 1)
+		{
+			LightColour_SetXY(colour, values[0], values[1]);
+			result = 0;
+		}
+	}
+	else
+		result = LightColour_ParseName(string, colour);
+
+	if (result == -1)
+	{
+		LightColour_SetRGB(colour, 255, 255, 255);
+		colour->Model = LightColourModel_Unknown;
+	}
+	return result;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file
+ * Parses Light Control Colour strings into numeric colours.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_LIGHT_COLOUR_H_
+#define LWM2M_CLIENT_LIGHT_COLOUR_H_
+
+#include <stdint.h>
+
+#define LIGHT_COLOUR_CHANNELS		3
+
+typedef enum
+{
+	LightColourChannel_Red,
+	LightColourChannel_Green,
+	LightColourChannel_Blue,
+} LightColourChannel;
+
+/* The format a Colour string was written in, or Unknown for free-form text */
+typedef enum
+{
+	LightColourModel_Unknown,
+	LightColourModel_RGB,
+	LightColourModel_HSV,
+	LightColourModel_XY,
+} LightColourModel;
+
+/*
+ * A colour in every model at once, worked out when Colour is written. Duty is the linear light
+ * output of each channel at full brightness, 0 to 65535, ready to scale into a PWM compare value.
+ */
+typedef struct
+{
+	LightColourModel Model;
+	uint8_t Red;
+	uint8_t Green;
+	uint8_t Blue;
+	float Hue;					/* degrees, 0 to 360 */
+	float Saturation;			/* 0 to 1 */
+	float Value;				/* 0 to 1 */
+	float X;					/* CIE 1931 chromaticity */
+	float Y;
+	uint16_t Duty[LIGHT_COLOUR_CHANNELS];
+} LightColour;
+
+/*
+ * Parses a Colour string: "#RRGGBB", "#RGB", "rgb(r, g, b)" with channels 0 to 255,
+ * "hsv(h, s, v)" with hue in degrees and saturation and value in percent, "xy(x, y)" as CIE 1931
+ * chromaticity, or a colour name such as "red", "Red2" or "warm white" (any trailing number is
+ * ignored). Returns 0, or -1 if the string is in none of these, in which case colour is white.
+ */
+int LightColour_Parse(const char * string, LightColour * colour);
+
+#endif /* LWM2M_CLIENT_LIGHT_COLOUR_H_ */
@@ -0,0 +1,156 @@
+/**
+ * @file
+ * Converts Light Control Dimmer values to PWM along perceptual dimming curves.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "lwm2m-client-light-dimming.h"
+#include "lwm2m-client-light-tables.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define LIGHT_DIMMING_LANES				8
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LIGHT_DIMMING_AVX2
+#endif
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef uint16_t LightDimmingHalves __attribute__((vector_size(LIGHT_DIMMING_LANES * 2)));
+typedef uint32_t LightDimmingWords __attribute__((vector_size(LIGHT_DIMMING_LANES * 4)));
+
+typedef void (*LightDimmingScale)(uint32_t level, const uint16_t * duties, uint16_t * pwm,
+	int count);
+
+/***************************************************************************************************
+ * Implementation - Private
+ **************************************************************************************************/
+
+/*
+ * pwm = duty * level / 65535, rounded to nearest. (t + 1 + (t >> 16)) >> 16 divides t by 65535
+ * exactly for every product of two 16-bit values, without overflowing 32 bits.
+ */
+static inline __attribute__((always_inline)) void LightDimming_Scale(uint32_t level,
+	const uint16_t * duties, uint16_t * pwm, int count)
+{
+	int i;
+
+	for (i = 0; i + LIGHT_DIMMING_LANES <= count; i += LIGHT_DIMMING_LANES)
+	{
+		LightDimmingHalves halves;
+		LightDimmingWords words;
+
+		memcpy(&halves, duties + i, sizeof(halves));
+		words = __builtin_convertvector(halves, LightDimmingWords);
+		words = words * level + 32767;
+		words = (words + 1 + (words >> 16)) >> 16;
+		halves = __builtin_convertvector(words, LightDimmingHalves);
+		memcpy(pwm + i, &halves, sizeof(halves));
+	}
+	for (; i < count; i++)
+	{
+		uint32_t product = duties[i] * level + 32767;
+
+		pwm[i] = (product + 1 + (product >> 16)) >> 16;
+	}
+}
+
+/* Built for the baseline instruction set, which the compiler lowers to whatever vectors it has */
+static void LightDimming_ScaleGeneric(uint32_t level, const uint16_t * duties, uint16_t * pwm,
+	int count)
+{
+	LightDimming_Scale(level, duties, pwm, count);
+}
+
+#ifdef LIGHT_DIMMING_AVX2
+/* The same with one AVX2 register per 8 channels */
+__attribute__((target("avx2")))
+static void LightDimming_ScaleAvx2(uint32_t level, const uint16_t * duties, uint16_t * pwm,
+	int count)
+{
+	LightDimming_Scale(level, duties, pwm, count);
+}
+#endif
+
+/* Picks the implementation once; racing first callers all pick the same one */
+static LightDimmingScale LightDimming_GetScale(void)
+{
+	static LightDimmingScale scale;
+	LightDimmingScale picked = __atomic_load_n(&scale, __ATOMIC_RELAXED);
+
+	if (picked == NULL)
+	{
+		picked = LightDimming_ScaleGeneric;
+#ifdef LIGHT_DIMMING_AVX2
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			picked = LightDimming_ScaleAvx2;
+#endif
+		__atomic_store_n(&scale, picked, __ATOMIC_RELAXED);
+	}
+	return picked;
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+uint16_t LightDimming_ToPwm(LightDimmingCurve curve, LightDimmingResolution resolution,
+	int64_t dimmer)
+{
+	int level = dimmer < 0 ? 0 : dimmer > 100 ? 100 : (int)dimmer;
+
+	if ((unsigned)curve >= LightDimmingCurve_Count)
+		curve = LightDimmingCurve_Linear;
+	return resolution == LightDimmingResolution_12Bit ? lightDimming12[curve][level] :
+		lightDimming16[curve][level];
+}
+
+void LightDimming_ScaleChannels(LightDimmingCurve curve, LightDimmingResolution resolution,
+	int64_t dimmer, const uint16_t * duties, uint16_t * pwm, int count)
+{
+	uint32_t level = LightDimming_ToPwm(curve, resolution, dimmer);
+
+	if (count > 0)
+		LightDimming_GetScale()(level, duties, pwm, count);
+}
@@ -0,0 +1,68 @@
+/**
+ * @file
+ * Converts Light Control Dimmer values to PWM along perceptual dimming curves.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_LIGHT_DIMMING_H_
+#define LWM2M_CLIENT_LIGHT_DIMMING_H_
+
+#include <stdint.h>
+
+/* How Dimmer percentages map to light output */
+typedef enum
+{
+	LightDimmingCurve_Linear,
+	LightDimmingCurve_Gamma22,				/* output = (dimmer / 100) ^ 2.2 */
+	LightDimmingCurve_CieLightness,			/* dimmer is CIE 1931 lightness (L*) */
+	LightDimmingCurve_Count
+} LightDimmingCurve;
+
+typedef enum
+{
+	LightDimmingResolution_16Bit,
+	LightDimmingResolution_12Bit,
+} LightDimmingResolution;
+
+/* Returns the PWM value for a Dimmer percentage, clamped to 0 to 100, from a lookup table */
+uint16_t LightDimming_ToPwm(LightDimmingCurve curve, LightDimmingResolution resolution,
+	int64_t dimmer);
+
+/*
+ * Converts count channels at once, for example every LED of a strip. duties are each channel's
+ * linear output at full brightness, 0 to 65535, such as a LightColour's Duty; pwm gets them
+ * dimmed to dimmer along curve. Runs 8 channels per step, with AVX2 when the CPU supports it.
+ */
+void LightDimming_ScaleChannels(LightDimmingCurve curve, LightDimmingResolution resolution,
+	int64_t dimmer, const uint16_t * duties, uint16_t * pwm, int count);
+
+#endif /* LWM2M_CLIENT_LIGHT_DIMMING_H_ */
@@ -0,0 +1,319 @@
+/**
+ * @file
+ * Worker thread that runs Light Control driver callbacks off the LWM2M thread.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "lwm2m_core.h"
+#include "lwm2m-client-light-dispatch.h"
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef struct
+{
+	Lwm2mContextType * Context;
+	ObjectInstanceIDType ObjectInstanceID;
+	LightControlCallBack Callback;
+	LightControlOutputCallBack OutputCallback;
+	void * CallbackContext;
+	bool OnOff;
+	unsigned char Dimmer;
+	char Colour[LIGHT_DISPATCH_MAX_COLOUR_SIZE];
+	LightControlOutput Output;
+} LightDispatchEntry;
+
+/*
+ * Waiting updates sit in a ring, oldest first. The ring is small, so finding the update to merge
+ * with is a scan of it under the lock.
+ */
+struct _LightDispatcher
+{
+	pthread_mutex_t Lock;
+	pthread_cond_t Pending;
+	pthread_cond_t Idle;
+	pthread_t Worker;
+	LightDispatchEntry * Entries;
+	int Depth;
+	int Head;
+	int Count;
+	bool Busy;
+	bool Stopping;
+	LightDispatchOverflow Overflow;
+	LightDispatchCompletion Completion;
+	void * CompletionContext;
+	LightDispatchStats Stats;
+};
+
+/***************************************************************************************************
+ * Implementation - Private
+ **************************************************************************************************/
+
+static void * LightDispatcher_Run(void * argument)
+{
+	LightDispatcher * dispatcher = argument;
+	LightDispatchEntry entry;
+
+	pthread_mutex_lock(&dispatcher->Lock);
+	for (;;)
+	{
+		while (dispatcher->Count == 0 && !dispatcher->Stopping)
+			pthread_cond_wait(&dispatcher->Pending, &dispatcher->Lock);
+		if (dispatcher->Count == 0)
+			break;
+
+		entry = dispatcher->Entries[dispatcher->Head];
+		dispatcher->Head = (dispatcher->Head + 1) % dispatcher->Depth;
+		dispatcher->Count--;
+		dispatcher->Busy = true;
+		pthread_mutex_unlock(&dispatcher->Lock);
+
+		if (entry.OutputCallback != NULL)
+			entry.OutputCallback(entry.CallbackContext, &entry.Output);
+		else
+			entry.Callback(entry.CallbackContext, entry.OnOff, entry.Dimmer, entry.Colour);
+		if (dispatcher->Completion != NULL)
+		{
+			dispatcher->Completion(dispatcher->CompletionContext, entry.Context,
+				entry.ObjectInstanceID, entry.OnOff, entry.Dimmer, entry.Colour);
+		}
+
+		pthread_mutex_lock(&dispatcher->Lock);
+		dispatcher->Busy = false;
+		dispatcher->Stats.Delivered++;
+		if (dispatcher->Count == 0)
+			pthread_cond_broadcast(&dispatcher->Idle);
+	}
+	pthread_mutex_unlock(&dispatcher->Lock);
+	return NULL;
+}
+
+static LightDispatchEntry * LightDispatcher_FindWaiting(LightDispatcher * dispatcher,
+	Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID)
+{
+	int i;
+
+	for (i = 0; i < dispatcher->Count; i++)
+	{
+		LightDispatchEntry * entry =
+			&dispatcher->Entries[(dispatcher->Head + i) % dispatcher->Depth];
+
+		if (entry->Context == context && entry->ObjectInstanceID == objectInstanceID)
+			return entry;
+	}
+	return NULL;
+}
+
+/*
+ * Returns the entry to fill in for an instance with the lock held, merging with one still
+ * waiting, or NULL with the lock released when the update is dropped.
+ */
+static LightDispatchEntry * LightDispatcher_Claim(LightDispatcher * dispatcher,
+	Lwm2mContextType * context, ObjectInstanceIDType objectInstanceID)
+{
+	LightDispatchEntry * entry;
+
+	pthread_mutex_lock(&dispatcher->Lock);
+	dispatcher->Stats.Submitted++;
+
+	if ((entry = LightDispatcher_FindWaiting(dispatcher, context, objectInstanceID)) != NULL)
+	{
+		dispatcher->Stats.Coalesced++;
+		return entry;
+	}
+
+	if (dispatcher->Count == dispatcher->Depth)
+	{
+		dispatcher->Stats.Dropped++;
+		if (dispatcher->Overflow == LightDispatchOverflow_DropNewest)
+		{
+			pthread_mutex_unlock(&dispatcher->Lock);
+			return NULL;
+		}
+		dispatcher->Head = (dispatcher->Head + 1) % dispatcher->Depth;
+		dispatcher->Count--;
+	}
+
+	entry = &dispatcher->Entries[(dispatcher->Head + dispatcher->Count) % dispatcher->Depth];
+	entry->Context = context;
+	entry->ObjectInstanceID = objectInstanceID;
+	dispatcher->Count++;
+	if (dispatcher->Count > dispatcher->Stats.MaxDepth)
+		dispatcher->Stats.MaxDepth = dispatcher->Count;
+	pthread_cond_signal(&dispatcher->Pending);
+	return entry;
+}
+
+static void LightDispatcher_SetColour(LightDispatchEntry * entry, const char * colour)
+{
+	strncpy(entry->Colour, colour != NULL ? colour : "", sizeof(entry->Colour) - 1);
+	entry->Colour[sizeof(entry->Colour) - 1] = '\0';
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+LightDispatcher * LightDispatcher_Create(int depth, LightDispatchOverflow overflow,
+	LightDispatchCompletion completion, void * completionContext)
+{
+	LightDispatcher * dispatcher;
+
+	if (depth < 1)
+	{
+		Lwm2m_Error("Invalid Light Control dispatch depth %d\n", depth);
+		return NULL;
+	}
+
+	dispatcher = calloc(1, sizeof(LightDispatcher));
+	if (dispatcher == NULL || (dispatcher->Entries = malloc(depth * sizeof(LightDispatchEntry)))
+		== NULL)
+	{
+		Lwm2m_Error("Out of memory for Light Control dispatch\n");
+		free(dispatcher);
+		return NULL;
+	}
+
+	dispatcher->Depth = depth;
+	dispatcher->Overflow = overflow;
+	dispatcher->Completion = completion;
+	dispatcher->CompletionContext = completionContext;
+	pthread_mutex_init(&dispatcher->Lock, NULL);
+	pthread_cond_init(&dispatcher->Pending, NULL);
+	pthread_cond_init(&dispatcher->Idle, NULL);
+
+	if (pthread_create(&dispatcher->Worker, NULL, LightDispatcher_Run, dispatcher) != 0)
+	{
+		Lwm2m_Error("Failed to start Light Control dispatch thread\n");
+		pthread_cond_destroy(&dispatcher->Idle);
+		pthread_cond_destroy(&dispatcher->Pending);
+		pthread_mutex_destroy(&dispatcher->Lock);
+		free(dispatcher->Entries);
+		free(dispatcher);
+		return NULL;
+	}
+	return dispatcher;
+}
+
+void LightDispatcher_Destroy(LightDispatcher * dispatcher)
+{
+	if (dispatcher == NULL)
+		return;
+
+	pthread_mutex_lock(&dispatcher->Lock);
+	dispatcher->Stopping = true;
+	pthread_cond_signal(&dispatcher->Pending);
+	pthread_mutex_unlock(&dispatcher->Lock);
+	pthread_join(dispatcher->Worker, NULL);
+
+	pthread_cond_destroy(&dispatcher->Idle);
+	pthread_cond_destroy(&dispatcher->Pending);
+	pthread_mutex_destroy(&dispatcher->Lock);
+	free(dispatcher->Entries);
+	free(dispatcher);
+}
+
+int LightDispatcher_Submit(LightDispatcher * dispatcher, Lwm2mContextType * context,
+	ObjectInstanceIDType objectInstanceID, LightControlCallBack callback, void * callbackContext,
+	bool onOff, unsigned char dimmer, const char * colour)
+{
+	LightDispatchEntry * entry;
+
+	if (dispatcher == NULL || callback == NULL ||
+		(entry = LightDispatcher_Claim(dispatcher, context, objectInstanceID)) == NULL)
+	{
+		return -1;
+	}
+
+	/* The latest callback wins too, in case the instance was deleted and added again */
+	entry->Callback = callback;
+	entry->OutputCallback = NULL;
+	entry->CallbackContext = callbackContext;
+	entry->OnOff = onOff;
+	entry->Dimmer = dimmer;
+	LightDispatcher_SetColour(entry, colour);
+
+	pthread_mutex_unlock(&dispatcher->Lock);
+	return 0;
+}
+
+int LightDispatcher_SubmitOutput(LightDispatcher * dispatcher, Lwm2mContextType * context,
+	ObjectInstanceIDType objectInstanceID, LightControlOutputCallBack callback,
+	void * callbackContext, const LightControlOutput * output, const char * colour)
+{
+	LightDispatchEntry * entry;
+
+	if (dispatcher == NULL || callback == NULL ||
+		(entry = LightDispatcher_Claim(dispatcher, context, objectInstanceID)) == NULL)
+	{
+		return -1;
+	}
+
+	entry->Callback = NULL;
+	entry->OutputCallback = callback;
+	entry->CallbackContext = callbackContext;
+	entry->OnOff = output->OnOff;
+	entry->Dimmer = output->Dimmer;
+	entry->Output = *output;
+	LightDispatcher_SetColour(entry, colour);
+
+	pthread_mutex_unlock(&dispatcher->Lock);
+	return 0;
+}
+
+void LightDispatcher_Flush(LightDispatcher * dispatcher)
+{
+	if (dispatcher == NULL)
+		return;
+
+	pthread_mutex_lock(&dispatcher->Lock);
+	while (dispatcher->Count > 0 || dispatcher->Busy)
+		pthread_cond_wait(&dispatcher->Idle, &dispatcher->Lock);
+	pthread_mutex_unlock(&dispatcher->Lock);
+}
+
+void LightDispatcher_GetStats(LightDispatcher * dispatcher, LightDispatchStats * stats)
+{
+	pthread_mutex_lock(&dispatcher->Lock);
+	*stats = dispatcher->Stats;
+	pthread_mutex_unlock(&dispatcher->Lock);
+}
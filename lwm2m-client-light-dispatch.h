@@ -0,0 +1,96 @@
+/**
+ * @file
+ * Worker thread that runs Light Control driver callbacks off the LWM2M thread.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_LIGHT_DISPATCH_H_
+#define LWM2M_CLIENT_LIGHT_DISPATCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwm2m_core.h"
+#include "lwm2m-client-ipso-light-control.h"
+
+#define LIGHT_DISPATCH_MAX_COLOUR_SIZE		64
+
+typedef enum
+{
+	LightDispatchOverflow_DropOldest,
+	LightDispatchOverflow_DropNewest,
+} LightDispatchOverflow;
+
+/*
+ * Called on the worker thread once the driver callback has returned, with the state it was given.
+ * Use it to read back what the hardware actually did, and hand that to LightControl_ReportState()
+ * when it differs, so the instance shows the light's real state rather than the requested one.
+ */
+typedef void (*LightDispatchCompletion)(void * completionContext, Lwm2mContextType * context,
+	ObjectInstanceIDType objectInstanceID, bool onOff, unsigned char dimmer, const char * colour);
+
+typedef struct
+{
+	uint64_t Submitted;
+	uint64_t Coalesced;
+	uint64_t Dropped;
+	uint64_t Delivered;
+	int MaxDepth;
+} LightDispatchStats;
+
+/*
+ * Hands Light Control callbacks to a worker thread, so a driver on a slow bus (I2C, DALI) does not
+ * stall the LWM2M processing loop. Updates to an instance that is still waiting are merged, so the
+ * driver only sees its latest state. The queue holds at most depth instances; when it is full a
+ * new instance either pushes out the oldest waiting update or is dropped itself.
+ */
+LightDispatcher * LightDispatcher_Create(int depth, LightDispatchOverflow overflow,
+	LightDispatchCompletion completion, void * completionContext);
+
+/* Delivers what is still queued, then stops the worker */
+void LightDispatcher_Destroy(LightDispatcher * dispatcher);
+
+/* Queues one callback invocation, merging it with one already waiting for the same instance */
+int LightDispatcher_Submit(LightDispatcher * dispatcher, Lwm2mContextType * context,
+	ObjectInstanceIDType objectInstanceID, LightControlCallBack callback, void * callbackContext,
+	bool onOff, unsigned char dimmer, const char * colour);
+
+/* The same for an instance with an output callback; colour is still passed to the completion */
+int LightDispatcher_SubmitOutput(LightDispatcher * dispatcher, Lwm2mContextType * context,
+	ObjectInstanceIDType objectInstanceID, LightControlOutputCallBack callback,
+	void * callbackContext, const LightControlOutput * output, const char * colour);
+
+/* Waits until everything submitted so far has been delivered */
+void LightDispatcher_Flush(LightDispatcher * dispatcher);
+
+void LightDispatcher_GetStats(LightDispatcher * dispatcher, LightDispatchStats * stats);
+
+#endif /* LWM2M_CLIENT_LIGHT_DISPATCH_H_ */
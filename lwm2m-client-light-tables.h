@@ -0,0 +1,145 @@
+/* Generated by tools/lwm2m-client-light-tables.c; do not edit */
+
+#ifndef LWM2M_CLIENT_LIGHT_TABLES_H_
+#define LWM2M_CLIENT_LIGHT_TABLES_H_
+
+#include <stdint.h>
+
+/* Linear light, 0 to 65535, of each 8-bit sRGB channel value */
+static const uint16_t lightSrgbToLinear[256] =
+{
+	    0,    20,    40,    60,    80,    99,   119,   139,
+	  159,   179,   199,   219,   241,   264,   288,   313,
+	  340,   367,   396,   427,   458,   491,   526,   562,
+	  599,   637,   677,   718,   761,   805,   851,   898,
+	  947,   997,  1048,  1101,  1156,  1212,  1270,  1330,
+	 1391,  1453,  1517,  1583,  1651,  1720,  1790,  1863,
+	 1937,  2013,  2090,  2170,  2250,  2333,  2418,  2504,
+	 2592,  2681,  2773,  2866,  2961,  3058,  3157,  3258,
+	 3360,  3464,  3570,  3678,  3788,  3900,  4014,  4129,
+	 4247,  4366,  4488,  4611,  4736,  4864,  4993,  5124,
+	 5257,  5392,  5530,  5669,  5810,  5953,  6099,  6246,
+	 6395,  6547,  6700,  6856,  7014,  7174,  7335,  7500,
+	 7666,  7834,  8004,  8177,  8352,  8528,  8708,  8889,
+	 9072,  9258,  9445,  9635,  9828, 10022, 10219, 10417,
+	10619, 10822, 11028, 11235, 11446, 11658, 11873, 12090,
+	12309, 12530, 12754, 12980, 13209, 13440, 13673, 13909,
+	14146, 14387, 14629, 14874, 15122, 15371, 15623, 15878,
+	16135, 16394, 16656, 16920, 17187, 17456, 17727, 18001,
+	18277, 18556, 18837, 19121, 19407, 19696, 19987, 20281,
+	20577, 20876, 21177, 21481, 21787, 22096, 22407, 22721,
+	23038, 23357, 23678, 24002, 24329, 24658, 24990, 25325,
+	25662, 26001, 26344, 26688, 27036, 27386, 27739, 28094,
+	28452, 28813, 29176, 29542, 29911, 30282, 30656, 31033,
+	31412, 31794, 32179, 32567, 32957, 33350, 33745, 34143,
+	34544, 34948, 35355, 35764, 36176, 36591, 37008, 37429,
+	37852, 38278, 38706, 39138, 39572, 40009, 40449, 40891,
+	41337, 41785, 42236, 42690, 43147, 43606, 44069, 44534,
+	45002, 45473, 45947, 46423, 46903, 47385, 47871, 48359,
+	48850, 49344, 49841, 50341, 50844, 51349, 51858, 52369,
+	52884, 53401, 53921, 54445, 54971, 55500, 56032, 56567,
+	57105, 57646, 58190, 58737, 59287, 59840, 60396, 60955,
+	61517, 62082, 62650, 63221, 63795, 64372, 64952, 65535,
+};
+
+/* PWM values at 12 bits for each Dimmer, by LightDimmingCurve */
+static const uint16_t lightDimming12[3][101] =
+{
+	{
+		    0,    41,    82,   123,   164,   205,   246,   287,
+		  328,   369,   410,   450,   491,   532,   573,   614,
+		  655,   696,   737,   778,   819,   860,   901,   942,
+		  983,  1024,  1065,  1106,  1147,  1188,  1229,  1269,
+		 1310,  1351,  1392,  1433,  1474,  1515,  1556,  1597,
+		 1638,  1679,  1720,  1761,  1802,  1843,  1884,  1925,
+		 1966,  2007,  2048,  2088,  2129,  2170,  2211,  2252,
+		 2293,  2334,  2375,  2416,  2457,  2498,  2539,  2580,
+		 2621,  2662,  2703,  2744,  2785,  2826,  2867,  2907,
+		 2948,  2989,  3030,  3071,  3112,  3153,  3194,  3235,
+		 3276,  3317,  3358,  3399,  3440,  3481,  3522,  3563,
+		 3604,  3645,  3686,  3726,  3767,  3808,  3849,  3890,
+		 3931,  3972,  4013,  4054,  4095,
+	},
+	{
+		    0,     0,     1,     2,     3,     6,     8,    12,
+		   16,    20,    26,    32,    39,    46,    54,    63,
+		   73,    83,    94,   106,   119,   132,   146,   161,
+		  177,   194,   211,   230,   249,   269,   290,   311,
+		  334,   357,   382,   407,   433,   460,   487,   516,
+		  545,   576,   607,   640,   673,   707,   742,   778,
+		  815,   852,   891,   931,   972,  1013,  1056,  1099,
+		 1144,  1189,  1235,  1283,  1331,  1380,  1431,  1482,
+		 1534,  1587,  1642,  1697,  1753,  1810,  1868,  1928,
+		 1988,  2049,  2111,  2175,  2239,  2304,  2371,  2438,
+		 2506,  2576,  2646,  2718,  2790,  2864,  2939,  3014,
+		 3091,  3169,  3248,  3328,  3409,  3491,  3574,  3658,
+		 3743,  3830,  3917,  4005,  4095,
+	},
+	{
+		    0,     5,     9,    14,    18,    23,    27,    32,
+		   36,    41,    46,    52,    58,    64,    71,    78,
+		   86,    94,   103,   112,   122,   133,   144,   156,
+		  168,   181,   194,   209,   223,   239,   255,   272,
+		  290,   309,   328,   348,   369,   391,   413,   436,
+		  461,   486,   512,   539,   567,   595,   625,   656,
+		  688,   720,   754,   789,   825,   862,   900,   939,
+		  979,  1021,  1063,  1107,  1152,  1198,  1245,  1293,
+		 1343,  1394,  1447,  1500,  1555,  1611,  1669,  1728,
+		 1788,  1849,  1913,  1977,  2043,  2110,  2179,  2249,
+		 2321,  2394,  2469,  2546,  2623,  2703,  2784,  2867,
+		 2951,  3037,  3125,  3214,  3305,  3397,  3492,  3588,
+		 3686,  3785,  3887,  3990,  4095,
+	},
+};
+
+/* PWM values at 16 bits for each Dimmer, by LightDimmingCurve */
+static const uint16_t lightDimming16[3][101] =
+{
+	{
+		    0,   655,  1311,  1966,  2621,  3277,  3932,  4587,
+		 5243,  5898,  6554,  7209,  7864,  8520,  9175,  9830,
+		10486, 11141, 11796, 12452, 13107, 13762, 14418, 15073,
+		15728, 16384, 17039, 17694, 18350, 19005, 19661, 20316,
+		20971, 21627, 22282, 22937, 23593, 24248, 24903, 25559,
+		26214, 26869, 27525, 28180, 28835, 29491, 30146, 30801,
+		31457, 32112, 32768, 33423, 34078, 34734, 35389, 36044,
+		36700, 37355, 38010, 38666, 39321, 39976, 40632, 41287,
+		41942, 42598, 43253, 43908, 44564, 45219, 45875, 46530,
+		47185, 47841, 48496, 49151, 49807, 50462, 51117, 51773,
+		52428, 53083, 53739, 54394, 55049, 55705, 56360, 57015,
+		57671, 58326, 58982, 59637, 60292, 60948, 61603, 62258,
+		62914, 63569, 64224, 64880, 65535,
+	},
+	{
+		    0,     3,    12,    29,    55,    90,   134,   189,
+		  253,   328,   413,   510,   618,   736,   867,  1009,
+		 1163,  1329,  1507,  1697,  1900,  2115,  2343,  2584,
+		 2838,  3104,  3384,  3677,  3983,  4303,  4636,  4983,
+		 5343,  5717,  6106,  6508,  6924,  7354,  7798,  8257,
+		 8730,  9217,  9719, 10235, 10766, 11312, 11872, 12448,
+		13038, 13643, 14263, 14898, 15548, 16214, 16894, 17590,
+		18302, 19028, 19770, 20528, 21301, 22090, 22895, 23715,
+		24551, 25403, 26271, 27154, 28054, 28970, 29901, 30849,
+		31813, 32793, 33790, 34802, 35831, 36877, 37939, 39017,
+		40112, 41223, 42351, 43496, 44657, 45835, 47029, 48241,
+		49469, 50714, 51976, 53255, 54551, 55864, 57195, 58542,
+		59906, 61287, 62686, 64102, 65535,
+	},
+	{
+		    0,    73,   145,   218,   290,   363,   435,   508,
+		  580,   656,   738,   826,   922,  1024,  1134,  1251,
+		 1376,  1509,  1650,  1800,  1959,  2127,  2304,  2491,
+		 2687,  2894,  3111,  3338,  3576,  3826,  4087,  4359,
+		 4643,  4940,  5248,  5569,  5903,  6251,  6611,  6985,
+		 7373,  7775,  8192,  8623,  9069,  9530, 10006, 10498,
+		11006, 11530, 12071, 12628, 13202, 13793, 14401, 15027,
+		15671, 16333, 17014, 17713, 18431, 19168, 19924, 20700,
+		21497, 22313, 23149, 24007, 24885, 25784, 26705, 27648,
+		28612, 29598, 30607, 31639, 32694, 33771, 34872, 35997,
+		37146, 38319, 39516, 40738, 41986, 43258, 44555, 45879,
+		47228, 48603, 50005, 51434, 52890, 54372, 55883, 57421,
+		58987, 60581, 62203, 63855, 65535,
+	},
+};
+
+#endif /* LWM2M_CLIENT_LIGHT_TABLES_H_ */
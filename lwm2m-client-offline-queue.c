@@ -0,0 +1,520 @@
+/**
+ * @file
+ * Bounded store-and-forward queue for changes made while offline.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "lwm2m_core.h"
+#include "lwm2m-client-offline-queue.h"
+#include "lwm2m-client-state.h"
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+/* Object, instance and resource IDs are 16 bits in LWM2M, so they pack into one key */
+typedef struct
+{
+	uint64_t Key;
+	bool Used;
+	bool Pending;
+	OfflineChangeKind Kind;
+	int64_t Value;
+	int64_t TimeMs;
+	/* Bumped on every change, so a drain can tell whether one arrived while it was sending */
+	uint32_t Sequence;
+} OfflineResource;
+
+typedef struct
+{
+	uint64_t Key;
+	int64_t Value;
+	int64_t TimeMs;
+} OfflineTransition;
+
+/*
+ * Where each change of the batch being sent came from, to remove it once the sink succeeds.
+ * Resources are found again by key, as committing one may move others to other buckets.
+ */
+typedef struct
+{
+	uint64_t Key;
+	uint32_t Sequence;
+	bool Transition;
+} OfflineSource;
+
+/*
+ * Latest values, counter sums and folded transitions live in a fixed open-addressing table sized
+ * for MaxResources at most half full. An entry is freed once its change has been sent, so
+ * MaxResources limits the resources with changes queued, not the resources ever seen.
+ * Transitions live in a ring; RingStart counts the transitions that have ever left it, so a drain
+ * can tell which of those it sent are still there.
+ */
+typedef struct
+{
+	pthread_mutex_t Lock;
+	bool Recording;
+	bool Enabled;
+	bool Online;
+	OfflineQueueConfig Config;
+	OfflineResource * Resources;
+	int BucketCount;
+	int ResourceCount;
+	int PendingResources;
+	OfflineTransition * Ring;
+	int RingHead;
+	int RingCount;
+	uint64_t RingStart;
+	OfflineChange * Batch;
+	OfflineSource * Sources;
+	double Tokens;
+	int64_t LastRefillMs;
+	OfflineQueueStats Stats;
+} OfflineQueueState;
+
+/***************************************************************************************************
+ * Prototypes
+ **************************************************************************************************/
+
+static void OfflineQueue_InitialiseState(void * state);
+static void OfflineQueue_CleanupState(void * state);
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+static const ClientStateDefinition offlineQueueStateDefinition =
+{
+	.Slot = ClientStateSlot_OfflineQueue,
+	.Size = sizeof(OfflineQueueState),
+	.Initialise = OfflineQueue_InitialiseState,
+	.Cleanup = OfflineQueue_CleanupState,
+};
+
+/***************************************************************************************************
+ * Implementation - Private
+ **************************************************************************************************/
+
+static void OfflineQueue_InitialiseState(void * state)
+{
+	pthread_mutex_init(&((OfflineQueueState *)state)->Lock, NULL);
+}
+
+static void OfflineQueue_FreeQueue(OfflineQueueState * queue)
+{
+	free(queue->Resources);
+	free(queue->Ring);
+	free(queue->Batch);
+	free(queue->Sources);
+	queue->Resources = NULL;
+	queue->Ring = NULL;
+	queue->Batch = NULL;
+	queue->Sources = NULL;
+}
+
+static void OfflineQueue_CleanupState(void * state)
+{
+	OfflineQueueState * queue = state;
+
+	OfflineQueue_FreeQueue(queue);
+	pthread_mutex_destroy(&queue->Lock);
+}
+
+/* Called with the lock held whenever what is queued or the connection changes */
+static void OfflineQueue_UpdateRecording(OfflineQueueState * queue)
+{
+	queue->Stats.Pending = queue->PendingResources + queue->RingCount;
+	__atomic_store_n(&queue->Recording, queue->Enabled && (!queue->Online ||
+		queue->Stats.Pending > 0), __ATOMIC_RELEASE);
+}
+
+static uint64_t OfflineQueue_MakeKey(ObjectIDType objectID, ObjectInstanceIDType objectInstanceID,
+	ResourceIDType resourceID)
+{
+	return ((uint64_t)(uint16_t)objectID << 32) | ((uint64_t)(uint16_t)objectInstanceID << 16) |
+		(uint16_t)resourceID;
+}
+
+static int OfflineQueue_Hash(OfflineQueueState * queue, uint64_t key)
+{
+	return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (queue->BucketCount - 1);
+}
+
+/* Returns the bucket holding the resource, or the free bucket where it would go */
+static int OfflineQueue_FindBucket(OfflineQueueState * queue, uint64_t key)
+{
+	int bucket = OfflineQueue_Hash(queue, key);
+
+	while (queue->Resources[bucket].Used && queue->Resources[bucket].Key != key)
+		bucket = (bucket + 1) & (queue->BucketCount - 1);
+	return bucket;
+}
+
+/* Returns the resource's entry, adding it if there is room, or -1 */
+static int OfflineQueue_FindResource(OfflineQueueState * queue, uint64_t key,
+	OfflineChangeKind kind)
+{
+	int bucket = OfflineQueue_FindBucket(queue, key);
+
+	if (!queue->Resources[bucket].Used)
+	{
+		if (queue->ResourceCount == queue->Config.MaxResources)
+			return -1;
+		queue->Resources[bucket].Used = true;
+		queue->Resources[bucket].Key = key;
+		queue->Resources[bucket].Kind = kind;
+		queue->ResourceCount++;
+	}
+	return bucket;
+}
+
+/*
+ * Frees an entry with backward-shift deletion: each entry after it in the probe run moves back
+ * into the hole unless that would put it before its home bucket, so lookups need no tombstones.
+ */
+static void OfflineQueue_RemoveResource(OfflineQueueState * queue, int bucket)
+{
+	int mask = queue->BucketCount - 1;
+	int next, home;
+
+	for (next = (bucket + 1) & mask; queue->Resources[next].Used; next = (next + 1) & mask)
+	{
+		home = OfflineQueue_Hash(queue, queue->Resources[next].Key);
+		if (((next - home) & mask) >= ((next - bucket) & mask))
+		{
+			queue->Resources[bucket] = queue->Resources[next];
+			bucket = next;
+		}
+	}
+	memset(&queue->Resources[bucket], 0, sizeof(OfflineResource));
+	queue->ResourceCount--;
+}
+
+/*
+ * Merges a change into the resource's entry. Returns 1 if it merged with a queued change, 0 if
+ * nothing was queued for the resource, or -1 if there is no room for it.
+ */
+static int OfflineQueue_Fold(OfflineQueueState * queue, uint64_t key, OfflineChangeKind kind,
+	int64_t value, int64_t timeMs)
+{
+	int bucket = OfflineQueue_FindResource(queue, key, kind);
+	OfflineResource * resource;
+	int merged = 0;
+
+	if (bucket == -1)
+		return -1;
+	resource = &queue->Resources[bucket];
+
+	if (resource->Pending)
+		merged = 1;
+	else
+	{
+		resource->Pending = true;
+		resource->Value = 0;
+		queue->PendingResources++;
+	}
+
+	resource->Value = kind == OfflineChangeKind_Counter ? resource->Value + value : value;
+	resource->TimeMs = timeMs;
+	resource->Sequence++;
+	return merged;
+}
+
+static void OfflineQueue_PushTransition(OfflineQueueState * queue, uint64_t key, int64_t value,
+	int64_t timeMs)
+{
+	OfflineTransition * transition;
+
+	/* Out of budget: the oldest transition becomes its resource's latest known value */
+	if (queue->RingCount == queue->Config.TransitionBudget)
+	{
+		transition = &queue->Ring[queue->RingHead];
+		if (OfflineQueue_Fold(queue, transition->Key, OfflineChangeKind_Transition,
+			transition->Value, transition->TimeMs) == -1)
+		{
+			queue->Stats.Dropped++;
+		}
+		else
+			queue->Stats.Compacted++;
+		queue->RingHead = (queue->RingHead + 1) % queue->Config.TransitionBudget;
+		queue->RingCount--;
+		queue->RingStart++;
+	}
+
+	transition = &queue->Ring[(queue->RingHead + queue->RingCount) %
+		queue->Config.TransitionBudget];
+	transition->Key = key;
+	transition->Value = value;
+	transition->TimeMs = timeMs;
+	queue->RingCount++;
+}
+
+static void OfflineQueue_SetChange(OfflineChange * change, uint64_t key, OfflineChangeKind kind,
+	int64_t value, int64_t timeMs)
+{
+	change->ObjectID = (uint16_t)(key >> 32);
+	change->ObjectInstanceID = (uint16_t)(key >> 16);
+	change->ResourceID = (uint16_t)key;
+	change->Kind = kind;
+	change->Value = value;
+	change->TimeMs = timeMs;
+}
+
+/* Copies up to count changes into the batch, compacted values first. Called with the lock held. */
+static int OfflineQueue_CollectBatch(OfflineQueueState * queue, int count, int * transitions)
+{
+	int collected = 0;
+	int i;
+
+	for (i = 0; i < queue->BucketCount && collected < count; i++)
+	{
+		const OfflineResource * resource = &queue->Resources[i];
+
+		if (resource->Pending)
+		{
+			OfflineQueue_SetChange(&queue->Batch[collected], resource->Key, resource->Kind,
+				resource->Value, resource->TimeMs);
+			queue->Sources[collected].Key = resource->Key;
+			queue->Sources[collected].Sequence = resource->Sequence;
+			queue->Sources[collected].Transition = false;
+			collected++;
+		}
+	}
+
+	for (i = 0; i < queue->RingCount && collected < count; i++)
+	{
+		const OfflineTransition * transition =
+			&queue->Ring[(queue->RingHead + i) % queue->Config.TransitionBudget];
+
+		OfflineQueue_SetChange(&queue->Batch[collected], transition->Key,
+			OfflineChangeKind_Transition, transition->Value, transition->TimeMs);
+		queue->Sources[collected].Transition = true;
+		collected++;
+	}
+
+	*transitions = i;
+	return collected;
+}
+
+/*
+ * Removes what the sink sent and frees the entries left with nothing queued. Changes that arrived
+ * meanwhile stay queued: a counter keeps the increments it has had since, and transitions folded
+ * away during the send are already gone.
+ */
+static void OfflineQueue_CommitBatch(OfflineQueueState * queue, int count, uint64_t ringStart,
+	int transitions)
+{
+	uint64_t sentEnd = ringStart + transitions;
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		const OfflineSource * source = &queue->Sources[i];
+		OfflineResource * resource;
+		int bucket;
+
+		if (source->Transition)
+			continue;
+
+		bucket = OfflineQueue_FindBucket(queue, source->Key);
+		resource = &queue->Resources[bucket];
+		if (!resource->Used)
+			continue;
+
+		if (resource->Kind == OfflineChangeKind_Counter)
+			resource->Value -= queue->Batch[i].Value;
+		if (resource->Pending && resource->Sequence == source->Sequence)
+		{
+			resource->Pending = false;
+			queue->PendingResources--;
+		}
+		if (!resource->Pending)
+			OfflineQueue_RemoveResource(queue, bucket);
+	}
+
+	while (queue->RingCount > 0 && queue->RingStart < sentEnd)
+	{
+		queue->RingHead = (queue->RingHead + 1) % queue->Config.TransitionBudget;
+		queue->RingCount--;
+		queue->RingStart++;
+	}
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+int OfflineQueue_Enable(Lwm2mContextType * context, const OfflineQueueConfig * config)
+{
+	OfflineQueueState * queue = ClientState_Get(context, &offlineQueueStateDefinition);
+	int bucketCount = 1;
+
+	if (queue == NULL || config->MaxResources < 1 || config->TransitionBudget < 1 ||
+		config->DrainBatchSize < 1 || config->DrainRatePerSecond < 1)
+	{
+		Lwm2m_Error("Invalid offline queue config\n");
+		return -1;
+	}
+
+	while (bucketCount < 2 * config->MaxResources)
+		bucketCount *= 2;
+
+	pthread_mutex_lock(&queue->Lock);
+	OfflineQueue_FreeQueue(queue);
+	memset(&queue->Stats, 0, sizeof(queue->Stats));
+	queue->Config = *config;
+	queue->BucketCount = bucketCount;
+	queue->ResourceCount = queue->PendingResources = 0;
+	queue->RingHead = queue->RingCount = 0;
+	queue->Tokens = 0;
+	queue->LastRefillMs = 0;
+	queue->Resources = calloc(bucketCount, sizeof(OfflineResource));
+	queue->Ring = malloc(config->TransitionBudget * sizeof(OfflineTransition));
+	queue->Batch = malloc(config->DrainBatchSize * sizeof(OfflineChange));
+	queue->Sources = malloc(config->DrainBatchSize * sizeof(OfflineSource));
+	queue->Enabled = queue->Resources != NULL && queue->Ring != NULL && queue->Batch != NULL &&
+		queue->Sources != NULL;
+	if (!queue->Enabled)
+		OfflineQueue_FreeQueue(queue);
+	OfflineQueue_UpdateRecording(queue);
+	pthread_mutex_unlock(&queue->Lock);
+
+	if (!queue->Enabled)
+	{
+		Lwm2m_Error("Out of memory for offline queue\n");
+		return -1;
+	}
+	return 0;
+}
+
+void OfflineQueue_SetOnline(Lwm2mContextType * context, bool online)
+{
+	OfflineQueueState * queue = ClientState_Get(context, &offlineQueueStateDefinition);
+
+	if (queue == NULL)
+		return;
+
+	pthread_mutex_lock(&queue->Lock);
+	queue->Online = online;
+	OfflineQueue_UpdateRecording(queue);
+	pthread_mutex_unlock(&queue->Lock);
+}
+
+void OfflineQueue_Record(Lwm2mContextType * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID, OfflineChangeKind kind,
+	int64_t value, int64_t timeMs)
+{
+	OfflineQueueState * queue = ClientState_Get(context, &offlineQueueStateDefinition);
+	uint64_t key = OfflineQueue_MakeKey(objectID, objectInstanceID, resourceID);
+	int merged;
+
+	if (queue == NULL || !__atomic_load_n(&queue->Recording, __ATOMIC_ACQUIRE))
+		return;
+
+	pthread_mutex_lock(&queue->Lock);
+	if (queue->Recording)
+	{
+		queue->Stats.Recorded++;
+		if (kind == OfflineChangeKind_Transition)
+			OfflineQueue_PushTransition(queue, key, value, timeMs);
+		else if ((merged = OfflineQueue_Fold(queue, key, kind, value, timeMs)) == -1)
+			queue->Stats.Dropped++;
+		else if (merged)
+			queue->Stats.Compacted++;
+		OfflineQueue_UpdateRecording(queue);
+	}
+	pthread_mutex_unlock(&queue->Lock);
+}
+
+int OfflineQueue_Drain(Lwm2mContextType * context, int64_t nowMs, OfflineQueueSink sink,
+	void * sinkContext)
+{
+	OfflineQueueState * queue = ClientState_Get(context, &offlineQueueStateDefinition);
+	uint64_t ringStart;
+	int count, transitions;
+
+	if (queue == NULL || sink == NULL)
+		return -1;
+
+	pthread_mutex_lock(&queue->Lock);
+	if (!queue->Enabled || !queue->Online)
+	{
+		pthread_mutex_unlock(&queue->Lock);
+		return 0;
+	}
+
+	/* Token bucket holding at most one batch, so a long gap does not allow a burst */
+	queue->Tokens += (double)(nowMs - queue->LastRefillMs) * queue->Config.DrainRatePerSecond /
+		1000;
+	if (queue->Tokens > queue->Config.DrainBatchSize || queue->LastRefillMs == 0)
+		queue->Tokens = queue->Config.DrainBatchSize;
+	queue->LastRefillMs = nowMs;
+
+	count = OfflineQueue_CollectBatch(queue, (int)queue->Tokens, &transitions);
+	ringStart = queue->RingStart;
+	pthread_mutex_unlock(&queue->Lock);
+
+	if (count == 0)
+		return 0;
+	if (sink(sinkContext, queue->Batch, count) == -1)
+		return -1;
+
+	pthread_mutex_lock(&queue->Lock);
+	OfflineQueue_CommitBatch(queue, count, ringStart, transitions);
+	queue->Tokens -= count;
+	queue->Stats.Drained += count;
+	OfflineQueue_UpdateRecording(queue);
+	pthread_mutex_unlock(&queue->Lock);
+	return count;
+}
+
+void OfflineQueue_GetStats(Lwm2mContextType * context, OfflineQueueStats * stats)
+{
+	OfflineQueueState * queue = ClientState_Get(context, &offlineQueueStateDefinition);
+
+	memset(stats, 0, sizeof(*stats));
+	if (queue == NULL)
+		return;
+
+	pthread_mutex_lock(&queue->Lock);
+	*stats = queue->Stats;
+	pthread_mutex_unlock(&queue->Lock);
+}
@@ -0,0 +1,119 @@
+/**
+ * @file
+ * Bounded store-and-forward queue for changes made while offline.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_OFFLINE_QUEUE_H_
+#define LWM2M_CLIENT_OFFLINE_QUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwm2m_core.h"
+
+/*
+ * While a client is offline, Digital Input and Light Control record their changes here rather
+ * than losing all but the final value. The queue has a fixed size and compacts as it fills:
+ * - State resources keep only their latest value.
+ * - Counter resources fold their increments into one sum.
+ * - Transitions keep every timestamped change while the transition budget allows. When it runs
+ *   out, the oldest transition of any resource is folded into that resource's latest value.
+ * Recording continues after reconnecting until the queue has drained, so queued changes are never
+ * overtaken by newer ones. Recording is thread-safe, so setters on other threads may record.
+ */
+typedef enum
+{
+	OfflineChangeKind_State,
+	OfflineChangeKind_Counter,
+	OfflineChangeKind_Transition,
+} OfflineChangeKind;
+
+typedef struct
+{
+	int MaxResources;			/* distinct resources that can have changes queued */
+	int TransitionBudget;		/* timestamped transitions kept before folding the oldest */
+	int DrainBatchSize;			/* changes handed to the sink at once */
+	int DrainRatePerSecond;		/* changes drained per second, on average */
+} OfflineQueueConfig;
+
+/*
+ * A queued change. Value is the latest value of a state, the sum of increments of a counter, or
+ * the value after a transition; TimeMs is when it last changed.
+ */
+typedef struct
+{
+	ObjectIDType ObjectID;
+	ObjectInstanceIDType ObjectInstanceID;
+	ResourceIDType ResourceID;
+	OfflineChangeKind Kind;
+	int64_t Value;
+	int64_t TimeMs;
+} OfflineChange;
+
+/*
+ * Sends one batch of changes, for example as a SenML-CBOR Send. Returns 0 once they are sent, or
+ * -1 to keep them queued and try again on a later drain.
+ */
+typedef int (*OfflineQueueSink)(void * sinkContext, const OfflineChange * changes, int count);
+
+typedef struct
+{
+	int Pending;
+	uint64_t Recorded;
+	uint64_t Compacted;
+	uint64_t Dropped;
+	uint64_t Drained;
+} OfflineQueueStats;
+
+/* Starts queuing changes for the client, discarding any queued under an earlier config */
+int OfflineQueue_Enable(Lwm2mContextType * context, const OfflineQueueConfig * config);
+
+/* Clients start out offline, so changes are queued until this is first called with true */
+void OfflineQueue_SetOnline(Lwm2mContextType * context, bool online);
+
+/* Called by the objects for every change; does nothing while there is nothing to queue for */
+void OfflineQueue_Record(Lwm2mContextType * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID, OfflineChangeKind kind,
+	int64_t value, int64_t timeMs);
+
+/*
+ * Hands the sink at most one batch, limited to the configured rate. Call it regularly from the
+ * client's loop once online, and only from there. Compacted values go first, then transitions
+ * in the order they happened. Returns the number of changes sent, 0 if none were due, or -1 if
+ * the sink failed.
+ */
+int OfflineQueue_Drain(Lwm2mContextType * context, int64_t nowMs, OfflineQueueSink sink,
+	void * sinkContext);
+
+void OfflineQueue_GetStats(Lwm2mContextType * context, OfflineQueueStats * stats);
+
+#endif /* LWM2M_CLIENT_OFFLINE_QUEUE_H_ */
@@ -0,0 +1,203 @@
+/**
+ * @file
+ * Batched provisioning of the Flow objects.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lwm2m_core.h"
+#include "lwm2m_observers.h"
+#include "lwm2m-client-provisioning.h"
+#include "lwm2m-client-resource-version.h"
+
+/***************************************************************************************************
+ * Implementation - Private
+ **************************************************************************************************/
+
+static ProvisionedValue * Provisioning_Add(ProvisioningBatch * batch, ResourceIDType resourceID)
+{
+	ProvisionedValue * value = &batch->Values[batch->Count++];
+
+	memset(value, 0, sizeof(*value));
+	value->ResourceID = resourceID;
+	return value;
+}
+
+static const ProvisionedValue * Provisioning_Find(const ProvisioningBatch * batch,
+	ResourceIDType resourceID)
+{
+	int i;
+
+	for (i = 0; i < batch->Count; i++)
+	{
+		if (batch->Values[i].ResourceID == resourceID)
+			return &batch->Values[i];
+	}
+	return NULL;
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+void Provisioning_AddString(ProvisioningBatch * batch, ResourceIDType resourceID,
+	const char * value, const char * current)
+{
+	ProvisionedValue * provisioned = Provisioning_Add(batch, resourceID);
+
+	provisioned->Value = value != NULL ? value : current;
+	provisioned->Length = provisioned->Value != NULL ? strlen(provisioned->Value) + 1 : 0;
+	provisioned->Changed = value != NULL && (current == NULL || strcmp(value, current) != 0);
+	provisioned->Copied = true;
+	if (value != NULL)
+		batch->Given++;
+}
+
+void Provisioning_AddOpaque(ProvisioningBatch * batch, ResourceIDType resourceID,
+	const void * value, int length, const void * current, int currentLength)
+{
+	ProvisionedValue * provisioned = Provisioning_Add(batch, resourceID);
+
+	if (value != NULL)
+	{
+		provisioned->Value = value;
+		provisioned->Length = length;
+		provisioned->Changed = current == NULL || currentLength != length ||
+			memcmp(value, current, length) != 0;
+		batch->Given++;
+	}
+	else
+	{
+		provisioned->Value = current;
+		provisioned->Length = current != NULL ? currentLength : 0;
+	}
+	provisioned->Copied = true;
+}
+
+void Provisioning_AddInteger(ProvisioningBatch * batch, ResourceIDType resourceID,
+	const int64_t * value, int64_t current)
+{
+	ProvisionedValue * provisioned = Provisioning_Add(batch, resourceID);
+
+	provisioned->Integer = value != NULL ? *value : current;
+	provisioned->Length = sizeof(provisioned->Integer);
+	provisioned->Changed = value != NULL && *value != current;
+	if (value != NULL)
+		batch->Given++;
+}
+
+int Provisioning_Allocate(ProvisioningBatch * batch)
+{
+	int offset = 0;
+	int i;
+
+	batch->BlockSize = 0;
+	for (i = 0; i < batch->Count; i++)
+	{
+		if (batch->Values[i].Copied)
+			batch->BlockSize += batch->Values[i].Length;
+	}
+
+	batch->Block = NULL;
+	if (batch->BlockSize > 0 && (batch->Block = malloc(batch->BlockSize)) == NULL)
+		return -1;
+
+	for (i = 0; i < batch->Count; i++)
+	{
+		ProvisionedValue * value = &batch->Values[i];
+
+		if (value->Copied && value->Length > 0)
+		{
+			memcpy(batch->Block + offset, value->Value, value->Length);
+			value->Value = batch->Block + offset;
+			offset += value->Length;
+		}
+		else if (!value->Copied)
+		{
+			value->Value = &value->Integer;
+		}
+	}
+	return 0;
+}
+
+void Provisioning_Discard(ProvisioningBatch * batch)
+{
+	free(batch->Block);
+	batch->Block = NULL;
+	batch->BlockSize = 0;
+}
+
+void * Provisioning_GetValue(const ProvisioningBatch * batch, ResourceIDType resourceID)
+{
+	const ProvisionedValue * value = Provisioning_Find(batch, resourceID);
+
+	return value != NULL && value->Length > 0 ? (void *)value->Value : NULL;
+}
+
+int Provisioning_GetLength(const ProvisioningBatch * batch, ResourceIDType resourceID)
+{
+	const ProvisionedValue * value = Provisioning_Find(batch, resourceID);
+
+	return value != NULL ? value->Length : 0;
+}
+
+bool Provisioning_OwnsValue(const char * block, int blockSize, const void * value)
+{
+	uintptr_t address = (uintptr_t)value;
+
+	return block != NULL && address >= (uintptr_t)block && address < (uintptr_t)block + blockSize;
+}
+
+void Provisioning_MarkObservers(Lwm2mContextType * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, const ProvisioningBatch * batch)
+{
+	int i;
+
+	for (i = 0; i < batch->Count; i++)
+	{
+		const ProvisionedValue * value = &batch->Values[i];
+
+		if (value->Changed)
+		{
+			Lwm2m_MarkObserversChanged(context, objectID, objectInstanceID, value->ResourceID,
+				value->Value, value->Length);
+			ResourceVersion_Stamp(context, objectID, objectInstanceID, value->ResourceID);
+		}
+	}
+}
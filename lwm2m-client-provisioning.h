@@ -0,0 +1,121 @@
+/**
+ * @file
+ * Batched provisioning of the Flow objects.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_PROVISIONING_H_
+#define LWM2M_CLIENT_PROVISIONING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwm2m_core.h"
+
+#define PROVISIONING_MAX_VALUES			8
+
+/*
+ * Everything a device is provisioned with, for Lwm2m_ProvisionFlowObjects(). A NULL value, or an
+ * integer whose Has flag is false, keeps the resource's current value. Values of resources
+ * compiled out by lwm2m-client-config.h are ignored.
+ */
+typedef struct
+{
+	/* Flow object */
+	const char * DeviceType;
+	const char * FCAP;
+	int64_t LicenseeID;
+	bool HasLicenseeID;
+	const void * ParentID;
+	int ParentIDLength;
+	const char * Name;
+	const char * Description;
+
+	/* Flow Access object, whose instance is only created if one of these is given */
+	const char * URL;
+	const char * CustomerKey;
+	const char * CustomerSecret;
+	const char * RememberMeToken;
+	int64_t RememberMeTokenExpiry;
+	bool HasRememberMeTokenExpiry;
+} FlowProvisioningInfo;
+
+/* One resource of a batch */
+typedef struct
+{
+	ResourceIDType ResourceID;
+	const void * Value;							/* The new value, or the current one if none */
+	int Length;
+	bool Changed;
+	bool Copied;								/* Value is copied into the batch's block */
+	int64_t Integer;
+} ProvisionedValue;
+
+/*
+ * The values an object is about to take. Every copied value shares one allocation, which the
+ * object keeps once the batch is committed and frees when the instance is deleted.
+ */
+typedef struct
+{
+	ProvisionedValue Values[PROVISIONING_MAX_VALUES];
+	int Count;
+	int Given;									/* Values the caller supplied */
+	char * Block;
+	int BlockSize;
+} ProvisioningBatch;
+
+/* Adds a resource to a batch. value is NULL to keep current */
+void Provisioning_AddString(ProvisioningBatch * batch, ResourceIDType resourceID,
+	const char * value, const char * current);
+void Provisioning_AddOpaque(ProvisioningBatch * batch, ResourceIDType resourceID,
+	const void * value, int length, const void * current, int currentLength);
+void Provisioning_AddInteger(ProvisioningBatch * batch, ResourceIDType resourceID,
+	const int64_t * value, int64_t current);
+
+/* Copies every string and opaque value into one block. Returns -1 if memory runs out */
+int Provisioning_Allocate(ProvisioningBatch * batch);
+void Provisioning_Discard(ProvisioningBatch * batch);
+
+/* Where a resource's value lives once the batch is committed, and its length */
+void * Provisioning_GetValue(const ProvisioningBatch * batch, ResourceIDType resourceID);
+int Provisioning_GetLength(const ProvisioningBatch * batch, ResourceIDType resourceID);
+
+/* True if value is inside a committed block, so it must not be freed on its own */
+bool Provisioning_OwnsValue(const char * block, int blockSize, const void * value);
+
+/*
+ * Marks the observers of every changed resource. The core then sends each observer one
+ * notification on its next update, however many of its resources changed.
+ */
+void Provisioning_MarkObservers(Lwm2mContextType * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, const ProvisioningBatch * batch);
+
+#endif /* LWM2M_CLIENT_PROVISIONING_H_ */
@@ -0,0 +1,97 @@
+/**
+ * @file
+ * Table-driven object registration.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include "lwm2m_core.h"
+#include "lwm2m-client-registration.h"
+#include "common.h"
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+int Registration_RegisterResources(Lwm2mContextType * context, ObjectIDType objectID,
+	const ResourceDescriptor * descriptors, int count, ResourceOperationHandlers * handlers)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		const ResourceDescriptor * descriptor = &descriptors[i];
+
+		if (Lwm2mCore_RegisterResourceType(context, descriptor->Name, objectID,
+			descriptor->ResourceID, descriptor->Type, descriptor->MaxInstances,
+			descriptor->MinInstances, descriptor->Operations, handlers) == -1)
+		{
+			Lwm2m_Error("Failed to register %s resource with Lwm2m core\n", descriptor->Name);
+			return -1;
+		}
+		DIAGNOSTICS_TRACK_RESOURCE(objectID, descriptor->ResourceID);
+	}
+	return 0;
+}
+
+int Registration_CreateInstances(Lwm2mContextType * context, ObjectIDType objectID,
+	ObjectInstanceIDType firstInstanceID, int count, const ResourceIDType * optionalResources,
+	int optionalCount)
+{
+	ObjectInstanceIDType objectInstanceID;
+	int i;
+
+	for (objectInstanceID = firstInstanceID; objectInstanceID < firstInstanceID + count;
+		objectInstanceID++)
+	{
+		if (Lwm2mCore_CreateObjectInstance(context, objectID, objectInstanceID) == -1)
+		{
+			Lwm2m_Error("Failed to create instance %d of object %d\n", objectInstanceID, objectID);
+			return -1;
+		}
+
+		for (i = 0; i < optionalCount; i++)
+		{
+			if (Lwm2mCore_CreateOptionalResource(context, objectID, objectInstanceID,
+				optionalResources[i]) == -1)
+			{
+				Lwm2m_Error("Failed to create optional resource %d for object %d instance %d\n",
+					optionalResources[i], objectID, objectInstanceID);
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file
+ * Table-driven object registration.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_REGISTRATION_H_
+#define LWM2M_CLIENT_REGISTRATION_H_
+
+#include "lwm2m_core.h"
+
+/* One resource of an object, as passed to Lwm2mCore_RegisterResourceType() */
+typedef struct
+{
+	char * Name;
+	ResourceIDType ResourceID;
+	ResourceTypeEnum Type;
+	MultipleInstancesEnum MaxInstances;
+	MandatoryEnum MinInstances;
+	Operations Operations;
+} ResourceDescriptor;
+
+#define RESOURCE_DESCRIPTOR_COUNT(descriptors) \
+	(int)(sizeof(descriptors) / sizeof((descriptors)[0]))
+
+/* Registers every resource of a const table with the same handlers, in one pass */
+int Registration_RegisterResources(Lwm2mContextType * context, ObjectIDType objectID,
+	const ResourceDescriptor * descriptors, int count, ResourceOperationHandlers * handlers);
+
+/*
+ * Creates instances firstInstanceID to firstInstanceID + count - 1 and, in each one, the optional
+ * resources listed. Stops at the first failure, leaving the instances before it in place.
+ */
+int Registration_CreateInstances(Lwm2mContextType * context, ObjectIDType objectID,
+	ObjectInstanceIDType firstInstanceID, int count, const ResourceIDType * optionalResources,
+	int optionalCount);
+
+#endif /* LWM2M_CLIENT_REGISTRATION_H_ */
@@ -0,0 +1,314 @@
+/**
+ * @file
+ * Per-resource change versions for resynchronizing after a reconnect.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "lwm2m_core.h"
+#include "lwm2m-client-resource-version.h"
+#include "lwm2m-client-state.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define RESOURCE_VERSION_INITIAL_BUCKETS	64
+
+/* Set in the key of an entry for a whole instance, whose resource bits are zero */
+#define RESOURCE_VERSION_INSTANCE_KEY		((uint64_t)1 << 48)
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+/* Object, instance and resource IDs are 16 bits in LWM2M, so they pack into one key */
+typedef struct
+{
+	uint64_t Key;
+	uint32_t Version;
+	bool Deleted;
+} ResourceVersionEntry;
+
+/*
+ * Open-addressing hash table with linear probing, kept at most half full. A version of 0 marks an
+ * empty bucket. Entries are never removed; those of a deleted instance are marked instead. Write
+ * handlers stamp from the core thread and setters such as DigitalInput_SetInput() from others, so
+ * the table has a lock.
+ */
+typedef struct
+{
+	pthread_mutex_t Lock;
+	uint32_t Current;
+	ResourceVersionEntry * Entries;
+	int Count;
+	int BucketCount;
+} ResourceVersionState;
+
+/***************************************************************************************************
+ * Prototypes
+ **************************************************************************************************/
+
+static void ResourceVersion_InitialiseState(void * state);
+static void ResourceVersion_CleanupState(void * state);
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+static const ClientStateDefinition resourceVersionStateDefinition =
+{
+	.Slot = ClientStateSlot_ResourceVersion,
+	.Size = sizeof(ResourceVersionState),
+	.Initialise = ResourceVersion_InitialiseState,
+	.Cleanup = ResourceVersion_CleanupState,
+};
+
+/***************************************************************************************************
+ * Implementation - Private
+ **************************************************************************************************/
+
+static void ResourceVersion_InitialiseState(void * state)
+{
+	ResourceVersionState * versions = state;
+
+	pthread_mutex_init(&versions->Lock, NULL);
+}
+
+static void ResourceVersion_CleanupState(void * state)
+{
+	ResourceVersionState * versions = state;
+
+	free(versions->Entries);
+	pthread_mutex_destroy(&versions->Lock);
+}
+
+static uint64_t ResourceVersion_MakeKey(ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID)
+{
+	uint64_t key = ((uint64_t)(uint16_t)objectID << 32) |
+		((uint64_t)(uint16_t)objectInstanceID << 16);
+
+	return resourceID == RESOURCE_VERSION_INSTANCE ? key | RESOURCE_VERSION_INSTANCE_KEY :
+		key | (uint16_t)resourceID;
+}
+
+static ResourceVersionEntry * ResourceVersion_FindBucket(ResourceVersionEntry * entries,
+	int bucketCount, uint64_t key)
+{
+	uint32_t bucket = (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (bucketCount - 1);
+
+	while (entries[bucket].Version != 0 && entries[bucket].Key != key)
+		bucket = (bucket + 1) & (bucketCount - 1);
+	return &entries[bucket];
+}
+
+static int ResourceVersion_Grow(ResourceVersionState * versions)
+{
+	int bucketCount = versions->BucketCount == 0 ? RESOURCE_VERSION_INITIAL_BUCKETS :
+		2 * versions->BucketCount;
+	ResourceVersionEntry * entries = calloc(bucketCount, sizeof(ResourceVersionEntry));
+	int i;
+
+	if (entries == NULL)
+		return -1;
+
+	for (i = 0; i < versions->BucketCount; i++)
+	{
+		if (versions->Entries[i].Version != 0)
+			*ResourceVersion_FindBucket(entries, bucketCount, versions->Entries[i].Key) =
+				versions->Entries[i];
+	}
+	free(versions->Entries);
+	versions->Entries = entries;
+	versions->BucketCount = bucketCount;
+	return 0;
+}
+
+/* Called with the lock held */
+static uint32_t ResourceVersion_StampKey(ResourceVersionState * versions, uint64_t key,
+	bool deleted)
+{
+	ResourceVersionEntry * entry;
+
+	if (2 * (versions->Count + 1) > versions->BucketCount && ResourceVersion_Grow(versions) == -1)
+	{
+		Lwm2m_Error("Out of memory for resource versions\n");
+		return 0;
+	}
+
+	entry = ResourceVersion_FindBucket(versions->Entries, versions->BucketCount, key);
+	if (entry->Version == 0)
+	{
+		entry->Key = key;
+		versions->Count++;
+	}
+
+	/* 0 marks an empty bucket, so it is skipped when the count wraps */
+	if (++versions->Current == 0)
+		versions->Current = 1;
+	entry->Version = versions->Current;
+	entry->Deleted = deleted;
+	return entry->Version;
+}
+
+/* Changes hold versions relative to the one asked about while sorting, so a wrap sorts correctly */
+static int ResourceVersion_CompareChanges(const void * a, const void * b)
+{
+	uint32_t versionA = ((const ResourceVersionChange *)a)->Version;
+	uint32_t versionB = ((const ResourceVersionChange *)b)->Version;
+
+	return versionA < versionB ? -1 : versionA > versionB;
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+uint32_t ResourceVersion_Stamp(Lwm2mContextType * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID)
+{
+	ResourceVersionState * versions = ClientState_Get(context, &resourceVersionStateDefinition);
+	uint32_t version;
+
+	if (versions == NULL)
+		return 0;
+
+	pthread_mutex_lock(&versions->Lock);
+	version = ResourceVersion_StampKey(versions,
+		ResourceVersion_MakeKey(objectID, objectInstanceID, resourceID), false);
+	pthread_mutex_unlock(&versions->Lock);
+	return version;
+}
+
+uint32_t ResourceVersion_StampInstance(Lwm2mContextType * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, bool deleted)
+{
+	ResourceVersionState * versions = ClientState_Get(context, &resourceVersionStateDefinition);
+	uint64_t key = ResourceVersion_MakeKey(objectID, objectInstanceID, RESOURCE_VERSION_INSTANCE);
+	uint32_t version;
+	int i;
+
+	if (versions == NULL)
+		return 0;
+
+	pthread_mutex_lock(&versions->Lock);
+	if (deleted)
+	{
+		for (i = 0; i < versions->BucketCount; i++)
+		{
+			ResourceVersionEntry * entry = &versions->Entries[i];
+
+			/* Resource keys share the object and instance bits with the instance key */
+			if (entry->Version != 0 &&
+				entry->Key >> 16 == (key & ~RESOURCE_VERSION_INSTANCE_KEY) >> 16)
+			{
+				entry->Deleted = true;
+			}
+		}
+	}
+	version = ResourceVersion_StampKey(versions, key, deleted);
+	pthread_mutex_unlock(&versions->Lock);
+	return version;
+}
+
+uint32_t ResourceVersion_GetCurrent(Lwm2mContextType * context)
+{
+	ResourceVersionState * versions = ClientState_Get(context, &resourceVersionStateDefinition);
+	uint32_t version;
+
+	if (versions == NULL)
+		return 0;
+
+	pthread_mutex_lock(&versions->Lock);
+	version = versions->Current;
+	pthread_mutex_unlock(&versions->Lock);
+	return version;
+}
+
+int ResourceVersion_GetChangedSince(Lwm2mContextType * context, uint32_t version,
+	ResourceVersionChange * changes, int maxChanges)
+{
+	ResourceVersionState * versions = ClientState_Get(context, &resourceVersionStateDefinition);
+	ResourceVersionChange * changed;
+	int count = 0;
+	int i;
+
+	if (versions == NULL)
+		return -1;
+
+	pthread_mutex_lock(&versions->Lock);
+	if ((changed = malloc((versions->Count + 1) * sizeof(ResourceVersionChange))) == NULL)
+	{
+		pthread_mutex_unlock(&versions->Lock);
+		Lwm2m_Error("Out of memory for changed resources\n");
+		return -1;
+	}
+
+	for (i = 0; i < versions->BucketCount; i++)
+	{
+		const ResourceVersionEntry * entry = &versions->Entries[i];
+		bool instance = (entry->Key & RESOURCE_VERSION_INSTANCE_KEY) != 0;
+
+		/* Newer than version, counting round a wrap; resources of deleted instances are gone */
+		if (entry->Version == 0 || (int32_t)(entry->Version - version) <= 0 ||
+			(entry->Deleted && !instance))
+		{
+			continue;
+		}
+
+		changed[count].ObjectID = (uint16_t)(entry->Key >> 32);
+		changed[count].ObjectInstanceID = (uint16_t)(entry->Key >> 16);
+		changed[count].ResourceID = instance ? RESOURCE_VERSION_INSTANCE : (uint16_t)entry->Key;
+		changed[count].Version = entry->Version - version;
+		changed[count].Deleted = entry->Deleted;
+		count++;
+	}
+	pthread_mutex_unlock(&versions->Lock);
+
+	qsort(changed, count, sizeof(ResourceVersionChange), ResourceVersion_CompareChanges);
+	for (i = 0; i < count && i < maxChanges; i++)
+	{
+		changes[i] = changed[i];
+		changes[i].Version += version;
+	}
+	free(changed);
+	return count;
+}
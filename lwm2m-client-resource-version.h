@@ -0,0 +1,84 @@
+/**
+ * @file
+ * Per-resource change versions for resynchronizing after a reconnect.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_RESOURCE_VERSION_H_
+#define LWM2M_CLIENT_RESOURCE_VERSION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwm2m_core.h"
+
+/*
+ * Each client counts changes to its object resources. Every change stamps the resource with the
+ * next value of the count, so after a reconnect a server that remembers the version it last saw
+ * can fetch just what changed since, instead of re-reading whole objects. Versions start again
+ * from 1 when the client is recreated, and wrap after 2^32 changes.
+ */
+
+/* ResourceID of a change that created or deleted a whole instance */
+#define RESOURCE_VERSION_INSTANCE			-1
+
+typedef struct
+{
+	ObjectIDType ObjectID;
+	ObjectInstanceIDType ObjectInstanceID;
+	ResourceIDType ResourceID;
+	uint32_t Version;
+	bool Deleted;
+} ResourceVersionChange;
+
+/* Records a change to one resource and returns its new version, or 0 if memory runs out */
+uint32_t ResourceVersion_Stamp(Lwm2mContextType * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID);
+
+/*
+ * Records that an instance was created or deleted. Deleting an instance forgets the versions of
+ * its resources, so only the deletion is reported.
+ */
+uint32_t ResourceVersion_StampInstance(Lwm2mContextType * context, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, bool deleted);
+
+/* The version of the latest change, or 0 if nothing has changed yet */
+uint32_t ResourceVersion_GetCurrent(Lwm2mContextType * context);
+
+/*
+ * Fills changes with up to maxChanges resources and instances changed after version, oldest
+ * first. Returns how many there are in total, which may be more than maxChanges; call again with
+ * the version of the last one returned to get the rest. Returns -1 if memory runs out.
+ */
+int ResourceVersion_GetChangedSince(Lwm2mContextType * context, uint32_t version,
+	ResourceVersionChange * changes, int maxChanges);
+
+#endif /* LWM2M_CLIENT_RESOURCE_VERSION_H_ */
@@ -0,0 +1,391 @@
+/**
+ * @file
+ * SenML-CBOR encoder for libobjects telemetry.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lwm2m_core.h"
+#include "lwm2m-client-senml-cbor.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define CBOR_MAJOR_UNSIGNED				0x00
+#define CBOR_MAJOR_NEGATIVE				0x20
+#define CBOR_MAJOR_TEXT					0x60
+#define CBOR_MAJOR_MAP					0xA0
+#define CBOR_ARRAY_INDEFINITE			0x9F
+#define CBOR_FALSE						0xF4
+#define CBOR_TRUE						0xF5
+#define CBOR_FLOAT32					0xFA
+#define CBOR_FLOAT64					0xFB
+#define CBOR_BREAK						0xFF
+
+/* SenML labels (RFC 8428) */
+#define SENML_LABEL_BASE_NAME			-2
+#define SENML_LABEL_BASE_TIME			-3
+#define SENML_LABEL_NAME				0
+#define SENML_LABEL_VALUE				2
+#define SENML_LABEL_STRING_VALUE		3
+#define SENML_LABEL_BOOLEAN_VALUE		4
+#define SENML_LABEL_TIME				6
+
+#define SENML_MAX_NAME_LENGTH			36		/* Three int IDs, two slashes and the NUL */
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef enum
+{
+	SenMLValue_Integer,
+	SenMLValue_Float,
+	SenMLValue_Boolean,
+	SenMLValue_String,
+} SenMLValueType;
+
+typedef struct
+{
+	SenMLValueType Type;
+	int64_t Integer;
+	double Float;
+	const char * String;
+} SenMLValue;
+
+/***************************************************************************************************
+ * Implementation - Private
+ **************************************************************************************************/
+
+static void SenMLCbor_Put(SenMLCborEncoder * encoder, const void * data, int length)
+{
+	if (encoder->Length + length > encoder->BufferLength)
+	{
+		encoder->Overflow = true;
+		return;
+	}
+	memcpy(encoder->Buffer + encoder->Length, data, length);
+	encoder->Length += length;
+}
+
+static void SenMLCbor_PutHead(SenMLCborEncoder * encoder, uint8_t major, uint64_t value)
+{
+	uint8_t head[9];
+	int length, i;
+
+	if (value < 24)
+	{
+		head[0] = major | (uint8_t)value;
+		length = 1;
+	}
+	else
+	{
+		int size = value <= 0xFF ? 1 : value <= 0xFFFF ? 2 : value <= 0xFFFFFFFF ? 4 : 8;
+
+		head[0] = major | (size == 1 ? 24 : size == 2 ? 25 : size == 4 ? 26 : 27);
+		for (i = size; i > 0; i--)
+		{
+			head[i] = (uint8_t)value;
+			value >>= 8;
+		}
+		length = size + 1;
+	}
+	SenMLCbor_Put(encoder, head, length);
+}
+
+static void SenMLCbor_PutInteger(SenMLCborEncoder * encoder, int64_t value)
+{
+	if (value >= 0)
+		SenMLCbor_PutHead(encoder, CBOR_MAJOR_UNSIGNED, (uint64_t)value);
+	else
+		SenMLCbor_PutHead(encoder, CBOR_MAJOR_NEGATIVE, (uint64_t)(-1 - value));
+}
+
+static void SenMLCbor_PutText(SenMLCborEncoder * encoder, const char * text)
+{
+	int length = strlen(text);
+
+	SenMLCbor_PutHead(encoder, CBOR_MAJOR_TEXT, length);
+	SenMLCbor_Put(encoder, text, length);
+}
+
+/* Uses the shortest of float32 and float64 that keeps the value exact */
+static void SenMLCbor_PutFloat(SenMLCborEncoder * encoder, double value)
+{
+	uint8_t data[9];
+	float single = (float)value;
+	uint64_t bits;
+	int size, i;
+
+	if ((double)single == value)
+	{
+		uint32_t bits32;
+
+		memcpy(&bits32, &single, sizeof(bits32));
+		bits = bits32;
+		data[0] = CBOR_FLOAT32;
+		size = 4;
+	}
+	else
+	{
+		memcpy(&bits, &value, sizeof(bits));
+		data[0] = CBOR_FLOAT64;
+		size = 8;
+	}
+
+	for (i = size; i > 0; i--)
+	{
+		data[i] = (uint8_t)bits;
+		bits >>= 8;
+	}
+	SenMLCbor_Put(encoder, data, size + 1);
+}
+
+/* SenML times are in seconds, whole seconds are sent as integers */
+static void SenMLCbor_PutTime(SenMLCborEncoder * encoder, int64_t timeMs)
+{
+	if (timeMs % 1000 == 0)
+		SenMLCbor_PutInteger(encoder, timeMs / 1000);
+	else
+		SenMLCbor_PutFloat(encoder, timeMs / 1000.0);
+}
+
+/* Appends the decimal digits of a non-negative ID, returns the position after them */
+static char * SenMLCbor_PutID(char * position, int id)
+{
+	char digits[10];
+	int count = 0;
+
+	do
+	{
+		digits[count++] = '0' + id % 10;
+		id /= 10;
+	} while (id > 0);
+
+	while (count > 0)
+		*position++ = digits[--count];
+	return position;
+}
+
+static int SenMLCbor_AddRecord(SenMLCborEncoder * encoder, const char * name, int64_t timeMs,
+	const SenMLValue * value)
+{
+	bool first = encoder->Records == 0;
+	int start = encoder->Length;
+	int fields = 2;
+
+	if (encoder->Overflow)
+		return -1;
+
+	if (first)
+		fields += (encoder->BaseName != NULL) + (encoder->BaseTimeMs != SENML_NO_TIME);
+	if (timeMs != SENML_NO_TIME)
+		fields++;
+
+	SenMLCbor_PutHead(encoder, CBOR_MAJOR_MAP, fields);
+
+	if (first && encoder->BaseName != NULL)
+	{
+		SenMLCbor_PutInteger(encoder, SENML_LABEL_BASE_NAME);
+		SenMLCbor_PutText(encoder, encoder->BaseName);
+	}
+	if (first && encoder->BaseTimeMs != SENML_NO_TIME)
+	{
+		SenMLCbor_PutInteger(encoder, SENML_LABEL_BASE_TIME);
+		SenMLCbor_PutTime(encoder, encoder->BaseTimeMs);
+	}
+
+	SenMLCbor_PutInteger(encoder, SENML_LABEL_NAME);
+	SenMLCbor_PutText(encoder, name);
+
+	switch (value->Type)
+	{
+		case SenMLValue_Integer:
+			SenMLCbor_PutInteger(encoder, SENML_LABEL_VALUE);
+			SenMLCbor_PutInteger(encoder, value->Integer);
+			break;
+
+		case SenMLValue_Float:
+			SenMLCbor_PutInteger(encoder, SENML_LABEL_VALUE);
+			SenMLCbor_PutFloat(encoder, value->Float);
+			break;
+
+		case SenMLValue_Boolean:
+		{
+			uint8_t boolean = value->Integer ? CBOR_TRUE : CBOR_FALSE;
+
+			SenMLCbor_PutInteger(encoder, SENML_LABEL_BOOLEAN_VALUE);
+			SenMLCbor_Put(encoder, &boolean, 1);
+			break;
+		}
+
+		case SenMLValue_String:
+			SenMLCbor_PutInteger(encoder, SENML_LABEL_STRING_VALUE);
+			SenMLCbor_PutText(encoder, value->String);
+			break;
+	}
+
+	if (timeMs != SENML_NO_TIME)
+	{
+		SenMLCbor_PutInteger(encoder, SENML_LABEL_TIME);
+		SenMLCbor_PutTime(encoder, encoder->BaseTimeMs != SENML_NO_TIME ?
+			timeMs - encoder->BaseTimeMs : timeMs);
+	}
+
+	/* A record that does not fit, with the break that closes the array, is left out whole */
+	if (encoder->Overflow || encoder->Length >= encoder->BufferLength)
+	{
+		encoder->Length = start;
+		encoder->Overflow = false;
+		return -1;
+	}
+
+	encoder->Records++;
+	return 0;
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+void SenMLCbor_Init(SenMLCborEncoder * encoder, uint8_t * buffer, int bufferLength,
+	const char * baseName, int64_t baseTimeMs)
+{
+	uint8_t start = CBOR_ARRAY_INDEFINITE;
+
+	memset(encoder, 0, sizeof(SenMLCborEncoder));
+	encoder->Buffer = buffer;
+	encoder->BufferLength = bufferLength;
+	encoder->BaseName = baseName;
+	encoder->BaseTimeMs = baseTimeMs;
+	SenMLCbor_Put(encoder, &start, 1);
+}
+
+int SenMLCbor_AddInteger(SenMLCborEncoder * encoder, const char * name, int64_t timeMs,
+	int64_t value)
+{
+	SenMLValue record = { .Type = SenMLValue_Integer, .Integer = value };
+	return SenMLCbor_AddRecord(encoder, name, timeMs, &record);
+}
+
+int SenMLCbor_AddFloat(SenMLCborEncoder * encoder, const char * name, int64_t timeMs,
+	double value)
+{
+	SenMLValue record = { .Type = SenMLValue_Float, .Float = value };
+	return SenMLCbor_AddRecord(encoder, name, timeMs, &record);
+}
+
+int SenMLCbor_AddBoolean(SenMLCborEncoder * encoder, const char * name, int64_t timeMs,
+	bool value)
+{
+	SenMLValue record = { .Type = SenMLValue_Boolean, .Integer = value };
+	return SenMLCbor_AddRecord(encoder, name, timeMs, &record);
+}
+
+int SenMLCbor_AddString(SenMLCborEncoder * encoder, const char * name, int64_t timeMs,
+	const char * value)
+{
+	SenMLValue record = { .Type = SenMLValue_String, .String = value };
+	return SenMLCbor_AddRecord(encoder, name, timeMs, &record);
+}
+
+int SenMLCbor_AddResource(SenMLCborEncoder * encoder, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID, ResourceTypeEnum type,
+	const void * value, int valueLength, int64_t timeMs)
+{
+	SenMLValue record;
+	char name[SENML_MAX_NAME_LENGTH], * position;
+
+	switch (type)
+	{
+		case ResourceTypeEnum_TypeInteger:
+		case ResourceTypeEnum_TypeTime:
+			record.Type = SenMLValue_Integer;
+			if (valueLength == sizeof(int64_t))
+				memcpy(&record.Integer, value, sizeof(record.Integer));
+			else if (valueLength == sizeof(int32_t))
+				record.Integer = *(const int32_t *)value;
+			else
+				return -1;
+			break;
+
+		case ResourceTypeEnum_TypeFloat:
+			record.Type = SenMLValue_Float;
+			if (valueLength == sizeof(float))
+				record.Float = *(const float *)value;
+			else if (valueLength == sizeof(double))
+				record.Float = *(const double *)value;
+			else
+				return -1;
+			break;
+
+		case ResourceTypeEnum_TypeBoolean:
+			record.Type = SenMLValue_Boolean;
+			record.Integer = *(const bool *)value;
+			break;
+
+		case ResourceTypeEnum_TypeString:
+			record.Type = SenMLValue_String;
+			record.String = value;
+			break;
+
+		default:
+			Lwm2m_Error("SenML encoding of resource type %d is not supported\n", type);
+			return -1;
+	}
+
+	/* "<object>/<instance>/<resource>", without the cost of snprintf() on every record */
+	if (objectID < 0 || objectInstanceID < 0 || resourceID < 0)
+		return -1;
+	position = SenMLCbor_PutID(name, objectID);
+	*position++ = '/';
+	position = SenMLCbor_PutID(position, objectInstanceID);
+	*position++ = '/';
+	*SenMLCbor_PutID(position, resourceID) = '\0';
+	return SenMLCbor_AddRecord(encoder, name, timeMs, &record);
+}
+
+int SenMLCbor_Finish(SenMLCborEncoder * encoder)
+{
+	uint8_t end = CBOR_BREAK;
+
+	SenMLCbor_Put(encoder, &end, 1);
+	return encoder->Overflow ? -1 : encoder->Length;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file
+ * SenML-CBOR encoder for libobjects telemetry.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_SENML_CBOR_H_
+#define LWM2M_CLIENT_SENML_CBOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwm2m_core.h"
+
+/* Pass as timeMs to leave the time out of a record (it then means "now" to the receiver) */
+#define SENML_NO_TIME				INT64_MIN
+
+/*
+ * Streams SenML records into a fixed caller buffer, without heap allocation. Base name and base
+ * time go in the first record only, later records carry their name relative to the base name and
+ * their time as a (small) delta to the base time. A record that does not fit is left out whole and
+ * its Add call returns -1. The records before it can still be closed with SenMLCbor_Finish() and
+ * sent, and the rest go in a new payload.
+ */
+typedef struct
+{
+	uint8_t * Buffer;
+	int BufferLength;
+	int Length;
+	bool Overflow;
+	const char * BaseName;
+	int64_t BaseTimeMs;
+	int Records;
+} SenMLCborEncoder;
+
+void SenMLCbor_Init(SenMLCborEncoder * encoder, uint8_t * buffer, int bufferLength,
+	const char * baseName, int64_t baseTimeMs);
+
+int SenMLCbor_AddInteger(SenMLCborEncoder * encoder, const char * name, int64_t timeMs,
+	int64_t value);
+int SenMLCbor_AddFloat(SenMLCborEncoder * encoder, const char * name, int64_t timeMs,
+	double value);
+int SenMLCbor_AddBoolean(SenMLCborEncoder * encoder, const char * name, int64_t timeMs,
+	bool value);
+int SenMLCbor_AddString(SenMLCborEncoder * encoder, const char * name, int64_t timeMs,
+	const char * value);
+
+/* Adds a resource value as stored by the objects, named "<object>/<instance>/<resource>" */
+int SenMLCbor_AddResource(SenMLCborEncoder * encoder, ObjectIDType objectID,
+	ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID, ResourceTypeEnum type,
+	const void * value, int valueLength, int64_t timeMs);
+
+/* Closes the record array, returns the payload length or -1 if the buffer is too small for it */
+int SenMLCbor_Finish(SenMLCborEncoder * encoder);
+
+#endif /* LWM2M_CLIENT_SENML_CBOR_H_ */
@@ -0,0 +1,120 @@
+/**
+ * @file
+ * Sequence locks for libobjects instance records.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_SEQLOCK_H_
+#define LWM2M_CLIENT_SEQLOCK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Records guarded by their own lock are aligned to this so writers do not false-share */
+#define SEQLOCK_CACHE_LINE_SIZE			64
+
+#define SEQLOCK_ALIGNED					__attribute__((aligned(SEQLOCK_CACHE_LINE_SIZE)))
+
+/*
+ * Sequence lock. The sequence is odd while a writer is inside the record. Writers exclude each
+ * other; readers never block a writer. A reader copies what it needs and retries if the sequence
+ * moved while it was copying.
+ *
+ *	do
+ *	{
+ *		sequence = SeqLock_ReadBegin(&record->Lock);
+ *		snapshot = *record;
+ *	} while (SeqLock_ReadRetry(&record->Lock, sequence));
+ *
+ * A reader may also copy what the record points at, inside the same section, as long as a writer
+ * never frees it while readers run. Interned strings and cached TLV records are reused rather than
+ * freed for this, so StringTable_Copy() and Tlv_CopyCachedResource() are safe there; a copy a
+ * writer changed underneath is thrown away by the retry.
+ */
+typedef struct
+{
+	uint32_t Sequence;
+} SeqLock;
+
+/* Starts a write if the sequence is still the even value a reader saw, without waiting */
+static inline bool SeqLock_TryWriteBegin(SeqLock * lock, uint32_t sequence)
+{
+	if ((sequence & 1) != 0 || !__atomic_compare_exchange_n(&lock->Sequence, &sequence,
+		sequence + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return false;
+
+	/*
+	 * The acquire only keeps later accesses from moving above the CAS's load. On weakly ordered
+	 * CPUs the record stores that follow could become visible before the odd sequence, and a
+	 * reader could copy a half-written record yet see the old even sequence when it checks.
+	 */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	return true;
+}
+
+static inline void SeqLock_WriteBegin(SeqLock * lock)
+{
+	while (!SeqLock_TryWriteBegin(lock, __atomic_load_n(&lock->Sequence, __ATOMIC_RELAXED)))
+		;
+}
+
+static inline void SeqLock_WriteEnd(SeqLock * lock)
+{
+	__atomic_store_n(&lock->Sequence, lock->Sequence + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Ends a write section that changed nothing. The sequence goes back to the even value it had, so
+ * readers that overlapped the section retry at most once and a reader's later TryWriteBegin()
+ * still succeeds.
+ */
+static inline void SeqLock_WriteCancel(SeqLock * lock)
+{
+	__atomic_store_n(&lock->Sequence, lock->Sequence - 1, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t SeqLock_ReadBegin(const SeqLock * lock)
+{
+	uint32_t sequence;
+
+	while ((sequence = __atomic_load_n(&lock->Sequence, __ATOMIC_ACQUIRE)) & 1)
+		;
+	return sequence;
+}
+
+static inline bool SeqLock_ReadRetry(const SeqLock * lock, uint32_t sequence)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&lock->Sequence, __ATOMIC_RELAXED) != sequence;
+}
+
+#endif /* LWM2M_CLIENT_SEQLOCK_H_ */
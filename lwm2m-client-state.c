@@ -0,0 +1,439 @@
+/**
+ * @file
+ * LightWeightM2M per-client object state.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "lwm2m_core.h"
+#include "lwm2m-client-state.h"
+#include "lwm2m-client-seqlock.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define CLIENT_STATE_ALIGNMENT				SEQLOCK_CACHE_LINE_SIZE
+#define CLIENT_STATE_CHUNK_SIZE				4096
+#define CLIENT_STATE_INITIAL_BUCKETS		16
+
+#define CLIENT_STATE_ALIGN(size) \
+	(((size) + CLIENT_STATE_ALIGNMENT - 1) & ~(size_t)(CLIENT_STATE_ALIGNMENT - 1))
+
+#define CLIENT_STATE_CHUNK_HEADER_SIZE		CLIENT_STATE_ALIGN(sizeof(ClientStateChunk))
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+/* Arena memory is carved from chunks; the data follows the header, aligned to a cache line */
+typedef struct ClientStateChunk
+{
+	struct ClientStateChunk * Next;
+	size_t Size;
+	size_t Used;
+} ClientStateChunk;
+
+/* Everything one client owns, itself stored at the start of its first arena chunk */
+typedef struct
+{
+	Lwm2mContextType * Context;
+	ClientStateChunk * Chunks;
+	size_t ArenaSize;
+	void * Slots[ClientStateSlot_Count];
+	const ClientStateDefinition * Definitions[ClientStateSlot_Count];
+} ClientState;
+
+/* The context is kept in the bucket so probing never touches another client's state */
+typedef struct
+{
+	Lwm2mContextType * Context;
+	ClientState * Client;
+} ClientStateBucket;
+
+typedef struct ClientStateTable
+{
+	struct ClientStateTable * Retired;			/* Tables this one replaced */
+	int BucketCount;
+	ClientStateBucket Buckets[];
+} ClientStateTable;
+
+/*
+ * Maps core contexts to their state through an open-addressing hash table with linear probing.
+ * Lookups take no lock, so every object handler can call ClientState_Get(): they probe the
+ * published table inside a read section of Sequence and retry if a writer moved entries meanwhile.
+ * Creating or destroying a client or one of its state blocks serializes on Lock. A grown table
+ * replaces the old one, which is kept until the last client is destroyed, as a lookup may still
+ * be probing it.
+ */
+typedef struct
+{
+	pthread_mutex_t Lock;
+	SeqLock Sequence;
+	ClientStateTable * Table;
+	int Count;
+} ClientStateRegistry;
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+static ClientStateRegistry registry = { .Lock = PTHREAD_MUTEX_INITIALIZER };
+
+/***************************************************************************************************
+ * Implementation - Private
+ **************************************************************************************************/
+
+static uint32_t ClientState_Hash(const Lwm2mContextType * context)
+{
+	uintptr_t address = (uintptr_t)context;
+
+	return (uint32_t)(address >> 4 ^ (uint64_t)address >> 32) * 2654435761u;
+}
+
+/* Probes are bounded, as a lookup racing a writer may see a table that is briefly inconsistent */
+static int ClientState_FindBucket(const ClientStateTable * table, const Lwm2mContextType * context)
+{
+	const Lwm2mContextType * bucketContext;
+	int mask, bucket, probe;
+
+	if (table == NULL)
+		return -1;
+
+	mask = table->BucketCount - 1;
+	bucket = ClientState_Hash(context) & mask;
+	for (probe = 0; probe < table->BucketCount; probe++, bucket = (bucket + 1) & mask)
+	{
+		bucketContext = __atomic_load_n(&table->Buckets[bucket].Context, __ATOMIC_RELAXED);
+		if (bucketContext == context)
+			return bucket;
+		if (bucketContext == NULL)
+			break;
+	}
+	return -1;
+}
+
+/* Lock-free; a client is only dereferenced by its own context's users, so it cannot be freed */
+static ClientState * ClientState_Lookup(const Lwm2mContextType * context)
+{
+	ClientStateTable * table;
+	ClientState * client;
+	uint32_t sequence;
+	int bucket;
+
+	do
+	{
+		sequence = SeqLock_ReadBegin(&registry.Sequence);
+		table = __atomic_load_n(&registry.Table, __ATOMIC_ACQUIRE);
+		bucket = ClientState_FindBucket(table, context);
+		client = bucket == -1 ? NULL :
+			__atomic_load_n(&table->Buckets[bucket].Client, __ATOMIC_RELAXED);
+	} while (SeqLock_ReadRetry(&registry.Sequence, sequence));
+
+	return client;
+}
+
+/* Writers hold the registry lock, and the sequence for writing whenever readers can see table */
+static void ClientState_SetBucket(ClientStateTable * table, int bucket,
+	Lwm2mContextType * context, ClientState * client)
+{
+	__atomic_store_n(&table->Buckets[bucket].Client, client, __ATOMIC_RELAXED);
+	__atomic_store_n(&table->Buckets[bucket].Context, context, __ATOMIC_RELAXED);
+}
+
+static void ClientState_PlaceClient(ClientStateTable * table, ClientState * client)
+{
+	int mask = table->BucketCount - 1;
+	int bucket = ClientState_Hash(client->Context) & mask;
+
+	while (table->Buckets[bucket].Context != NULL)
+		bucket = (bucket + 1) & mask;
+	ClientState_SetBucket(table, bucket, client->Context, client);
+}
+
+/* Empties a bucket, shifting later entries of the same probe run back so no tombstone is needed */
+static void ClientState_RemoveBucket(ClientStateTable * table, int bucket)
+{
+	int mask = table->BucketCount - 1;
+	int next = bucket;
+
+	for (;;)
+	{
+		int home;
+
+		next = (next + 1) & mask;
+		if (table->Buckets[next].Context == NULL)
+			break;
+
+		home = ClientState_Hash(table->Buckets[next].Context) & mask;
+		if (((next - home) & mask) >= ((next - bucket) & mask))
+		{
+			ClientState_SetBucket(table, bucket, table->Buckets[next].Context,
+				table->Buckets[next].Client);
+			bucket = next;
+		}
+	}
+	ClientState_SetBucket(table, bucket, NULL, NULL);
+}
+
+/* Fills a larger table before publishing it; lookups still on the old one see it unchanged */
+static int ClientState_GrowBuckets(void)
+{
+	ClientStateTable * oldTable = registry.Table;
+	int oldBucketCount = oldTable == NULL ? 0 : oldTable->BucketCount;
+	int bucketCount = oldBucketCount == 0 ? CLIENT_STATE_INITIAL_BUCKETS : 2 * oldBucketCount;
+	ClientStateTable * table;
+	int i;
+
+	if ((table = calloc(1, sizeof(ClientStateTable) + bucketCount * sizeof(ClientStateBucket)))
+		== NULL)
+	{
+		return -1;
+	}
+	table->BucketCount = bucketCount;
+	table->Retired = oldTable;
+
+	for (i = 0; i < oldBucketCount; i++)
+	{
+		if (oldTable->Buckets[i].Context != NULL)
+			ClientState_PlaceClient(table, oldTable->Buckets[i].Client);
+	}
+	__atomic_store_n(&registry.Table, table, __ATOMIC_RELEASE);
+	return 0;
+}
+
+static ClientStateChunk * ClientState_NewChunk(size_t size)
+{
+	void * memory;
+	ClientStateChunk * chunk;
+
+	if (posix_memalign(&memory, CLIENT_STATE_ALIGNMENT, CLIENT_STATE_CHUNK_HEADER_SIZE + size) != 0)
+		return NULL;
+
+	chunk = memory;
+	chunk->Next = NULL;
+	chunk->Size = size;
+	chunk->Used = 0;
+	return chunk;
+}
+
+/*
+ * Bump allocates from the newest chunk. A block that does not fit in a fresh chunk gets a chunk of
+ * its own, linked behind the newest so the space left there is still used.
+ */
+static void * ClientState_ArenaAllocate(ClientState * client, size_t size)
+{
+	ClientStateChunk * chunk = client->Chunks;
+	void * block;
+
+	size = CLIENT_STATE_ALIGN(size);
+	if (chunk->Size - chunk->Used < size)
+	{
+		if ((chunk = ClientState_NewChunk(size > CLIENT_STATE_CHUNK_SIZE ? size :
+			CLIENT_STATE_CHUNK_SIZE)) == NULL)
+		{
+			return NULL;
+		}
+		client->ArenaSize += CLIENT_STATE_CHUNK_HEADER_SIZE + chunk->Size;
+
+		if (size > CLIENT_STATE_CHUNK_SIZE)
+		{
+			chunk->Next = client->Chunks->Next;
+			client->Chunks->Next = chunk;
+		}
+		else
+		{
+			chunk->Next = client->Chunks;
+			client->Chunks = chunk;
+		}
+	}
+
+	block = (uint8_t *)chunk + CLIENT_STATE_CHUNK_HEADER_SIZE + chunk->Used;
+	chunk->Used += size;
+	memset(block, 0, size);
+	return block;
+}
+
+/* Called with the registry lock held */
+static ClientState * ClientState_Create(Lwm2mContextType * context)
+{
+	ClientStateChunk * chunk;
+	ClientState * client;
+
+	if ((registry.Table == NULL || 2 * (registry.Count + 1) > registry.Table->BucketCount) &&
+		ClientState_GrowBuckets() == -1)
+	{
+		return NULL;
+	}
+
+	if ((chunk = ClientState_NewChunk(CLIENT_STATE_CHUNK_SIZE)) == NULL)
+		return NULL;
+
+	client = (ClientState *)((uint8_t *)chunk + CLIENT_STATE_CHUNK_HEADER_SIZE);
+	memset(client, 0, sizeof(ClientState));
+	chunk->Used = CLIENT_STATE_ALIGN(sizeof(ClientState));
+	client->Context = context;
+	client->Chunks = chunk;
+	client->ArenaSize = CLIENT_STATE_CHUNK_HEADER_SIZE + chunk->Size;
+
+	SeqLock_WriteBegin(&registry.Sequence);
+	ClientState_PlaceClient(registry.Table, client);
+	SeqLock_WriteEnd(&registry.Sequence);
+	registry.Count++;
+	return client;
+}
+
+/* Called with the registry lock held */
+static ClientState * ClientState_Find(const Lwm2mContextType * context)
+{
+	int bucket = ClientState_FindBucket(registry.Table, context);
+
+	return bucket == -1 ? NULL : registry.Table->Buckets[bucket].Client;
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+void * ClientState_Get(Lwm2mContextType * context, const ClientStateDefinition * definition)
+{
+	ClientState * client = ClientState_Lookup(context);
+	void * state = NULL;
+
+	if (client != NULL &&
+		(state = __atomic_load_n(&client->Slots[definition->Slot], __ATOMIC_ACQUIRE)) != NULL)
+	{
+		return state;
+	}
+
+	pthread_mutex_lock(&registry.Lock);
+	if ((client = ClientState_Find(context)) == NULL)
+		client = ClientState_Create(context);
+
+	if (client != NULL && (state = client->Slots[definition->Slot]) == NULL &&
+		(state = ClientState_ArenaAllocate(client, definition->Size)) != NULL)
+	{
+		if (definition->Initialise != NULL)
+			definition->Initialise(state);
+		client->Definitions[definition->Slot] = definition;
+		__atomic_store_n(&client->Slots[definition->Slot], state, __ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&registry.Lock);
+
+	if (state == NULL)
+		Lwm2m_Error("Out of memory for state %d of client %p\n", definition->Slot, context);
+	return state;
+}
+
+void * ClientState_Allocate(Lwm2mContextType * context, size_t size)
+{
+	ClientState * client;
+	void * block = NULL;
+
+	pthread_mutex_lock(&registry.Lock);
+	if ((client = ClientState_Find(context)) != NULL || (client = ClientState_Create(context)))
+		block = ClientState_ArenaAllocate(client, size);
+	pthread_mutex_unlock(&registry.Lock);
+	return block;
+}
+
+size_t ClientState_GetArenaSize(Lwm2mContextType * context)
+{
+	ClientState * client;
+	size_t size;
+
+	pthread_mutex_lock(&registry.Lock);
+	client = ClientState_Find(context);
+	size = client != NULL ? client->ArenaSize : 0;
+	pthread_mutex_unlock(&registry.Lock);
+	return size;
+}
+
+void ClientState_Destroy(Lwm2mContextType * context)
+{
+	ClientState * client = NULL;
+	ClientStateTable * retired = NULL;
+	ClientStateChunk * chunk;
+	int bucket, slot;
+
+	pthread_mutex_lock(&registry.Lock);
+	if ((bucket = ClientState_FindBucket(registry.Table, context)) != -1)
+	{
+		client = registry.Table->Buckets[bucket].Client;
+		SeqLock_WriteBegin(&registry.Sequence);
+		ClientState_RemoveBucket(registry.Table, bucket);
+		SeqLock_WriteEnd(&registry.Sequence);
+
+		if (--registry.Count == 0)
+		{
+			retired = registry.Table->Retired;
+			registry.Table->Retired = NULL;
+		}
+	}
+	pthread_mutex_unlock(&registry.Lock);
+
+	while (retired != NULL)
+	{
+		ClientStateTable * next = retired->Retired;
+
+		free(retired);
+		retired = next;
+	}
+
+	if (client == NULL)
+		return;
+
+	/* Cleanups run in reverse, as later objects may refer to earlier ones */
+	for (slot = ClientStateSlot_Count - 1; slot >= 0; slot--)
+	{
+		if (client->Slots[slot] != NULL && client->Definitions[slot]->Cleanup != NULL)
+			client->Definitions[slot]->Cleanup(client->Slots[slot]);
+	}
+
+	/* The client itself lives in one of the chunks, so it is not touched past this point */
+	chunk = client->Chunks;
+	while (chunk != NULL)
+	{
+		ClientStateChunk * next = chunk->Next;
+
+		free(chunk);
+		chunk = next;
+	}
+}
@@ -0,0 +1,91 @@
+/**
+ * @file
+ * LightWeightM2M per-client object state.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_STATE_H_
+#define LWM2M_CLIENT_STATE_H_
+
+#include <stddef.h>
+
+/* Objects that keep state for each client, one state block each */
+typedef enum
+{
+	ClientStateSlot_Flow,
+	ClientStateSlot_FlowAccess,
+	ClientStateSlot_DigitalInput,
+	ClientStateSlot_LightControl,
+	ClientStateSlot_Sensor,
+	ClientStateSlot_PowerMeasurement,
+	ClientStateSlot_ResourceVersion,
+	ClientStateSlot_OfflineQueue,
+	ClientStateSlot_Diagnostics,
+	ClientStateSlot_Count,
+} ClientStateSlot;
+
+/*
+ * Describes an object's state block. The block is zeroed, then Initialise (if set) runs once when
+ * it is first used. Cleanup (if set) releases anything the block owns outside the arena when the
+ * client is destroyed.
+ */
+typedef struct
+{
+	ClientStateSlot Slot;
+	size_t Size;
+	void (*Initialise)(void * state);
+	void (*Cleanup)(void * state);
+} ClientStateDefinition;
+
+/*
+ * Returns the state block of one object for the client owning context, allocating it from the
+ * client's arena the first time. Blocks are cache-line aligned and stay at the same address until
+ * ClientState_Destroy() is called. Returns NULL if memory runs out. Finding an existing block takes
+ * no lock.
+ */
+void * ClientState_Get(Lwm2mContextType * context, const ClientStateDefinition * definition);
+
+/* Allocates zeroed, cache-line aligned memory from the client's arena, freed with the client */
+void * ClientState_Allocate(Lwm2mContextType * context, size_t size);
+
+/* Bytes of arena the client has reserved, or 0 if it has no state */
+size_t ClientState_GetArenaSize(Lwm2mContextType * context);
+
+/*
+ * Cleans up every object's state for the client and frees its arena. Call it once the core
+ * context is finished with, while no other thread is using the client's objects. Destroying the
+ * last client also frees the lookup tables the registry has outgrown, so no other client may be
+ * created at the same time.
+ */
+void ClientState_Destroy(Lwm2mContextType * context);
+
+#endif /* LWM2M_CLIENT_STATE_H_ */
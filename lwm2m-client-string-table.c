@@ -0,0 +1,389 @@
+/**
+ * @file
+ * Interned strings shared by object instances.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "lwm2m-client-string-table.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define STRING_TABLE_PAGE_BITS				8
+#define STRING_TABLE_PAGE_SIZE				(1 << STRING_TABLE_PAGE_BITS)
+#define STRING_TABLE_PAGES					(1 << (16 - STRING_TABLE_PAGE_BITS))
+#define STRING_TABLE_INITIAL_BUCKETS		64
+
+/* Buffers come in power of two sizes, from 16 bytes up to 64K for the longest string */
+#define STRING_TABLE_MIN_BUFFER_BITS		4
+#define STRING_TABLE_BUFFER_CLASSES			(16 - STRING_TABLE_MIN_BUFFER_BITS + 1)
+
+/* Handle 0 never enters the hash table, so it marks empty buckets and the end of the free list */
+#define STRING_TABLE_EMPTY_BUCKET			STRING_HANDLE_EMPTY
+
+#define STRING_TABLE_ENTRY(handle) \
+	(&stringTable.Pages[(handle) >> STRING_TABLE_PAGE_BITS] \
+		[(handle) & (STRING_TABLE_PAGE_SIZE - 1)])
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef struct _StringTableBuffer
+{
+	int Capacity;
+	struct _StringTableBuffer * NextFree;
+	char String[];
+} StringTableBuffer;
+
+typedef struct
+{
+	StringTableBuffer * Buffer;
+	uint32_t Hash;
+	uint32_t References;
+	uint16_t Length;
+	StringHandle NextFree;
+} StringTableEntry;
+
+/*
+ * Entries sit in fixed pages that are never moved or freed, so resolving a handle takes no lock.
+ * Interning and releasing take the lock; strings are found by an open-addressing hash table of
+ * handles with linear probing. Freed handles are reused before new ones are taken. String buffers
+ * are kept on a free list for their size when released rather than freed, so a reader copying a
+ * string under a sequence lock never touches freed memory, only a string that may have changed.
+ */
+typedef struct
+{
+	pthread_mutex_t Lock;
+	StringTableEntry * Pages[STRING_TABLE_PAGES];
+	StringTableBuffer * FreeBuffers[STRING_TABLE_BUFFER_CLASSES];
+	StringHandle * Buckets;
+	int BucketCount;
+	int Count;
+	int NextHandle;
+	StringHandle FreeList;
+} StringTable;
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+static StringTable stringTable = { .Lock = PTHREAD_MUTEX_INITIALIZER, .NextHandle = 1 };
+
+/***************************************************************************************************
+ * Implementation - Private
+ **************************************************************************************************/
+
+/* FNV-1a */
+static uint32_t StringTable_Hash(const char * string, int length)
+{
+	uint32_t hash = 2166136261u;
+	int i;
+
+	for (i = 0; i < length; i++)
+		hash = (hash ^ (uint8_t)string[i]) * 16777619u;
+	return hash;
+}
+
+static int StringTable_FindBucket(const char * string, int length, uint32_t hash)
+{
+	int mask = stringTable.BucketCount - 1;
+	int bucket;
+
+	if (stringTable.BucketCount == 0)
+		return -1;
+
+	for (bucket = hash & mask; stringTable.Buckets[bucket] != STRING_TABLE_EMPTY_BUCKET;
+		bucket = (bucket + 1) & mask)
+	{
+		StringTableEntry * entry = STRING_TABLE_ENTRY(stringTable.Buckets[bucket]);
+
+		if (entry->Hash == hash && entry->Length == length &&
+			memcmp(entry->Buffer->String, string, length) == 0)
+		{
+			return bucket;
+		}
+	}
+	return -1;
+}
+
+static void StringTable_PlaceHandle(StringHandle handle)
+{
+	int mask = stringTable.BucketCount - 1;
+	int bucket = STRING_TABLE_ENTRY(handle)->Hash & mask;
+
+	while (stringTable.Buckets[bucket] != STRING_TABLE_EMPTY_BUCKET)
+		bucket = (bucket + 1) & mask;
+	stringTable.Buckets[bucket] = handle;
+}
+
+/* Empties a bucket, shifting later entries of the same probe run back so no tombstone is needed */
+static void StringTable_RemoveBucket(int bucket)
+{
+	int mask = stringTable.BucketCount - 1;
+	int next = bucket;
+
+	for (;;)
+	{
+		int home;
+
+		next = (next + 1) & mask;
+		if (stringTable.Buckets[next] == STRING_TABLE_EMPTY_BUCKET)
+			break;
+
+		home = STRING_TABLE_ENTRY(stringTable.Buckets[next])->Hash & mask;
+		if (((next - home) & mask) >= ((next - bucket) & mask))
+		{
+			stringTable.Buckets[bucket] = stringTable.Buckets[next];
+			bucket = next;
+		}
+	}
+	stringTable.Buckets[bucket] = STRING_TABLE_EMPTY_BUCKET;
+}
+
+static int StringTable_GrowBuckets(void)
+{
+	StringHandle * oldBuckets = stringTable.Buckets;
+	int oldBucketCount = stringTable.BucketCount;
+	int bucketCount = oldBucketCount == 0 ? STRING_TABLE_INITIAL_BUCKETS : 2 * oldBucketCount;
+	int i;
+
+	if ((stringTable.Buckets = calloc(bucketCount, sizeof(StringHandle))) == NULL)
+	{
+		stringTable.Buckets = oldBuckets;
+		return -1;
+	}
+	stringTable.BucketCount = bucketCount;
+
+	for (i = 0; i < oldBucketCount; i++)
+	{
+		if (oldBuckets[i] != STRING_TABLE_EMPTY_BUCKET)
+			StringTable_PlaceHandle(oldBuckets[i]);
+	}
+	free(oldBuckets);
+	return 0;
+}
+
+/* Takes a buffer with room for length bytes and a NUL off its free list, or allocates one */
+static StringTableBuffer * StringTable_NewBuffer(int length)
+{
+	int sizeClass = 0;
+	StringTableBuffer * buffer;
+
+	while ((1 << (sizeClass + STRING_TABLE_MIN_BUFFER_BITS)) < length + 1)
+		sizeClass++;
+
+	if ((buffer = stringTable.FreeBuffers[sizeClass]) != NULL)
+	{
+		stringTable.FreeBuffers[sizeClass] = buffer->NextFree;
+		return buffer;
+	}
+
+	buffer = malloc(sizeof(StringTableBuffer) + (1 << (sizeClass + STRING_TABLE_MIN_BUFFER_BITS)));
+	if (buffer != NULL)
+		buffer->Capacity = 1 << (sizeClass + STRING_TABLE_MIN_BUFFER_BITS);
+	return buffer;
+}
+
+static void StringTable_FreeBuffer(StringTableBuffer * buffer)
+{
+	int sizeClass = 0;
+
+	while ((1 << (sizeClass + STRING_TABLE_MIN_BUFFER_BITS)) < buffer->Capacity)
+		sizeClass++;
+
+	buffer->NextFree = stringTable.FreeBuffers[sizeClass];
+	stringTable.FreeBuffers[sizeClass] = buffer;
+}
+
+/* Takes a handle off the free list, or the next unused one, or returns -1 if all are taken */
+static int StringTable_NewHandle(void)
+{
+	int handle = stringTable.FreeList;
+	StringTableEntry ** page;
+
+	if (handle != STRING_HANDLE_EMPTY)
+	{
+		stringTable.FreeList = STRING_TABLE_ENTRY(handle)->NextFree;
+		return handle;
+	}
+
+	if (stringTable.NextHandle > UINT16_MAX)
+		return -1;
+
+	handle = stringTable.NextHandle;
+	page = &stringTable.Pages[handle >> STRING_TABLE_PAGE_BITS];
+	if (*page == NULL)
+	{
+		StringTableEntry * entries = calloc(STRING_TABLE_PAGE_SIZE, sizeof(StringTableEntry));
+
+		if (entries == NULL)
+			return -1;
+		__atomic_store_n(page, entries, __ATOMIC_RELEASE);
+	}
+	stringTable.NextHandle++;
+	return handle;
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+int StringTable_Intern(const char * string, int length)
+{
+	StringTableEntry * entry;
+	uint32_t hash;
+	int bucket, handle = -1;
+	StringTableBuffer * buffer;
+
+	length = strnlen(string, length);
+	if (length == 0)
+		return STRING_HANDLE_EMPTY;
+	if (length > UINT16_MAX)
+		return -1;
+
+	hash = StringTable_Hash(string, length);
+	pthread_mutex_lock(&stringTable.Lock);
+
+	if ((bucket = StringTable_FindBucket(string, length, hash)) != -1)
+	{
+		handle = stringTable.Buckets[bucket];
+		STRING_TABLE_ENTRY(handle)->References++;
+	}
+	else if ((2 * (stringTable.Count + 1) <= stringTable.BucketCount ||
+		StringTable_GrowBuckets() == 0) && (buffer = StringTable_NewBuffer(length)) != NULL)
+	{
+		if ((handle = StringTable_NewHandle()) == -1)
+		{
+			StringTable_FreeBuffer(buffer);
+		}
+		else
+		{
+			memcpy(buffer->String, string, length);
+			buffer->String[length] = '\0';
+
+			entry = STRING_TABLE_ENTRY(handle);
+			__atomic_store_n(&entry->Buffer, buffer, __ATOMIC_RELEASE);
+			__atomic_store_n(&entry->Length, length, __ATOMIC_RELAXED);
+			entry->Hash = hash;
+			entry->References = 1;
+			StringTable_PlaceHandle(handle);
+			stringTable.Count++;
+		}
+	}
+
+	pthread_mutex_unlock(&stringTable.Lock);
+	return handle;
+}
+
+void StringTable_Release(StringHandle handle)
+{
+	StringTableEntry * entry;
+
+	if (handle == STRING_HANDLE_EMPTY)
+		return;
+
+	pthread_mutex_lock(&stringTable.Lock);
+	entry = STRING_TABLE_ENTRY(handle);
+	if (--entry->References == 0)
+	{
+		StringTable_RemoveBucket(StringTable_FindBucket(entry->Buffer->String, entry->Length,
+			entry->Hash));
+		StringTable_FreeBuffer(entry->Buffer);
+		__atomic_store_n(&entry->Buffer, NULL, __ATOMIC_RELAXED);
+		__atomic_store_n(&entry->Length, 0, __ATOMIC_RELAXED);
+		entry->NextFree = stringTable.FreeList;
+		stringTable.FreeList = handle;
+		stringTable.Count--;
+	}
+	pthread_mutex_unlock(&stringTable.Lock);
+}
+
+int StringTable_Replace(StringHandle * handle, const char * string, int length)
+{
+	int result = StringTable_Intern(string, length);
+
+	if (result == -1)
+		return -1;
+
+	StringTable_Release(*handle);
+	*handle = result;
+	return 0;
+}
+
+const char * StringTable_Resolve(StringHandle handle)
+{
+	return handle == STRING_HANDLE_EMPTY ? "" : STRING_TABLE_ENTRY(handle)->Buffer->String;
+}
+
+int StringTable_GetLength(StringHandle handle)
+{
+	return handle == STRING_HANDLE_EMPTY ? 0 : STRING_TABLE_ENTRY(handle)->Length;
+}
+
+int StringTable_Copy(StringHandle handle, char * destBuffer, int destBufferLen)
+{
+	StringTableEntry * page;
+	StringTableBuffer * buffer = NULL;
+	int length = 0;
+
+	page = __atomic_load_n(&stringTable.Pages[handle >> STRING_TABLE_PAGE_BITS], __ATOMIC_ACQUIRE);
+	if (handle != STRING_HANDLE_EMPTY && page != NULL)
+	{
+		buffer = __atomic_load_n(&page[handle & (STRING_TABLE_PAGE_SIZE - 1)].Buffer,
+			__ATOMIC_ACQUIRE);
+		length = __atomic_load_n(&page[handle & (STRING_TABLE_PAGE_SIZE - 1)].Length,
+			__ATOMIC_RELAXED);
+	}
+
+	/* A handle or length read while the string was replaced may not match the buffer */
+	if (buffer == NULL)
+		length = 0;
+	else if (length >= buffer->Capacity)
+		length = buffer->Capacity - 1;
+	if (length >= destBufferLen)
+		length = destBufferLen - 1;
+
+	if (length > 0)
+		memcpy(destBuffer, buffer->String, length);
+	destBuffer[length] = '\0';
+	return length;
+}
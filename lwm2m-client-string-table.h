@@ -0,0 +1,81 @@
+/**
+ * @file
+ * Interned strings shared by object instances.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_STRING_TABLE_H_
+#define LWM2M_CLIENT_STRING_TABLE_H_
+
+#include <stdint.h>
+
+/*
+ * Instances keep string resources that rarely differ between them (Application Type, Colour,
+ * Units) as 16-bit handles into one process-wide table. Each distinct string is stored once with a
+ * reference count. Handle 0 is the empty string and holds no reference, so a zeroed instance
+ * needs no setup.
+ */
+typedef uint16_t StringHandle;
+
+#define STRING_HANDLE_EMPTY					0
+
+/*
+ * Returns a handle holding one reference to the string, adding it to the table if it is not there
+ * yet. The string ends at its first NUL or after length bytes. Returns -1 if memory runs out or
+ * the table is full.
+ */
+int StringTable_Intern(const char * string, int length);
+
+/* Drops one reference, freeing the string when it was the last */
+void StringTable_Release(StringHandle handle);
+
+/* Interns a new value and releases the old one, leaving handle untouched on failure */
+int StringTable_Replace(StringHandle * handle, const char * string, int length);
+
+/*
+ * Returns the NUL-terminated string of a handle in constant time. The pointer stays valid until
+ * the reference it was resolved through is released.
+ */
+const char * StringTable_Resolve(StringHandle handle);
+
+/* Length of the string of a handle, excluding the NUL */
+int StringTable_GetLength(StringHandle handle);
+
+/*
+ * Copies the string of a handle into destBuffer, cut to destBufferLen - 1 bytes and NUL-terminated,
+ * and returns its length. Needs no reference and no lock: buffers of released strings are reused
+ * but never freed, so a reader under a sequence lock can copy a string a writer may be replacing
+ * and retry when the sequence tells it the copy is stale.
+ */
+int StringTable_Copy(StringHandle handle, char * destBuffer, int destBufferLen);
+
+#endif /* LWM2M_CLIENT_STRING_TABLE_H_ */
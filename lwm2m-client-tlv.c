@@ -0,0 +1,245 @@
+/**
+ * @file
+ * OMA-TLV resource encoding for libobjects.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lwm2m_core.h"
+#include "lwm2m-client-tlv.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define TLV_TYPE_RESOURCE_VALUE			0xC0
+#define TLV_ID_16BIT					0x20
+#define TLV_LENGTH_8BIT					0x08
+#define TLV_LENGTH_16BIT				0x10
+#define TLV_LENGTH_24BIT				0x18
+
+#define TLV_MAX_HEADER_LENGTH			6
+
+/***************************************************************************************************
+ * Implementation - Private
+ **************************************************************************************************/
+
+static void Tlv_PutBigEndian(uint8_t * destBuffer, uint64_t value, int length)
+{
+	int i;
+
+	for (i = length - 1; i >= 0; i--)
+	{
+		destBuffer[i] = (uint8_t)value;
+		value >>= 8;
+	}
+}
+
+static int Tlv_IntegerLength(int64_t value)
+{
+	if (value >= INT8_MIN && value <= INT8_MAX)
+		return 1;
+	if (value >= INT16_MIN && value <= INT16_MAX)
+		return 2;
+	if (value >= INT32_MIN && value <= INT32_MAX)
+		return 4;
+	return 8;
+}
+
+/***************************************************************************************************
+ * Implementation - Public
+ **************************************************************************************************/
+
+int Tlv_EncodeResource(uint8_t * destBuffer, int destBufferLen, ResourceIDType resourceID,
+	ResourceTypeEnum type, const void * value, int valueLength)
+{
+	uint8_t header[TLV_MAX_HEADER_LENGTH];
+	int headerLength = 1;
+	int64_t integer = 0;
+	int length;
+
+	switch (type)
+	{
+		case ResourceTypeEnum_TypeInteger:
+		case ResourceTypeEnum_TypeTime:
+			if (valueLength == sizeof(int64_t))
+				memcpy(&integer, value, sizeof(integer));
+			else if (valueLength == sizeof(int32_t))
+				integer = *(const int32_t *)value;
+			else
+				return -1;
+			length = Tlv_IntegerLength(integer);
+			break;
+
+		case ResourceTypeEnum_TypeBoolean:
+			integer = *(const bool *)value ? 1 : 0;
+			length = 1;
+			break;
+
+		case ResourceTypeEnum_TypeString:
+			length = valueLength;
+			if (length > 0 && ((const char *)value)[length - 1] == '\0')
+				length--;
+			break;
+
+		default:
+			length = valueLength;
+			break;
+	}
+
+	header[0] = TLV_TYPE_RESOURCE_VALUE;
+	if (resourceID > 0xFF)
+	{
+		header[0] |= TLV_ID_16BIT;
+		Tlv_PutBigEndian(&header[headerLength], resourceID, 2);
+		headerLength += 2;
+	}
+	else
+	{
+		header[headerLength++] = (uint8_t)resourceID;
+	}
+
+	if (length < 8)
+	{
+		header[0] |= length;
+	}
+	else
+	{
+		int lengthBytes = length <= 0xFF ? 1 : length <= 0xFFFF ? 2 : 3;
+
+		header[0] |= lengthBytes == 1 ? TLV_LENGTH_8BIT :
+			lengthBytes == 2 ? TLV_LENGTH_16BIT : TLV_LENGTH_24BIT;
+		Tlv_PutBigEndian(&header[headerLength], length, lengthBytes);
+		headerLength += lengthBytes;
+	}
+
+	if (headerLength + length > destBufferLen)
+		return -1;
+
+	memcpy(destBuffer, header, headerLength);
+	destBuffer += headerLength;
+
+	switch (type)
+	{
+		case ResourceTypeEnum_TypeInteger:
+		case ResourceTypeEnum_TypeTime:
+		case ResourceTypeEnum_TypeBoolean:
+			Tlv_PutBigEndian(destBuffer, (uint64_t)integer, length);
+			break;
+
+		case ResourceTypeEnum_TypeFloat:
+		{
+			uint64_t bits = 0;
+
+			if (length == sizeof(float))
+			{
+				uint32_t bits32;
+				memcpy(&bits32, value, sizeof(bits32));
+				bits = bits32;
+			}
+			else if (length == sizeof(double))
+			{
+				memcpy(&bits, value, sizeof(bits));
+			}
+			else
+			{
+				return -1;
+			}
+			Tlv_PutBigEndian(destBuffer, bits, length);
+			break;
+		}
+
+		default:
+			if (length > 0)
+				memcpy(destBuffer, value, length);
+			break;
+	}
+
+	return headerLength + length;
+}
+
+int Tlv_EncodeCachedResource(TlvCachedResource * cache, uint8_t * destBuffer, int destBufferLen,
+	ResourceIDType resourceID, ResourceTypeEnum type, const void * value, int valueLength,
+	int maxValueLength)
+{
+	int length;
+
+	if (cache->Data == NULL && valueLength <= maxValueLength &&
+		(cache->Data = malloc(TLV_MAX_HEADER_LENGTH + maxValueLength)) != NULL)
+	{
+		cache->Capacity = TLV_MAX_HEADER_LENGTH + maxValueLength;
+	}
+
+	if (cache->Data == NULL || TLV_MAX_HEADER_LENGTH + valueLength > cache->Capacity)
+		return Tlv_EncodeResource(destBuffer, destBufferLen, resourceID, type, value, valueLength);
+
+	length = Tlv_EncodeResource(cache->Data, cache->Capacity, resourceID, type, value,
+		valueLength);
+	if (length == -1)
+	{
+		cache->Length = 0;
+		return -1;
+	}
+
+	cache->Length = length;
+	return Tlv_CopyCachedResource(cache, destBuffer, destBufferLen);
+}
+
+int Tlv_CopyCachedResource(const TlvCachedResource * cache, uint8_t * destBuffer,
+	int destBufferLen)
+{
+	if (cache->Length > destBufferLen)
+		return -1;
+
+	memcpy(destBuffer, cache->Data, cache->Length);
+	return cache->Length;
+}
+
+void Tlv_InvalidateCachedResource(TlvCachedResource * cache)
+{
+	cache->Length = 0;
+}
+
+void Tlv_FreeCachedResource(TlvCachedResource * cache)
+{
+	free(cache->Data);
+	cache->Data = NULL;
+	cache->Capacity = 0;
+	cache->Length = 0;
+}
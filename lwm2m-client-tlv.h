@@ -0,0 +1,90 @@
+/**
+ * @file
+ * OMA-TLV resource encoding for libobjects.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LWM2M_CLIENT_TLV_H_
+#define LWM2M_CLIENT_TLV_H_
+
+#include <stdint.h>
+#include "lwm2m_core.h"
+
+/* Identifier and type of a resource, listed in the order it is serialized */
+typedef struct
+{
+	ResourceIDType ResourceID;
+	ResourceTypeEnum Type;
+} TlvResourceType;
+
+/*
+ * Appends one resource value as an OMA-TLV "resource with value" record. The value is in the form
+ * the objects store it: host order integers and floats, strings with or without a trailing NUL.
+ * Returns the number of bytes written, or -1 if it does not fit in destBufferLen.
+ */
+int Tlv_EncodeResource(uint8_t * destBuffer, int destBufferLen, ResourceIDType resourceID,
+	ResourceTypeEnum type, const void * value, int valueLength);
+
+/*
+ * Encoded record of a resource that rarely changes. It holds a record while Length is above 0 and
+ * must be invalidated whenever the value is written. Only the objects' bulk *_ReadInstance()
+ * functions use it: the core's per-resource reads go through the Read handlers and encode every
+ * time. Data is allocated on the first encode with room for the longest value and is only freed by
+ * Tlv_FreeCachedResource(), so a reader under a sequence lock may copy it while a writer replaces
+ * the record.
+ */
+typedef struct
+{
+	uint8_t * Data;
+	int Capacity;
+	int Length;
+} TlvCachedResource;
+
+/*
+ * As Tlv_EncodeResource(), also keeping a copy of the record in cache. A value longer than
+ * maxValueLength, or longer than the one the cache was first sized for, is encoded but not cached.
+ */
+int Tlv_EncodeCachedResource(TlvCachedResource * cache, uint8_t * destBuffer, int destBufferLen,
+	ResourceIDType resourceID, ResourceTypeEnum type, const void * value, int valueLength,
+	int maxValueLength);
+
+/* Copies a cached record, returns its length or -1 if it does not fit in destBufferLen */
+int Tlv_CopyCachedResource(const TlvCachedResource * cache, uint8_t * destBuffer,
+	int destBufferLen);
+
+/* Drops the record, keeping the buffer for the next one */
+void Tlv_InvalidateCachedResource(TlvCachedResource * cache);
+
+/* Drops the record and frees the buffer, once no reader can be copying it */
+void Tlv_FreeCachedResource(TlvCachedResource * cache);
+
+#endif /* LWM2M_CLIENT_TLV_H_ */
@@ -0,0 +1,63 @@
+#!/bin/sh
+#
+# Reports the code size of each object and the size of its records, and checks them against
+# budgets. CC, CFLAGS, NM and SIZE come from the environment, so it works with cross toolchains;
+# record sizes are read from symbols that LWM2M_CLIENT_FOOTPRINT adds, without running anything.
+#
+# Usage: lwm2m-client-footprint.sh [-b budgets] source.c...
+#
+# A budgets file has one "<name> <bytes>" pair per line, where name is a source file without .c
+# (checked against text + data) or a record type such as IPSODigitalInput. Lines starting with #
+# are ignored. The exit status is 1 if anything is over budget.
+
+set -e
+
+budgets=
+if [ "$1" = "-b" ]; then
+	budgets=$2
+	shift 2
+fi
+
+CC=${CC:-cc}
+NM=${NM:-nm}
+SIZE=${SIZE:-size}
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+over=0
+
+# check <name> <bytes>
+check()
+{
+	if [ -n "$budgets" ]; then
+		limit=$(awk -v name="$1" '$1 == name { print $2 }' "$budgets")
+		if [ -n "$limit" ] && [ "$2" -gt "$limit" ]; then
+			echo "  $1 is $2 bytes, over its budget of $limit" >&2
+			over=1
+		fi
+	fi
+}
+
+printf '%-40s %8s %8s %8s\n' object text data bss
+for source in "$@"; do
+	name=$(basename "$source" .c)
+	$CC $CFLAGS -c "$source" -o "$work/$name.o"
+	$SIZE "$work/$name.o" | awk 'NR == 2 { print $1, $2, $3 }' > "$work/$name.size"
+	read text data bss < "$work/$name.size"
+	printf '%-40s %8d %8d %8d\n' "$name" "$text" "$data" "$bss"
+	check "$name" $((text + data))
+
+	$CC $CFLAGS -DLWM2M_CLIENT_FOOTPRINT -c "$source" -o "$work/$name.footprint.o"
+	$NM -S --defined-only "$work/$name.footprint.o" |
+		awk '$4 ~ /Footprint$/ { sub(/Footprint$/, "", $4); print $4, $2 }' >> "$work/records"
+done
+
+if [ -s "$work/records" ]; then
+	printf '\n%-40s %8s\n' record bytes
+	while read record size; do
+		printf '%-40s %8d\n' "$record" $((0x$size))
+		check "$record" $((0x$size))
+	done < "$work/records"
+fi
+
+exit $over
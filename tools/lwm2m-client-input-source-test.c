@@ -0,0 +1,490 @@
+/**
+ * @file
+ * LightWeightM2M Digital Input source test.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks lwm2m-client-digital-input-source.c against pipes and eventfds added with
+ * DigitalInputSources_AddRecords(). It feeds records split across writes, more records than fit
+ * in one read batch, records followed by a hang up, coalesced eventfd counts and records the
+ * decoder skips or rejects. It then checks what was decoded, what each poll applied, and the
+ * times the State history recorded, read and acknowledged by a second thread while the polls
+ * record into it. Any mismatch fails the run.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include "lwm2m_core.h"
+#include "lwm2m-client-ipso-digital-input.h"
+#include "lwm2m-client-digital-input-source.h"
+#include "lwm2m-client-history.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+/* Sequence, state and time offset, 32 bits each, so 4096 byte reads end mid-record */
+#define INPUT_SOURCE_TEST_RECORD_SIZE		12
+/* Records in one read, as DigitalInputSources_Poll() rounds its 4096 byte batch down */
+#define INPUT_SOURCE_TEST_BATCH_RECORDS		(4096 / INPUT_SOURCE_TEST_RECORD_SIZE)
+#define INPUT_SOURCE_TEST_MAX_RECORDS		1024
+#define INPUT_SOURCE_TEST_HISTORY_BLOCKS	128
+
+#define INPUT_SOURCE_TEST_BASE_TIME			1500000000000LL
+#define INPUT_SOURCE_TEST_TIME_STEP			10
+
+/* Record states the decoder does not apply */
+#define INPUT_SOURCE_TEST_SKIP				2
+#define INPUT_SOURCE_TEST_REJECT			3
+
+#define INPUT_SOURCE_TEST_CHECK(test, condition, ...)                                             \
+	do                                                                                            \
+	{                                                                                             \
+		if (!(condition))                                                                         \
+		{                                                                                         \
+			printf("%s: ", (test)->Name);                                                         \
+			printf(__VA_ARGS__);                                                                  \
+			printf("\n");                                                                         \
+			(test)->Failed = true;                                                                \
+			return;                                                                               \
+		}                                                                                         \
+	} while (0)
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef struct
+{
+	const char * Name;
+	Lwm2mContextType * Context;
+	DigitalInputSources * Sources;
+	bool Failed;
+	/* Sequence numbers in the order the decoder saw them */
+	uint32_t Decoded[INPUT_SOURCE_TEST_MAX_RECORDS];
+	int DecodedCount;
+	/* Samples the State history gave back */
+	int64_t SampleTimes[INPUT_SOURCE_TEST_MAX_RECORDS];
+	int64_t SampleValues[INPUT_SOURCE_TEST_MAX_RECORDS];
+	int SampleCount;
+} InputSourceTest;
+
+/* Drains a history while it is still attached to the instance recording into it */
+typedef struct
+{
+	InputSourceTest * Test;
+	ResourceHistory * History;
+	bool Done;
+} InputSourceTestReader;
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+static void InputSourceTest_EncodeRecord(uint8_t * record, uint32_t sequence, uint32_t state)
+{
+	uint32_t timeOffset = sequence * INPUT_SOURCE_TEST_TIME_STEP;
+
+	memcpy(record, &sequence, sizeof(sequence));
+	memcpy(record + 4, &state, sizeof(state));
+	memcpy(record + 8, &timeOffset, sizeof(timeOffset));
+}
+
+/* Even sequence numbers set the input and odd ones clear it, so every record is an edge */
+static uint32_t InputSourceTest_State(uint32_t sequence)
+{
+	return (sequence & 1) == 0;
+}
+
+static int InputSourceTest_DecodeRecord(void * decoderContext, const uint8_t * record,
+	bool * state, int64_t * timeMs)
+{
+	InputSourceTest * test = decoderContext;
+	uint32_t sequence, value, timeOffset;
+
+	memcpy(&sequence, record, sizeof(sequence));
+	memcpy(&value, record + 4, sizeof(value));
+	memcpy(&timeOffset, record + 8, sizeof(timeOffset));
+
+	if (test->DecodedCount < INPUT_SOURCE_TEST_MAX_RECORDS)
+		test->Decoded[test->DecodedCount++] = sequence;
+
+	if (value == INPUT_SOURCE_TEST_SKIP)
+		return 0;
+	if (value == INPUT_SOURCE_TEST_REJECT)
+		return -1;
+
+	*state = value != 0;
+	*timeMs = INPUT_SOURCE_TEST_BASE_TIME + timeOffset;
+	return 1;
+}
+
+/* An eventfd read yields the sum of every write since the last read; odd sums set the input */
+static int InputSourceTest_DecodeCount(void * decoderContext, const uint8_t * record,
+	bool * state, int64_t * timeMs)
+{
+	InputSourceTest * test = decoderContext;
+	uint64_t count;
+
+	memcpy(&count, record, sizeof(count));
+	if (test->DecodedCount < INPUT_SOURCE_TEST_MAX_RECORDS)
+		test->Decoded[test->DecodedCount++] = (uint32_t)count;
+	*state = (count & 1) != 0;
+	return 1;
+}
+
+static void InputSourceTest_AddSample(void * context, int64_t timeMs, int64_t value)
+{
+	InputSourceTest * test = context;
+
+	if (test->SampleCount < INPUT_SOURCE_TEST_MAX_RECORDS)
+	{
+		test->SampleTimes[test->SampleCount] = timeMs;
+		test->SampleValues[test->SampleCount++] = value;
+	}
+}
+
+/* Reads, decodes and acknowledges what the history holds, returns the number of bytes read */
+static int InputSourceTest_DrainHistory(InputSourceTest * test, ResourceHistory * history)
+{
+	uint8_t batch[INPUT_SOURCE_TEST_HISTORY_BLOCKS * 80];
+	uint32_t mark;
+	int length = ResourceHistory_Read(history, batch, sizeof(batch), &mark);
+
+	if (length > 0)
+	{
+		ResourceHistory_Decode(batch, length, ResourceHistoryEncoding_Xor,
+			InputSourceTest_AddSample, test);
+		ResourceHistory_Acknowledge(history, mark);
+	}
+	return length;
+}
+
+static void * InputSourceTest_ReaderThread(void * context)
+{
+	InputSourceTestReader * reader = context;
+
+	while (!__atomic_load_n(&reader->Done, __ATOMIC_ACQUIRE))
+		InputSourceTest_DrainHistory(reader->Test, reader->History);
+	return NULL;
+}
+
+/* Writes records first to first + count - 1, then length bytes of the record after them */
+static bool InputSourceTest_WriteRecords(int fd, uint32_t first, int count, int partialLength)
+{
+	static uint8_t buffer[(INPUT_SOURCE_TEST_MAX_RECORDS + 1) * INPUT_SOURCE_TEST_RECORD_SIZE];
+	int length = count * INPUT_SOURCE_TEST_RECORD_SIZE + partialLength;
+	int i;
+
+	for (i = 0; i <= count; i++)
+	{
+		InputSourceTest_EncodeRecord(buffer + i * INPUT_SOURCE_TEST_RECORD_SIZE, first + i,
+			InputSourceTest_State(first + i));
+	}
+	return write(fd, buffer, length) == length;
+}
+
+static bool InputSourceTest_OpenPipe(int fds[2])
+{
+	if (pipe(fds) == -1)
+		return false;
+	fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+	return true;
+}
+
+static void InputSourceTest_Begin(InputSourceTest * test, const char * name,
+	Lwm2mContextType * context)
+{
+	memset(test, 0, sizeof(*test));
+	test->Name = name;
+	test->Context = context;
+	test->Sources = DigitalInputSources_Create(context);
+}
+
+static bool InputSourceTest_End(InputSourceTest * test)
+{
+	DigitalInputSources_Destroy(test->Sources);
+	printf("%-16s %s\n", test->Name, test->Failed ? "FAILED" : "passed");
+	return !test->Failed;
+}
+
+/* A record split over several writes is applied once, when its last byte arrives */
+static void InputSourceTest_PartialRecords(InputSourceTest * test)
+{
+	uint8_t records[3 * INPUT_SOURCE_TEST_RECORD_SIZE];
+	int fds[2];
+	int applied, i;
+
+	INPUT_SOURCE_TEST_CHECK(test, test->Sources != NULL && InputSourceTest_OpenPipe(fds),
+		"no pipe");
+	INPUT_SOURCE_TEST_CHECK(test, DigitalInputSources_AddRecords(test->Sources, fds[0],
+		INPUT_SOURCE_TEST_RECORD_SIZE, InputSourceTest_DecodeRecord, test, 0) == 0,
+		"AddRecords failed");
+
+	for (i = 0; i < 3; i++)
+	{
+		InputSourceTest_EncodeRecord(records + i * INPUT_SOURCE_TEST_RECORD_SIZE, i,
+			InputSourceTest_State(i));
+	}
+
+	/* 5 bytes, then the other 7 with all of record 1 and 3 bytes of record 2, then the rest */
+	INPUT_SOURCE_TEST_CHECK(test, write(fds[1], records, 5) == 5, "write failed");
+	applied = DigitalInputSources_Poll(test->Sources, 0);
+	INPUT_SOURCE_TEST_CHECK(test, applied == 0 && test->DecodedCount == 0,
+		"applied %d of a 5 byte fragment", applied);
+
+	INPUT_SOURCE_TEST_CHECK(test, write(fds[1], records + 5, 22) == 22, "write failed");
+	applied = DigitalInputSources_Poll(test->Sources, 0);
+	INPUT_SOURCE_TEST_CHECK(test, applied == 2, "applied %d of 2 completed records", applied);
+
+	INPUT_SOURCE_TEST_CHECK(test, write(fds[1], records + 27, 9) == 9, "write failed");
+	applied = DigitalInputSources_Poll(test->Sources, 0);
+	INPUT_SOURCE_TEST_CHECK(test, applied == 1, "applied %d of the last record", applied);
+
+	INPUT_SOURCE_TEST_CHECK(test, test->DecodedCount == 3 && test->Decoded[0] == 0 &&
+		test->Decoded[1] == 1 && test->Decoded[2] == 2, "decoded %d records out of order",
+		test->DecodedCount);
+
+	DigitalInputSources_Remove(test->Sources, fds[0]);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+/*
+ * More records than one read takes are applied over several polls, a full batch each, in order,
+ * and the State history keeps the time each record carried rather than the time it was read. The
+ * history is read and acknowledged by another thread while the polls record into it.
+ */
+static void InputSourceTest_Batches(InputSourceTest * test)
+{
+	const int count = 1000;
+	ResourceHistory * history = ResourceHistory_Create(INPUT_SOURCE_TEST_HISTORY_BLOCKS,
+		ResourceHistoryEncoding_Xor);
+	InputSourceTestReader reader = { .Test = test, .History = history };
+	pthread_t thread;
+	int fds[2];
+	int applied, expected, total = 0, polls = 0, i;
+
+	INPUT_SOURCE_TEST_CHECK(test, history != NULL && test->Sources != NULL &&
+		InputSourceTest_OpenPipe(fds), "no pipe or history");
+	INPUT_SOURCE_TEST_CHECK(test, DigitalInput_EnableHistory(test->Context, 1, 5500, history) == 0,
+		"EnableHistory failed");
+	INPUT_SOURCE_TEST_CHECK(test, DigitalInputSources_AddRecords(test->Sources, fds[0],
+		INPUT_SOURCE_TEST_RECORD_SIZE, InputSourceTest_DecodeRecord, test, 1) == 0,
+		"AddRecords failed");
+	INPUT_SOURCE_TEST_CHECK(test, InputSourceTest_WriteRecords(fds[1], 0, count, 0),
+		"write failed");
+	INPUT_SOURCE_TEST_CHECK(test,
+		pthread_create(&thread, NULL, InputSourceTest_ReaderThread, &reader) == 0,
+		"no reader thread");
+
+	while (total < count)
+	{
+		expected = count - total < INPUT_SOURCE_TEST_BATCH_RECORDS ? count - total :
+			INPUT_SOURCE_TEST_BATCH_RECORDS;
+		applied = DigitalInputSources_Poll(test->Sources, 0);
+		INPUT_SOURCE_TEST_CHECK(test, applied == expected, "poll %d applied %d, expected %d",
+			polls, applied, expected);
+		total += applied;
+		polls++;
+	}
+	__atomic_store_n(&reader.Done, true, __ATOMIC_RELEASE);
+	pthread_join(thread, NULL);
+
+	for (i = 0; i < count; i++)
+	{
+		INPUT_SOURCE_TEST_CHECK(test, test->Decoded[i] == (uint32_t)i,
+			"record %d decoded as %" PRIu32, i, test->Decoded[i]);
+	}
+
+	InputSourceTest_DrainHistory(test, history);
+	INPUT_SOURCE_TEST_CHECK(test, ResourceHistory_GetDropped(history) == 0 &&
+		test->SampleCount == count, "history kept %d of %d edges", test->SampleCount, count);
+	for (i = 0; i < count; i++)
+	{
+		INPUT_SOURCE_TEST_CHECK(test, test->SampleTimes[i] == INPUT_SOURCE_TEST_BASE_TIME +
+			i * INPUT_SOURCE_TEST_TIME_STEP && test->SampleValues[i] == InputSourceTest_State(i),
+			"edge %d recorded at %" PRId64 " as %" PRId64, i, test->SampleTimes[i],
+			test->SampleValues[i]);
+	}
+
+	DigitalInput_EnableHistory(test->Context, 1, 5500, NULL);
+	ResourceHistory_Destroy(history);
+	DigitalInputSources_Remove(test->Sources, fds[0]);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+/*
+ * Records still buffered when the writer hangs up are all applied before the source is dropped.
+ * The trailing fragment of a record is discarded without being decoded.
+ */
+static void InputSourceTest_HangUp(InputSourceTest * test)
+{
+	const int count = 500;
+	int fds[2];
+	int applied, total = 0, polls = 0;
+
+	INPUT_SOURCE_TEST_CHECK(test, test->Sources != NULL && InputSourceTest_OpenPipe(fds),
+		"no pipe");
+	INPUT_SOURCE_TEST_CHECK(test, DigitalInputSources_AddRecords(test->Sources, fds[0],
+		INPUT_SOURCE_TEST_RECORD_SIZE, InputSourceTest_DecodeRecord, test, 0) == 0,
+		"AddRecords failed");
+	INPUT_SOURCE_TEST_CHECK(test, InputSourceTest_WriteRecords(fds[1], 0, count, 7),
+		"write failed");
+	close(fds[1]);
+
+	/* The last poll reads end of file and drops the source */
+	while ((applied = DigitalInputSources_Poll(test->Sources, 0)) > 0 && polls++ < count)
+		total += applied;
+
+	INPUT_SOURCE_TEST_CHECK(test, applied == 0 && total == count,
+		"applied %d of %d records before the hang up", total, count);
+	INPUT_SOURCE_TEST_CHECK(test, test->DecodedCount == count,
+		"decoded %d records, expected %d", test->DecodedCount, count);
+	INPUT_SOURCE_TEST_CHECK(test, DigitalInputSources_Remove(test->Sources, fds[0]) == -1,
+		"source was not dropped after the hang up");
+	close(fds[0]);
+}
+
+/* Writes to an eventfd between polls coalesce into one record holding their sum */
+static void InputSourceTest_Eventfd(InputSourceTest * test)
+{
+	uint64_t one = 1, two = 2;
+	int fd = eventfd(0, EFD_NONBLOCK);
+	int applied;
+
+	INPUT_SOURCE_TEST_CHECK(test, fd != -1 && test->Sources != NULL, "no eventfd");
+	INPUT_SOURCE_TEST_CHECK(test, DigitalInputSources_AddRecords(test->Sources, fd,
+		sizeof(uint64_t), InputSourceTest_DecodeCount, test, 0) == 0, "AddRecords failed");
+
+	INPUT_SOURCE_TEST_CHECK(test, write(fd, &one, sizeof(one)) == sizeof(one), "write failed");
+	applied = DigitalInputSources_Poll(test->Sources, 0);
+	INPUT_SOURCE_TEST_CHECK(test, applied == 1 && test->DecodedCount == 1 &&
+		test->Decoded[0] == 1, "applied %d for one write", applied);
+
+	INPUT_SOURCE_TEST_CHECK(test, write(fd, &two, sizeof(two)) == sizeof(two) &&
+		write(fd, &one, sizeof(one)) == sizeof(one), "write failed");
+	applied = DigitalInputSources_Poll(test->Sources, 0);
+	INPUT_SOURCE_TEST_CHECK(test, applied == 1 && test->DecodedCount == 2 &&
+		test->Decoded[1] == 3, "applied %d for two coalesced writes", applied);
+
+	applied = DigitalInputSources_Poll(test->Sources, 0);
+	INPUT_SOURCE_TEST_CHECK(test, applied == 0, "applied %d with nothing written", applied);
+
+	DigitalInputSources_Remove(test->Sources, fd);
+	close(fd);
+}
+
+/*
+ * Skipped records are not applied. A rejected record drops the source with the rest of its batch,
+ * but the records before it in the batch stay applied.
+ */
+static void InputSourceTest_Decoder(InputSourceTest * test)
+{
+	const uint32_t states[] = { 1, INPUT_SOURCE_TEST_SKIP, 0, INPUT_SOURCE_TEST_REJECT, 1 };
+	uint8_t records[sizeof(states) / sizeof(states[0]) * INPUT_SOURCE_TEST_RECORD_SIZE];
+	int fds[2];
+	int applied, i;
+
+	INPUT_SOURCE_TEST_CHECK(test, test->Sources != NULL && InputSourceTest_OpenPipe(fds),
+		"no pipe");
+	INPUT_SOURCE_TEST_CHECK(test, DigitalInputSources_AddRecords(test->Sources, fds[0],
+		INPUT_SOURCE_TEST_RECORD_SIZE, InputSourceTest_DecodeRecord, test, 0) == 0,
+		"AddRecords failed");
+
+	for (i = 0; i < sizeof(states) / sizeof(states[0]); i++)
+		InputSourceTest_EncodeRecord(records + i * INPUT_SOURCE_TEST_RECORD_SIZE, i, states[i]);
+	INPUT_SOURCE_TEST_CHECK(test, write(fds[1], records, sizeof(records)) == sizeof(records),
+		"write failed");
+
+	applied = DigitalInputSources_Poll(test->Sources, 0);
+	INPUT_SOURCE_TEST_CHECK(test, applied == 2 && test->DecodedCount == 4,
+		"applied %d and decoded %d records up to the rejected one", applied,
+		test->DecodedCount);
+	INPUT_SOURCE_TEST_CHECK(test, DigitalInputSources_Remove(test->Sources, fds[0]) == -1,
+		"source was not dropped after its decoder rejected a record");
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+int main(int argc, char ** argv)
+{
+	static InputSourceTest test;
+	Lwm2mContextType * context;
+	bool passed = true;
+
+	if ((context = Lwm2mCore_Init(NULL, "inputsourcetest")) == NULL ||
+		DigitalInput_RegisterDigitalInputObject(context) == -1 ||
+		DigitalInput_AddDigitalInputs(context, 0, 2) == -1)
+	{
+		fprintf(stderr, "Failed to set up Digital Input instances\n");
+		return 1;
+	}
+
+	InputSourceTest_Begin(&test, "partial records", context);
+	InputSourceTest_PartialRecords(&test);
+	passed &= InputSourceTest_End(&test);
+
+	InputSourceTest_Begin(&test, "batches", context);
+	InputSourceTest_Batches(&test);
+	passed &= InputSourceTest_End(&test);
+
+	InputSourceTest_Begin(&test, "hang up", context);
+	InputSourceTest_HangUp(&test);
+	passed &= InputSourceTest_End(&test);
+
+	InputSourceTest_Begin(&test, "eventfd", context);
+	InputSourceTest_Eventfd(&test);
+	passed &= InputSourceTest_End(&test);
+
+	InputSourceTest_Begin(&test, "decoder", context);
+	InputSourceTest_Decoder(&test);
+	passed &= InputSourceTest_End(&test);
+
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
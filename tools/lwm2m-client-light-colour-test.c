@@ -0,0 +1,228 @@
+/**
+ * @file
+ * LightWeightM2M Light Control colour test.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Checks LightColour_Parse() in lwm2m-client-light-colour.c: every accepted format, names with
+ * trailing numbers, malformed and out of range strings falling back to white, and the HSV, xy and
+ * duty values worked out alongside RGB. Any mismatch fails the run.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lwm2m-client-light-colour.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+/* RGB worked out from hsv() and xy() may round either way */
+#define LIGHT_COLOUR_TEST_RGB_TOLERANCE		1
+#define LIGHT_COLOUR_TEST_FLOAT_TOLERANCE	0.002f
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef struct
+{
+	const char * String;
+	int Result;
+	LightColourModel Model;
+	uint8_t Red;
+	uint8_t Green;
+	uint8_t Blue;
+} LightColourTestCase;
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+static const LightColourTestCase lightColourTestCases[] =
+{
+	{ "#FF8000", 0, LightColourModel_RGB, 255, 128, 0 },
+	{ "#ff8000", 0, LightColourModel_RGB, 255, 128, 0 },
+	{ "  #F80 ", 0, LightColourModel_RGB, 255, 136, 0 },
+	{ "rgb(12, 34, 56)", 0, LightColourModel_RGB, 12, 34, 56 },
+	{ "RGB( 0 ,255, 0 )", 0, LightColourModel_RGB, 0, 255, 0 },
+	{ "hsv(0, 100, 100)", 0, LightColourModel_HSV, 255, 0, 0 },
+	{ "hsv(120, 100%, 50%)", 0, LightColourModel_HSV, 0, 128, 0 },
+	{ "hsv(360, 0, 100)", 0, LightColourModel_HSV, 255, 255, 255 },
+	{ "xy(0.3127, 0.3290)", 0, LightColourModel_XY, 255, 255, 255 },
+	{ "Red1", 0, LightColourModel_RGB, 255, 0, 0 },
+	{ "red", 0, LightColourModel_RGB, 255, 0, 0 },
+	{ "Warm White 2", 0, LightColourModel_RGB, 255, 180, 107 },
+	{ "BLACK", 0, LightColourModel_RGB, 0, 0, 0 },
+	{ "", -1, LightColourModel_Unknown, 255, 255, 255 },
+	{ "#GG0000", -1, LightColourModel_Unknown, 255, 255, 255 },
+	{ "#FF80", -1, LightColourModel_Unknown, 255, 255, 255 },
+	{ "#FF8000 x", -1, LightColourModel_Unknown, 255, 255, 255 },
+	{ "rgb(256, 0, 0)", -1, LightColourModel_Unknown, 255, 255, 255 },
+	{ "rgb(1, 2)", -1, LightColourModel_Unknown, 255, 255, 255 },
+	{ "hsv(0, 101, 0)", -1, LightColourModel_Unknown, 255, 255, 255 },
+	{ "xy(0.7, 0.4)", -1, LightColourModel_Unknown, 255, 255, 255 },
+	{ "xy(0.3, 0)", -1, LightColourModel_Unknown, 255, 255, 255 },
+	{ "redish", -1, LightColourModel_Unknown, 255, 255, 255 },
+	{ "Some colour", -1, LightColourModel_Unknown, 255, 255, 255 },
+};
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+static bool LightColourTest_Near(int value, int expected, int tolerance)
+{
+	return value >= expected - tolerance && value <= expected + tolerance;
+}
+
+static bool LightColourTest_NearFloat(float value, float expected)
+{
+	return value >= expected - LIGHT_COLOUR_TEST_FLOAT_TOLERANCE &&
+		value <= expected + LIGHT_COLOUR_TEST_FLOAT_TOLERANCE;
+}
+
+/* Every case parses to its result, model and RGB */
+static bool LightColourTest_Formats(void)
+{
+	const int caseCount = sizeof(lightColourTestCases) / sizeof(lightColourTestCases[0]);
+	bool passed = true;
+	int i;
+
+	for (i = 0; i < caseCount; i++)
+	{
+		const LightColourTestCase * testCase = &lightColourTestCases[i];
+		int tolerance = testCase->Model == LightColourModel_HSV ||
+			testCase->Model == LightColourModel_XY ? LIGHT_COLOUR_TEST_RGB_TOLERANCE : 0;
+		LightColour colour;
+		int result = LightColour_Parse(testCase->String, &colour);
+
+		if (result != testCase->Result || colour.Model != testCase->Model ||
+			!LightColourTest_Near(colour.Red, testCase->Red, tolerance) ||
+			!LightColourTest_Near(colour.Green, testCase->Green, tolerance) ||
+			!LightColourTest_Near(colour.Blue, testCase->Blue, tolerance))
+		{
+			printf("formats: \"%s\" gave %d, model %d, RGB %d %d %d\n", testCase->String, result,
+				colour.Model, colour.Red, colour.Green, colour.Blue);
+			passed = false;
+		}
+	}
+	return passed;
+}
+
+/* HSV, xy and duties are worked out from whichever model the string was in */
+static bool LightColourTest_Models(void)
+{
+	LightColour colour;
+
+	LightColour_Parse("#0000FF", &colour);
+	if (!LightColourTest_NearFloat(colour.Hue, 240) ||
+		!LightColourTest_NearFloat(colour.Saturation, 1) ||
+		!LightColourTest_NearFloat(colour.Value, 1))
+	{
+		printf("models: blue has HSV %.1f %.3f %.3f\n", colour.Hue, colour.Saturation,
+			colour.Value);
+		return false;
+	}
+	if (colour.Duty[LightColourChannel_Red] != 0 || colour.Duty[LightColourChannel_Green] != 0 ||
+		colour.Duty[LightColourChannel_Blue] != 65535)
+	{
+		printf("models: blue has duties %d %d %d\n", colour.Duty[LightColourChannel_Red],
+			colour.Duty[LightColourChannel_Green], colour.Duty[LightColourChannel_Blue]);
+		return false;
+	}
+
+	/* sRGB mid grey is about 21.6% linear light */
+	LightColour_Parse("#808080", &colour);
+	if (!LightColourTest_Near(colour.Duty[LightColourChannel_Red], 14146, 64) ||
+		colour.Duty[LightColourChannel_Green] != colour.Duty[LightColourChannel_Red] ||
+		colour.Duty[LightColourChannel_Blue] != colour.Duty[LightColourChannel_Red])
+	{
+		printf("models: mid grey has duties %d %d %d\n", colour.Duty[LightColourChannel_Red],
+			colour.Duty[LightColourChannel_Green], colour.Duty[LightColourChannel_Blue]);
+		return false;
+	}
+
+	/* White and black both sit at the D65 white point */
+	LightColour_Parse("white", &colour);
+	if (!LightColourTest_NearFloat(colour.X, 0.3127f) ||
+		!LightColourTest_NearFloat(colour.Y, 0.3290f))
+	{
+		printf("models: white at xy %.4f %.4f\n", colour.X, colour.Y);
+		return false;
+	}
+	LightColour_Parse("black", &colour);
+	if (!LightColourTest_NearFloat(colour.X, 0.3127f) ||
+		!LightColourTest_NearFloat(colour.Y, 0.3290f))
+	{
+		printf("models: black at xy %.4f %.4f\n", colour.X, colour.Y);
+		return false;
+	}
+
+	/* xy() keeps the chromaticity it was given and drives the brightest channel fully */
+	LightColour_Parse("xy(0.64, 0.33)", &colour);
+	if (!LightColourTest_NearFloat(colour.X, 0.64f) ||
+		!LightColourTest_NearFloat(colour.Y, 0.33f) ||
+		colour.Duty[LightColourChannel_Red] != 65535 || colour.Red != 255)
+	{
+		printf("models: sRGB red primary gave RGB %d %d %d, duty %d\n", colour.Red, colour.Green,
+			colour.Blue, colour.Duty[LightColourChannel_Red]);
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char ** argv)
+{
+	bool passed = true;
+	bool result;
+
+	result = LightColourTest_Formats();
+	printf("%-16s %s\n", "formats", result ? "passed" : "FAILED");
+	passed &= result;
+
+	result = LightColourTest_Models();
+	printf("%-16s %s\n", "models", result ? "passed" : "FAILED");
+	passed &= result;
+
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file
+ * Generates the lookup tables in lwm2m-client-light-tables.h.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Prints lwm2m-client-light-tables.h, so the objects convert colours and Dimmer values without
+ * floating-point powers at run time or linking the maths library. Build it from
+ * Makefile.lighttables and rerun it after changing a table:
+ *
+ *     lwm2m-client-light-tables > lwm2m-client-light-tables.h
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include "lwm2m-client-light-dimming.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define TABLES_PER_LINE						8
+#define TABLES_DIMMER_LEVELS				101
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/* The sRGB transfer function, from an encoded value to linear light, both 0 to 1 */
+static double LightTables_SrgbToLinear(double value)
+{
+	return value <= 0.04045 ? value / 12.92 : pow((value + 0.055) / 1.055, 2.4);
+}
+
+/* Relative luminance for a CIE 1931 (L*) lightness of dimmer, so equal steps look equal */
+static double LightTables_CieLightness(double dimmer)
+{
+	return dimmer > 8 ? pow((dimmer + 16) / 116, 3) : dimmer * 27 / 24389;
+}
+
+static double LightTables_Dimming(LightDimmingCurve curve, int dimmer)
+{
+	switch (curve)
+	{
+		case LightDimmingCurve_Gamma22:
+			return pow(dimmer / 100.0, 2.2);
+		case LightDimmingCurve_CieLightness:
+			return LightTables_CieLightness(dimmer);
+		default:
+			return dimmer / 100.0;
+	}
+}
+
+static void LightTables_PrintTable(const char * comment, const char * name, const uint16_t * values,
+	int count)
+{
+	int i;
+
+	printf("\n/* %s */\nstatic const uint16_t %s[%d] =\n{", comment, name, count);
+	for (i = 0; i < count; i++)
+		printf("%s%5u,", i % TABLES_PER_LINE == 0 ? "\n\t" : " ", values[i]);
+	printf("\n};\n");
+}
+
+static void LightTables_PrintDimming(const char * name, int bits)
+{
+	LightDimmingCurve curve;
+	int dimmer;
+
+	printf("\n/* PWM values at %d bits for each Dimmer, by LightDimmingCurve */\n", bits);
+	printf("static const uint16_t %s[%d][%d] =\n{", name, LightDimmingCurve_Count,
+		TABLES_DIMMER_LEVELS);
+	for (curve = 0; curve < LightDimmingCurve_Count; curve++)
+	{
+		printf("\n\t{");
+		for (dimmer = 0; dimmer < TABLES_DIMMER_LEVELS; dimmer++)
+		{
+			printf("%s%5ld,", dimmer % TABLES_PER_LINE == 0 ? "\n\t\t" : " ",
+				lround(LightTables_Dimming(curve, dimmer) * ((1 << bits) - 1)));
+		}
+		printf("\n\t},");
+	}
+	printf("\n};\n");
+}
+
+int main(void)
+{
+	uint16_t srgb[256];
+	int i;
+
+	for (i = 0; i < 256; i++)
+		srgb[i] = (uint16_t)lround(LightTables_SrgbToLinear(i / 255.0) * 65535);
+
+	printf("/* Generated by tools/lwm2m-client-light-tables.c; do not edit */\n\n");
+	printf("#ifndef LWM2M_CLIENT_LIGHT_TABLES_H_\n#define LWM2M_CLIENT_LIGHT_TABLES_H_\n\n");
+	printf("#include <stdint.h>\n");
+
+	LightTables_PrintTable("Linear light, 0 to 65535, of each 8-bit sRGB channel value",
+		"lightSrgbToLinear", srgb, 256);
+	LightTables_PrintDimming("lightDimming12", 12);
+	LightTables_PrintDimming("lightDimming16", 16);
+
+	printf("\n#endif /* LWM2M_CLIENT_LIGHT_TABLES_H_ */\n");
+	return 0;
+}
@@ -0,0 +1,1008 @@
+/**
+ * @file
+ * LightWeightM2M virtual device load generator.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Runs many virtual clients in one process. Each registers the Flow, Flow Access, Digital Input
+ * and Light Control objects. It then presses buttons and toggles lights at random (Poisson) times
+ * and reports every change to a CoAP server as a confirmable message. A stand-in server on the
+ * loopback interface acknowledges them unless another server is given. All clients share one
+ * epoll loop, so the number of clients is limited by file descriptors and memory rather than
+ * threads.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <time.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "lwm2m_core.h"
+#include "lwm2m-client-flow-object.h"
+#include "lwm2m-client-flow-access-object.h"
+#include "lwm2m-client-ipso-digital-input.h"
+#include "lwm2m-client-ipso-light-control.h"
+#include "lwm2m-client-senml-cbor.h"
+#include "lwm2m-client-state.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define LOADGEN_DEFAULT_CLIENTS				1000
+#define LOADGEN_DEFAULT_DURATION			10
+#define LOADGEN_DEFAULT_BUTTON_RATE			0.2
+#define LOADGEN_DEFAULT_LIGHT_RATE			0.1
+#define LOADGEN_DEFAULT_TIMEOUT_MS			2000
+
+#define LOADGEN_MAX_OUTSTANDING				4
+#define LOADGEN_MAX_MESSAGE					512
+#define LOADGEN_MAX_PAYLOAD					256
+#define LOADGEN_EPOLL_EVENTS				256
+#define LOADGEN_SERVER_BATCH				64
+#define LOADGEN_SCAN_INTERVAL_US			50000
+#define LOADGEN_REPORT_INTERVAL_US			1000000
+#define LOADGEN_SERVER_BUFFER_SIZE			(4 * 1024 * 1024)
+
+#define DIGITAL_INPUT_OBJECT				3200
+#define DIGITAL_INPUT_EDGE_SELECTION		5504
+#define DIGITAL_INPUT_STATE					5500
+#define DIGITAL_INPUT_COUNTER				5501
+#define DIGITAL_INPUT_RISING_EDGE			2
+#define LIGHT_CONTROL_OBJECT				3311
+#define LIGHT_CONTROL_ON_OFF				5850
+
+#define COAP_VERSION						1
+#define COAP_HEADER_SIZE					4
+#define COAP_TOKEN_SIZE						4
+#define COAP_TYPE_CON						0
+#define COAP_TYPE_NON						1
+#define COAP_TYPE_ACK						2
+#define COAP_CODE(class, detail)			((class) << 5 | (detail))
+#define COAP_CODE_EMPTY						COAP_CODE(0, 0)
+#define COAP_CODE_POST						COAP_CODE(0, 2)
+#define COAP_CODE_CREATED					COAP_CODE(2, 1)
+#define COAP_CODE_CHANGED					COAP_CODE(2, 4)
+#define COAP_CODE_CONTENT					COAP_CODE(2, 5)
+#define COAP_OPTION_OBSERVE					6
+#define COAP_OPTION_URI_PATH				11
+#define COAP_OPTION_CONTENT_FORMAT			12
+#define COAP_OPTION_URI_QUERY				15
+#define COAP_FORMAT_LINK					40
+#define COAP_FORMAT_SENML_CBOR				112
+#define COAP_FORMAT_TLV						11542
+
+/* Latencies in microseconds, in buckets of 1/8 of a power of two */
+#define HISTOGRAM_SUB_BITS					3
+#define HISTOGRAM_BUCKETS					((64 - HISTOGRAM_SUB_BITS + 1) << HISTOGRAM_SUB_BITS)
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef enum
+{
+	LoadGenOperation_Register,
+	LoadGenOperation_Button,
+	LoadGenOperation_Light,
+	LoadGenOperation_Max
+} LoadGenOperation;
+
+typedef struct
+{
+	uint64_t Sent;
+	uint64_t Completed;
+	uint64_t TimedOut;
+	uint64_t Skipped;
+	uint64_t MaxLatency;
+	uint64_t Latency[HISTOGRAM_BUCKETS];
+} LoadGenStats;
+
+/* A confirmable message waiting for its acknowledgement */
+typedef struct
+{
+	bool InUse;
+	uint8_t Operation;
+	uint16_t MessageID;
+	uint64_t SentTime;
+} LoadGenRequest;
+
+typedef struct
+{
+	Lwm2mContextType * Context;
+	int Socket;
+	uint32_t Index;
+	uint32_t Random;
+	uint16_t NextMessageID;
+	uint32_t ObserveSequence;
+	bool Registered;
+	bool Registering;
+	bool LightOn;
+	LoadGenRequest Requests[LOADGEN_MAX_OUTSTANDING];
+} LoadGenClient;
+
+/* Min-heap entry: the next time a client has something to do */
+typedef struct
+{
+	uint64_t Due;
+	uint32_t Client;
+} LoadGenEvent;
+
+typedef struct
+{
+	int Socket;
+	volatile bool Stop;
+	uint64_t Received;
+} LoadGenServer;
+
+typedef struct
+{
+	int Clients;
+	double ButtonRate;
+	double LightRate;
+	int Duration;
+	int TimeoutMs;
+	int RegisterRate;
+	const char * Server;
+} LoadGenOptions;
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+static const char * operationNames[LoadGenOperation_Max] = { "register", "button", "light" };
+
+static LoadGenClient * clients;
+static LoadGenEvent * events;
+static int eventCount;
+static LoadGenStats stats[LoadGenOperation_Max];
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+static uint64_t LoadGen_GetTime(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static int LoadGen_HistogramBucket(uint64_t value)
+{
+	int exponent;
+
+	if (value < (1 << HISTOGRAM_SUB_BITS))
+		return (int)value;
+
+	exponent = 63 - __builtin_clzll(value);
+	return ((exponent - HISTOGRAM_SUB_BITS + 1) << HISTOGRAM_SUB_BITS) +
+		(int)((value >> (exponent - HISTOGRAM_SUB_BITS)) & ((1 << HISTOGRAM_SUB_BITS) - 1));
+}
+
+/* Smallest value that falls in a bucket */
+static uint64_t LoadGen_HistogramValue(int bucket)
+{
+	int exponent;
+
+	if (bucket < (1 << HISTOGRAM_SUB_BITS))
+		return bucket;
+
+	exponent = (bucket >> HISTOGRAM_SUB_BITS) + HISTOGRAM_SUB_BITS - 1;
+	return (uint64_t)((1 << HISTOGRAM_SUB_BITS) + (bucket & ((1 << HISTOGRAM_SUB_BITS) - 1))) <<
+		(exponent - HISTOGRAM_SUB_BITS);
+}
+
+static uint64_t LoadGen_Percentile(const LoadGenStats * stat, double percentile)
+{
+	uint64_t target = (uint64_t)ceil(stat->Completed * percentile / 100.0);
+	uint64_t count = 0;
+	int bucket;
+
+	if (target == 0)
+		target = 1;
+
+	for (bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+	{
+		count += stat->Latency[bucket];
+		if (count >= target)
+			return LoadGen_HistogramValue(bucket);
+	}
+	return stat->MaxLatency;
+}
+
+static uint32_t LoadGen_Random(LoadGenClient * client)
+{
+	/* xorshift32, one stream per client */
+	client->Random ^= client->Random << 13;
+	client->Random ^= client->Random >> 17;
+	client->Random ^= client->Random << 5;
+	return client->Random;
+}
+
+/* Uniform in (0, 1] */
+static double LoadGen_Uniform(LoadGenClient * client)
+{
+	return (LoadGen_Random(client) + 1.0) / 4294967296.0;
+}
+
+static void LoadGen_PushEvent(uint32_t client, uint64_t due)
+{
+	int child = eventCount++;
+
+	while (child > 0)
+	{
+		int parent = (child - 1) / 2;
+
+		if (events[parent].Due <= due)
+			break;
+		events[child] = events[parent];
+		child = parent;
+	}
+	events[child].Due = due;
+	events[child].Client = client;
+}
+
+static LoadGenEvent LoadGen_PopEvent(void)
+{
+	LoadGenEvent top = events[0];
+	LoadGenEvent last = events[--eventCount];
+	int parent = 0;
+
+	for (;;)
+	{
+		int child = 2 * parent + 1;
+
+		if (child >= eventCount)
+			break;
+		if (child + 1 < eventCount && events[child + 1].Due < events[child].Due)
+			child++;
+		if (last.Due <= events[child].Due)
+			break;
+		events[parent] = events[child];
+		parent = child;
+	}
+	if (eventCount > 0)
+		events[parent] = last;
+	return top;
+}
+
+/* Schedules the client's next button press or light toggle after an exponential gap */
+static void LoadGen_ScheduleNext(LoadGenClient * client, const LoadGenOptions * options,
+	uint64_t now)
+{
+	double rate = options->ButtonRate + options->LightRate;
+
+	if (rate > 0)
+		LoadGen_PushEvent(client->Index, now - log(LoadGen_Uniform(client)) / rate * 1000000.0);
+}
+
+static uint8_t * LoadGen_PutOption(uint8_t * position, int * lastOption, int option,
+	const void * value, int length)
+{
+	int delta = option - *lastOption;
+	uint8_t * header = position++;
+
+	*header = 0;
+	if (delta >= 13)
+	{
+		*header |= 13 << 4;
+		*position++ = delta - 13;
+	}
+	else
+		*header |= delta << 4;
+
+	if (length >= 13)
+	{
+		*header |= 13;
+		*position++ = length - 13;
+	}
+	else
+		*header |= length;
+
+	memcpy(position, value, length);
+	*lastOption = option;
+	return position + length;
+}
+
+/* Puts an unsigned option value in the fewest bytes, as CoAP requires */
+static uint8_t * LoadGen_PutUintOption(uint8_t * position, int * lastOption, int option,
+	uint32_t value)
+{
+	uint8_t bytes[4];
+	int length = 0, i;
+
+	for (i = 24; i >= 0; i -= 8)
+	{
+		if (length > 0 || (value >> i) & 0xFF)
+			bytes[length++] = (value >> i) & 0xFF;
+	}
+	return LoadGen_PutOption(position, lastOption, option, bytes, length);
+}
+
+static uint8_t * LoadGen_PutHeader(uint8_t * position, int type, int code, uint16_t messageID,
+	uint32_t token)
+{
+	*position++ = COAP_VERSION << 6 | type << 4 | COAP_TOKEN_SIZE;
+	*position++ = code;
+	*position++ = messageID >> 8;
+	*position++ = messageID & 0xFF;
+	*position++ = token >> 24;
+	*position++ = token >> 16;
+	*position++ = token >> 8;
+	*position++ = token;
+	return position;
+}
+
+static uint8_t * LoadGen_PutPayload(uint8_t * position, const uint8_t * payload, int length)
+{
+	if (length > 0)
+	{
+		*position++ = 0xFF;
+		memcpy(position, payload, length);
+		position += length;
+	}
+	return position;
+}
+
+/* Claims a free request slot and a message ID, or returns NULL if too many are in flight */
+static LoadGenRequest * LoadGen_NewRequest(LoadGenClient * client, LoadGenOperation operation)
+{
+	int i;
+
+	for (i = 0; i < LOADGEN_MAX_OUTSTANDING; i++)
+	{
+		LoadGenRequest * request = &client->Requests[i];
+
+		if (!request->InUse)
+		{
+			request->InUse = true;
+			request->Operation = operation;
+			request->MessageID = client->NextMessageID++;
+			return request;
+		}
+	}
+	stats[operation].Skipped++;
+	return NULL;
+}
+
+static void LoadGen_Send(LoadGenClient * client, LoadGenRequest * request, const uint8_t * message,
+	int length)
+{
+	request->SentTime = LoadGen_GetTime();
+	if (send(client->Socket, message, length, 0) != length)
+	{
+		/* Left in flight, so a full socket buffer shows up as a timeout */
+		if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ECONNREFUSED)
+			perror("send");
+	}
+	stats[request->Operation].Sent++;
+}
+
+static void LoadGen_Register(LoadGenClient * client)
+{
+	static const char links[] = "</20000/0>,</20001/0>,</3200/0>,</3311/0>";
+	uint8_t message[LOADGEN_MAX_MESSAGE];
+	LoadGenRequest * request = LoadGen_NewRequest(client, LoadGenOperation_Register);
+	uint8_t * position;
+	char query[32];
+	int lastOption = 0;
+
+	if (request == NULL)
+		return;
+
+	position = LoadGen_PutHeader(message, COAP_TYPE_CON, COAP_CODE_POST, request->MessageID,
+		client->Index);
+	position = LoadGen_PutOption(position, &lastOption, COAP_OPTION_URI_PATH, "rd", 2);
+	position = LoadGen_PutUintOption(position, &lastOption, COAP_OPTION_CONTENT_FORMAT,
+		COAP_FORMAT_LINK);
+	snprintf(query, sizeof(query), "ep=loadgen-%u", client->Index);
+	position = LoadGen_PutOption(position, &lastOption, COAP_OPTION_URI_QUERY, query,
+		strlen(query));
+	position = LoadGen_PutOption(position, &lastOption, COAP_OPTION_URI_QUERY, "lt=300", 6);
+	position = LoadGen_PutPayload(position, (const uint8_t *)links, sizeof(links) - 1);
+
+	client->Registering = true;
+	LoadGen_Send(client, request, message, position - message);
+}
+
+/* A press and release of button 0, sent to the server as SenML-CBOR (LWM2M Send) */
+static void LoadGen_PressButton(LoadGenClient * client)
+{
+	static const ResourceIDType resources[] = { DIGITAL_INPUT_STATE, DIGITAL_INPUT_COUNTER };
+	static const ObjectInstanceIDType instance = 0;
+	uint8_t message[LOADGEN_MAX_MESSAGE];
+	uint8_t payload[LOADGEN_MAX_PAYLOAD];
+	SenMLCborEncoder encoder;
+	LoadGenRequest * request;
+	uint8_t * position;
+	int lastOption = 0;
+	int length;
+
+	DigitalInput_SetInput(client->Context, instance, true);
+	DigitalInput_SetInput(client->Context, instance, false);
+
+	if ((request = LoadGen_NewRequest(client, LoadGenOperation_Button)) == NULL)
+		return;
+
+	SenMLCbor_Init(&encoder, payload, sizeof(payload), "/", SENML_NO_TIME);
+	if (DigitalInput_EncodeSenML(client->Context, &encoder, &instance, 1, resources, 2,
+		SENML_NO_TIME) == -1 || (length = SenMLCbor_Finish(&encoder)) == -1)
+	{
+		request->InUse = false;
+		return;
+	}
+
+	position = LoadGen_PutHeader(message, COAP_TYPE_CON, COAP_CODE_POST, request->MessageID,
+		client->Index);
+	position = LoadGen_PutOption(position, &lastOption, COAP_OPTION_URI_PATH, "dp", 2);
+	position = LoadGen_PutUintOption(position, &lastOption, COAP_OPTION_CONTENT_FORMAT,
+		COAP_FORMAT_SENML_CBOR);
+	position = LoadGen_PutPayload(position, payload, length);
+	LoadGen_Send(client, request, message, position - message);
+}
+
+/* Toggles light 0 through the core, then notifies the server with the instance as TLV */
+static void LoadGen_ToggleLight(LoadGenClient * client)
+{
+	uint8_t message[LOADGEN_MAX_MESSAGE];
+	uint8_t payload[LOADGEN_MAX_PAYLOAD];
+	LoadGenRequest * request;
+	uint8_t * position;
+	int lastOption = 0;
+	int length;
+
+	client->LightOn = !client->LightOn;
+	Lwm2mCore_SetResourceInstanceValue(client->Context, LIGHT_CONTROL_OBJECT, 0,
+		LIGHT_CONTROL_ON_OFF, 0, &client->LightOn, sizeof(client->LightOn));
+
+	if ((request = LoadGen_NewRequest(client, LoadGenOperation_Light)) == NULL)
+		return;
+
+	if ((length = LightControl_ReadInstance(client->Context, 0, payload, sizeof(payload))) == -1)
+	{
+		request->InUse = false;
+		return;
+	}
+
+	position = LoadGen_PutHeader(message, COAP_TYPE_CON, COAP_CODE_CONTENT, request->MessageID,
+		client->Index);
+	position = LoadGen_PutUintOption(position, &lastOption, COAP_OPTION_OBSERVE,
+		++client->ObserveSequence & 0xFFFFFF);
+	position = LoadGen_PutUintOption(position, &lastOption, COAP_OPTION_CONTENT_FORMAT,
+		COAP_FORMAT_TLV);
+	position = LoadGen_PutPayload(position, payload, length);
+	LoadGen_Send(client, request, message, position - message);
+}
+
+static void LoadGen_Receive(LoadGenClient * client, const LoadGenOptions * options)
+{
+	uint8_t message[LOADGEN_MAX_MESSAGE];
+	ssize_t length;
+
+	while ((length = recv(client->Socket, message, sizeof(message), 0)) >= 0)
+	{
+		uint16_t messageID;
+		int i;
+
+		if (length < COAP_HEADER_SIZE || ((message[0] >> 4) & 3) != COAP_TYPE_ACK)
+			continue;
+
+		messageID = message[2] << 8 | message[3];
+		for (i = 0; i < LOADGEN_MAX_OUTSTANDING; i++)
+		{
+			LoadGenRequest * request = &client->Requests[i];
+			LoadGenStats * stat = &stats[request->Operation];
+			uint64_t now, latency;
+
+			if (!request->InUse || request->MessageID != messageID)
+				continue;
+
+			now = LoadGen_GetTime();
+			latency = now - request->SentTime;
+			stat->Completed++;
+			stat->Latency[LoadGen_HistogramBucket(latency)]++;
+			if (latency > stat->MaxLatency)
+				stat->MaxLatency = latency;
+			request->InUse = false;
+
+			if (request->Operation == LoadGenOperation_Register)
+			{
+				client->Registering = false;
+				client->Registered = true;
+				LoadGen_ScheduleNext(client, options, now);
+			}
+			break;
+		}
+	}
+}
+
+/* Gives up on requests past the timeout; clients whose registration timed out register again */
+static void LoadGen_ExpireRequests(const LoadGenOptions * options, uint64_t now)
+{
+	uint64_t timeout = (uint64_t)options->TimeoutMs * 1000;
+	int i, j;
+
+	for (i = 0; i < options->Clients; i++)
+	{
+		LoadGenClient * client = &clients[i];
+
+		for (j = 0; j < LOADGEN_MAX_OUTSTANDING; j++)
+		{
+			LoadGenRequest * request = &client->Requests[j];
+
+			if (!request->InUse || now < request->SentTime + timeout)
+				continue;
+
+			stats[request->Operation].TimedOut++;
+			request->InUse = false;
+			if (request->Operation == LoadGenOperation_Register)
+			{
+				client->Registering = false;
+				LoadGen_PushEvent(client->Index, now);
+			}
+		}
+	}
+}
+
+static int LoadGen_CountOutstanding(const LoadGenOptions * options)
+{
+	int i, j, count = 0;
+
+	for (i = 0; i < options->Clients; i++)
+	{
+		for (j = 0; j < LOADGEN_MAX_OUTSTANDING; j++)
+			count += clients[i].Requests[j].InUse;
+	}
+	return count;
+}
+
+/* Acknowledges every confirmable message, piggybacking a response on requests */
+static void * LoadGen_ServerThread(void * argument)
+{
+	LoadGenServer * server = argument;
+	static uint8_t buffers[LOADGEN_SERVER_BATCH][LOADGEN_MAX_MESSAGE];
+	static uint8_t replies[LOADGEN_SERVER_BATCH][COAP_HEADER_SIZE + 8];
+	struct sockaddr_storage addresses[LOADGEN_SERVER_BATCH];
+	struct mmsghdr messages[LOADGEN_SERVER_BATCH];
+	struct mmsghdr responses[LOADGEN_SERVER_BATCH];
+	struct iovec vectors[LOADGEN_SERVER_BATCH];
+	struct iovec replyVectors[LOADGEN_SERVER_BATCH];
+	int i;
+
+	for (i = 0; i < LOADGEN_SERVER_BATCH; i++)
+	{
+		vectors[i].iov_base = buffers[i];
+		vectors[i].iov_len = LOADGEN_MAX_MESSAGE;
+		memset(&messages[i], 0, sizeof(messages[i]));
+		messages[i].msg_hdr.msg_iov = &vectors[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+		messages[i].msg_hdr.msg_name = &addresses[i];
+	}
+
+	while (!server->Stop)
+	{
+		int received, replyCount = 0;
+
+		for (i = 0; i < LOADGEN_SERVER_BATCH; i++)
+			messages[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+
+		received = recvmmsg(server->Socket, messages, LOADGEN_SERVER_BATCH, MSG_WAITFORONE, NULL);
+		if (received <= 0)
+			continue;
+		server->Received += received;
+
+		for (i = 0; i < received; i++)
+		{
+			const uint8_t * request = buffers[i];
+			uint8_t * reply = replies[replyCount];
+			int tokenLength = request[0] & 0x0F;
+			int length = COAP_HEADER_SIZE;
+
+			if (messages[i].msg_len < COAP_HEADER_SIZE + tokenLength || tokenLength > 8 ||
+				((request[0] >> 4) & 3) != COAP_TYPE_CON)
+			{
+				continue;
+			}
+
+			reply[0] = COAP_VERSION << 6 | COAP_TYPE_ACK << 4;
+			reply[2] = request[2];
+			reply[3] = request[3];
+			if (request[1] == COAP_CODE_POST)
+			{
+				/* Registration (/rd) creates a resource, Send (/dp) changes one */
+				reply[0] |= tokenLength;
+				reply[1] = messages[i].msg_len > 8 && request[COAP_HEADER_SIZE + tokenLength + 1]
+					== 'r' ? COAP_CODE_CREATED : COAP_CODE_CHANGED;
+				memcpy(reply + COAP_HEADER_SIZE, request + COAP_HEADER_SIZE, tokenLength);
+				length += tokenLength;
+			}
+			else
+				reply[1] = COAP_CODE_EMPTY;
+
+			replyVectors[replyCount].iov_base = reply;
+			replyVectors[replyCount].iov_len = length;
+			memset(&responses[replyCount], 0, sizeof(responses[replyCount]));
+			responses[replyCount].msg_hdr.msg_iov = &replyVectors[replyCount];
+			responses[replyCount].msg_hdr.msg_iovlen = 1;
+			responses[replyCount].msg_hdr.msg_name = &addresses[i];
+			responses[replyCount].msg_hdr.msg_namelen = messages[i].msg_hdr.msg_namelen;
+			replyCount++;
+		}
+
+		if (replyCount > 0)
+			sendmmsg(server->Socket, responses, replyCount, 0);
+	}
+	return NULL;
+}
+
+static int LoadGen_StartServer(LoadGenServer * server, struct sockaddr_in * address)
+{
+	struct timeval timeout = { .tv_sec = 0, .tv_usec = 100000 };
+	int bufferSize = LOADGEN_SERVER_BUFFER_SIZE;
+	socklen_t addressLength = sizeof(*address);
+	pthread_t thread;
+
+	memset(address, 0, sizeof(*address));
+	address->sin_family = AF_INET;
+	address->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if ((server->Socket = socket(AF_INET, SOCK_DGRAM, 0)) == -1 ||
+		bind(server->Socket, (struct sockaddr *)address, sizeof(*address)) == -1 ||
+		getsockname(server->Socket, (struct sockaddr *)address, &addressLength) == -1)
+	{
+		perror("stand-in server");
+		return -1;
+	}
+
+	/* The receive timeout lets the thread see Stop */
+	setsockopt(server->Socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(server->Socket, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+	setsockopt(server->Socket, SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+
+	if (pthread_create(&thread, NULL, LoadGen_ServerThread, server) != 0)
+	{
+		perror("pthread_create");
+		return -1;
+	}
+	pthread_detach(thread);
+	return 0;
+}
+
+static int LoadGen_ResolveServer(const char * server, struct sockaddr_in * address)
+{
+	struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_DGRAM };
+	struct addrinfo * result;
+	char host[256];
+	const char * port = strrchr(server, ':');
+
+	if (port == NULL || port - server >= sizeof(host))
+	{
+		fprintf(stderr, "Server must be given as host:port\n");
+		return -1;
+	}
+	memcpy(host, server, port - server);
+	host[port - server] = '\0';
+
+	if (getaddrinfo(host, port + 1, &hints, &result) != 0)
+	{
+		fprintf(stderr, "Cannot resolve %s\n", server);
+		return -1;
+	}
+	memcpy(address, result->ai_addr, sizeof(*address));
+	freeaddrinfo(result);
+	return 0;
+}
+
+/* Every client needs a socket, so lift the descriptor limit as far as the hard limit allows */
+static int LoadGen_RaiseFileLimit(int clients)
+{
+	struct rlimit limit;
+	rlim_t needed = clients + 64;
+
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < needed)
+	{
+		limit.rlim_cur = needed < limit.rlim_max ? needed : limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < needed)
+	{
+		fprintf(stderr, "%d clients need %lu file descriptors, the limit is %lu\n", clients,
+			(unsigned long)needed, (unsigned long)limit.rlim_cur);
+		return -1;
+	}
+	return 0;
+}
+
+static int LoadGen_CreateClient(LoadGenClient * client, uint32_t index, int epollFd,
+	const struct sockaddr_in * server)
+{
+	struct epoll_event event = { .events = EPOLLIN };
+	int64_t edgeSelection = DIGITAL_INPUT_RISING_EDGE;
+	char endPointName[32];
+
+	memset(client, 0, sizeof(*client));
+	client->Index = index;
+	client->Random = 2463534242u ^ (index * 2654435761u);
+	if (client->Random == 0)
+		client->Random = 1;
+
+	snprintf(endPointName, sizeof(endPointName), "loadgen-%u", index);
+	if ((client->Context = Lwm2mCore_Init(NULL, endPointName)) == NULL ||
+		Lwm2m_RegisterFlowObject(client->Context) == -1 ||
+		Lwm2m_RegisterFlowAccessObject(client->Context) == -1 ||
+		DigitalInput_RegisterDigitalInputObject(client->Context) == -1 ||
+		LightControl_RegisterLightControlObject(client->Context) == -1 ||
+		Lwm2m_SetProvisioningInfo(client->Context, "LoadGen", "LOADGEN", index) == -1 ||
+		DigitalInput_AddDigitialInput(client->Context, 0) == -1 ||
+		LightControl_AddLightControl(client->Context, 0, NULL, NULL) == -1)
+	{
+		fprintf(stderr, "Failed to set up client %u\n", index);
+		return -1;
+	}
+
+	/* Count presses on the rising edge, so DigitalInput_SetInput() keeps Counter up to date */
+	Lwm2mCore_SetResourceInstanceValue(client->Context, DIGITAL_INPUT_OBJECT, 0,
+		DIGITAL_INPUT_EDGE_SELECTION, 0, &edgeSelection, sizeof(edgeSelection));
+
+	if ((client->Socket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0)) == -1 ||
+		connect(client->Socket, (const struct sockaddr *)server, sizeof(*server)) == -1)
+	{
+		perror("client socket");
+		return -1;
+	}
+
+	event.data.u32 = index;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, client->Socket, &event) == -1)
+	{
+		perror("epoll_ctl");
+		return -1;
+	}
+	return 0;
+}
+
+static void LoadGen_Report(const LoadGenOptions * options, double seconds)
+{
+	uint64_t completed = 0;
+	int i, registered = 0;
+
+	for (i = 0; i < options->Clients; i++)
+		registered += clients[i].Registered;
+
+	printf("\n%d clients, %d registered, %.1f s\n\n", options->Clients, registered, seconds);
+	printf("%-9s %10s %10s %9s %9s %10s %8s %8s %8s %8s %8s\n", "operation", "sent",
+		"completed", "timed out", "skipped", "ops/s", "p50 ms", "p90 ms", "p99 ms", "p99.9 ms",
+		"max ms");
+
+	for (i = 0; i < LoadGenOperation_Max; i++)
+	{
+		const LoadGenStats * stat = &stats[i];
+
+		printf("%-9s %10" PRIu64 " %10" PRIu64 " %9" PRIu64 " %9" PRIu64 " %10.1f "
+			"%8.3f %8.3f %8.3f %8.3f %8.3f\n", operationNames[i], stat->Sent, stat->Completed,
+			stat->TimedOut, stat->Skipped, stat->Completed / seconds,
+			LoadGen_Percentile(stat, 50) / 1000.0, LoadGen_Percentile(stat, 90) / 1000.0,
+			LoadGen_Percentile(stat, 99) / 1000.0, LoadGen_Percentile(stat, 99.9) / 1000.0,
+			stat->MaxLatency / 1000.0);
+
+		if (i != LoadGenOperation_Register)
+			completed += stat->Completed;
+	}
+	printf("\nbutton + light: %.1f ops/s\n", completed / seconds);
+}
+
+static void LoadGen_Usage(const char * program)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -n clients        virtual clients (default %d)\n"
+		"  -b rate           button presses per second per client (default %.2f)\n"
+		"  -l rate           light toggles per second per client (default %.2f)\n"
+		"  -d seconds        duration of the run (default %d)\n"
+		"  -t milliseconds   acknowledgement timeout (default %d)\n"
+		"  -r rate           registrations per second, 0 for all at once (default 0)\n"
+		"  -s host:port      server to load instead of the stand-in on the loopback\n",
+		program, LOADGEN_DEFAULT_CLIENTS, LOADGEN_DEFAULT_BUTTON_RATE,
+		LOADGEN_DEFAULT_LIGHT_RATE, LOADGEN_DEFAULT_DURATION, LOADGEN_DEFAULT_TIMEOUT_MS);
+}
+
+int main(int argc, char ** argv)
+{
+	LoadGenOptions options =
+	{
+		.Clients = LOADGEN_DEFAULT_CLIENTS,
+		.ButtonRate = LOADGEN_DEFAULT_BUTTON_RATE,
+		.LightRate = LOADGEN_DEFAULT_LIGHT_RATE,
+		.Duration = LOADGEN_DEFAULT_DURATION,
+		.TimeoutMs = LOADGEN_DEFAULT_TIMEOUT_MS,
+	};
+	struct epoll_event epollEvents[LOADGEN_EPOLL_EVENTS];
+	LoadGenServer server = { .Socket = -1 };
+	struct sockaddr_in address;
+	uint64_t start, end, now, nextScan, nextReport;
+	int epollFd, option, i;
+
+	while ((option = getopt(argc, argv, "n:b:l:d:t:r:s:h")) != -1)
+	{
+		switch (option)
+		{
+			case 'n': options.Clients = atoi(optarg); break;
+			case 'b': options.ButtonRate = atof(optarg); break;
+			case 'l': options.LightRate = atof(optarg); break;
+			case 'd': options.Duration = atoi(optarg); break;
+			case 't': options.TimeoutMs = atoi(optarg); break;
+			case 'r': options.RegisterRate = atoi(optarg); break;
+			case 's': options.Server = optarg; break;
+			default:
+				LoadGen_Usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (options.Clients <= 0 || options.Duration <= 0 || options.TimeoutMs <= 0 ||
+		options.ButtonRate < 0 || options.LightRate < 0)
+	{
+		LoadGen_Usage(argv[0]);
+		return 1;
+	}
+
+	if (LoadGen_RaiseFileLimit(options.Clients) == -1)
+		return 1;
+
+	if (options.Server != NULL ? LoadGen_ResolveServer(options.Server, &address) == -1 :
+		LoadGen_StartServer(&server, &address) == -1)
+	{
+		return 1;
+	}
+
+	clients = calloc(options.Clients, sizeof(LoadGenClient));
+	events = malloc(options.Clients * sizeof(LoadGenEvent));
+	if (clients == NULL || events == NULL || (epollFd = epoll_create1(0)) == -1)
+	{
+		fprintf(stderr, "Out of memory for %d clients\n", options.Clients);
+		return 1;
+	}
+
+	for (i = 0; i < options.Clients; i++)
+	{
+		if (LoadGen_CreateClient(&clients[i], i, epollFd, &address) == -1)
+			return 1;
+	}
+	fprintf(stderr, "%d clients set up against %s:%d\n", options.Clients,
+		inet_ntoa(address.sin_addr), ntohs(address.sin_port));
+
+	/* Registrations go first; each client starts its workload once registered */
+	start = LoadGen_GetTime();
+	for (i = 0; i < options.Clients; i++)
+	{
+		LoadGen_PushEvent(i, options.RegisterRate > 0 ?
+			start + (uint64_t)i * 1000000 / options.RegisterRate : start);
+	}
+
+	end = start + (uint64_t)options.Duration * 1000000;
+	nextScan = start + LOADGEN_SCAN_INTERVAL_US;
+	nextReport = start + LOADGEN_REPORT_INTERVAL_US;
+
+	for (now = start; now < end + (uint64_t)options.TimeoutMs * 1000; now = LoadGen_GetTime())
+	{
+		int timeout = LOADGEN_SCAN_INTERVAL_US / 1000;
+		int ready;
+
+		if (now >= end && LoadGen_CountOutstanding(&options) == 0)
+			break;
+
+		if (now < end && eventCount > 0)
+		{
+			uint64_t wait = events[0].Due > now ? (events[0].Due - now + 999) / 1000 : 0;
+
+			if (wait < timeout)
+				timeout = wait;
+		}
+
+		ready = epoll_wait(epollFd, epollEvents, LOADGEN_EPOLL_EVENTS, timeout);
+		for (i = 0; i < ready; i++)
+			LoadGen_Receive(&clients[epollEvents[i].data.u32], &options);
+
+		now = LoadGen_GetTime();
+		while (now < end && eventCount > 0 && events[0].Due <= now)
+		{
+			LoadGenClient * client = &clients[LoadGen_PopEvent().Client];
+
+			if (!client->Registered)
+			{
+				if (!client->Registering)
+					LoadGen_Register(client);
+				continue;
+			}
+
+			if (LoadGen_Uniform(client) * (options.ButtonRate + options.LightRate) <=
+				options.ButtonRate)
+			{
+				LoadGen_PressButton(client);
+			}
+			else
+				LoadGen_ToggleLight(client);
+			LoadGen_ScheduleNext(client, &options, now);
+		}
+
+		if (now >= nextScan)
+		{
+			LoadGen_ExpireRequests(&options, now);
+			nextScan = now + LOADGEN_SCAN_INTERVAL_US;
+		}
+
+		if (now >= nextReport)
+		{
+			fprintf(stderr, "%3" PRIu64 " s: %" PRIu64 " button, %" PRIu64 " light acknowledged\n",
+				(now - start) / 1000000, stats[LoadGenOperation_Button].Completed,
+				stats[LoadGenOperation_Light].Completed);
+			nextReport += LOADGEN_REPORT_INTERVAL_US;
+		}
+	}
+
+	LoadGen_ExpireRequests(&options, UINT64_MAX / 2);
+	LoadGen_Report(&options, (end - start) / 1000000.0);
+
+	server.Stop = true;
+	for (i = 0; i < options.Clients; i++)
+	{
+		close(clients[i].Socket);
+		ClientState_Destroy(clients[i].Context);
+		Lwm2mCore_Destroy(clients[i].Context);
+	}
+	free(clients);
+	free(events);
+	close(epollFd);
+	return 0;
+}
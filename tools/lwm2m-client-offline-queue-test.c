@@ -0,0 +1,418 @@
+/**
+ * @file
+ * LightWeightM2M offline queue test.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Checks lwm2m-client-offline-queue.c through its public API: compaction of states and of
+ * transitions past the budget, counter folding, changes recorded while a batch is being sent,
+ * a failing sink, and the drain rate limit. Any mismatch fails the run.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lwm2m_core.h"
+#include "lwm2m-client-offline-queue.h"
+#include "lwm2m-client-state.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define OFFLINE_QUEUE_TEST_MAX_SENT			64
+
+#define OFFLINE_QUEUE_TEST_DIGITAL_INPUT	3200
+#define OFFLINE_QUEUE_TEST_STATE			5500
+#define OFFLINE_QUEUE_TEST_COUNTER			5501
+#define OFFLINE_QUEUE_TEST_LIGHT_CONTROL	3311
+#define OFFLINE_QUEUE_TEST_ON_OFF			5850
+#define OFFLINE_QUEUE_TEST_DIMMER			5851
+
+#define OFFLINE_QUEUE_TEST_CHECK(test, condition, ...)                                            \
+	do                                                                                            \
+	{                                                                                             \
+		if (!(condition))                                                                         \
+		{                                                                                         \
+			printf("%s: ", (test)->Name);                                                         \
+			printf(__VA_ARGS__);                                                                  \
+			printf("\n");                                                                         \
+			(test)->Failed = true;                                                                \
+			return;                                                                               \
+		}                                                                                         \
+	} while (0)
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef struct _OfflineQueueTest OfflineQueueTest;
+
+/* Called by the sink before it accepts a batch, while the queue is not locked */
+typedef void (*OfflineQueueTestHook)(OfflineQueueTest * test);
+
+struct _OfflineQueueTest
+{
+	const char * Name;
+	Lwm2mContextType * Context;
+	bool Failed;
+	bool SinkFails;
+	OfflineQueueTestHook Hook;
+	/* Every change the sink accepted, in the order it got them */
+	OfflineChange Sent[OFFLINE_QUEUE_TEST_MAX_SENT];
+	int SentCount;
+};
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+static int OfflineQueueTest_Sink(void * sinkContext, const OfflineChange * changes, int count)
+{
+	OfflineQueueTest * test = sinkContext;
+	int i;
+
+	if (test->Hook != NULL)
+	{
+		test->Hook(test);
+		test->Hook = NULL;
+	}
+	if (test->SinkFails)
+		return -1;
+
+	for (i = 0; i < count && test->SentCount < OFFLINE_QUEUE_TEST_MAX_SENT; i++)
+		test->Sent[test->SentCount++] = changes[i];
+	return 0;
+}
+
+/* Returns the first change sent for the resource at or after index first, or NULL */
+static const OfflineChange * OfflineQueueTest_FindSent(OfflineQueueTest * test, int first,
+	ObjectIDType objectID, ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID)
+{
+	int i;
+
+	for (i = first; i < test->SentCount; i++)
+	{
+		const OfflineChange * change = &test->Sent[i];
+
+		if (change->ObjectID == objectID && change->ObjectInstanceID == objectInstanceID &&
+			change->ResourceID == resourceID)
+			return change;
+	}
+	return NULL;
+}
+
+static bool OfflineQueueTest_IsChange(const OfflineChange * change, OfflineChangeKind kind,
+	int64_t value, int64_t timeMs)
+{
+	return change != NULL && change->Kind == kind && change->Value == value &&
+		change->TimeMs == timeMs;
+}
+
+static int OfflineQueueTest_GetPending(OfflineQueueTest * test)
+{
+	OfflineQueueStats stats;
+
+	OfflineQueue_GetStats(test->Context, &stats);
+	return stats.Pending;
+}
+
+static void OfflineQueueTest_Begin(OfflineQueueTest * test, const char * name,
+	Lwm2mContextType * context, int transitionBudget, int drainBatchSize, int drainRatePerSecond)
+{
+	OfflineQueueConfig config =
+	{
+		.MaxResources = 16,
+		.TransitionBudget = transitionBudget,
+		.DrainBatchSize = drainBatchSize,
+		.DrainRatePerSecond = drainRatePerSecond,
+	};
+
+	memset(test, 0, sizeof(*test));
+	test->Name = name;
+	test->Context = context;
+	OfflineQueue_SetOnline(context, false);
+	if (OfflineQueue_Enable(context, &config) == -1)
+		test->Failed = true;
+}
+
+static bool OfflineQueueTest_End(OfflineQueueTest * test)
+{
+	printf("%-16s %s\n", test->Name, test->Failed ? "FAILED" : "passed");
+	return !test->Failed;
+}
+
+/*
+ * A state keeps only its latest value. Transitions past the budget fold the oldest into the
+ * resource's latest value, which is sent ahead of the transitions still in the ring, in order.
+ */
+static void OfflineQueueTest_Compaction(OfflineQueueTest * test)
+{
+	OfflineQueueStats stats;
+	int sent;
+
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_LIGHT_CONTROL, 0,
+		OFFLINE_QUEUE_TEST_DIMMER, OfflineChangeKind_State, 10, 1);
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_LIGHT_CONTROL, 0,
+		OFFLINE_QUEUE_TEST_DIMMER, OfflineChangeKind_State, 20, 2);
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_LIGHT_CONTROL, 0,
+		OFFLINE_QUEUE_TEST_DIMMER, OfflineChangeKind_State, 30, 3);
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_LIGHT_CONTROL, 0,
+		OFFLINE_QUEUE_TEST_ON_OFF, OfflineChangeKind_Transition, 1, 4);
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_LIGHT_CONTROL, 0,
+		OFFLINE_QUEUE_TEST_ON_OFF, OfflineChangeKind_Transition, 0, 5);
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_LIGHT_CONTROL, 0,
+		OFFLINE_QUEUE_TEST_ON_OFF, OfflineChangeKind_Transition, 1, 6);
+
+	OfflineQueue_GetStats(test->Context, &stats);
+	OFFLINE_QUEUE_TEST_CHECK(test, stats.Recorded == 6 && stats.Compacted == 3 &&
+		stats.Pending == 4 && stats.Dropped == 0, "recorded %" PRIu64 ", compacted %" PRIu64
+		", pending %d, dropped %" PRIu64, stats.Recorded, stats.Compacted, stats.Pending,
+		stats.Dropped);
+
+	OfflineQueue_SetOnline(test->Context, true);
+	sent = OfflineQueue_Drain(test->Context, 1000, OfflineQueueTest_Sink, test);
+	OFFLINE_QUEUE_TEST_CHECK(test, sent == 4 && test->SentCount == 4, "drained %d of 4", sent);
+	OFFLINE_QUEUE_TEST_CHECK(test, OfflineQueueTest_IsChange(OfflineQueueTest_FindSent(test, 0,
+		OFFLINE_QUEUE_TEST_LIGHT_CONTROL, 0, OFFLINE_QUEUE_TEST_DIMMER), OfflineChangeKind_State,
+		30, 3), "Dimmer not sent as its latest value");
+	OFFLINE_QUEUE_TEST_CHECK(test, OfflineQueueTest_IsChange(OfflineQueueTest_FindSent(test, 0,
+		OFFLINE_QUEUE_TEST_LIGHT_CONTROL, 0, OFFLINE_QUEUE_TEST_ON_OFF),
+		OfflineChangeKind_Transition, 1, 4), "oldest On/Off transition not folded first");
+	OFFLINE_QUEUE_TEST_CHECK(test, OfflineQueueTest_IsChange(&test->Sent[2],
+		OfflineChangeKind_Transition, 0, 5) && OfflineQueueTest_IsChange(&test->Sent[3],
+		OfflineChangeKind_Transition, 1, 6), "On/Off transitions out of order");
+
+	/* Once drained while online, changes are no longer queued */
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_LIGHT_CONTROL, 0,
+		OFFLINE_QUEUE_TEST_DIMMER, OfflineChangeKind_State, 40, 7);
+	OfflineQueue_GetStats(test->Context, &stats);
+	OFFLINE_QUEUE_TEST_CHECK(test, stats.Pending == 0 && stats.Recorded == 6 &&
+		stats.Drained == 4, "pending %d, recorded %" PRIu64 " after draining", stats.Pending,
+		stats.Recorded);
+}
+
+/* Counter increments add up per resource, and instances keep separate sums */
+static void OfflineQueueTest_CounterFolding(OfflineQueueTest * test)
+{
+	const OfflineChange * change;
+	int sent;
+
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_DIGITAL_INPUT, 0,
+		OFFLINE_QUEUE_TEST_COUNTER, OfflineChangeKind_Counter, 1, 1);
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_DIGITAL_INPUT, 1,
+		OFFLINE_QUEUE_TEST_COUNTER, OfflineChangeKind_Counter, 4, 2);
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_DIGITAL_INPUT, 0,
+		OFFLINE_QUEUE_TEST_COUNTER, OfflineChangeKind_Counter, 2, 3);
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_DIGITAL_INPUT, 0,
+		OFFLINE_QUEUE_TEST_COUNTER, OfflineChangeKind_Counter, 3, 4);
+	OFFLINE_QUEUE_TEST_CHECK(test, OfflineQueueTest_GetPending(test) == 2,
+		"%d changes pending, expected 2", OfflineQueueTest_GetPending(test));
+
+	OfflineQueue_SetOnline(test->Context, true);
+	sent = OfflineQueue_Drain(test->Context, 1000, OfflineQueueTest_Sink, test);
+	OFFLINE_QUEUE_TEST_CHECK(test, sent == 2, "drained %d of 2", sent);
+
+	change = OfflineQueueTest_FindSent(test, 0, OFFLINE_QUEUE_TEST_DIGITAL_INPUT, 0,
+		OFFLINE_QUEUE_TEST_COUNTER);
+	OFFLINE_QUEUE_TEST_CHECK(test, OfflineQueueTest_IsChange(change, OfflineChangeKind_Counter,
+		6, 4), "instance 0 sent %" PRId64 ", expected 6", change ? change->Value : -1);
+	change = OfflineQueueTest_FindSent(test, 0, OFFLINE_QUEUE_TEST_DIGITAL_INPUT, 1,
+		OFFLINE_QUEUE_TEST_COUNTER);
+	OFFLINE_QUEUE_TEST_CHECK(test, OfflineQueueTest_IsChange(change, OfflineChangeKind_Counter,
+		4, 2), "instance 1 sent %" PRId64 ", expected 4", change ? change->Value : -1);
+}
+
+/* Records a change of each kind while the sink holds a batch with the same resources */
+static void OfflineQueueTest_RecordDuringSend(OfflineQueueTest * test)
+{
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_DIGITAL_INPUT, 0,
+		OFFLINE_QUEUE_TEST_COUNTER, OfflineChangeKind_Counter, 2, 20);
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_LIGHT_CONTROL, 0,
+		OFFLINE_QUEUE_TEST_DIMMER, OfflineChangeKind_State, 50, 21);
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_LIGHT_CONTROL, 0,
+		OFFLINE_QUEUE_TEST_ON_OFF, OfflineChangeKind_Transition, 1, 22);
+}
+
+/*
+ * Changes recorded while a batch is out survive its commit: a counter keeps the increments it had
+ * since, a state its newer value, and the ring the transitions behind those sent.
+ */
+static void OfflineQueueTest_PartialCommit(OfflineQueueTest * test)
+{
+	int sent;
+
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_DIGITAL_INPUT, 0,
+		OFFLINE_QUEUE_TEST_COUNTER, OfflineChangeKind_Counter, 5, 10);
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_LIGHT_CONTROL, 0,
+		OFFLINE_QUEUE_TEST_DIMMER, OfflineChangeKind_State, 40, 11);
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_LIGHT_CONTROL, 0,
+		OFFLINE_QUEUE_TEST_ON_OFF, OfflineChangeKind_Transition, 1, 12);
+	OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_LIGHT_CONTROL, 0,
+		OFFLINE_QUEUE_TEST_ON_OFF, OfflineChangeKind_Transition, 0, 13);
+
+	OfflineQueue_SetOnline(test->Context, true);
+	test->Hook = OfflineQueueTest_RecordDuringSend;
+	sent = OfflineQueue_Drain(test->Context, 1000, OfflineQueueTest_Sink, test);
+	OFFLINE_QUEUE_TEST_CHECK(test, sent == 4, "first drain sent %d of 4", sent);
+	OFFLINE_QUEUE_TEST_CHECK(test, OfflineQueueTest_GetPending(test) == 3,
+		"%d changes left after the first drain, expected 3", OfflineQueueTest_GetPending(test));
+
+	sent = OfflineQueue_Drain(test->Context, 10000, OfflineQueueTest_Sink, test);
+	OFFLINE_QUEUE_TEST_CHECK(test, sent == 3 && test->SentCount == 7,
+		"second drain sent %d of 3", sent);
+	OFFLINE_QUEUE_TEST_CHECK(test, OfflineQueueTest_IsChange(OfflineQueueTest_FindSent(test, 4,
+		OFFLINE_QUEUE_TEST_DIGITAL_INPUT, 0, OFFLINE_QUEUE_TEST_COUNTER),
+		OfflineChangeKind_Counter, 2, 20), "Counter lost the increment made during the send");
+	OFFLINE_QUEUE_TEST_CHECK(test, OfflineQueueTest_IsChange(OfflineQueueTest_FindSent(test, 4,
+		OFFLINE_QUEUE_TEST_LIGHT_CONTROL, 0, OFFLINE_QUEUE_TEST_DIMMER), OfflineChangeKind_State,
+		50, 21), "Dimmer lost the value written during the send");
+	OFFLINE_QUEUE_TEST_CHECK(test, OfflineQueueTest_IsChange(&test->Sent[6],
+		OfflineChangeKind_Transition, 1, 22), "On/Off lost the transition made during the send");
+	OFFLINE_QUEUE_TEST_CHECK(test, OfflineQueueTest_GetPending(test) == 0,
+		"%d changes left after the second drain", OfflineQueueTest_GetPending(test));
+}
+
+/* A batch the sink fails stays queued whole and goes out again on the next drain */
+static void OfflineQueueTest_SinkFailure(OfflineQueueTest * test)
+{
+	OfflineQueueStats stats;
+	int sent, i;
+
+	for (i = 0; i < 3; i++)
+	{
+		OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_LIGHT_CONTROL, i,
+			OFFLINE_QUEUE_TEST_DIMMER, OfflineChangeKind_State, 10 + i, i);
+	}
+
+	OfflineQueue_SetOnline(test->Context, true);
+	test->SinkFails = true;
+	sent = OfflineQueue_Drain(test->Context, 1000, OfflineQueueTest_Sink, test);
+	OfflineQueue_GetStats(test->Context, &stats);
+	OFFLINE_QUEUE_TEST_CHECK(test, sent == -1 && stats.Pending == 3 && stats.Drained == 0,
+		"failed drain returned %d, left %d pending", sent, stats.Pending);
+
+	test->SinkFails = false;
+	sent = OfflineQueue_Drain(test->Context, 10000, OfflineQueueTest_Sink, test);
+	OFFLINE_QUEUE_TEST_CHECK(test, sent == 3, "retry sent %d of 3", sent);
+	for (i = 0; i < 3; i++)
+	{
+		OFFLINE_QUEUE_TEST_CHECK(test, OfflineQueueTest_IsChange(OfflineQueueTest_FindSent(test,
+			0, OFFLINE_QUEUE_TEST_LIGHT_CONTROL, i, OFFLINE_QUEUE_TEST_DIMMER),
+			OfflineChangeKind_State, 10 + i, i), "instance %d not resent", i);
+	}
+}
+
+/*
+ * The first drain may send a whole batch. After that a drain sends what the rate allows since the
+ * last one, and a long gap still allows no more than one batch.
+ */
+static void OfflineQueueTest_RateLimit(OfflineQueueTest * test)
+{
+	static const struct
+	{
+		int64_t NowMs;
+		int Expected;
+	} drains[] =
+	{
+		{ 1000, 4 },		/* full bucket */
+		{ 1000, 0 },		/* nothing since */
+		{ 1400, 0 },		/* 0.8 of a change */
+		{ 2000, 2 },		/* 2 a second over the second since the first */
+		{ 60000, 4 },		/* capped at one batch */
+	};
+	int sent, i;
+
+	for (i = 0; i < 10; i++)
+	{
+		OfflineQueue_Record(test->Context, OFFLINE_QUEUE_TEST_LIGHT_CONTROL, i,
+			OFFLINE_QUEUE_TEST_DIMMER, OfflineChangeKind_State, i, i);
+	}
+
+	OfflineQueue_SetOnline(test->Context, true);
+	for (i = 0; i < (int)(sizeof(drains) / sizeof(drains[0])); i++)
+	{
+		sent = OfflineQueue_Drain(test->Context, drains[i].NowMs, OfflineQueueTest_Sink, test);
+		OFFLINE_QUEUE_TEST_CHECK(test, sent == drains[i].Expected,
+			"drain at %" PRId64 " ms sent %d, expected %d", drains[i].NowMs, sent,
+			drains[i].Expected);
+	}
+	OFFLINE_QUEUE_TEST_CHECK(test, OfflineQueueTest_GetPending(test) == 0,
+		"%d changes left", OfflineQueueTest_GetPending(test));
+}
+
+int main(int argc, char ** argv)
+{
+	static OfflineQueueTest test;
+	Lwm2mContextType * context;
+	bool passed = true;
+
+	if ((context = Lwm2mCore_Init(NULL, "offlinequeuetest")) == NULL)
+	{
+		fprintf(stderr, "Failed to set up a client\n");
+		return 1;
+	}
+
+	OfflineQueueTest_Begin(&test, "compaction", context, 2, 16, 1000);
+	OfflineQueueTest_Compaction(&test);
+	passed &= OfflineQueueTest_End(&test);
+
+	OfflineQueueTest_Begin(&test, "counter folding", context, 8, 16, 1000);
+	OfflineQueueTest_CounterFolding(&test);
+	passed &= OfflineQueueTest_End(&test);
+
+	OfflineQueueTest_Begin(&test, "partial commit", context, 8, 16, 1000);
+	OfflineQueueTest_PartialCommit(&test);
+	passed &= OfflineQueueTest_End(&test);
+
+	OfflineQueueTest_Begin(&test, "sink failure", context, 8, 16, 1000);
+	OfflineQueueTest_SinkFailure(&test);
+	passed &= OfflineQueueTest_End(&test);
+
+	OfflineQueueTest_Begin(&test, "rate limit", context, 8, 4, 2);
+	OfflineQueueTest_RateLimit(&test);
+	passed &= OfflineQueueTest_End(&test);
+
+	ClientState_Destroy(context);
+	Lwm2mCore_Destroy(context);
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,585 @@
+/**
+ * @file
+ * LightWeightM2M object read benchmark.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Compares the two ways of reading a whole object instance. The core reads one resource at a time:
+ * GetLength, then Read, then it encodes the value as an OMA-TLV record. The objects' bulk
+ * *_ReadInstance() functions walk their resources once and write the TLV records straight into
+ * the caller's buffer. Handlers are captured by wrapping the core's resource type registration
+ * with the linker's --wrap option (see Makefile.readbench), so the per-resource path calls the
+ * same handlers the core would.
+ *
+ * A second table shows what the TLV cache of rarely-changing resources saves. Each bulk read is
+ * timed right after those resources were written, so it has to encode them (miss), and again
+ * when nothing changed since the last read (hit). Only the bulk reads use the cache.
+ *
+ * A third table compares telemetry for every Digital Input and Light Control instance sent as one
+ * SenML-CBOR payload with the per-resource reporting it replaces: one notification per resource,
+ * each carrying a TLV record. Sizes include the CoAP header and options of each message, and are
+ * given again with the UDP and IPv4 headers a cellular link also carries.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include "lwm2m_core.h"
+#include "lwm2m-client-flow-object.h"
+#include "lwm2m-client-ipso-digital-input.h"
+#include "lwm2m-client-ipso-light-control.h"
+#include "lwm2m-client-state.h"
+#include "lwm2m-client-tlv.h"
+#include "lwm2m-client-senml-cbor.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define READBENCH_DEFAULT_ITERATIONS		1000000
+
+#define READBENCH_MAX_OBJECTS				8
+#define READBENCH_MAX_RESOURCES				32
+#define READBENCH_BUFFER_SIZE				2048
+#define READBENCH_VALUE_SIZE				512
+
+#define READBENCH_MAX_CACHED				2
+#define READBENCH_REPORT_INSTANCES			2
+#define READBENCH_REPORT_TIME_MS			1700000000000LL
+
+/* Header, 4-byte token, Observe and Content-Format options and payload marker of a notification */
+#define READBENCH_COAP_NOTIFY_OVERHEAD		16
+#define READBENCH_UDP_IPV4_OVERHEAD			28
+
+#define DIGITAL_INPUT_OBJECT				3200
+#define DIGITAL_INPUT_APPLICATION_TYPE		5750
+#define DIGITAL_INPUT_SENSOR_TYPE			5751
+#define LIGHT_CONTROL_OBJECT				3311
+#define LIGHT_CONTROL_COLOUR				5706
+#define LIGHT_CONTROL_UNITS					5701
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef struct
+{
+	ResourceIDType ResourceID;
+	ResourceTypeEnum Type;
+	MandatoryEnum Mandatory;
+	Operations Operations;
+} ReadBenchResource;
+
+typedef struct
+{
+	ObjectIDType ObjectID;
+	ResourceOperationHandlers * Handlers;
+	ReadBenchResource Resources[READBENCH_MAX_RESOURCES];
+	int ResourceCount;
+} ReadBenchObject;
+
+typedef int (*ReadBenchInstanceRead)(Lwm2mContextType * context,
+	ObjectInstanceIDType objectInstanceID, uint8_t * destBuffer, int destBufferLen);
+
+typedef struct
+{
+	const char * Name;
+	ObjectIDType ObjectID;
+	ReadBenchInstanceRead ReadInstance;
+	ResourceIDType CachedResources[READBENCH_MAX_CACHED];	/* Resources with a TLV cache */
+	int Instances;
+	Lwm2mContextType * Context;
+	const ReadBenchObject * Object;
+} ReadBenchCase;
+
+typedef int (*ReadBenchRead)(const ReadBenchCase * benchCase, uint8_t * destBuffer,
+	int destBufferLen);
+
+typedef struct
+{
+	double Nanoseconds;
+	double Cycles;
+	int Length;
+	int Messages;
+} ReadBenchResult;
+
+/***************************************************************************************************
+ * Prototypes
+ **************************************************************************************************/
+
+int __real_Lwm2mCore_RegisterResourceType(Lwm2mContextType * context, char * resName,
+	ObjectIDType objectID, ResourceIDType resourceID, ResourceTypeEnum resourceType,
+	MultipleInstancesEnum multipleInstances, MandatoryEnum mandatory, Operations operations,
+	ResourceOperationHandlers * handlers);
+
+static int ReadBench_ReadFlowInstance(Lwm2mContextType * context,
+	ObjectInstanceIDType objectInstanceID, uint8_t * destBuffer, int destBufferLen);
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+static ReadBenchObject objects[READBENCH_MAX_OBJECTS];
+static int objectCount;
+
+static ReadBenchCase cases[] =
+{
+	{
+		"Flow", FLOWM2M_FLOW_OBJECT, ReadBench_ReadFlowInstance,
+		{ FLOWM2M_FLOW_OBJECT_DEVICETYPE, FLOWM2M_FLOW_OBJECT_FCAP }, 1
+	},
+	{
+		"DigitalInput", DIGITAL_INPUT_OBJECT, DigitalInput_ReadInstance,
+		{ DIGITAL_INPUT_APPLICATION_TYPE, DIGITAL_INPUT_SENSOR_TYPE }, READBENCH_REPORT_INSTANCES
+	},
+	{
+		"LightControl", LIGHT_CONTROL_OBJECT, LightControl_ReadInstance,
+		{ LIGHT_CONTROL_COLOUR, LIGHT_CONTROL_UNITS }, READBENCH_REPORT_INSTANCES
+	},
+};
+
+/* Keeps the compiler from dropping reads whose result is not otherwise used */
+static volatile int sink;
+
+/***************************************************************************************************
+ * Registration
+ **************************************************************************************************/
+
+static ReadBenchObject * ReadBench_FindObject(ObjectIDType objectID)
+{
+	int i;
+
+	for (i = 0; i < objectCount; i++)
+	{
+		if (objects[i].ObjectID == objectID)
+			return &objects[i];
+	}
+	if (objectCount == READBENCH_MAX_OBJECTS)
+		return NULL;
+	objects[objectCount].ObjectID = objectID;
+	return &objects[objectCount++];
+}
+
+int __wrap_Lwm2mCore_RegisterResourceType(Lwm2mContextType * context, char * resName,
+	ObjectIDType objectID, ResourceIDType resourceID, ResourceTypeEnum resourceType,
+	MultipleInstancesEnum multipleInstances, MandatoryEnum mandatory, Operations operations,
+	ResourceOperationHandlers * handlers)
+{
+	ReadBenchObject * object = ReadBench_FindObject(objectID);
+
+	if (object != NULL && object->ResourceCount < READBENCH_MAX_RESOURCES)
+	{
+		ReadBenchResource * resource = &object->Resources[object->ResourceCount++];
+
+		resource->ResourceID = resourceID;
+		resource->Type = resourceType;
+		resource->Mandatory = mandatory;
+		resource->Operations = operations;
+		object->Handlers = handlers;
+	}
+	return __real_Lwm2mCore_RegisterResourceType(context, resName, objectID, resourceID,
+		resourceType, multipleInstances, mandatory, operations, handlers);
+}
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+static uint64_t ReadBench_GetTime(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/* Time stamp counter where there is one, so results can be compared in cycles */
+static uint64_t ReadBench_GetCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	return 0;
+#endif
+}
+
+static bool ReadBench_IsReadable(const ReadBenchResource * resource)
+{
+	return resource->Operations == Operations_R || resource->Operations == Operations_RW;
+}
+
+static bool ReadBench_IsWritable(const ReadBenchResource * resource)
+{
+	return resource->Operations == Operations_W || resource->Operations == Operations_RW;
+}
+
+static int ReadBench_ReadFlowInstance(Lwm2mContextType * context,
+	ObjectInstanceIDType objectInstanceID, uint8_t * destBuffer, int destBufferLen)
+{
+	return Lwm2m_ReadFlowObjectInstance(context, destBuffer, destBufferLen);
+}
+
+/* What the core does for a whole-instance read: GetLength, Read and encode each resource */
+static int ReadBench_ReadPerResource(const ReadBenchCase * benchCase, uint8_t * destBuffer,
+	int destBufferLen)
+{
+	const ReadBenchObject * object = benchCase->Object;
+	uint8_t value[READBENCH_VALUE_SIZE];
+	int i, length = 0;
+
+	for (i = 0; i < object->ResourceCount; i++)
+	{
+		const ReadBenchResource * resource = &object->Resources[i];
+		int valueLength, encoded;
+
+		if (!ReadBench_IsReadable(resource))
+			continue;
+
+		valueLength = object->Handlers->GetLength(benchCase->Context, object->ObjectID, 0,
+			resource->ResourceID, 0);
+		if (valueLength <= 0 || valueLength > sizeof(value))
+			continue;
+
+		valueLength = object->Handlers->Read(benchCase->Context, object->ObjectID, 0,
+			resource->ResourceID, 0, value, sizeof(value));
+		if (valueLength <= 0)
+			continue;
+
+		if ((encoded = Tlv_EncodeResource(destBuffer + length, destBufferLen - length,
+			resource->ResourceID, resource->Type, value, valueLength)) == -1)
+			return -1;
+		length += encoded;
+	}
+	return length;
+}
+
+static int ReadBench_ReadBulk(const ReadBenchCase * benchCase, uint8_t * destBuffer,
+	int destBufferLen)
+{
+	return benchCase->ReadInstance(benchCase->Context, 0, destBuffer, destBufferLen);
+}
+
+static ReadBenchResult ReadBench_Measure(ReadBenchRead read, const ReadBenchCase * benchCase,
+	int iterations)
+{
+	uint8_t buffer[READBENCH_BUFFER_SIZE];
+	ReadBenchResult result;
+	uint64_t startTime, startCycles;
+	int i;
+
+	/* Warm up caches, branch predictors and any encoding caches of the object */
+	result.Length = read(benchCase, buffer, sizeof(buffer));
+	for (i = 0; i < iterations / 10; i++)
+		sink = read(benchCase, buffer, sizeof(buffer));
+
+	startTime = ReadBench_GetTime();
+	startCycles = ReadBench_GetCycles();
+	for (i = 0; i < iterations; i++)
+		sink = read(benchCase, buffer, sizeof(buffer));
+	result.Cycles = (double)(ReadBench_GetCycles() - startCycles) / iterations;
+	result.Nanoseconds = (double)(ReadBench_GetTime() - startTime) / iterations;
+	return result;
+}
+
+/* Writes the cached resources back with the values they have, which drops their TLV cache */
+static void ReadBench_InvalidateCache(const ReadBenchCase * benchCase)
+{
+	const ReadBenchObject * object = benchCase->Object;
+	uint8_t value[READBENCH_VALUE_SIZE];
+	int i, length;
+	bool changed;
+
+	for (i = 0; i < READBENCH_MAX_CACHED; i++)
+	{
+		ResourceIDType resourceID = benchCase->CachedResources[i];
+
+		if ((length = object->Handlers->Read(benchCase->Context, object->ObjectID, 0, resourceID,
+			0, value, sizeof(value))) > 0)
+			object->Handlers->Write(benchCase->Context, object->ObjectID, 0, resourceID, 0,
+				value, length, &changed);
+	}
+}
+
+/* Times bulk reads one at a time, each after a write of the cached resources if miss is set */
+static ReadBenchResult ReadBench_MeasureCache(const ReadBenchCase * benchCase, int iterations,
+	bool miss)
+{
+	uint8_t buffer[READBENCH_BUFFER_SIZE];
+	ReadBenchResult result = { 0 };
+	uint64_t nanoseconds = 0, cycles = 0;
+	int i;
+
+	for (i = 0; i < iterations; i++)
+	{
+		uint64_t startTime, startCycles;
+
+		if (miss)
+			ReadBench_InvalidateCache(benchCase);
+
+		startTime = ReadBench_GetTime();
+		startCycles = ReadBench_GetCycles();
+		result.Length = ReadBench_ReadBulk(benchCase, buffer, sizeof(buffer));
+		cycles += ReadBench_GetCycles() - startCycles;
+		nanoseconds += ReadBench_GetTime() - startTime;
+	}
+	result.Cycles = (double)cycles / iterations;
+	result.Nanoseconds = (double)nanoseconds / iterations;
+	return result;
+}
+
+/* Encodes each readable resource of every reported instance as a separate TLV notification */
+static int ReadBench_ReportPerResource(Lwm2mContextType * context, int * messages)
+{
+	static const ObjectIDType objectIDs[] = { DIGITAL_INPUT_OBJECT, LIGHT_CONTROL_OBJECT };
+	uint8_t value[READBENCH_VALUE_SIZE], message[READBENCH_VALUE_SIZE];
+	int i, j, instanceID, length = 0;
+
+	*messages = 0;
+	for (i = 0; i < sizeof(objectIDs) / sizeof(objectIDs[0]); i++)
+	{
+		const ReadBenchObject * object = ReadBench_FindObject(objectIDs[i]);
+
+		for (instanceID = 0; instanceID < cases[i].Instances; instanceID++)
+		{
+			for (j = 0; j < object->ResourceCount; j++)
+			{
+				const ReadBenchResource * resource = &object->Resources[j];
+				int valueLength, encoded;
+
+				if (!ReadBench_IsReadable(resource) ||
+					(valueLength = object->Handlers->Read(context, object->ObjectID, instanceID,
+					resource->ResourceID, 0, value, sizeof(value))) <= 0)
+					continue;
+
+				if ((encoded = Tlv_EncodeResource(message, sizeof(message), resource->ResourceID,
+					resource->Type, value, valueLength)) == -1)
+					return -1;
+				length += READBENCH_COAP_NOTIFY_OVERHEAD + encoded;
+				(*messages)++;
+			}
+		}
+	}
+	return length;
+}
+
+/* Encodes every resource of every reported instance into one SenML-CBOR payload */
+static int ReadBench_ReportSenML(Lwm2mContextType * context, int * messages)
+{
+	static const ObjectInstanceIDType instances[READBENCH_REPORT_INSTANCES] = { 0, 1 };
+	uint8_t payload[READBENCH_BUFFER_SIZE];
+	SenMLCborEncoder encoder;
+	int length;
+
+	SenMLCbor_Init(&encoder, payload, sizeof(payload), "/", READBENCH_REPORT_TIME_MS);
+	if (DigitalInput_EncodeSenML(context, &encoder, instances, READBENCH_REPORT_INSTANCES, NULL,
+		0, READBENCH_REPORT_TIME_MS) == -1 || LightControl_EncodeSenML(context, &encoder,
+		instances, READBENCH_REPORT_INSTANCES, NULL, 0, READBENCH_REPORT_TIME_MS) == -1 ||
+		(length = SenMLCbor_Finish(&encoder)) == -1)
+		return -1;
+
+	*messages = 1;
+	return READBENCH_COAP_NOTIFY_OVERHEAD + length;
+}
+
+static ReadBenchResult ReadBench_MeasureReport(int (*report)(Lwm2mContextType *, int *),
+	Lwm2mContextType * context, int iterations)
+{
+	ReadBenchResult result;
+	uint64_t startTime, startCycles;
+	int i, messages;
+
+	result.Length = report(context, &result.Messages);
+	startTime = ReadBench_GetTime();
+	startCycles = ReadBench_GetCycles();
+	for (i = 0; i < iterations; i++)
+		sink = report(context, &messages);
+	result.Cycles = (double)(ReadBench_GetCycles() - startCycles) / iterations;
+	result.Nanoseconds = (double)(ReadBench_GetTime() - startTime) / iterations;
+	return result;
+}
+
+/* Writes a value to every writable string and opaque resource, so that every resource is read */
+static void ReadBench_FillInstance(Lwm2mContextType * context, const ReadBenchObject * object,
+	ObjectInstanceIDType instanceID)
+{
+	static const uint8_t opaque[16] = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF };
+	int i;
+
+	for (i = 0; i < object->ResourceCount; i++)
+	{
+		const ReadBenchResource * resource = &object->Resources[i];
+		bool changed;
+
+		if (resource->Mandatory == MandatoryEnum_Optional &&
+			object->Handlers->CreateOptionalResource)
+			object->Handlers->CreateOptionalResource(context, object->ObjectID, instanceID,
+				resource->ResourceID);
+
+		if (!ReadBench_IsWritable(resource) || object->Handlers->GetLength(context,
+			object->ObjectID, instanceID, resource->ResourceID, 0) > 0)
+			continue;
+
+		if (resource->Type == ResourceTypeEnum_TypeString)
+			object->Handlers->Write(context, object->ObjectID, instanceID, resource->ResourceID, 0,
+				(uint8_t *)"#FF8000", 7, &changed);
+		else if (resource->Type == ResourceTypeEnum_TypeOpaque)
+			object->Handlers->Write(context, object->ObjectID, instanceID, resource->ResourceID, 0,
+				(uint8_t *)opaque, sizeof(opaque), &changed);
+	}
+}
+
+static void ReadBench_PrintReport(const char * format, const ReadBenchResult * result)
+{
+	printf("%-14s %8d %8d %8d %10.1f %10.0f\n", format, result->Messages, result->Length,
+		result->Length + result->Messages * READBENCH_UDP_IPV4_OVERHEAD, result->Nanoseconds,
+		result->Cycles);
+}
+
+static void ReadBench_PrintReports(Lwm2mContextType * context, int iterations)
+{
+	ReadBenchResult perResource = ReadBench_MeasureReport(ReadBench_ReportPerResource, context,
+		iterations);
+	ReadBenchResult senML = ReadBench_MeasureReport(ReadBench_ReportSenML, context, iterations);
+
+	printf("\nReporting %d Digital Input and %d Light Control instances, %d iterations\n",
+		READBENCH_REPORT_INSTANCES, READBENCH_REPORT_INSTANCES, iterations);
+	printf("%-14s %8s %8s %8s %10s %10s\n", "format", "messages", "coap", "udp/ip", "ns",
+		"cycles");
+	ReadBench_PrintReport("TLV/resource", &perResource);
+	ReadBench_PrintReport("SenML-CBOR", &senML);
+}
+
+static void ReadBench_Usage(const char * program)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -n iterations     reads of each instance per measurement (default %d)\n",
+		program, READBENCH_DEFAULT_ITERATIONS);
+}
+
+int main(int argc, char ** argv)
+{
+	Lwm2mContextType * context;
+	int iterations = READBENCH_DEFAULT_ITERATIONS;
+	int option, i, instanceID;
+
+	while ((option = getopt(argc, argv, "n:h")) != -1)
+	{
+		switch (option)
+		{
+			case 'n': iterations = atoi(optarg); break;
+			default:
+				ReadBench_Usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (iterations <= 0)
+	{
+		ReadBench_Usage(argv[0]);
+		return 1;
+	}
+
+	if ((context = Lwm2mCore_Init(NULL, "readbench")) == NULL ||
+		Lwm2m_RegisterFlowObject(context) == -1 ||
+		DigitalInput_RegisterDigitalInputObject(context) == -1 ||
+		LightControl_RegisterLightControlObject(context) == -1 ||
+		Lwm2m_SetProvisioningInfo(context, "ReadBench", "READBENCH", 1) == -1 ||
+		DigitalInput_AddDigitalInputs(context, 0, READBENCH_REPORT_INSTANCES) == -1 ||
+		LightControl_AddLightControls(context, 0, READBENCH_REPORT_INSTANCES, NULL,
+		NULL) == -1)
+	{
+		fprintf(stderr, "Failed to set up the client\n");
+		return 1;
+	}
+
+	for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		cases[i].Context = context;
+		if ((cases[i].Object = ReadBench_FindObject(cases[i].ObjectID)) == NULL)
+			return 1;
+		for (instanceID = 0; instanceID < cases[i].Instances; instanceID++)
+			ReadBench_FillInstance(context, cases[i].Object, instanceID);
+	}
+
+	printf("Whole-instance reads, %d iterations\n", iterations);
+	printf("%-14s %6s %10s %10s %10s %10s %8s\n", "object", "bytes", "per-res ns", "bulk ns",
+		"per-res cy", "bulk cy", "speedup");
+
+	for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		ReadBenchResult perResource = ReadBench_Measure(ReadBench_ReadPerResource, &cases[i],
+			iterations);
+		ReadBenchResult bulk = ReadBench_Measure(ReadBench_ReadBulk, &cases[i], iterations);
+
+		if (perResource.Length != bulk.Length)
+			fprintf(stderr, "%s: per-resource read gave %d bytes, bulk read %d\n",
+				cases[i].Name, perResource.Length, bulk.Length);
+
+		printf("%-14s %6d %10.1f %10.1f %10.0f %10.0f %7.2fx\n", cases[i].Name, bulk.Length,
+			perResource.Nanoseconds, bulk.Nanoseconds, perResource.Cycles, bulk.Cycles,
+			perResource.Nanoseconds / bulk.Nanoseconds);
+	}
+
+	/* Single reads are timed one at a time, so the clock's own cost is in both columns */
+	printf("\nBulk reads with the TLV cache empty (miss) and filled (hit), %d iterations\n",
+		iterations);
+	printf("%-14s %10s %10s %10s %10s %10s\n", "object", "miss ns", "hit ns", "miss cy",
+		"hit cy", "saved cy");
+
+	for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		ReadBenchResult miss = ReadBench_MeasureCache(&cases[i], iterations, true);
+		ReadBenchResult hit = ReadBench_MeasureCache(&cases[i], iterations, false);
+
+		printf("%-14s %10.1f %10.1f %10.0f %10.0f %10.0f\n", cases[i].Name, miss.Nanoseconds,
+			hit.Nanoseconds, miss.Cycles, hit.Cycles, miss.Cycles - hit.Cycles);
+	}
+
+	ReadBench_PrintReports(context, iterations);
+
+	ClientState_Destroy(context);
+	Lwm2mCore_Destroy(context);
+	return 0;
+}
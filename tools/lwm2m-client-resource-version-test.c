@@ -0,0 +1,329 @@
+/**
+ * @file
+ * LightWeightM2M resource version test.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Checks lwm2m-client-resource-version.c: restamped resources reported once at their latest
+ * version, paging through changes with the last version returned, instance deletes hiding the
+ * instance's resources, and the stamps the Light Control and Digital Input objects make when they
+ * are created, written and set. Each check uses a client of its own. Any mismatch fails the run.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lwm2m_core.h"
+#include "lwm2m-client-resource-version.h"
+#include "lwm2m-client-ipso-digital-input.h"
+#include "lwm2m-client-ipso-light-control.h"
+#include "lwm2m-client-state.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define RESOURCE_VERSION_TEST_MAX_CHANGES	64
+
+#define RESOURCE_VERSION_TEST_OBJECT		3303
+#define RESOURCE_VERSION_TEST_VALUE			5700
+#define RESOURCE_VERSION_TEST_DIGITAL_INPUT	3200
+#define RESOURCE_VERSION_TEST_STATE			5500
+#define RESOURCE_VERSION_TEST_LIGHT_CONTROL	3311
+#define RESOURCE_VERSION_TEST_ON_OFF		5850
+
+#define RESOURCE_VERSION_TEST_CHECK(test, condition, ...)                                         \
+	do                                                                                            \
+	{                                                                                             \
+		if (!(condition))                                                                         \
+		{                                                                                         \
+			printf("%s: ", (test)->Name);                                                         \
+			printf(__VA_ARGS__);                                                                  \
+			printf("\n");                                                                         \
+			(test)->Failed = true;                                                                \
+			return;                                                                               \
+		}                                                                                         \
+	} while (0)
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef struct
+{
+	const char * Name;
+	Lwm2mContextType * Context;
+	bool Failed;
+	ResourceVersionChange Changes[RESOURCE_VERSION_TEST_MAX_CHANGES];
+	int ChangeCount;
+} ResourceVersionTest;
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+static void ResourceVersionTest_Begin(ResourceVersionTest * test, const char * name)
+{
+	memset(test, 0, sizeof(*test));
+	test->Name = name;
+	if ((test->Context = Lwm2mCore_Init(NULL, "resourceversiontest")) == NULL)
+		test->Failed = true;
+}
+
+static bool ResourceVersionTest_End(ResourceVersionTest * test)
+{
+	if (test->Context != NULL)
+	{
+		ClientState_Destroy(test->Context);
+		Lwm2mCore_Destroy(test->Context);
+	}
+	printf("%-16s %s\n", test->Name, test->Failed ? "FAILED" : "passed");
+	return !test->Failed;
+}
+
+/* Fetches everything changed after version, returning the total or -1 */
+static int ResourceVersionTest_GetChanges(ResourceVersionTest * test, uint32_t version)
+{
+	int count = ResourceVersion_GetChangedSince(test->Context, version, test->Changes,
+		RESOURCE_VERSION_TEST_MAX_CHANGES);
+
+	test->ChangeCount = count < RESOURCE_VERSION_TEST_MAX_CHANGES ? count :
+		RESOURCE_VERSION_TEST_MAX_CHANGES;
+	return count;
+}
+
+/* Returns the change fetched for the resource, or NULL */
+static const ResourceVersionChange * ResourceVersionTest_Find(ResourceVersionTest * test,
+	ObjectIDType objectID, ObjectInstanceIDType objectInstanceID, ResourceIDType resourceID)
+{
+	int i;
+
+	for (i = 0; i < test->ChangeCount; i++)
+	{
+		const ResourceVersionChange * change = &test->Changes[i];
+
+		if (change->ObjectID == objectID && change->ObjectInstanceID == objectInstanceID &&
+			change->ResourceID == resourceID)
+			return change;
+	}
+	return NULL;
+}
+
+/* Versions count up from 1, and a resource stamped again is reported once, at its latest */
+static void ResourceVersionTest_Restamp(ResourceVersionTest * test)
+{
+	const ResourceVersionChange * change;
+	uint32_t version;
+	int count, i;
+
+	RESOURCE_VERSION_TEST_CHECK(test, ResourceVersion_GetCurrent(test->Context) == 0,
+		"a new client starts at version %" PRIu32, ResourceVersion_GetCurrent(test->Context));
+
+	for (i = 0; i < 3; i++)
+	{
+		version = ResourceVersion_Stamp(test->Context, RESOURCE_VERSION_TEST_OBJECT, i,
+			RESOURCE_VERSION_TEST_VALUE);
+		RESOURCE_VERSION_TEST_CHECK(test, version == (uint32_t)i + 1,
+			"stamp %d gave version %" PRIu32, i, version);
+	}
+	version = ResourceVersion_Stamp(test->Context, RESOURCE_VERSION_TEST_OBJECT, 0,
+		RESOURCE_VERSION_TEST_VALUE);
+
+	count = ResourceVersionTest_GetChanges(test, 0);
+	RESOURCE_VERSION_TEST_CHECK(test, count == 3, "%d changes, expected 3", count);
+	RESOURCE_VERSION_TEST_CHECK(test, test->Changes[0].ObjectInstanceID == 1 &&
+		test->Changes[1].ObjectInstanceID == 2 && test->Changes[2].ObjectInstanceID == 0,
+		"changes not oldest first");
+	change = &test->Changes[2];
+	RESOURCE_VERSION_TEST_CHECK(test, change->Version == version && version == 4 &&
+		!change->Deleted, "restamped resource at version %" PRIu32 ", expected 4",
+		change->Version);
+
+	count = ResourceVersionTest_GetChanges(test, version);
+	RESOURCE_VERSION_TEST_CHECK(test, count == 0, "%d changes after the latest version", count);
+}
+
+/* Passing back the version of the last change returned fetches the next page */
+static void ResourceVersionTest_Paging(ResourceVersionTest * test)
+{
+	ResourceVersionChange page[3];
+	uint32_t version = 0;
+	int fetched = 0, count, i;
+
+	for (i = 0; i < 10; i++)
+	{
+		ResourceVersion_Stamp(test->Context, RESOURCE_VERSION_TEST_OBJECT, 0,
+			RESOURCE_VERSION_TEST_VALUE + i);
+	}
+
+	while (fetched < 10)
+	{
+		count = ResourceVersion_GetChangedSince(test->Context, version, page, 3);
+		RESOURCE_VERSION_TEST_CHECK(test, count == 10 - fetched,
+			"%d changes after version %" PRIu32 ", expected %d", count, version, 10 - fetched);
+
+		for (i = 0; i < count && i < 3; i++)
+		{
+			RESOURCE_VERSION_TEST_CHECK(test,
+				page[i].ResourceID == RESOURCE_VERSION_TEST_VALUE + fetched &&
+				page[i].Version == (uint32_t)fetched + 1, "change %d is resource %d at version %"
+				PRIu32, fetched, page[i].ResourceID, page[i].Version);
+			fetched++;
+		}
+		version = page[i - 1].Version;
+	}
+}
+
+/*
+ * Deleting an instance reports only the deletion, and creating it again reports the instance
+ * but not the resources it had before.
+ */
+static void ResourceVersionTest_DeleteInstance(ResourceVersionTest * test)
+{
+	const ResourceVersionChange * change;
+	uint32_t version;
+	int count, i;
+
+	for (i = 0; i < 2; i++)
+	{
+		ResourceVersion_StampInstance(test->Context, RESOURCE_VERSION_TEST_OBJECT, i, false);
+		ResourceVersion_Stamp(test->Context, RESOURCE_VERSION_TEST_OBJECT, i,
+			RESOURCE_VERSION_TEST_VALUE);
+		ResourceVersion_Stamp(test->Context, RESOURCE_VERSION_TEST_OBJECT, i,
+			RESOURCE_VERSION_TEST_VALUE + 1);
+	}
+	version = ResourceVersion_StampInstance(test->Context, RESOURCE_VERSION_TEST_OBJECT, 0, true);
+
+	count = ResourceVersionTest_GetChanges(test, 0);
+	RESOURCE_VERSION_TEST_CHECK(test, count == 4, "%d changes, expected 4", count);
+	change = ResourceVersionTest_Find(test, RESOURCE_VERSION_TEST_OBJECT, 0,
+		RESOURCE_VERSION_INSTANCE);
+	RESOURCE_VERSION_TEST_CHECK(test, change != NULL && change->Deleted &&
+		change->Version == version, "deletion of instance 0 not reported");
+	RESOURCE_VERSION_TEST_CHECK(test, ResourceVersionTest_Find(test, RESOURCE_VERSION_TEST_OBJECT,
+		0, RESOURCE_VERSION_TEST_VALUE) == NULL, "resource of a deleted instance reported");
+	RESOURCE_VERSION_TEST_CHECK(test, ResourceVersionTest_Find(test, RESOURCE_VERSION_TEST_OBJECT,
+		1, RESOURCE_VERSION_TEST_VALUE + 1) != NULL, "resource of instance 1 lost");
+
+	ResourceVersion_StampInstance(test->Context, RESOURCE_VERSION_TEST_OBJECT, 0, false);
+	count = ResourceVersionTest_GetChanges(test, version);
+	RESOURCE_VERSION_TEST_CHECK(test, count == 1 && test->Changes[0].ObjectInstanceID == 0 &&
+		test->Changes[0].ResourceID == RESOURCE_VERSION_INSTANCE && !test->Changes[0].Deleted,
+		"%d changes after creating instance 0 again, expected only the instance", count);
+}
+
+/* The objects stamp instances they create, resources written through the core, and setters */
+static void ResourceVersionTest_Objects(ResourceVersionTest * test)
+{
+	const ResourceVersionChange * change;
+	uint32_t version;
+	bool onOff = true;
+	int count, i;
+
+	RESOURCE_VERSION_TEST_CHECK(test, LightControl_RegisterLightControlObject(test->Context) == 0 &&
+		DigitalInput_RegisterDigitalInputObject(test->Context) == 0 &&
+		LightControl_AddLightControls(test->Context, 0, 2, NULL, NULL) == 0 &&
+		DigitalInput_AddDigitalInputs(test->Context, 0, 2) == 0, "failed to add instances");
+
+	count = ResourceVersionTest_GetChanges(test, 0);
+	for (i = 0; i < 2; i++)
+	{
+		RESOURCE_VERSION_TEST_CHECK(test, ResourceVersionTest_Find(test,
+			RESOURCE_VERSION_TEST_LIGHT_CONTROL, i, RESOURCE_VERSION_INSTANCE) != NULL &&
+			ResourceVersionTest_Find(test, RESOURCE_VERSION_TEST_DIGITAL_INPUT, i,
+			RESOURCE_VERSION_INSTANCE) != NULL, "creation of instance %d not reported", i);
+	}
+
+	version = ResourceVersion_GetCurrent(test->Context);
+	RESOURCE_VERSION_TEST_CHECK(test, Lwm2mCore_SetResourceInstanceValue(test->Context,
+		RESOURCE_VERSION_TEST_LIGHT_CONTROL, 1, RESOURCE_VERSION_TEST_ON_OFF, 0, &onOff,
+		sizeof(onOff)) != -1, "On/Off write failed");
+	count = ResourceVersionTest_GetChanges(test, version);
+	change = ResourceVersionTest_Find(test, RESOURCE_VERSION_TEST_LIGHT_CONTROL, 1,
+		RESOURCE_VERSION_TEST_ON_OFF);
+	RESOURCE_VERSION_TEST_CHECK(test, count == 1 && change != NULL,
+		"%d changes after an On/Off write, expected Light Control 1 On/Off", count);
+
+	version = ResourceVersion_GetCurrent(test->Context);
+	RESOURCE_VERSION_TEST_CHECK(test, DigitalInput_SetInput(test->Context, 0, true) == 0,
+		"SetInput failed");
+	count = ResourceVersionTest_GetChanges(test, version);
+	change = ResourceVersionTest_Find(test, RESOURCE_VERSION_TEST_DIGITAL_INPUT, 0,
+		RESOURCE_VERSION_TEST_STATE);
+	RESOURCE_VERSION_TEST_CHECK(test, count >= 1 && change != NULL,
+		"Digital Input 0 State not reported after SetInput");
+	for (i = 0; i < test->ChangeCount; i++)
+	{
+		change = &test->Changes[i];
+		RESOURCE_VERSION_TEST_CHECK(test, change->ObjectID == RESOURCE_VERSION_TEST_DIGITAL_INPUT &&
+			change->ObjectInstanceID == 0, "SetInput stamped %d/%d/%d", change->ObjectID,
+			change->ObjectInstanceID, change->ResourceID);
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	static ResourceVersionTest test;
+	bool passed = true;
+
+	ResourceVersionTest_Begin(&test, "restamp");
+	if (!test.Failed)
+		ResourceVersionTest_Restamp(&test);
+	passed &= ResourceVersionTest_End(&test);
+
+	ResourceVersionTest_Begin(&test, "paging");
+	if (!test.Failed)
+		ResourceVersionTest_Paging(&test);
+	passed &= ResourceVersionTest_End(&test);
+
+	ResourceVersionTest_Begin(&test, "delete instance");
+	if (!test.Failed)
+		ResourceVersionTest_DeleteInstance(&test);
+	passed &= ResourceVersionTest_End(&test);
+
+	ResourceVersionTest_Begin(&test, "objects");
+	if (!test.Failed)
+		ResourceVersionTest_Objects(&test);
+	passed &= ResourceVersionTest_End(&test);
+
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,515 @@
+/**
+ * @file
+ * LightWeightM2M sequence lock stress test.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks lwm2m-client-seqlock.h for torn reads. Writer threads keep rewriting a record that spans
+ * two cache lines, every word set to the same generation number, under the record's sequence
+ * lock. Reader threads take snapshots the way the objects do and check that all the words of each
+ * snapshot agree. A single torn snapshot fails the run. Run it on a weakly ordered CPU (ARM,
+ * POWER) as well as on x86, where the hardware hides most ordering mistakes. With -u the writers
+ * skip the lock, which shows that the check does catch torn snapshots.
+ *
+ * With -o the same check runs against real Digital Input and Light Control instances. A GPIO-like
+ * thread toggles the input with DigitalInput_SetInputAt(), a core thread rewrites its Sensor Type,
+ * and a dispatcher thread reports On/Off, Dimmer and Colour with LightControl_ReportState(), all
+ * derived from one value. Readers decode *_ReadInstance() and check the values still agree.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include "lwm2m_core.h"
+#include "lwm2m-client-seqlock.h"
+#include "lwm2m-client-ipso-digital-input.h"
+#include "lwm2m-client-ipso-light-control.h"
+#include "lwm2m-client-history.h"
+#include "lwm2m-client-state.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define SEQLOCK_STRESS_DEFAULT_WRITERS		1
+#define SEQLOCK_STRESS_DEFAULT_DURATION		10
+#define SEQLOCK_STRESS_MAX_THREADS			256
+
+#define SEQLOCK_STRESS_WORDS				(2 * SEQLOCK_CACHE_LINE_SIZE / sizeof(uint64_t) - 1)
+
+/* Object mode runs these writers, each standing in for a thread of a real client */
+#define SEQLOCK_STRESS_OBJECT_WRITERS		3
+#define SEQLOCK_STRESS_BUFFER_SIZE			512
+
+#define DIGITAL_INPUT_OBJECT				3200
+#define DIGITAL_INPUT_STATE					5500
+#define DIGITAL_INPUT_COUNTER				5501
+#define DIGITAL_INPUT_EDGE_SELECTION		5504
+#define DIGITAL_INPUT_SENSOR_TYPE			5751
+#define LIGHT_CONTROL_ON_OFF				5850
+#define LIGHT_CONTROL_DIMMER				5851
+#define LIGHT_CONTROL_COLOUR				5706
+
+#define TLV_ID_16BIT						0x20
+#define TLV_LENGTH_TYPE						0x18
+#define TLV_LENGTH							0x07
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef struct
+{
+	SeqLock Lock;
+	uint64_t Words[SEQLOCK_STRESS_WORDS];
+} SEQLOCK_ALIGNED SeqLockStressRecord;
+
+typedef struct
+{
+	pthread_t Thread;
+	uint64_t Operations;
+	uint64_t Retries;
+	uint64_t Torn;
+} SEQLOCK_ALIGNED SeqLockStressThread;
+
+typedef struct
+{
+	int Writers;
+	int Readers;
+	int Duration;
+	bool Unlocked;
+	bool Objects;
+} SeqLockStressOptions;
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+static SeqLockStressRecord record;
+static SeqLockStressOptions options;
+static volatile bool stop;
+static Lwm2mContextType * context;
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+static void * SeqLockStress_Writer(void * argument)
+{
+	SeqLockStressThread * thread = argument;
+	uint64_t generation;
+	int i;
+
+	while (!stop)
+	{
+		if (!options.Unlocked)
+			SeqLock_WriteBegin(&record.Lock);
+
+		/* Plain stores, as the objects' write handlers make */
+		generation = record.Words[0] + 1;
+		for (i = 0; i < SEQLOCK_STRESS_WORDS; i++)
+			record.Words[i] = generation;
+
+		if (!options.Unlocked)
+			SeqLock_WriteEnd(&record.Lock);
+		thread->Operations++;
+	}
+	return NULL;
+}
+
+static void * SeqLockStress_Reader(void * argument)
+{
+	SeqLockStressThread * thread = argument;
+	SeqLockStressRecord snapshot;
+	uint32_t sequence;
+	int i;
+
+	while (!stop)
+	{
+		sequence = SeqLock_ReadBegin(&record.Lock);
+		memcpy(&snapshot, &record, sizeof(snapshot));
+		while (SeqLock_ReadRetry(&record.Lock, sequence))
+		{
+			thread->Retries++;
+			sequence = SeqLock_ReadBegin(&record.Lock);
+			memcpy(&snapshot, &record, sizeof(snapshot));
+		}
+
+		for (i = 1; i < SEQLOCK_STRESS_WORDS; i++)
+		{
+			if (snapshot.Words[i] != snapshot.Words[0])
+			{
+				thread->Torn++;
+				break;
+			}
+		}
+		thread->Operations++;
+	}
+	return NULL;
+}
+
+/* Strings whose every character and length follow from one value, so a mixed copy shows */
+static int SeqLockStress_FillString(char * string, char first, int length)
+{
+	memset(string, first, length);
+	string[length] = '\0';
+	return length + 1;
+}
+
+static bool SeqLockStress_CheckString(const uint8_t * value, int length, char first)
+{
+	int i;
+
+	for (i = 0; i < length; i++)
+	{
+		if (value[i] != first)
+			return false;
+	}
+	return true;
+}
+
+/* Toggles the input the way a GPIO thread does; with both edges counted State is Counter & 1 */
+static void * SeqLockStress_InputWriter(void * argument)
+{
+	SeqLockStressThread * thread = argument;
+	bool state = false;
+
+	while (!stop)
+	{
+		state = !state;
+		DigitalInput_SetInputAt(context, 0, state, ResourceHistory_GetTime());
+		thread->Operations++;
+	}
+	return NULL;
+}
+
+/* Rewrites Sensor Type through the core, whose length picks its character */
+static void * SeqLockStress_CoreWriter(void * argument)
+{
+	SeqLockStressThread * thread = argument;
+	char sensorType[128];
+	int length = 0, valueLength;
+
+	while (!stop)
+	{
+		length = length % 100 + 1;
+		valueLength = SeqLockStress_FillString(sensorType, 'a' + length % 26, length);
+		Lwm2mCore_SetResourceInstanceValue(context, DIGITAL_INPUT_OBJECT, 0,
+			DIGITAL_INPUT_SENSOR_TYPE, 0, sensorType, valueLength);
+		thread->Operations++;
+	}
+	return NULL;
+}
+
+/* Dimmer picks On/Off and the length and character of Colour */
+static void SeqLockStress_ReportLight(int dimmer)
+{
+	char colour[64];
+
+	SeqLockStress_FillString(colour, 'A' + dimmer % 26, 1 + dimmer % 50);
+	LightControl_ReportState(context, 0, dimmer & 1, dimmer, colour);
+}
+
+static void * SeqLockStress_LightWriter(void * argument)
+{
+	SeqLockStressThread * thread = argument;
+	int dimmer = 0;
+
+	while (!stop)
+	{
+		dimmer = (dimmer + 1) % 100;
+		SeqLockStress_ReportLight(dimmer);
+		thread->Operations++;
+	}
+	return NULL;
+}
+
+/* Finds a resource in a TLV instance and returns its value, or NULL if it is not there */
+static const uint8_t * SeqLockStress_FindTlv(const uint8_t * buffer, int length,
+	int resourceID, int * valueLength)
+{
+	int offset = 0;
+
+	while (offset < length)
+	{
+		uint8_t type = buffer[offset++];
+		int id, lengthBytes = (type & TLV_LENGTH_TYPE) >> 3;
+
+		if (type & TLV_ID_16BIT)
+		{
+			id = buffer[offset] << 8 | buffer[offset + 1];
+			offset += 2;
+		}
+		else
+			id = buffer[offset++];
+
+		if (lengthBytes == 0)
+			*valueLength = type & TLV_LENGTH;
+		else
+		{
+			for (*valueLength = 0; lengthBytes > 0; lengthBytes--)
+				*valueLength = *valueLength << 8 | buffer[offset++];
+		}
+
+		if (id == resourceID)
+			return &buffer[offset];
+		offset += *valueLength;
+	}
+	return NULL;
+}
+
+static bool SeqLockStress_GetInteger(const uint8_t * buffer, int length, int resourceID,
+	int64_t * integer)
+{
+	int valueLength, i;
+	const uint8_t * value = SeqLockStress_FindTlv(buffer, length, resourceID, &valueLength);
+
+	if (value == NULL || valueLength < 1 || valueLength > 8)
+		return false;
+
+	*integer = (int8_t)value[0];
+	for (i = 1; i < valueLength; i++)
+		*integer = *integer * 256 + value[i];
+	return true;
+}
+
+static bool SeqLockStress_CheckInput(const uint8_t * buffer, int length)
+{
+	int64_t state, counter;
+	int valueLength;
+	const uint8_t * sensorType;
+
+	if (!SeqLockStress_GetInteger(buffer, length, DIGITAL_INPUT_STATE, &state) ||
+		!SeqLockStress_GetInteger(buffer, length, DIGITAL_INPUT_COUNTER, &counter) ||
+		state != (counter & 1))
+	{
+		return false;
+	}
+
+	sensorType = SeqLockStress_FindTlv(buffer, length, DIGITAL_INPUT_SENSOR_TYPE, &valueLength);
+	return sensorType != NULL && valueLength >= 1 &&
+		SeqLockStress_CheckString(sensorType, valueLength, 'a' + valueLength % 26);
+}
+
+static bool SeqLockStress_CheckLight(const uint8_t * buffer, int length)
+{
+	int64_t onOff, dimmer;
+	int valueLength;
+	const uint8_t * colour;
+
+	if (!SeqLockStress_GetInteger(buffer, length, LIGHT_CONTROL_ON_OFF, &onOff) ||
+		!SeqLockStress_GetInteger(buffer, length, LIGHT_CONTROL_DIMMER, &dimmer) ||
+		onOff != (dimmer & 1))
+	{
+		return false;
+	}
+
+	colour = SeqLockStress_FindTlv(buffer, length, LIGHT_CONTROL_COLOUR, &valueLength);
+	return colour != NULL && valueLength == 1 + dimmer % 50 &&
+		SeqLockStress_CheckString(colour, valueLength, 'A' + dimmer % 26);
+}
+
+/* Reads each instance whole, as a bulk read or a notification does */
+static void * SeqLockStress_ObjectReader(void * argument)
+{
+	SeqLockStressThread * thread = argument;
+	uint8_t buffer[SEQLOCK_STRESS_BUFFER_SIZE];
+	int length;
+
+	while (!stop)
+	{
+		length = DigitalInput_ReadInstance(context, 0, buffer, sizeof(buffer));
+		if (length <= 0 || !SeqLockStress_CheckInput(buffer, length))
+			thread->Torn++;
+
+		length = LightControl_ReadInstance(context, 0, buffer, sizeof(buffer));
+		if (length <= 0 || !SeqLockStress_CheckLight(buffer, length))
+			thread->Torn++;
+		thread->Operations += 2;
+	}
+	return NULL;
+}
+
+/* One input and one light, both already holding values that pass the readers' checks */
+static bool SeqLockStress_SetUpObjects(void)
+{
+	int64_t edgeSelection = 3;
+	char sensorType[2];
+
+	if ((context = Lwm2mCore_Init(NULL, "seqlockstress")) == NULL ||
+		DigitalInput_RegisterDigitalInputObject(context) == -1 ||
+		LightControl_RegisterLightControlObject(context) == -1 ||
+		DigitalInput_AddDigitalInputs(context, 0, 1) == -1 ||
+		LightControl_AddLightControls(context, 0, 1, NULL, NULL) == -1 ||
+		Lwm2mCore_SetResourceInstanceValue(context, DIGITAL_INPUT_OBJECT, 0,
+			DIGITAL_INPUT_EDGE_SELECTION, 0, &edgeSelection, sizeof(edgeSelection)) == -1 ||
+		Lwm2mCore_SetResourceInstanceValue(context, DIGITAL_INPUT_OBJECT, 0,
+			DIGITAL_INPUT_SENSOR_TYPE, 0, sensorType,
+			SeqLockStress_FillString(sensorType, 'b', 1)) == -1)
+	{
+		return false;
+	}
+
+	SeqLockStress_ReportLight(0);
+	return true;
+}
+
+static void SeqLockStress_Usage(const char * program)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -w writers        writer threads (default %d)\n"
+		"  -r readers        reader threads (default one per remaining CPU, at least 1)\n"
+		"  -d seconds        duration of the run (default %d)\n"
+		"  -u                writers skip the lock, to check that torn reads are caught\n"
+		"  -o                read Digital Input and Light Control instances written by a GPIO,\n"
+		"                    a core and a dispatcher thread, ignoring -w\n",
+		program, SEQLOCK_STRESS_DEFAULT_WRITERS, SEQLOCK_STRESS_DEFAULT_DURATION);
+}
+
+int main(int argc, char ** argv)
+{
+	static void * (* const objectWriters[SEQLOCK_STRESS_OBJECT_WRITERS])(void *) =
+	{
+		SeqLockStress_InputWriter, SeqLockStress_CoreWriter, SeqLockStress_LightWriter
+	};
+	static SeqLockStressThread threads[SEQLOCK_STRESS_MAX_THREADS];
+	uint64_t writes = 0, reads = 0, retries = 0, torn = 0;
+	int option, i;
+
+	options.Writers = SEQLOCK_STRESS_DEFAULT_WRITERS;
+	options.Readers = -1;
+	options.Duration = SEQLOCK_STRESS_DEFAULT_DURATION;
+
+	while ((option = getopt(argc, argv, "w:r:d:uoh")) != -1)
+	{
+		switch (option)
+		{
+			case 'w': options.Writers = atoi(optarg); break;
+			case 'r': options.Readers = atoi(optarg); break;
+			case 'd': options.Duration = atoi(optarg); break;
+			case 'u': options.Unlocked = true; break;
+			case 'o': options.Objects = true; break;
+			default:
+				SeqLockStress_Usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (options.Objects)
+		options.Writers = SEQLOCK_STRESS_OBJECT_WRITERS;
+
+	if (options.Readers < 0)
+	{
+		options.Readers = sysconf(_SC_NPROCESSORS_ONLN) - options.Writers;
+		if (options.Readers < 1)
+			options.Readers = 1;
+	}
+
+	/* Unlocked writers would race each other as well as the readers */
+	if (options.Writers <= 0 || options.Readers <= 0 || options.Duration <= 0 ||
+		options.Writers + options.Readers > SEQLOCK_STRESS_MAX_THREADS ||
+		(options.Unlocked && (options.Writers > 1 || options.Objects)))
+	{
+		SeqLockStress_Usage(argv[0]);
+		return 1;
+	}
+
+	if (options.Objects && !SeqLockStress_SetUpObjects())
+	{
+		fprintf(stderr, "Failed to set up the client\n");
+		return 1;
+	}
+
+	for (i = 0; i < options.Writers + options.Readers; i++)
+	{
+		void * (* run)(void *);
+
+		if (options.Objects)
+			run = i < options.Writers ? objectWriters[i] : SeqLockStress_ObjectReader;
+		else
+			run = i < options.Writers ? SeqLockStress_Writer : SeqLockStress_Reader;
+
+		if (pthread_create(&threads[i].Thread, NULL, run, &threads[i]) != 0)
+		{
+			fprintf(stderr, "Failed to start thread %d\n", i);
+			return 1;
+		}
+	}
+
+	sleep(options.Duration);
+	stop = true;
+
+	for (i = 0; i < options.Writers + options.Readers; i++)
+	{
+		pthread_join(threads[i].Thread, NULL);
+		if (i < options.Writers)
+			writes += threads[i].Operations;
+		else
+		{
+			reads += threads[i].Operations;
+			retries += threads[i].Retries;
+			torn += threads[i].Torn;
+		}
+	}
+
+	printf("%d writers, %d readers, %d s%s\n", options.Writers, options.Readers, options.Duration,
+		options.Unlocked ? ", writers unlocked" : options.Objects ? ", objects" : "");
+	/* Object mode readers retry inside the objects, out of sight */
+	if (options.Objects)
+		printf("writes %" PRIu64 ", reads %" PRIu64 ", torn reads %" PRIu64 "\n", writes, reads,
+			torn);
+	else
+		printf("writes %" PRIu64 ", reads %" PRIu64 ", retries %" PRIu64 ", torn reads %" PRIu64
+			"\n", writes, reads, retries, torn);
+	printf("%s\n", torn == 0 ? "passed" : "FAILED");
+
+	if (options.Objects)
+	{
+		ClientState_Destroy(context);
+		Lwm2mCore_Destroy(context);
+	}
+	return torn == 0 ? 0 : 1;
+}
@@ -0,0 +1,577 @@
+/**
+ * @file
+ * LightWeightM2M object create, write and delete soak harness.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Runs create/write/read/delete cycles through the handlers of every object, as repeated
+ * bootstrap cycles do on a real client. The allocator and the core's object and resource type
+ * registration are interposed with the linker's --wrap option (see Makefile.soak). Registration
+ * still reaches the core, but the harness keeps a copy of each object's handlers so it can call
+ * them directly. Each object's instances are deleted at the end of every cycle. Any block still
+ * allocated after the delete that was not allocated before the create is a leak, and the harness
+ * stops with a non-zero exit status. The first few cycles of each client are a warm-up: per-client
+ * records are allocated on first use and kept until the client is destroyed, the string table
+ * keeps freed buffers for reuse once every string written has been seen, and objects with fewer
+ * instances than asked for are found out. Every few thousand cycles the client is destroyed and
+ * set up again, as a bootstrap would, and everything it allocated must be given back.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <time.h>
+#include <malloc.h>
+#include "lwm2m_core.h"
+#include "lwm2m-client-flow-object.h"
+#include "lwm2m-client-flow-access-object.h"
+#include "lwm2m-client-ipso-digital-input.h"
+#include "lwm2m-client-ipso-light-control.h"
+#include "lwm2m-client-ipso-power-measurement.h"
+#include "lwm2m-client-ipso-sensor.h"
+#include "lwm2m-client-diagnostics-object.h"
+#include "lwm2m-client-state.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define SOAK_DEFAULT_CYCLES					1000000
+#define SOAK_DEFAULT_BOOTSTRAP_INTERVAL		10000
+#define SOAK_DEFAULT_INSTANCES				4
+#define SOAK_DEFAULT_REPORT_INTERVAL		100000
+#define SOAK_WARMUP_CYCLES					3	/* One of each string Soak_WriteResource writes */
+
+#define SOAK_MAX_OBJECTS					16
+#define SOAK_MAX_RESOURCES					32
+#define SOAK_READ_BUFFER_SIZE				1024
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef struct
+{
+	ResourceIDType ResourceID;
+	ResourceTypeEnum Type;
+	MandatoryEnum Mandatory;
+	Operations Operations;
+} SoakResource;
+
+typedef struct
+{
+	ObjectIDType ObjectID;
+	const char * Name;
+	MultipleInstancesEnum MultipleInstances;
+	int Instances;
+	ObjectOperationHandlers * Handlers;
+	ResourceOperationHandlers * ResourceHandlers;
+	SoakResource Resources[SOAK_MAX_RESOURCES];
+	int ResourceCount;
+} SoakObject;
+
+typedef struct
+{
+	int64_t Blocks;
+	int64_t Bytes;
+} SoakUsage;
+
+typedef struct
+{
+	uint64_t Cycles;
+	uint64_t BootstrapInterval;
+	int Instances;
+	uint64_t ReportInterval;
+} SoakOptions;
+
+/***************************************************************************************************
+ * Prototypes
+ **************************************************************************************************/
+
+void * __real_malloc(size_t size);
+void * __real_calloc(size_t count, size_t size);
+void * __real_realloc(void * pointer, size_t size);
+void __real_free(void * pointer);
+int __real_posix_memalign(void ** pointer, size_t alignment, size_t size);
+
+int __real_Lwm2mCore_RegisterObjectType(Lwm2mContextType * context, char * objName,
+	ObjectIDType objectID, MultipleInstancesEnum multipleInstances, MandatoryEnum mandatory,
+	ObjectOperationHandlers * handlers);
+int __real_Lwm2mCore_RegisterResourceType(Lwm2mContextType * context, char * resName,
+	ObjectIDType objectID, ResourceIDType resourceID, ResourceTypeEnum resourceType,
+	MultipleInstancesEnum multipleInstances, MandatoryEnum mandatory, Operations operations,
+	ResourceOperationHandlers * handlers);
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+/* Updated atomically: the Light Control dispatcher allocates on its own thread */
+static SoakUsage usage;
+
+static SoakObject objects[SOAK_MAX_OBJECTS];
+static int objectCount;
+
+/***************************************************************************************************
+ * Allocator
+ **************************************************************************************************/
+
+static void Soak_Count(void * pointer, int blocks)
+{
+	if (pointer == NULL)
+		return;
+
+	__atomic_fetch_add(&usage.Blocks, blocks, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&usage.Bytes, blocks * (int64_t)malloc_usable_size(pointer),
+		__ATOMIC_RELAXED);
+}
+
+void * __wrap_malloc(size_t size)
+{
+	void * pointer = __real_malloc(size);
+
+	Soak_Count(pointer, 1);
+	return pointer;
+}
+
+void * __wrap_calloc(size_t count, size_t size)
+{
+	void * pointer = __real_calloc(count, size);
+
+	Soak_Count(pointer, 1);
+	return pointer;
+}
+
+void * __wrap_realloc(void * pointer, size_t size)
+{
+	size_t oldSize = pointer != NULL ? malloc_usable_size(pointer) : 0;
+	void * result = __real_realloc(pointer, size);
+
+	if (result != NULL)
+	{
+		if (pointer != NULL)
+			__atomic_fetch_sub(&usage.Bytes, (int64_t)oldSize, __ATOMIC_RELAXED);
+		else
+			__atomic_fetch_add(&usage.Blocks, 1, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&usage.Bytes, (int64_t)malloc_usable_size(result), __ATOMIC_RELAXED);
+	}
+	else if (pointer != NULL && size == 0)
+	{
+		/* glibc frees the block and returns NULL */
+		__atomic_fetch_sub(&usage.Blocks, 1, __ATOMIC_RELAXED);
+		__atomic_fetch_sub(&usage.Bytes, (int64_t)oldSize, __ATOMIC_RELAXED);
+	}
+	return result;
+}
+
+void __wrap_free(void * pointer)
+{
+	Soak_Count(pointer, -1);
+	__real_free(pointer);
+}
+
+int __wrap_posix_memalign(void ** pointer, size_t alignment, size_t size)
+{
+	int result = __real_posix_memalign(pointer, alignment, size);
+
+	if (result == 0)
+		Soak_Count(*pointer, 1);
+	return result;
+}
+
+static SoakUsage Soak_GetUsage(void)
+{
+	SoakUsage current;
+
+	current.Blocks = __atomic_load_n(&usage.Blocks, __ATOMIC_RELAXED);
+	current.Bytes = __atomic_load_n(&usage.Bytes, __ATOMIC_RELAXED);
+	return current;
+}
+
+/***************************************************************************************************
+ * Registration
+ **************************************************************************************************/
+
+static SoakObject * Soak_FindObject(ObjectIDType objectID)
+{
+	int i;
+
+	for (i = 0; i < objectCount; i++)
+	{
+		if (objects[i].ObjectID == objectID)
+			return &objects[i];
+	}
+	return NULL;
+}
+
+int __wrap_Lwm2mCore_RegisterObjectType(Lwm2mContextType * context, char * objName,
+	ObjectIDType objectID, MultipleInstancesEnum multipleInstances, MandatoryEnum mandatory,
+	ObjectOperationHandlers * handlers)
+{
+	SoakObject * object = Soak_FindObject(objectID);
+
+	if (object == NULL && objectCount < SOAK_MAX_OBJECTS)
+	{
+		object = &objects[objectCount++];
+		object->ObjectID = objectID;
+	}
+	if (object != NULL)
+	{
+		/* A new client registers everything again */
+		object->ResourceCount = 0;
+		object->Name = objName;
+		object->MultipleInstances = multipleInstances;
+		object->Handlers = handlers;
+	}
+	return __real_Lwm2mCore_RegisterObjectType(context, objName, objectID, multipleInstances,
+		mandatory, handlers);
+}
+
+int __wrap_Lwm2mCore_RegisterResourceType(Lwm2mContextType * context, char * resName,
+	ObjectIDType objectID, ResourceIDType resourceID, ResourceTypeEnum resourceType,
+	MultipleInstancesEnum multipleInstances, MandatoryEnum mandatory, Operations operations,
+	ResourceOperationHandlers * handlers)
+{
+	SoakObject * object = Soak_FindObject(objectID);
+
+	if (object != NULL && object->ResourceCount < SOAK_MAX_RESOURCES)
+	{
+		SoakResource * resource = &object->Resources[object->ResourceCount++];
+
+		resource->ResourceID = resourceID;
+		resource->Type = resourceType;
+		resource->Mandatory = mandatory;
+		resource->Operations = operations;
+		object->ResourceHandlers = handlers;
+	}
+	return __real_Lwm2mCore_RegisterResourceType(context, resName, objectID, resourceID,
+		resourceType, multipleInstances, mandatory, operations, handlers);
+}
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+static uint64_t Soak_GetTime(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static long Soak_GetResidentKB(void)
+{
+	FILE * file = fopen("/proc/self/statm", "r");
+	long size, resident = 0;
+
+	if (file != NULL)
+	{
+		if (fscanf(file, "%ld %ld", &size, &resident) != 2)
+			resident = 0;
+		fclose(file);
+	}
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/* Writes a value of the resource's type that changes from one cycle to the next */
+static void Soak_WriteResource(Lwm2mContextType * context, const SoakObject * object,
+	ObjectInstanceIDType instanceID, const SoakResource * resource, uint64_t cycle)
+{
+	static const char * strings[] =
+	{
+		"soak", "#FF8000", "a longer string that does not fit in a small buffer"
+	};
+	uint8_t opaque[32];
+	int64_t integer = (int64_t)(cycle % 101);
+	double real = (double)(cycle % 1000) / 10.0;
+	bool boolean = cycle & 1;
+	const void * value;
+	int length;
+	bool changed = false;
+
+	switch (resource->Type)
+	{
+		case ResourceTypeEnum_TypeString:
+			value = strings[cycle % 3];
+			length = strlen(value);
+			break;
+		case ResourceTypeEnum_TypeInteger:
+		case ResourceTypeEnum_TypeTime:
+			value = &integer;
+			length = sizeof(integer);
+			break;
+		case ResourceTypeEnum_TypeFloat:
+			value = &real;
+			length = sizeof(real);
+			break;
+		case ResourceTypeEnum_TypeBoolean:
+			value = &boolean;
+			length = sizeof(boolean);
+			break;
+		case ResourceTypeEnum_TypeOpaque:
+			memset(opaque, (int)cycle, sizeof(opaque));
+			value = opaque;
+			length = 1 + cycle % sizeof(opaque);
+			break;
+		default:
+			return;
+	}
+
+	/* Rejected values are part of the soak too: they must not leak either */
+	object->ResourceHandlers->Write(context, object->ObjectID, instanceID, resource->ResourceID, 0,
+		(uint8_t *)value, length, &changed);
+}
+
+static void Soak_ExerciseInstance(Lwm2mContextType * context, const SoakObject * object,
+	ObjectInstanceIDType instanceID, uint64_t cycle)
+{
+	ResourceOperationHandlers * handlers = object->ResourceHandlers;
+	uint8_t buffer[SOAK_READ_BUFFER_SIZE];
+	int i;
+
+	for (i = 0; i < object->ResourceCount; i++)
+	{
+		const SoakResource * resource = &object->Resources[i];
+
+		if (resource->Mandatory == MandatoryEnum_Optional && handlers->CreateOptionalResource)
+			handlers->CreateOptionalResource(context, object->ObjectID, instanceID,
+				resource->ResourceID);
+	}
+
+	for (i = 0; i < object->ResourceCount; i++)
+	{
+		const SoakResource * resource = &object->Resources[i];
+
+		if ((resource->Operations == Operations_W || resource->Operations == Operations_RW) &&
+			handlers->Write)
+			Soak_WriteResource(context, object, instanceID, resource, cycle);
+	}
+
+	for (i = 0; i < object->ResourceCount; i++)
+	{
+		const SoakResource * resource = &object->Resources[i];
+
+		if ((resource->Operations == Operations_R || resource->Operations == Operations_RW) &&
+			handlers->Read)
+			handlers->Read(context, object->ObjectID, instanceID, resource->ResourceID, 0,
+				buffer, sizeof(buffer));
+	}
+}
+
+/* Returns -1 if the object leaked during the cycle */
+static int Soak_CycleObject(Lwm2mContextType * context, SoakObject * object,
+	uint64_t clientCycle, uint64_t cycle)
+{
+	SoakUsage before = Soak_GetUsage(), after;
+	int instanceID;
+
+	for (instanceID = 0; instanceID < object->Instances; instanceID++)
+	{
+		if (object->Handlers->CreateInstance(context, object->ObjectID, instanceID) == -1)
+		{
+			/* Objects with fewer instances than asked for are found out in the first cycle */
+			if (clientCycle == 0 && instanceID > 0)
+			{
+				object->Instances = instanceID;
+				break;
+			}
+			fprintf(stderr, "cycle %" PRIu64 ": failed to create %s/%d\n", cycle, object->Name,
+				instanceID);
+			return -1;
+		}
+		if (object->ResourceHandlers != NULL)
+			Soak_ExerciseInstance(context, object, instanceID, cycle);
+	}
+
+	for (instanceID = 0; instanceID < object->Instances; instanceID++)
+		object->Handlers->Delete(context, object->ObjectID, instanceID, -1);
+
+	after = Soak_GetUsage();
+	if (clientCycle >= SOAK_WARMUP_CYCLES &&
+		(after.Blocks != before.Blocks || after.Bytes != before.Bytes))
+	{
+		fprintf(stderr, "cycle %" PRIu64 ": %s left %" PRId64 " blocks (%" PRId64 " bytes) "
+			"allocated after delete\n", cycle, object->Name, after.Blocks - before.Blocks,
+			after.Bytes - before.Bytes);
+		return -1;
+	}
+	return 0;
+}
+
+static int Soak_RegisterObjects(Lwm2mContextType * context)
+{
+	return Lwm2m_RegisterFlowObject(context) == -1 ||
+		Lwm2m_RegisterFlowAccessObject(context) == -1 ||
+		DigitalInput_RegisterDigitalInputObject(context) == -1 ||
+		LightControl_RegisterLightControlObject(context) == -1 ||
+		PowerMeasurement_RegisterPowerMeasurementObject(context) == -1 ||
+		Sensor_RegisterTemperatureObject(context) == -1 ||
+		Sensor_RegisterHumidityObject(context) == -1 ||
+		Sensor_RegisterBarometerObject(context) == -1 ||
+		Diagnostics_RegisterDiagnosticsObject(context) == -1 ? -1 : 0;
+}
+
+static Lwm2mContextType * Soak_StartClient(const SoakOptions * options)
+{
+	Lwm2mContextType * context;
+	int i;
+
+	if ((context = Lwm2mCore_Init(NULL, "soak")) == NULL || Soak_RegisterObjects(context) == -1)
+	{
+		fprintf(stderr, "Failed to set up the client\n");
+		return NULL;
+	}
+
+	for (i = 0; i < objectCount; i++)
+		objects[i].Instances = objects[i].MultipleInstances == MultipleInstancesEnum_Multiple ?
+			options->Instances : 1;
+	return context;
+}
+
+static void Soak_Usage(const char * program)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -n cycles         create/write/delete cycles (default %d)\n"
+		"  -b cycles         cycles before the client is destroyed and set up again (default %d)\n"
+		"  -i instances      instances of each multiple-instance object (default %d)\n"
+		"  -r cycles         cycles between reports (default %d)\n",
+		program, SOAK_DEFAULT_CYCLES, SOAK_DEFAULT_BOOTSTRAP_INTERVAL, SOAK_DEFAULT_INSTANCES,
+		SOAK_DEFAULT_REPORT_INTERVAL);
+}
+
+static void Soak_Report(uint64_t cycles, uint64_t startTime, SoakUsage start)
+{
+	uint64_t elapsed = Soak_GetTime() - startTime;
+	SoakUsage current = Soak_GetUsage();
+
+	printf("%12" PRIu64 " %12.0f %12" PRId64 " %12" PRId64 " %10ld\n", cycles,
+		elapsed > 0 ? cycles * 1e6 / elapsed : 0.0, current.Blocks - start.Blocks,
+		current.Bytes - start.Bytes, Soak_GetResidentKB());
+	fflush(stdout);
+}
+
+int main(int argc, char ** argv)
+{
+	SoakOptions options =
+	{
+		.Cycles = SOAK_DEFAULT_CYCLES,
+		.BootstrapInterval = SOAK_DEFAULT_BOOTSTRAP_INTERVAL,
+		.Instances = SOAK_DEFAULT_INSTANCES,
+		.ReportInterval = SOAK_DEFAULT_REPORT_INTERVAL,
+	};
+	Lwm2mContextType * context;
+	SoakUsage start, firstTeardown = { 0 }, teardown;
+	uint64_t startTime, cycle = 0, clientCycle;
+	long startResident;
+	int option, i, result = 0;
+
+	while ((option = getopt(argc, argv, "n:b:i:r:h")) != -1)
+	{
+		switch (option)
+		{
+			case 'n': options.Cycles = strtoull(optarg, NULL, 10); break;
+			case 'b': options.BootstrapInterval = strtoull(optarg, NULL, 10); break;
+			case 'i': options.Instances = atoi(optarg); break;
+			case 'r': options.ReportInterval = strtoull(optarg, NULL, 10); break;
+			default:
+				Soak_Usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (options.Cycles == 0 || options.BootstrapInterval == 0 || options.Instances <= 0 ||
+		options.ReportInterval == 0)
+	{
+		Soak_Usage(argv[0]);
+		return 1;
+	}
+
+	printf("%12s %12s %12s %12s %10s\n", "cycles", "cycles/s", "blocks", "bytes", "rss KB");
+
+	start = Soak_GetUsage();
+	startTime = Soak_GetTime();
+	startResident = Soak_GetResidentKB();
+
+	while (cycle < options.Cycles && result == 0)
+	{
+		if ((context = Soak_StartClient(&options)) == NULL)
+			return 1;
+
+		/* The first SOAK_WARMUP_CYCLES of each client are its warm-up */
+		for (clientCycle = 0; clientCycle < options.BootstrapInterval &&
+			cycle < options.Cycles && result == 0; clientCycle++)
+		{
+			for (i = 0; i < objectCount && result == 0; i++)
+				result = Soak_CycleObject(context, &objects[i], clientCycle, cycle);
+
+			if (++cycle % options.ReportInterval == 0 || cycle == options.Cycles)
+				Soak_Report(cycle, startTime, start);
+		}
+
+		/*
+		 * Destroying the client must give back its per-client records as well. Process-wide
+		 * tables (interned strings, the client registry) are set up by the first client and kept,
+		 * so later clients are measured against the first teardown.
+		 */
+		ClientState_Destroy(context);
+		Lwm2mCore_Destroy(context);
+		teardown = Soak_GetUsage();
+		if (cycle <= options.BootstrapInterval)
+			firstTeardown = teardown;
+		else if (result == 0 && (teardown.Blocks != firstTeardown.Blocks ||
+			teardown.Bytes != firstTeardown.Bytes))
+		{
+			fprintf(stderr, "cycle %" PRIu64 ": %" PRId64 " blocks (%" PRId64 " bytes) left "
+				"allocated after the client was destroyed\n", cycle,
+				teardown.Blocks - firstTeardown.Blocks, teardown.Bytes - firstTeardown.Bytes);
+			result = -1;
+		}
+	}
+
+	printf("%s after %" PRIu64 " cycles, RSS grew by %ld KB\n", result == 0 ? "passed" : "FAILED",
+		cycle, Soak_GetResidentKB() - startResident);
+	return result == 0 ? 0 : 1;
+}
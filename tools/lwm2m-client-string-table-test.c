@@ -0,0 +1,284 @@
+/**
+ * @file
+ * LightWeightM2M string table test.
+ *
+ * @author Imagination Technologies
+ *
+ * @copyright Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group
+ * companies and/or licensors.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Checks lwm2m-client-string-table.c: interning the same string twice, releasing and recycling
+ * handles, replacing a value, copying strings without a reference, reuse of released buffers,
+ * and the 65535 handle limit. Every check releases what it interned, so the table starts empty
+ * for the next. Any mismatch fails the run.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lwm2m-client-string-table.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+#define STRING_TABLE_TEST_MAX_HANDLES		UINT16_MAX
+
+#define STRING_TABLE_TEST_CHECK(test, condition, ...)                                             \
+	do                                                                                            \
+	{                                                                                             \
+		if (!(condition))                                                                         \
+		{                                                                                         \
+			printf("%s: ", (test)->Name);                                                         \
+			printf(__VA_ARGS__);                                                                  \
+			printf("\n");                                                                         \
+			(test)->Failed = true;                                                                \
+			return;                                                                               \
+		}                                                                                         \
+	} while (0)
+
+/***************************************************************************************************
+ * Typedefs
+ **************************************************************************************************/
+
+typedef struct
+{
+	const char * Name;
+	bool Failed;
+	/* Handles interned by the check, released by StringTableTest_End() */
+	StringHandle * Handles;
+	int HandleCount;
+} StringTableTest;
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+static void StringTableTest_Begin(StringTableTest * test, const char * name,
+	StringHandle * handles)
+{
+	memset(test, 0, sizeof(*test));
+	test->Name = name;
+	test->Handles = handles;
+}
+
+static bool StringTableTest_End(StringTableTest * test)
+{
+	int i;
+
+	for (i = 0; i < test->HandleCount; i++)
+		StringTable_Release(test->Handles[i]);
+	printf("%-16s %s\n", test->Name, test->Failed ? "FAILED" : "passed");
+	return !test->Failed;
+}
+
+/* Interns a string and keeps its handle for StringTableTest_End() to release */
+static int StringTableTest_Keep(StringTableTest * test, const char * string, int length)
+{
+	int handle = StringTable_Intern(string, length);
+
+	if (handle != -1 && test->HandleCount < STRING_TABLE_TEST_MAX_HANDLES)
+		test->Handles[test->HandleCount++] = handle;
+	return handle;
+}
+
+/* Equal strings share a handle; the empty string is handle 0; strings end at NUL or length */
+static void StringTableTest_Intern(StringTableTest * test)
+{
+	int first = StringTableTest_Keep(test, "Red1", 4);
+	int second = StringTableTest_Keep(test, "Red1", 4);
+	int other = StringTableTest_Keep(test, "Red12", 4);
+	int cut = StringTableTest_Keep(test, "Blue\0ignored", 12);
+	int empty = StringTable_Intern("", 0);
+
+	STRING_TABLE_TEST_CHECK(test, first > 0 && second == first && other == first,
+		"Red1 interned as %d, %d and %d", first, second, other);
+	STRING_TABLE_TEST_CHECK(test, strcmp(StringTable_Resolve(first), "Red1") == 0 &&
+		StringTable_GetLength(first) == 4, "Red1 resolved as \"%s\"", StringTable_Resolve(first));
+	STRING_TABLE_TEST_CHECK(test, cut > 0 && cut != first &&
+		strcmp(StringTable_Resolve(cut), "Blue") == 0 && StringTable_GetLength(cut) == 4,
+		"Blue resolved as \"%s\"", cut > 0 ? StringTable_Resolve(cut) : "");
+	STRING_TABLE_TEST_CHECK(test, empty == STRING_HANDLE_EMPTY &&
+		strcmp(StringTable_Resolve(STRING_HANDLE_EMPTY), "") == 0 &&
+		StringTable_GetLength(STRING_HANDLE_EMPTY) == 0, "empty string interned as %d", empty);
+}
+
+/* A string lives until its last reference goes, and its handle is then the next one given out */
+static void StringTableTest_Release(StringTableTest * test)
+{
+	int handle = StringTable_Intern("Lamp", 4);
+	int next;
+
+	STRING_TABLE_TEST_CHECK(test, handle > 0 && StringTable_Intern("Lamp", 4) == handle,
+		"Lamp interned as %d", handle);
+	StringTable_Release(handle);
+	STRING_TABLE_TEST_CHECK(test, strcmp(StringTable_Resolve(handle), "Lamp") == 0,
+		"Lamp gone with a reference left");
+	StringTable_Release(handle);
+
+	next = StringTableTest_Keep(test, "Switch", 6);
+	STRING_TABLE_TEST_CHECK(test, next == handle, "released handle %d not reused, got %d",
+		handle, next);
+	STRING_TABLE_TEST_CHECK(test, strcmp(StringTable_Resolve(next), "Switch") == 0,
+		"reused handle resolved as \"%s\"", StringTable_Resolve(next));
+}
+
+/* Replace releases the old value and leaves the handle holding the new one */
+static void StringTableTest_Replace(StringTableTest * test)
+{
+	StringHandle handle = STRING_HANDLE_EMPTY, old;
+	int shared = StringTableTest_Keep(test, "lux", 3);
+	char buffer[4];
+
+	STRING_TABLE_TEST_CHECK(test, StringTable_Replace(&handle, "Cel", 3) == 0 &&
+		strcmp(StringTable_Resolve(handle), "Cel") == 0, "replacing empty failed");
+	old = handle;
+	STRING_TABLE_TEST_CHECK(test, StringTable_Replace(&handle, "lux", 3) == 0 &&
+		handle == shared, "replacing with an interned string gave handle %d, expected %d",
+		handle, shared);
+	STRING_TABLE_TEST_CHECK(test, StringTable_Copy(old, buffer, sizeof(buffer)) == 0,
+		"Cel not released by the replace");
+	STRING_TABLE_TEST_CHECK(test, StringTable_Replace(&handle, "", 0) == 0 &&
+		handle == STRING_HANDLE_EMPTY, "replacing with the empty string gave handle %d", handle);
+}
+
+/* Copies are cut to fit and NUL-terminated; released and empty handles copy as "" */
+static void StringTableTest_Copy(StringTableTest * test)
+{
+	int handle = StringTable_Intern("Warm White", 10);
+	char buffer[16];
+	int length;
+
+	STRING_TABLE_TEST_CHECK(test, handle > 0, "Warm White not interned");
+	length = StringTable_Copy(handle, buffer, sizeof(buffer));
+	STRING_TABLE_TEST_CHECK(test, length == 10 && strcmp(buffer, "Warm White") == 0,
+		"copied %d bytes, \"%s\"", length, buffer);
+	length = StringTable_Copy(handle, buffer, 5);
+	STRING_TABLE_TEST_CHECK(test, length == 4 && strcmp(buffer, "Warm") == 0,
+		"cut copy gave %d bytes, \"%s\"", length, buffer);
+	length = StringTable_Copy(STRING_HANDLE_EMPTY, buffer, sizeof(buffer));
+	STRING_TABLE_TEST_CHECK(test, length == 0 && buffer[0] == '\0', "empty handle copied %d bytes",
+		length);
+
+	StringTable_Release(handle);
+	length = StringTable_Copy(handle, buffer, sizeof(buffer));
+	STRING_TABLE_TEST_CHECK(test, length == 0 && buffer[0] == '\0',
+		"released handle copied %d bytes", length);
+}
+
+/* A released buffer is reused for the next string of its size rather than freed */
+static void StringTableTest_BufferReuse(StringTableTest * test)
+{
+	char string[40];
+	const char * old;
+	int handle;
+
+	memset(string, 'a', sizeof(string));
+	handle = StringTable_Intern(string, sizeof(string));
+	STRING_TABLE_TEST_CHECK(test, handle > 0, "first string not interned");
+	old = StringTable_Resolve(handle);
+	StringTable_Release(handle);
+
+	memset(string, 'b', sizeof(string) - 1);
+	handle = StringTableTest_Keep(test, string, sizeof(string) - 1);
+	STRING_TABLE_TEST_CHECK(test, handle > 0 && StringTable_Resolve(handle) == old,
+		"released buffer not reused");
+}
+
+/* Handles 1 to 65535 can be live at once; interning fails beyond that until one is released */
+static void StringTableTest_HandleLimit(StringTableTest * test)
+{
+	char string[12];
+	int handle, i;
+
+	for (i = 0; i < STRING_TABLE_TEST_MAX_HANDLES; i++)
+	{
+		snprintf(string, sizeof(string), "%05d", i);
+		handle = StringTableTest_Keep(test, string, sizeof(string));
+		STRING_TABLE_TEST_CHECK(test, handle > 0, "string %d of %d not interned", i + 1,
+			STRING_TABLE_TEST_MAX_HANDLES);
+	}
+
+	handle = StringTable_Intern("one too many", 12);
+	STRING_TABLE_TEST_CHECK(test, handle == -1, "interned past the limit as %d", handle);
+
+	StringTable_Release(test->Handles[--test->HandleCount]);
+	handle = StringTableTest_Keep(test, "one too many", 12);
+	STRING_TABLE_TEST_CHECK(test, handle > 0, "not interned after a release");
+	for (i = 0; i < test->HandleCount; i++)
+	{
+		snprintf(string, sizeof(string), "%05d", i);
+		STRING_TABLE_TEST_CHECK(test, i == test->HandleCount - 1 ||
+			strcmp(StringTable_Resolve(test->Handles[i]), string) == 0,
+			"handle %d resolved as \"%s\"", test->Handles[i],
+			StringTable_Resolve(test->Handles[i]));
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	static StringHandle handles[STRING_TABLE_TEST_MAX_HANDLES];
+	StringTableTest test;
+	bool passed = true;
+
+	StringTableTest_Begin(&test, "intern", handles);
+	StringTableTest_Intern(&test);
+	passed &= StringTableTest_End(&test);
+
+	StringTableTest_Begin(&test, "release", handles);
+	StringTableTest_Release(&test);
+	passed &= StringTableTest_End(&test);
+
+	StringTableTest_Begin(&test, "replace", handles);
+	StringTableTest_Replace(&test);
+	passed &= StringTableTest_End(&test);
+
+	StringTableTest_Begin(&test, "copy", handles);
+	StringTableTest_Copy(&test);
+	passed &= StringTableTest_End(&test);
+
+	StringTableTest_Begin(&test, "buffer reuse", handles);
+	StringTableTest_BufferReuse(&test);
+	passed &= StringTableTest_End(&test);
+
+	StringTableTest_Begin(&test, "handle limit", handles);
+	StringTableTest_HandleLimit(&test);
+	passed &= StringTableTest_End(&test);
+
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}